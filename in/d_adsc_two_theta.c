@@ -35,7 +35,7 @@ MX_RECORD_FUNCTION_LIST mxd_adsc_two_theta_record_function_list = {
 	NULL,
 	mxd_adsc_two_theta_create_record_structures,
 	mxd_adsc_two_theta_finish_record_initialization,
-	NULL,
+	mxd_adsc_two_theta_delete_record,
 	mxd_adsc_two_theta_print_motor_structure
 };
 
@@ -53,7 +53,14 @@ MX_MOTOR_FUNCTION_LIST mxd_adsc_two_theta_motor_function_list = {
 	NULL,
 	NULL,
 	NULL,
-	mxd_adsc_two_theta_get_status
+	mxd_adsc_two_theta_get_status,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	mxd_adsc_two_theta_get_position_transform
 };
 
 /* Photon adsc_two_theta motor data structures. */
@@ -134,7 +141,7 @@ mxd_adsc_two_theta_create_record_structures( MX_RECORD *record )
 
 	/* Allocate memory for the necessary structures. */
 
-	motor = (MX_MOTOR *) malloc( sizeof(MX_MOTOR) );
+	motor = (MX_MOTOR *) mx_record_allocate( record, sizeof(MX_MOTOR) );
 
 	if ( motor == (MX_MOTOR *) NULL ) {
 		return mx_error( MXE_OUT_OF_MEMORY, fname,
@@ -142,7 +149,7 @@ mxd_adsc_two_theta_create_record_structures( MX_RECORD *record )
 	}
 
 	adsc_two_theta = (MX_ADSC_TWO_THETA *)
-				malloc( sizeof(MX_ADSC_TWO_THETA) );
+			mx_record_allocate( record, sizeof(MX_ADSC_TWO_THETA) );
 
 	if ( adsc_two_theta == (MX_ADSC_TWO_THETA *) NULL ) {
 		return mx_error( MXE_OUT_OF_MEMORY, fname,
@@ -201,7 +208,40 @@ mxd_adsc_two_theta_finish_record_initialization( MX_RECORD *record )
 
 	motor->real_motor_record = adsc_two_theta->height_motor_record;
 
-	return MX_SUCCESSFUL_RESULT;
+	status = mx_motor_compile_position_chain( record );
+
+	return status;
+}
+
+/* The MX_MOTOR and MX_ADSC_TWO_THETA structures may belong to the
+ * record arena, so they must not be passed to free() directly.
+ */
+
+MX_EXPORT mx_status_type
+mxd_adsc_two_theta_delete_record( MX_RECORD *record )
+{
+	if ( record == NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( record->record_class_struct != NULL ) {
+		(void) mx_motor_disable_state_cache( record );
+
+		mx_motor_free_position_chain( record );
+	}
+
+	if ( record->record_type_struct != NULL ) {
+		mx_record_free( record, record->record_type_struct );
+
+		record->record_type_struct = NULL;
+	}
+
+	if ( record->record_class_struct != NULL ) {
+		mx_record_free( record, record->record_class_struct );
+
+		record->record_class_struct = NULL;
+	}
+
+	return mx_default_delete_record_handler( record );
 }
 
 MX_EXPORT mx_status_type
@@ -341,6 +381,24 @@ h_to_theta( double h )
 	return(angle);
 }
 
+/* Wrappers with the signature of MX_MOTOR_TRANSFORM_FUNCTION. */
+
+static double
+mxd_adsc_two_theta_height_from_angle( double two_theta, void *args )
+{
+	MXW_UNUSED( args );
+
+	return theta_to_h( two_theta );
+}
+
+static double
+mxd_adsc_two_theta_angle_from_height( double height, void *args )
+{
+	MXW_UNUSED( args );
+
+	return h_to_theta( height );
+}
+
 /*=======================================================================*/
 
 MX_EXPORT mx_status_type
@@ -489,3 +547,32 @@ mxd_adsc_two_theta_get_status( MX_MOTOR *motor )
 	return MX_SUCCESSFUL_RESULT;
 }
 
+MX_EXPORT mx_status_type
+mxd_adsc_two_theta_get_position_transform( MX_MOTOR *motor,
+				MX_MOTOR_POSITION_TRANSFORM *transform )
+{
+	static const char fname[] =
+			"mxd_adsc_two_theta_get_position_transform()";
+
+	MX_ADSC_TWO_THETA *adsc_two_theta;
+	MX_RECORD *height_motor_record;
+	mx_status_type status;
+
+	status = mxd_adsc_two_theta_get_pointers( motor, &adsc_two_theta,
+					&height_motor_record,fname );
+
+	if ( status.code != MXE_SUCCESS )
+		return status;
+
+	transform->dependent_motor_record = height_motor_record;
+
+	transform->dependent_from_raw_pseudomotor =
+				mxd_adsc_two_theta_height_from_angle;
+
+	transform->raw_pseudomotor_from_dependent =
+				mxd_adsc_two_theta_angle_from_height;
+
+	transform->transform_args = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
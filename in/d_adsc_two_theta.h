@@ -33,6 +33,7 @@ MX_API mx_status_type mxd_adsc_two_theta_create_record_structures(
 					MX_RECORD *record );
 MX_API mx_status_type mxd_adsc_two_theta_finish_record_initialization(
 					MX_RECORD *record );
+MX_API mx_status_type mxd_adsc_two_theta_delete_record( MX_RECORD *record );
 MX_API mx_status_type mxd_adsc_two_theta_print_motor_structure(
 					FILE *file, MX_RECORD *record );
 MX_API mx_status_type mxd_adsc_two_theta_move_absolute( MX_MOTOR *motor );
@@ -41,6 +42,9 @@ MX_API mx_status_type mxd_adsc_two_theta_set_position( MX_MOTOR *motor );
 MX_API mx_status_type mxd_adsc_two_theta_soft_abort( MX_MOTOR *motor );
 MX_API mx_status_type mxd_adsc_two_theta_immediate_abort( MX_MOTOR *motor );
 MX_API mx_status_type mxd_adsc_two_theta_get_status( MX_MOTOR *motor );
+MX_API mx_status_type mxd_adsc_two_theta_get_position_transform(
+				MX_MOTOR *motor,
+				MX_MOTOR_POSITION_TRANSFORM *transform );
 
 extern MX_RECORD_FUNCTION_LIST mxd_adsc_two_theta_record_function_list;
 extern MX_MOTOR_FUNCTION_LIST mxd_adsc_two_theta_motor_function_list;
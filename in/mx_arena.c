@@ -0,0 +1,245 @@
+/*
+ * Name:    mx_arena.c
+ *
+ * Purpose: Arena allocators used to hold the records of an MX database.
+ *
+ *          Loading a large database used to make several separate
+ *          malloc() calls per record for the record itself, its field
+ *          array and its superclass, class and type structures.  An
+ *          arena instead carves them out of a few large blocks, which
+ *          keeps the records of one database close together in memory
+ *          and lets the whole database be freed at once.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_arena.h"
+
+/* All allocations are rounded up to a multiple of MX_ARENA_ALIGNMENT,
+ * which is enough for long double and 64-bit integers on every
+ * platform that MX supports.
+ */
+
+#define MX_ARENA_ALIGNMENT	16
+
+#define MX_ARENA_ROUND_UP(n) \
+	( ( (n) + (MX_ARENA_ALIGNMENT - 1) ) & ~((size_t) MX_ARENA_ALIGNMENT - 1) )
+
+MX_EXPORT mx_status_type
+mx_arena_create( MX_ARENA **arena, size_t block_size, unsigned long flags )
+{
+	static const char fname[] = "mx_arena_create()";
+
+	MX_ARENA *new_arena;
+
+	if ( arena == (MX_ARENA **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_ARENA pointer passed was NULL." );
+	}
+
+	new_arena = (MX_ARENA *) calloc( 1, sizeof(MX_ARENA) );
+
+	if ( new_arena == (MX_ARENA *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an MX_ARENA structure." );
+	}
+
+	if ( block_size == 0 ) {
+		block_size = MX_ARENA_DEFAULT_BLOCK_SIZE;
+	}
+
+	new_arena->flags = flags;
+	new_arena->block_size = MX_ARENA_ROUND_UP( block_size );
+
+	*arena = new_arena;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_arena_destroy( MX_ARENA *arena )
+{
+	MX_ARENA_BLOCK *block, *next_block;
+
+	if ( arena == (MX_ARENA *) NULL )
+		return;
+
+	block = arena->block_list;
+
+	while ( block != (MX_ARENA_BLOCK *) NULL ) {
+		next_block = block->next_block;
+
+		free( block->data );
+		free( block );
+
+		block = next_block;
+	}
+
+	free( arena );
+}
+
+/*------------------------------------------------------------------------*/
+
+static MX_ARENA_BLOCK *
+mx_arena_add_block( MX_ARENA *arena, size_t block_size )
+{
+	MX_ARENA_BLOCK *block;
+
+	block = (MX_ARENA_BLOCK *) malloc( sizeof(MX_ARENA_BLOCK) );
+
+	if ( block == (MX_ARENA_BLOCK *) NULL )
+		return NULL;
+
+	block->data = (char *) calloc( 1, block_size );
+
+	if ( block->data == (char *) NULL ) {
+		free( block );
+		return NULL;
+	}
+
+	block->block_size = block_size;
+	block->bytes_used = 0;
+
+	block->next_block = arena->block_list;
+	arena->block_list = block;
+
+	arena->num_blocks++;
+	arena->bytes_reserved += block_size;
+
+	return block;
+}
+
+MX_EXPORT void *
+mx_arena_allocate( MX_ARENA *arena, size_t num_bytes )
+{
+	MX_ARENA_BLOCK *block;
+	size_t rounded_bytes;
+	void *ptr;
+
+	if ( arena == (MX_ARENA *) NULL )
+		return NULL;
+
+	if ( num_bytes == 0 )
+		num_bytes = 1;
+
+	arena->num_allocations++;
+	arena->bytes_requested += num_bytes;
+
+	if ( arena->flags & MXF_ARENA_USE_MALLOC ) {
+		return calloc( 1, num_bytes );
+	}
+
+	rounded_bytes = MX_ARENA_ROUND_UP( num_bytes );
+
+	/* Large requests get a block of their own.  The new block is
+	 * linked in behind the current block, so that the free space
+	 * in the current block is not abandoned.
+	 */
+
+	if ( rounded_bytes > ( arena->block_size / 4 ) ) {
+		block = mx_arena_add_block( arena, rounded_bytes );
+
+		if ( block == (MX_ARENA_BLOCK *) NULL )
+			return NULL;
+
+		block->bytes_used = rounded_bytes;
+
+		return block->data;
+	}
+
+	block = arena->current_block;
+
+	if ( ( block == (MX_ARENA_BLOCK *) NULL )
+	  || ( ( block->bytes_used + rounded_bytes ) > block->block_size ) )
+	{
+		block = mx_arena_add_block( arena, arena->block_size );
+
+		if ( block == (MX_ARENA_BLOCK *) NULL )
+			return NULL;
+
+		arena->current_block = block;
+	}
+
+	ptr = block->data + block->bytes_used;
+
+	block->bytes_used += rounded_bytes;
+
+	return ptr;
+}
+
+/* The arena does not search its blocks to find out whether it owns
+ * 'ptr'.  Callers must only pass memory that came from this arena,
+ * so only MXF_ARENA_USE_MALLOC arenas have anything to free.
+ */
+
+MX_EXPORT void
+mx_arena_free( MX_ARENA *arena, void *ptr )
+{
+	if ( ptr == NULL )
+		return;
+
+	if ( arena != (MX_ARENA *) NULL ) {
+		arena->num_frees++;
+
+		if ( ( arena->flags & MXF_ARENA_USE_MALLOC ) == 0 )
+			return;
+	}
+
+	free( ptr );
+}
+
+MX_EXPORT void
+mx_arena_adopt( MX_ARENA *arena, MX_ARENA *source_arena )
+{
+	MX_ARENA_BLOCK *last_block;
+
+	if ( ( arena == (MX_ARENA *) NULL )
+	  || ( source_arena == (MX_ARENA *) NULL )
+	  || ( source_arena->block_list == (MX_ARENA_BLOCK *) NULL ) )
+	{
+		return;
+	}
+
+	/* The adopted blocks go on the end of the list, so that the
+	 * current block of 'arena' stays where it is.
+	 */
+
+	if ( arena->block_list == (MX_ARENA_BLOCK *) NULL ) {
+		arena->block_list = source_arena->block_list;
+	} else {
+		last_block = arena->block_list;
+
+		while ( last_block->next_block != (MX_ARENA_BLOCK *) NULL ) {
+			last_block = last_block->next_block;
+		}
+
+		last_block->next_block = source_arena->block_list;
+	}
+
+	arena->num_allocations += source_arena->num_allocations;
+	arena->num_frees += source_arena->num_frees;
+	arena->num_blocks += source_arena->num_blocks;
+	arena->bytes_requested += source_arena->bytes_requested;
+	arena->bytes_reserved += source_arena->bytes_reserved;
+
+	source_arena->block_list = NULL;
+	source_arena->current_block = NULL;
+	source_arena->num_allocations = 0;
+	source_arena->num_frees = 0;
+	source_arena->num_blocks = 0;
+	source_arena->bytes_requested = 0;
+	source_arena->bytes_reserved = 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Name:    mx_arena.h
+ *
+ * Purpose: Header file for arena allocators used to hold the records
+ *          of an MX database.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_ARENA_H__
+#define __MX_ARENA_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An MX arena hands out memory from a list of large blocks.  Individual
+ * allocations are never returned to the arena.  Instead, all of the
+ * blocks are freed at once by mx_arena_destroy().  Memory returned by
+ * mx_arena_allocate() is always zeroed and aligned for any MX datatype.
+ *
+ * Requests larger than a quarter of the block size get a block of
+ * their own, so that they do not waste the rest of the current block.
+ *
+ * If MXF_ARENA_USE_MALLOC is set, the arena passes all requests on to
+ * calloc() and mx_arena_free() really frees them.  The statistics are
+ * maintained in either case, which makes it possible to compare the
+ * two allocation strategies on the same database.
+ *
+ * MX arenas are not thread safe.
+ */
+
+#define MX_ARENA_DEFAULT_BLOCK_SIZE	65536
+
+#define MXF_ARENA_USE_MALLOC		0x1
+
+typedef struct mx_arena_block_type {
+	struct mx_arena_block_type *next_block;
+	size_t block_size;
+	size_t bytes_used;
+	char *data;
+} MX_ARENA_BLOCK;
+
+typedef struct {
+	unsigned long flags;
+	size_t block_size;
+	MX_ARENA_BLOCK *current_block;
+	MX_ARENA_BLOCK *block_list;
+
+	/* Statistics */
+
+	unsigned long num_allocations;
+	unsigned long num_frees;
+	unsigned long num_blocks;
+	size_t bytes_requested;
+	size_t bytes_reserved;
+} MX_ARENA;
+
+MX_API mx_status_type mx_arena_create( MX_ARENA **arena,
+					size_t block_size,
+					unsigned long flags );
+
+MX_API void mx_arena_destroy( MX_ARENA *arena );
+
+MX_API void *mx_arena_allocate( MX_ARENA *arena, size_t num_bytes );
+
+/* 'ptr' must have come from mx_arena_allocate() on the same arena.
+ * mx_arena_free() is a no-op unless MXF_ARENA_USE_MALLOC is set.
+ * If 'arena' is NULL, 'ptr' is passed to free().
+ */
+
+MX_API void mx_arena_free( MX_ARENA *arena, void *ptr );
+
+/* mx_arena_adopt() moves all of the blocks and statistics of
+ * 'source_arena' to 'arena', leaving 'source_arena' empty.
+ */
+
+MX_API void mx_arena_adopt( MX_ARENA *arena, MX_ARENA *source_arena );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_ARENA_H__ */
+
@@ -0,0 +1,373 @@
+/*
+ * Name:    mx_array_parse.c
+ *
+ * Purpose: Parses whole rows of numeric array fields in one pass.
+ *
+ *          mx_parse_array_description() recurses once per dimension and
+ *          then calls the field type's token parser through a function
+ *          pointer for every single element.  For large MXFT_DOUBLE and
+ *          MXFT_LONG arrays, such as motor position lists, variable
+ *          arrays and calibration tables, that per element overhead
+ *          dominated.  mx_parse_numeric_row() instead walks the record
+ *          description directly and converts the numbers of the
+ *          innermost dimension straight into the array.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+#include "mx_number.h"
+
+#define MX_ROW_IS_SEPARATOR(c) \
+	( ( (c) == ' ' ) || ( (c) == '\t' ) || ( (c) == '\n' ) )
+
+MX_EXPORT mx_bool_type
+mx_numeric_row_parser_is_available( long datatype )
+{
+	switch( datatype ) {
+	case MXFT_UCHAR:
+	case MXFT_SHORT:
+	case MXFT_USHORT:
+	case MXFT_BOOL:
+	case MXFT_LONG:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+	case MXFT_INT64:
+	case MXFT_UINT64:
+	case MXFT_FLOAT:
+	case MXFT_DOUBLE:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* Parse the elements one token at a time.  This is used when the
+ * description uses unusual separators.
+ */
+
+static mx_status_type
+mx_parse_numeric_row_by_token( char *row_ptr,
+				long datatype,
+				size_t element_size,
+				long num_elements,
+				MX_RECORD *record,
+				MX_RECORD_FIELD *record_field,
+				MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	MX_RECORD_TOKEN_PARSER *token_parser;
+	MX_RECORD_TOKEN token;
+	long n;
+	mx_status_type mx_status;
+
+	mx_status = mx_get_token_view_parser( datatype, &token_parser );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	for ( n = 0; n < num_elements; n++ ) {
+		mx_status = mx_get_next_record_token_view( parse_status,
+								&token );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		mx_status = (*token_parser)( row_ptr + n * element_size,
+				&token, record, record_field, parse_status );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_numeric_row_error( long status_code,
+			const char *ptr,
+			size_t length,
+			long element,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_parse_numeric_row()";
+
+	size_t token_length;
+
+	for ( token_length = 0; token_length < length; token_length++ ) {
+		if ( MX_ROW_IS_SEPARATOR( ptr[token_length] ) )
+			break;
+	}
+
+	if ( status_code == MXE_WOULD_EXCEED_LIMIT ) {
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+		"Element %ld '%.*s' of field '%s' in record '%s' is "
+		"outside the range of the field's datatype.",
+			element, (int) token_length, ptr,
+			record_field->descriptor->name, record->name );
+	}
+
+	return mx_error( MXE_UNPARSEABLE_STRING, fname,
+	"Element %ld '%.*s' of field '%s' in record '%s' "
+	"is not a valid number.",
+		element, (int) token_length, ptr,
+		record_field->descriptor->name, record->name );
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_parse_numeric_row( void *row_ptr,
+			long datatype,
+			long num_elements,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_numeric_row()";
+
+	MX_RECORD_TOKEN_PARSER *token_parser;
+	MX_RECORD_TOKEN token;
+	const char *ptr, *end;
+	size_t length, element_size, used;
+	long n, status_code;
+	int base;
+	int64_t signed_value;
+	uint64_t unsigned_value;
+	double double_value;
+	mx_status_type mx_status;
+
+	if ( ( row_ptr == NULL )
+	  || ( parse_status == (MX_RECORD_FIELD_PARSE_STATUS *) NULL )
+	  || ( parse_status->description == (char *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	switch( datatype ) {
+	case MXFT_UCHAR:   element_size = sizeof(unsigned char);	break;
+	case MXFT_SHORT:   element_size = sizeof(short);		break;
+	case MXFT_USHORT:  element_size = sizeof(unsigned short);	break;
+	case MXFT_BOOL:    element_size = sizeof(mx_bool_type);		break;
+	case MXFT_LONG:    element_size = sizeof(long);			break;
+	case MXFT_ULONG:   element_size = sizeof(unsigned long);	break;
+	case MXFT_HEX:     element_size = sizeof(unsigned long);	break;
+	case MXFT_INT64:   element_size = sizeof(int64_t);		break;
+	case MXFT_UINT64:  element_size = sizeof(uint64_t);		break;
+	case MXFT_FLOAT:   element_size = sizeof(float);		break;
+	case MXFT_DOUBLE:  element_size = sizeof(double);		break;
+	default:
+		return mx_error( MXE_UNSUPPORTED, fname,
+		"Field type %ld is not a numeric type.", datatype );
+	}
+
+	if ( ( parse_status->separators != (char *) NULL )
+	  && ( strcmp( parse_status->separators,
+			MX_RECORD_FIELD_SEPARATORS ) != 0 ) )
+	{
+		return mx_parse_numeric_row_by_token( (char *) row_ptr,
+				datatype, element_size, num_elements,
+				record, record_field, parse_status );
+	}
+
+	ptr = parse_status->description;
+
+	if ( parse_status->start_of_trailing_whitespace != (char *) NULL ) {
+		end = parse_status->start_of_trailing_whitespace;
+	} else {
+		end = ptr + strlen( ptr );
+	}
+
+	if ( datatype == MXFT_HEX ) {
+		base = 16;
+	} else {
+		base = 10;
+	}
+
+	token_parser = NULL;
+
+	for ( n = 0; n < num_elements; n++ ) {
+
+		while ( ( ptr < end ) && MX_ROW_IS_SEPARATOR( *ptr ) ) {
+			ptr++;
+		}
+
+		if ( ( ptr >= end ) || ( *ptr == '\0' ) ) {
+			parse_status->description = (char *) ptr;
+
+			return mx_error( MXE_UNEXPECTED_END_OF_DATA, fname,
+			"Only %ld of the %ld elements of field '%s' in "
+			"record '%s' were found.",
+				n, num_elements,
+				record_field->descriptor->name, record->name );
+		}
+
+		/* Quoted numbers are rare, so leave them to the ordinary
+		 * token parser.
+		 */
+
+		if ( *ptr == '"' ) {
+			if ( token_parser == (MX_RECORD_TOKEN_PARSER *) NULL ) {
+				mx_status = mx_get_token_view_parser( datatype,
+								&token_parser );
+
+				if ( mx_status.code != MXE_SUCCESS )
+					return mx_status;
+			}
+
+			parse_status->description = (char *) ptr;
+
+			mx_status = mx_get_next_record_token_view(
+						parse_status, &token );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+
+			mx_status = (*token_parser)(
+				(char *) row_ptr + n * element_size,
+				&token, record, record_field, parse_status );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+
+			ptr = parse_status->description;
+			continue;
+		}
+
+		length = end - ptr;
+		used = 0;
+
+		switch( datatype ) {
+		case MXFT_FLOAT:
+		case MXFT_DOUBLE:
+			status_code = mx_parse_double_n( ptr, length,
+						&double_value, &used );
+			break;
+
+		case MXFT_SHORT:
+		case MXFT_BOOL:
+		case MXFT_LONG:
+		case MXFT_INT64:
+			status_code = mx_parse_int64_n( ptr, length, base,
+						&signed_value, &used );
+			break;
+
+		default:
+			status_code = mx_parse_uint64_n( ptr, length, base,
+						&unsigned_value, &used );
+			break;
+		}
+
+		/* The number must be followed by a separator or by the
+		 * end of the description.
+		 */
+
+		if ( ( status_code == MXE_SUCCESS ) && ( used < length )
+		  && ( ptr[used] != '\0' )
+		  && ( ! MX_ROW_IS_SEPARATOR( ptr[used] ) ) )
+		{
+			status_code = MXE_UNPARSEABLE_STRING;
+		}
+
+		if ( status_code == MXE_SUCCESS ) {
+			switch( datatype ) {
+			case MXFT_SHORT:
+				if ( ( signed_value < SHRT_MIN )
+				  || ( signed_value > SHRT_MAX ) )
+				{
+					status_code = MXE_WOULD_EXCEED_LIMIT;
+				}
+				break;
+			case MXFT_LONG:
+				if ( ( signed_value < LONG_MIN )
+				  || ( signed_value > LONG_MAX ) )
+				{
+					status_code = MXE_WOULD_EXCEED_LIMIT;
+				}
+				break;
+			case MXFT_UCHAR:
+				if ( unsigned_value > UCHAR_MAX ) {
+					status_code = MXE_WOULD_EXCEED_LIMIT;
+				}
+				break;
+			case MXFT_USHORT:
+				if ( unsigned_value > USHRT_MAX ) {
+					status_code = MXE_WOULD_EXCEED_LIMIT;
+				}
+				break;
+			case MXFT_ULONG:
+			case MXFT_HEX:
+				if ( unsigned_value > ULONG_MAX ) {
+					status_code = MXE_WOULD_EXCEED_LIMIT;
+				}
+				break;
+			}
+		}
+
+		if ( status_code != MXE_SUCCESS ) {
+			parse_status->description = (char *) ptr;
+
+			return mx_numeric_row_error( status_code,
+				ptr, length, n, record, record_field );
+		}
+
+		switch( datatype ) {
+		case MXFT_DOUBLE:
+			((double *) row_ptr)[n] = double_value;
+			break;
+		case MXFT_FLOAT:
+			((float *) row_ptr)[n] = (float) double_value;
+			break;
+		case MXFT_SHORT:
+			((short *) row_ptr)[n] = (short) signed_value;
+			break;
+		case MXFT_BOOL:
+			((mx_bool_type *) row_ptr)[n] = ( signed_value != 0 );
+			break;
+		case MXFT_LONG:
+			((long *) row_ptr)[n] = (long) signed_value;
+			break;
+		case MXFT_INT64:
+			((int64_t *) row_ptr)[n] = signed_value;
+			break;
+		case MXFT_UCHAR:
+			((unsigned char *) row_ptr)[n] =
+						(unsigned char) unsigned_value;
+			break;
+		case MXFT_USHORT:
+			((unsigned short *) row_ptr)[n] =
+						(unsigned short) unsigned_value;
+			break;
+		case MXFT_ULONG:
+		case MXFT_HEX:
+			((unsigned long *) row_ptr)[n] =
+						(unsigned long) unsigned_value;
+			break;
+		case MXFT_UINT64:
+			((uint64_t *) row_ptr)[n] = unsigned_value;
+			break;
+		}
+
+		ptr += used;
+	}
+
+	parse_status->description = (char *) ptr;
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,51 @@
+/*
+ * Name:    mx_atomic.h
+ *
+ * Purpose: Header file for MX atomic operations.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_ATOMIC_H__
+#define __MX_ATOMIC_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* All of these functions act as full memory barriers.  The add,
+ * increment and decrement functions return the new value.
+ */
+
+MX_API void mx_atomic_initialize( void );
+
+MX_API int32_t mx_atomic_add32( int32_t *value_ptr, int32_t increment );
+
+MX_API int32_t mx_atomic_decrement32( int32_t *value_ptr );
+
+MX_API int32_t mx_atomic_increment32( int32_t *value_ptr );
+
+MX_API int32_t mx_atomic_read32( int32_t *value_ptr );
+
+MX_API void mx_atomic_write32( int32_t *value_ptr, int32_t new_value );
+
+MX_API void mx_atomic_memory_barrier( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_ATOMIC_H__ */
@@ -0,0 +1,210 @@
+/*
+ * Name:    mx_condition_variable.c
+ *
+ * Purpose: MX condition variable functions.
+ *
+ *          On the platforms supported here, the condition variables are
+ *          Posix threads condition variables, and they are used with MX
+ *          mutexes whose 'mutex_ptr' points to a pthread_mutex_t.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <errno.h>
+
+#include "mx_util.h"
+#include "mx_mutex.h"
+#include "mx_condition_variable.h"
+
+#if defined(OS_LINUX) || defined(OS_MACOSX) || defined(OS_BSD) \
+	|| defined(OS_SOLARIS) || defined(OS_QNX) || defined(OS_CYGWIN)
+
+#include <time.h>
+#include <pthread.h>
+
+MX_EXPORT mx_status_type
+mx_condition_variable_create( MX_CONDITION_VARIABLE **cv )
+{
+	static const char fname[] = "mx_condition_variable_create()";
+
+	pthread_cond_t *pthread_cv;
+	int status;
+
+	if ( cv == (MX_CONDITION_VARIABLE **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_CONDITION_VARIABLE pointer passed was NULL." );
+	}
+
+	*cv = (MX_CONDITION_VARIABLE *)
+			calloc( 1, sizeof(MX_CONDITION_VARIABLE) );
+
+	if ( *cv == (MX_CONDITION_VARIABLE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_CONDITION_VARIABLE structure." );
+	}
+
+	pthread_cv = (pthread_cond_t *) malloc( sizeof(pthread_cond_t) );
+
+	if ( pthread_cv == (pthread_cond_t *) NULL ) {
+		mx_free( *cv );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a pthread_cond_t." );
+	}
+
+	status = pthread_cond_init( pthread_cv, NULL );
+
+	if ( status != 0 ) {
+		mx_free( pthread_cv );
+		mx_free( *cv );
+
+		return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+		"pthread_cond_init() failed with error code %d.", status );
+	}
+
+	(*cv)->cv_ptr = pthread_cv;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_condition_variable_destroy( MX_CONDITION_VARIABLE *cv )
+{
+	static const char fname[] = "mx_condition_variable_destroy()";
+
+	pthread_cond_t *pthread_cv;
+	int status;
+
+	if ( cv == (MX_CONDITION_VARIABLE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_CONDITION_VARIABLE pointer passed was NULL." );
+	}
+
+	pthread_cv = (pthread_cond_t *) cv->cv_ptr;
+
+	if ( pthread_cv != (pthread_cond_t *) NULL ) {
+		status = pthread_cond_destroy( pthread_cv );
+
+		if ( status != 0 ) {
+			return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+			"pthread_cond_destroy() failed with error code %d.",
+				status );
+		}
+
+		free( pthread_cv );
+	}
+
+	free( cv );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT long
+mx_condition_variable_wait( MX_CONDITION_VARIABLE *cv, MX_MUTEX *mutex )
+{
+	int status;
+
+	if ( ( cv == (MX_CONDITION_VARIABLE *) NULL )
+	  || ( mutex == (MX_MUTEX *) NULL ) )
+	{
+		return MXE_NULL_ARGUMENT;
+	}
+
+	status = pthread_cond_wait( (pthread_cond_t *) cv->cv_ptr,
+				(pthread_mutex_t *) mutex->mutex_ptr );
+
+	if ( status != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_condition_variable_timed_wait( MX_CONDITION_VARIABLE *cv,
+				MX_MUTEX *mutex,
+				double max_seconds_to_wait )
+{
+	struct timespec deadline;
+	double whole_seconds, fractional_seconds;
+	int status;
+
+	if ( ( cv == (MX_CONDITION_VARIABLE *) NULL )
+	  || ( mutex == (MX_MUTEX *) NULL ) )
+	{
+		return MXE_NULL_ARGUMENT;
+	}
+
+	if ( max_seconds_to_wait < 0.0 ) {
+		return mx_condition_variable_wait( cv, mutex );
+	}
+
+	/* pthread_cond_timedwait() wants an absolute CLOCK_REALTIME time. */
+
+	if ( clock_gettime( CLOCK_REALTIME, &deadline ) != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	fractional_seconds = modf( max_seconds_to_wait, &whole_seconds );
+
+	deadline.tv_sec += (time_t) whole_seconds;
+	deadline.tv_nsec += (long) ( 1.0e9 * fractional_seconds );
+
+	if ( deadline.tv_nsec >= 1000000000L ) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	status = pthread_cond_timedwait( (pthread_cond_t *) cv->cv_ptr,
+				(pthread_mutex_t *) mutex->mutex_ptr,
+				&deadline );
+
+	switch( status ) {
+	case 0:
+		return MXE_SUCCESS;
+	case ETIMEDOUT:
+		return MXE_TIMED_OUT;
+	default:
+		return MXE_OPERATING_SYSTEM_ERROR;
+	}
+}
+
+MX_EXPORT long
+mx_condition_variable_signal( MX_CONDITION_VARIABLE *cv )
+{
+	if ( cv == (MX_CONDITION_VARIABLE *) NULL )
+		return MXE_NULL_ARGUMENT;
+
+	if ( pthread_cond_signal( (pthread_cond_t *) cv->cv_ptr ) != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_condition_variable_broadcast( MX_CONDITION_VARIABLE *cv )
+{
+	if ( cv == (MX_CONDITION_VARIABLE *) NULL )
+		return MXE_NULL_ARGUMENT;
+
+	if ( pthread_cond_broadcast( (pthread_cond_t *) cv->cv_ptr ) != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	return MXE_SUCCESS;
+}
+
+#else
+
+#error MX condition variable functions have not been defined for this platform.
+
+#endif
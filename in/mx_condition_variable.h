@@ -0,0 +1,63 @@
+/*
+ * Name:    mx_condition_variable.h
+ *
+ * Purpose: Header file for MX condition variable functions.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_CONDITION_VARIABLE_H__
+#define __MX_CONDITION_VARIABLE_H__
+
+#include "mx_util.h"
+#include "mx_mutex.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	void *cv_ptr;
+	void *application_ptr;
+} MX_CONDITION_VARIABLE;
+
+MX_API mx_status_type mx_condition_variable_create(
+					MX_CONDITION_VARIABLE **cv );
+
+MX_API mx_status_type mx_condition_variable_destroy(
+					MX_CONDITION_VARIABLE *cv );
+
+/* The wait functions must be called with 'mutex' locked, and return
+ * with it locked again.  Like the mutex lock functions, they return
+ * MXE_SUCCESS on success.  mx_condition_variable_timed_wait() returns
+ * MXE_TIMED_OUT if the condition variable was not signalled within
+ * 'max_seconds_to_wait'.  Spurious wakeups are possible, so callers
+ * must always recheck the condition they are waiting for.
+ */
+
+MX_API long mx_condition_variable_wait( MX_CONDITION_VARIABLE *cv,
+					MX_MUTEX *mutex );
+
+MX_API long mx_condition_variable_timed_wait( MX_CONDITION_VARIABLE *cv,
+					MX_MUTEX *mutex,
+					double max_seconds_to_wait );
+
+MX_API long mx_condition_variable_signal( MX_CONDITION_VARIABLE *cv );
+
+MX_API long mx_condition_variable_broadcast( MX_CONDITION_VARIABLE *cv );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_CONDITION_VARIABLE_H__ */
@@ -0,0 +1,1303 @@
+/*
+ * Name:    mx_database_image.c
+ *
+ * Purpose: Precompiled binary images of MX databases.
+ *
+ *          Reading a text database file requires every field of every
+ *          record to be tokenized and parsed again each time a server
+ *          starts.  A database image saves the field values in their
+ *          binary form, with record references replaced by indexes,
+ *          so that loading a database only has to create the records,
+ *          copy the values in, and patch the record pointers.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_private_version.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_hash_table.h"
+#include "mx_database_image.h"
+
+#if defined(OS_LINUX) || defined(OS_MACOSX) || defined(OS_BSD) \
+	|| defined(OS_SOLARIS) || defined(OS_QNX) || defined(OS_CYGWIN)
+#  define MX_DATABASE_IMAGE_USE_MMAP	TRUE
+#else
+#  define MX_DATABASE_IMAGE_USE_MMAP	FALSE
+#endif
+
+#if MX_DATABASE_IMAGE_USE_MMAP
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#endif
+
+#define MX_DATABASE_IMAGE_PAD(n) \
+	( ( (n) + (MX_DATABASE_IMAGE_ALIGNMENT - 1) ) \
+		& ~((size_t) MX_DATABASE_IMAGE_ALIGNMENT - 1) )
+
+typedef struct {
+	char *base;
+	size_t size;
+	mx_bool_type mapped;
+} MX_DATABASE_IMAGE_MAP;
+
+/*------------------------------------------------------------------------*/
+
+static size_t
+mx_database_image_datatype_size( long datatype )
+{
+	switch( datatype ) {
+	case MXFT_STRING:
+	case MXFT_CHAR:
+	case MXFT_UCHAR:
+		return sizeof(char);
+	case MXFT_SHORT:
+	case MXFT_USHORT:
+		return sizeof(short);
+	case MXFT_BOOL:
+		return sizeof(mx_bool_type);
+	case MXFT_LONG:
+	case MXFT_RECORDTYPE:
+		return sizeof(long);
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		return sizeof(unsigned long);
+	case MXFT_FLOAT:
+		return sizeof(float);
+	case MXFT_DOUBLE:
+		return sizeof(double);
+	case MXFT_INT64:
+	case MXFT_UINT64:
+		return sizeof(int64_t);
+	case MXFT_RECORD:
+		return sizeof(MX_RECORD *);
+	default:
+		return 0;
+	}
+}
+
+/* Returns the size in memory of one element of a field, which for
+ * record fields is the size of a record pointer, or 0 if the datatype
+ * cannot be saved.
+ */
+
+static size_t
+mx_database_image_element_size( MX_RECORD_FIELD *field )
+{
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+
+	descriptor = field->descriptor;
+
+	if ( ( descriptor->num_dimensions > 0 )
+	  && ( descriptor->datatype != MXFT_RECORD )
+	  && ( descriptor->data_element_size[0] != 0 ) )
+	{
+		return descriptor->data_element_size[0];
+	}
+
+	return mx_database_image_datatype_size( descriptor->datatype );
+}
+
+/* Figure out where the value of a field is stored, how many elements
+ * it has, and how big each element is.  For varargs fields, the value
+ * pointer is NULL if the array has not been allocated yet.
+ */
+
+static mx_status_type
+mx_database_image_get_field_layout( MX_RECORD *record,
+				MX_RECORD_FIELD *field,
+				void **value_ptr,
+				long *num_elements,
+				size_t *element_size )
+{
+	static const char fname[] = "mx_database_image_get_field_layout()";
+
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	long i;
+
+	descriptor = field->descriptor;
+
+	*element_size = mx_database_image_element_size( field );
+
+	if ( ( *element_size == 0 ) || ( field->data_pointer == NULL ) ) {
+		return mx_error( MXE_UNSUPPORTED, fname,
+		"Field '%s.%s' of datatype %ld cannot be saved "
+		"in a database image.", record->name, descriptor->name,
+			descriptor->datatype );
+	}
+
+	if ( descriptor->num_dimensions == 0 ) {
+		*value_ptr = field->data_pointer;
+		*num_elements = 1;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	if ( descriptor->flags & MXFF_VARARGS ) {
+		if ( descriptor->num_dimensions > 1 ) {
+			return mx_error( MXE_UNSUPPORTED, fname,
+			"Multidimensional varargs field '%s.%s' cannot be "
+			"saved in a database image.",
+				record->name, descriptor->name );
+		}
+
+		*value_ptr = *((void **) field->data_pointer);
+
+		/* If the array has not been allocated yet, the dimension
+		 * may still be an unresolved varargs cookie.
+		 */
+
+		if ( *value_ptr == NULL ) {
+			*num_elements = 0;
+		} else {
+			*num_elements = field->dimension[0];
+		}
+	} else {
+		*value_ptr = field->data_pointer;
+		*num_elements = 1;
+
+		for ( i = 0; i < descriptor->num_dimensions; i++ ) {
+			*num_elements *= field->dimension[i];
+		}
+	}
+
+	if ( *num_elements < 0 ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field '%s.%s' has a negative number of elements (%ld).",
+			record->name, descriptor->name, *num_elements );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_bool_type
+mx_database_image_record_is_saved( MX_RECORD *record )
+{
+	if ( record->mx_superclass == MXR_LIST_HEAD )
+		return FALSE;
+
+	/* Records created internally by other records are recreated
+	 * by their parent records, so they are not saved.
+	 */
+
+	if ( record->allocated_by != (MX_RECORD *) NULL )
+		return FALSE;
+
+	return TRUE;
+}
+
+/*========================================================================*/
+
+static mx_status_type
+mx_database_image_write_bytes( FILE *file,
+				const char *image_filename,
+				const void *buffer,
+				size_t num_bytes )
+{
+	static const char fname[] = "mx_database_image_write_bytes()";
+
+	static const char padding[MX_DATABASE_IMAGE_ALIGNMENT] = { 0 };
+
+	size_t padded_bytes;
+
+	if ( num_bytes > 0 ) {
+		if ( fwrite( buffer, 1, num_bytes, file ) != num_bytes ) {
+			return mx_error( MXE_FILE_IO_ERROR, fname,
+			"Error writing to database image '%s'.",
+				image_filename );
+		}
+	}
+
+	padded_bytes = MX_DATABASE_IMAGE_PAD( num_bytes ) - num_bytes;
+
+	if ( padded_bytes > 0 ) {
+		if ( fwrite( padding, 1, padded_bytes, file ) != padded_bytes ) {
+			return mx_error( MXE_FILE_IO_ERROR, fname,
+			"Error writing to database image '%s'.",
+				image_filename );
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_database_image_write_field( FILE *file,
+				const char *image_filename,
+				MX_RECORD *record,
+				long field_index,
+				MX_HASH_TABLE *record_index_table,
+				MX_RECORD **record_array )
+{
+	static const char fname[] = "mx_database_image_write_field()";
+
+	MX_RECORD_FIELD *field;
+	MX_DATABASE_IMAGE_FIELD image_field;
+	MX_RECORD **record_ptr_array, *referenced_record;
+	long *index_array;
+	void *value_ptr;
+	long i, num_elements;
+	unsigned long record_index;
+	size_t element_size;
+	mx_status_type mx_status;
+
+	field = &(record->record_field_array[field_index]);
+
+	mx_status = mx_database_image_get_field_layout( record, field,
+				&value_ptr, &num_elements, &element_size );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( value_ptr == NULL )
+		num_elements = 0;
+
+	memset( &image_field, 0, sizeof(image_field) );
+
+	image_field.field_index = field_index;
+	image_field.datatype = field->descriptor->datatype;
+	image_field.num_elements = num_elements;
+
+	if ( field->descriptor->datatype != MXFT_RECORD ) {
+		image_field.num_bytes = (long) ( num_elements * element_size );
+
+		mx_status = mx_database_image_write_bytes( file, image_filename,
+					&image_field, sizeof(image_field) );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		return mx_database_image_write_bytes( file, image_filename,
+					value_ptr, image_field.num_bytes );
+	}
+
+	/* Record pointers are replaced by their index in the image. */
+
+	image_field.num_bytes = (long) ( num_elements * sizeof(long) );
+
+	index_array = (long *) malloc( (num_elements + 1) * sizeof(long) );
+
+	if ( index_array == (long *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %ld element "
+		"record index array for field '%s.%s'.",
+			num_elements, record->name, field->descriptor->name );
+	}
+
+	record_ptr_array = (MX_RECORD **) value_ptr;
+
+	for ( i = 0; i < num_elements; i++ ) {
+		referenced_record = record_ptr_array[i];
+
+		if ( referenced_record == (MX_RECORD *) NULL ) {
+			index_array[i] = -1;
+			continue;
+		}
+
+		record_index = (unsigned long) (uintptr_t)
+			mx_hash_table_lookup( record_index_table,
+						referenced_record->name );
+
+		if ( ( record_index == 0 )
+		  || ( record_array[record_index - 1] != referenced_record ) )
+		{
+			mx_free( index_array );
+
+			return mx_error( MXE_UNSUPPORTED, fname,
+			"Field '%s.%s' refers to record '%s' which is not "
+			"saved in the database image.",
+				record->name, field->descriptor->name,
+				referenced_record->name );
+		}
+
+		index_array[i] = (long) ( record_index - 1 );
+	}
+
+	mx_status = mx_database_image_write_bytes( file, image_filename,
+					&image_field, sizeof(image_field) );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_database_image_write_bytes( file,
+			image_filename, index_array, image_field.num_bytes );
+	}
+
+	mx_free( index_array );
+
+	return mx_status;
+}
+
+static mx_status_type
+mx_database_image_write_records( FILE *file,
+				const char *image_filename,
+				unsigned long num_records,
+				MX_RECORD **record_array,
+				MX_HASH_TABLE *record_index_table )
+{
+	static const char fname[] = "mx_database_image_write_records()";
+
+	MX_RECORD *record;
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	MX_DATABASE_IMAGE_RECORD image_record;
+	unsigned long n;
+	long i;
+	mx_status_type mx_status;
+
+	for ( n = 0; n < num_records; n++ ) {
+		record = record_array[n];
+
+		memset( &image_record, 0, sizeof(image_record) );
+
+		image_record.mx_superclass = record->mx_superclass;
+		image_record.mx_class = record->mx_class;
+		image_record.mx_type = record->mx_type;
+		image_record.num_record_fields = record->num_record_fields;
+
+		strlcpy( image_record.name, record->name,
+				sizeof(image_record.name) );
+
+		for ( i = 0; i < record->num_record_fields; i++ ) {
+			descriptor = record->record_field_array[i].descriptor;
+
+			if ( descriptor->flags & MXFF_IN_DESCRIPTION ) {
+				image_record.num_image_fields++;
+			} else
+			if ( ( descriptor->flags & MXFF_VARARGS )
+			  && ( descriptor->num_dimensions > 1 ) )
+			{
+				/* The loader could not allocate it. */
+
+				return mx_error( MXE_UNSUPPORTED, fname,
+				"Multidimensional varargs field '%s.%s' "
+				"cannot be recreated from a database image.",
+					record->name, descriptor->name );
+			}
+		}
+
+		mx_status = mx_database_image_write_bytes( file, image_filename,
+					&image_record, sizeof(image_record) );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		for ( i = 0; i < record->num_record_fields; i++ ) {
+			if ( ( record->record_field_array[i].descriptor->flags
+						& MXFF_IN_DESCRIPTION ) == 0 )
+			{
+				continue;
+			}
+
+			mx_status = mx_database_image_write_field( file,
+					image_filename, record, i,
+					record_index_table, record_array );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_write_database_image( MX_RECORD *record_list,
+			const char *image_filename,
+			const char *source_filename )
+{
+	static const char fname[] = "mx_write_database_image()";
+
+	MX_RECORD *list_head_record, *current_record;
+	MX_RECORD **record_array;
+	MX_HASH_TABLE *record_index_table;
+	MX_DATABASE_IMAGE_HEADER header;
+	struct stat stat_struct;
+	unsigned long num_records;
+	long image_size;
+	FILE *file;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+	if ( image_filename == (const char *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The image filename pointer passed was NULL." );
+	}
+
+	memset( &header, 0, sizeof(header) );
+
+	strlcpy( header.magic, MX_DATABASE_IMAGE_MAGIC, sizeof(header.magic) );
+
+	header.image_version = MX_DATABASE_IMAGE_VERSION;
+	header.byte_order = MX_DATABASE_IMAGE_BYTE_ORDER;
+	header.sizeof_long = sizeof(long);
+	header.sizeof_double = sizeof(double);
+	header.header_size = sizeof(MX_DATABASE_IMAGE_HEADER);
+	header.mx_version = MX_VERSION;
+
+	if ( source_filename != (const char *) NULL ) {
+		if ( stat( source_filename, &stat_struct ) != 0 ) {
+			return mx_error( MXE_FILE_IO_ERROR, fname,
+			"Cannot get the status of database file '%s'.",
+				source_filename );
+		}
+
+		header.source_file_size = (int64_t) stat_struct.st_size;
+		header.source_file_mtime = (int64_t) stat_struct.st_mtime;
+	}
+
+	/* Make a list of the records to be saved, along with a table
+	 * that maps record names to their index in the image.  The
+	 * indexes are stored offset by 1, since the hash table uses
+	 * NULL to mean 'not found'.
+	 */
+
+	list_head_record = record_list->list_head;
+
+	num_records = 0;
+	current_record = list_head_record->next_record;
+
+	while ( current_record != list_head_record ) {
+		if ( mx_database_image_record_is_saved( current_record ) )
+			num_records++;
+
+		current_record = current_record->next_record;
+	}
+
+	record_array = (MX_RECORD **)
+			malloc( (num_records + 1) * sizeof(MX_RECORD *) );
+
+	if ( record_array == (MX_RECORD **) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %lu element "
+		"record array.", num_records );
+	}
+
+	mx_status = mx_hash_table_create( &record_index_table, num_records );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_free( record_array );
+		return mx_status;
+	}
+
+	num_records = 0;
+	current_record = list_head_record->next_record;
+
+	while ( current_record != list_head_record ) {
+		if ( mx_database_image_record_is_saved( current_record ) ) {
+			record_array[num_records] = current_record;
+
+			num_records++;
+
+			if ( mx_hash_table_lookup( record_index_table,
+						current_record->name ) == NULL )
+			{
+				mx_status = mx_hash_table_insert(
+					record_index_table,
+					current_record->name,
+					(void *) (uintptr_t) num_records );
+
+				if ( mx_status.code != MXE_SUCCESS )
+					break;
+			}
+		}
+
+		current_record = current_record->next_record;
+	}
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_hash_table_destroy( record_index_table );
+		mx_free( record_array );
+		return mx_status;
+	}
+
+	header.num_records = (uint32_t) num_records;
+
+	file = fopen( image_filename, "wb" );
+
+	if ( file == (FILE *) NULL ) {
+		mx_hash_table_destroy( record_index_table );
+		mx_free( record_array );
+
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot open database image '%s' for writing.",
+			image_filename );
+	}
+
+	/* The header is written twice.  The first time is just to
+	 * reserve space for it, since we do not know the size of the
+	 * image until all of the records have been written.
+	 */
+
+	mx_status = mx_database_image_write_bytes( file, image_filename,
+						&header, sizeof(header) );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_database_image_write_records( file,
+				image_filename, num_records, record_array,
+				record_index_table );
+	}
+
+	mx_hash_table_destroy( record_index_table );
+	mx_free( record_array );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		image_size = ftell( file );
+
+		header.image_size = (int64_t) image_size;
+
+		if ( ( image_size < 0 ) || ( fseek( file, 0L, SEEK_SET ) != 0 ) )
+		{
+			mx_status = mx_error( MXE_FILE_IO_ERROR, fname,
+			"Cannot seek in database image '%s'.", image_filename );
+		} else {
+			mx_status = mx_database_image_write_bytes( file,
+				image_filename, &header, sizeof(header) );
+		}
+	}
+
+	if ( fclose( file ) != 0 ) {
+		if ( mx_status.code == MXE_SUCCESS ) {
+			mx_status = mx_error( MXE_FILE_IO_ERROR, fname,
+			"Error closing database image '%s'.", image_filename );
+		}
+	}
+
+	/* Do not leave a partially written image behind. */
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		(void) remove( image_filename );
+	}
+
+	return mx_status;
+}
+
+/*========================================================================*/
+
+static mx_status_type
+mx_database_image_map( const char *image_filename,
+			MX_DATABASE_IMAGE_MAP *map )
+{
+	static const char fname[] = "mx_database_image_map()";
+
+#if MX_DATABASE_IMAGE_USE_MMAP
+	struct stat stat_struct;
+	void *base;
+	int fd;
+
+	fd = open( image_filename, O_RDONLY );
+
+	if ( fd < 0 ) {
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot open database image '%s'.", image_filename );
+	}
+
+	if ( fstat( fd, &stat_struct ) != 0 ) {
+		close( fd );
+
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot get the size of database image '%s'.", image_filename );
+	}
+
+	map->size = (size_t) stat_struct.st_size;
+
+	if ( map->size < sizeof(MX_DATABASE_IMAGE_HEADER) ) {
+		close( fd );
+
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Database image '%s' is too short to be valid.",
+			image_filename );
+	}
+
+	base = mmap( NULL, map->size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+	close( fd );
+
+	if ( base == MAP_FAILED ) {
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot map database image '%s' into memory.", image_filename );
+	}
+
+	map->base = (char *) base;
+	map->mapped = TRUE;
+
+	return MX_SUCCESSFUL_RESULT;
+#else
+	FILE *file;
+	long file_size;
+
+	file = fopen( image_filename, "rb" );
+
+	if ( file == (FILE *) NULL ) {
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot open database image '%s'.", image_filename );
+	}
+
+	if ( ( fseek( file, 0L, SEEK_END ) != 0 )
+	  || ( ( file_size = ftell( file ) ) < 0 )
+	  || ( fseek( file, 0L, SEEK_SET ) != 0 ) )
+	{
+		fclose( file );
+
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot get the size of database image '%s'.", image_filename );
+	}
+
+	map->size = (size_t) file_size;
+
+	if ( map->size < sizeof(MX_DATABASE_IMAGE_HEADER) ) {
+		fclose( file );
+
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Database image '%s' is too short to be valid.",
+			image_filename );
+	}
+
+	map->base = (char *) malloc( map->size );
+
+	if ( map->base == (char *) NULL ) {
+		fclose( file );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to read %lu byte database image '%s'.",
+			(unsigned long) map->size, image_filename );
+	}
+
+	if ( fread( map->base, 1, map->size, file ) != map->size ) {
+		fclose( file );
+		mx_free( map->base );
+
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Error reading database image '%s'.", image_filename );
+	}
+
+	fclose( file );
+
+	map->mapped = FALSE;
+
+	return MX_SUCCESSFUL_RESULT;
+#endif
+}
+
+static void
+mx_database_image_unmap( MX_DATABASE_IMAGE_MAP *map )
+{
+	if ( map->base == (char *) NULL )
+		return;
+
+#if MX_DATABASE_IMAGE_USE_MMAP
+	if ( map->mapped ) {
+		munmap( map->base, map->size );
+		map->base = NULL;
+		return;
+	}
+#endif
+	mx_free( map->base );
+}
+
+static mx_status_type
+mx_database_image_check_header( MX_DATABASE_IMAGE_HEADER *header,
+				size_t image_size,
+				const char *image_filename,
+				const char *source_filename )
+{
+	static const char fname[] = "mx_database_image_check_header()";
+
+	struct stat stat_struct;
+
+	if ( strncmp( header->magic, MX_DATABASE_IMAGE_MAGIC,
+				sizeof(header->magic) ) != 0 )
+	{
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"File '%s' is not an MX database image.", image_filename );
+	}
+
+	if ( ( header->image_version != MX_DATABASE_IMAGE_VERSION )
+	  || ( header->byte_order != MX_DATABASE_IMAGE_BYTE_ORDER )
+	  || ( header->sizeof_long != sizeof(long) )
+	  || ( header->sizeof_double != sizeof(double) )
+	  || ( header->header_size != sizeof(MX_DATABASE_IMAGE_HEADER) )
+	  || ( header->mx_version != MX_VERSION ) )
+	{
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Database image '%s' was written by a different version "
+		"of MX or on a different kind of computer.", image_filename );
+	}
+
+	if ( header->image_size != (int64_t) image_size ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Database image '%s' is %lu bytes long, but its header "
+		"says that it should be %ld bytes long.", image_filename,
+			(unsigned long) image_size, (long) header->image_size );
+	}
+
+	if ( source_filename == (const char *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( stat( source_filename, &stat_struct ) != 0 ) {
+		return mx_error( MXE_FILE_IO_ERROR, fname,
+		"Cannot get the status of database file '%s'.",
+			source_filename );
+	}
+
+	if ( ( header->source_file_size != (int64_t) stat_struct.st_size )
+	  || ( header->source_file_mtime != (int64_t) stat_struct.st_mtime ) )
+	{
+		return mx_error( MXE_NOT_VALID_FOR_CURRENT_STATE, fname,
+		"Database image '%s' is out of date with respect to "
+		"database file '%s'.", image_filename, source_filename );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_status_type
+mx_database_image_create_record( MX_RECORD *record_list,
+				MX_DATABASE_IMAGE_RECORD *image_record,
+				MX_RECORD **created_record )
+{
+	static const char fname[] = "mx_database_image_create_record()";
+
+	MX_DRIVER *driver;
+	MX_RECORD *record;
+	MX_RECORD_FUNCTION_LIST *fl_ptr;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	MX_RECORD_FIELD *field;
+	char record_name[MXU_RECORD_NAME_LENGTH+1];
+	long i;
+	mx_status_type mx_status;
+
+	strlcpy( record_name, image_record->name, sizeof(record_name) );
+
+	if ( mx_get_record( record_list, record_name ) != (MX_RECORD *) NULL )
+	{
+		return mx_error( MXE_ALREADY_EXISTS, fname,
+		"A record named '%s' already exists in the database.",
+			record_name );
+	}
+
+	driver = mx_get_driver_by_type( image_record->mx_type );
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"No driver was found for type %ld used by record '%s'.",
+			image_record->mx_type, record_name );
+	}
+
+	if ( ( driver->num_record_fields == (long *) NULL )
+	  || ( *(driver->num_record_fields) != image_record->num_record_fields )
+	  || ( driver->record_field_defaults_ptr == NULL ) )
+	{
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"The field list of driver '%s' used by record '%s' does not "
+		"match the database image.", driver->name, record_name );
+	}
+
+	fl_ptr = (MX_RECORD_FUNCTION_LIST *) driver->record_function_list;
+
+	if ( ( fl_ptr == (MX_RECORD_FUNCTION_LIST *) NULL )
+	  || ( fl_ptr->create_record_structures == NULL ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Driver '%s' has no create_record_structures function.",
+			driver->name );
+	}
+
+	record = mx_create_record();
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to create record '%s'.",
+			record_name );
+	}
+
+	/* From here on, the record is returned even if setting it up
+	 * fails, so that the caller can delete it.
+	 */
+
+	*created_record = record;
+
+	record->mx_superclass = image_record->mx_superclass;
+	record->mx_class = image_record->mx_class;
+	record->mx_type = image_record->mx_type;
+
+	strlcpy( record->name, record_name, sizeof(record->name) );
+
+	record->list_head = record_list->list_head;
+
+	record->record_function_list = fl_ptr;
+	record->superclass_specific_function_list =
+				driver->superclass_specific_function_list;
+	record->class_specific_function_list =
+				driver->class_specific_function_list;
+
+	mx_status = (*fl_ptr->create_record_structures)( record );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	record->num_record_fields = image_record->num_record_fields;
+
+	record->record_field_array = (MX_RECORD_FIELD *) mx_record_allocate(
+		record, record->num_record_fields * sizeof(MX_RECORD_FIELD) );
+
+	if ( record->record_field_array == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the field array "
+		"for record '%s'.", record_name );
+	}
+
+	defaults_array = *(driver->record_field_defaults_ptr);
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		field = &(record->record_field_array[i]);
+
+		mx_status = mx_share_defaults_with_record_field( field,
+							&defaults_array[i] );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		field->record = record;
+
+		mx_status = mx_construct_ptr_to_field_data( record,
+				&defaults_array[i], &(field->data_pointer) );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	/* Add the record to the end of the record list. */
+
+	mx_status = mx_insert_before_record( record_list->list_head, record );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_status = mx_record_name_index_add( record );
+
+	return mx_status;
+}
+
+/* Deletes the records made by an image load that failed, newest first,
+ * so that the caller can fall back to mx_read_database_file() without
+ * finding the same names already in the database.
+ */
+
+static void
+mx_database_image_delete_records( unsigned long num_records,
+				MX_RECORD **record_array )
+{
+	unsigned long n;
+
+	for ( n = num_records; n > 0; n-- ) {
+		if ( record_array[n-1] == (MX_RECORD *) NULL )
+			continue;
+
+		(void) mx_record_name_index_delete( record_array[n-1] );
+
+		(void) mx_delete_record( record_array[n-1] );
+
+		record_array[n-1] = NULL;
+	}
+}
+
+/* The arrays of varargs fields are allocated just as they are when a
+ * record description is parsed.  The dimension is first resolved from
+ * the fields that it refers to, using the driver's varargs plan, and
+ * then a zeroed array of that length is allocated.  Only 1-dimensional
+ * varargs fields are ever found in a database image.
+ */
+
+static mx_status_type
+mx_database_image_allocate_varargs( MX_RECORD *record,
+				long field_index,
+				mx_bool_type allow_forward_references )
+{
+	static const char fname[] = "mx_database_image_allocate_varargs()";
+
+	MX_RECORD_FIELD *field;
+	void *array_ptr;
+	long num_elements;
+	size_t element_size;
+	mx_status_type mx_status;
+
+	field = &(record->record_field_array[field_index]);
+
+	if ( ( field->descriptor->num_dimensions != 1 )
+	  || ( field->data_pointer == NULL ) )
+	{
+		return mx_error( MXE_UNSUPPORTED, fname,
+		"Varargs field '%s.%s' cannot be recreated from "
+		"a database image.", record->name, field->descriptor->name );
+	}
+
+	mx_status = mx_resolve_varargs_field( record, field_index,
+						allow_forward_references );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	num_elements = field->dimension[0];
+
+	element_size = mx_database_image_element_size( field );
+
+	if ( ( num_elements < 0 ) || ( element_size == 0 ) ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Varargs field '%s.%s' has an invalid length (%ld) or "
+		"datatype (%ld).", record->name, field->descriptor->name,
+			num_elements, field->descriptor->datatype );
+	}
+
+	array_ptr = calloc( num_elements + 1, element_size );
+
+	if ( array_ptr == NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %ld element "
+		"array for field '%s.%s'.", num_elements,
+			record->name, field->descriptor->name );
+	}
+
+	*((void **) field->data_pointer) = array_ptr;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Varargs fields that are not in the record description do not appear
+ * in the image, but they still need their arrays.  By the time this is
+ * called, all of the fields in the image have been loaded.
+ */
+
+static mx_status_type
+mx_database_image_allocate_other_varargs( MX_RECORD *record )
+{
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	long i;
+	mx_status_type mx_status;
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		descriptor = record->record_field_array[i].descriptor;
+
+		if ( ( ( descriptor->flags & MXFF_VARARGS ) == 0 )
+		  || ( descriptor->flags & MXFF_IN_DESCRIPTION ) )
+		{
+			continue;
+		}
+
+		mx_status = mx_database_image_allocate_varargs( record,
+								i, TRUE );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_database_image_load_field( MX_RECORD *record,
+				MX_DATABASE_IMAGE_FIELD *image_field,
+				char *field_data,
+				unsigned long num_records,
+				MX_RECORD **record_array )
+{
+	static const char fname[] = "mx_database_image_load_field()";
+
+	MX_RECORD_FIELD *field;
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	MX_RECORD **record_ptr_array;
+	void *value_ptr;
+	long i, num_elements, record_index;
+	size_t element_size, stored_element_size;
+	mx_status_type mx_status;
+
+	if ( ( image_field->field_index < 0 )
+	  || ( image_field->field_index >= record->num_record_fields ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field index %ld for record '%s' is outside the allowed "
+		"range of 0 to %ld.", image_field->field_index,
+			record->name, record->num_record_fields - 1 );
+	}
+
+	field = &(record->record_field_array[image_field->field_index]);
+
+	descriptor = field->descriptor;
+
+	if ( descriptor->datatype != image_field->datatype ) {
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"The datatype %ld of field '%s.%s' does not match the "
+		"datatype %ld in the database image.",
+			descriptor->datatype, record->name, descriptor->name,
+			image_field->datatype );
+	}
+
+	mx_status = mx_database_image_get_field_layout( record, field,
+				&value_ptr, &num_elements, &element_size );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( descriptor->datatype == MXFT_RECORD ) {
+		stored_element_size = sizeof(long);
+	} else {
+		stored_element_size = element_size;
+	}
+
+	if ( ( image_field->num_elements < 0 )
+	  || ( (size_t) image_field->num_bytes
+		!= image_field->num_elements * stored_element_size ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The size of field '%s.%s' in the database image is invalid.",
+			record->name, descriptor->name );
+	}
+
+	if ( ( descriptor->num_dimensions > 0 )
+	  && ( descriptor->flags & MXFF_VARARGS ) )
+	{
+		/* As in a record description, the length of a varargs
+		 * field may only depend on the fields that come before it.
+		 */
+
+		mx_status = mx_database_image_allocate_varargs( record,
+					image_field->field_index, FALSE );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		value_ptr = *((void **) field->data_pointer);
+
+		num_elements = field->dimension[0];
+	}
+
+	if ( num_elements != image_field->num_elements ) {
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s.%s' has %ld elements, but the database image "
+		"has %ld elements for it.", record->name, descriptor->name,
+			num_elements, image_field->num_elements );
+	}
+
+	if ( descriptor->datatype != MXFT_RECORD ) {
+		memcpy( value_ptr, field_data, image_field->num_bytes );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	record_ptr_array = (MX_RECORD **) value_ptr;
+
+	for ( i = 0; i < num_elements; i++ ) {
+		memcpy( &record_index, field_data + i * sizeof(long),
+							sizeof(long) );
+
+		if ( record_index < 0 ) {
+			record_ptr_array[i] = NULL;
+		} else
+		if ( (unsigned long) record_index < num_records ) {
+			record_ptr_array[i] = record_array[record_index];
+		} else {
+			return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+			"Field '%s.%s' refers to record %ld, but the database "
+			"image only has %lu records.", record->name,
+				descriptor->name, record_index, num_records );
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_read_database_image( MX_RECORD *record_list,
+			const char *image_filename,
+			const char *source_filename )
+{
+	static const char fname[] = "mx_read_database_image()";
+
+	MX_DATABASE_IMAGE_MAP map;
+	MX_DATABASE_IMAGE_HEADER *header;
+	MX_DATABASE_IMAGE_RECORD *image_record;
+	MX_DATABASE_IMAGE_FIELD *image_field;
+	MX_RECORD **record_array;
+	size_t *field_offset_array;
+	size_t offset, padded_bytes;
+	unsigned long n, num_records;
+	long i;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+	if ( image_filename == (const char *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The image filename pointer passed was NULL." );
+	}
+
+	memset( &map, 0, sizeof(map) );
+
+	mx_status = mx_database_image_map( image_filename, &map );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	header = (MX_DATABASE_IMAGE_HEADER *) map.base;
+
+	mx_status = mx_database_image_check_header( header, map.size,
+					image_filename, source_filename );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_database_image_unmap( &map );
+		return mx_status;
+	}
+
+	num_records = header->num_records;
+
+	record_array = (MX_RECORD **)
+			calloc( num_records + 1, sizeof(MX_RECORD *) );
+
+	field_offset_array = (size_t *)
+			malloc( (num_records + 1) * sizeof(size_t) );
+
+	if ( ( record_array == (MX_RECORD **) NULL )
+	  || ( field_offset_array == (size_t *) NULL ) )
+	{
+		mx_free( record_array );
+		mx_free( field_offset_array );
+		mx_database_image_unmap( &map );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate arrays for %lu records.",
+			num_records );
+	}
+
+	/* Pass 1: Create all of the records, so that record references
+	 * in pass 2 can be resolved regardless of the record order.
+	 */
+
+	offset = MX_DATABASE_IMAGE_PAD( sizeof(MX_DATABASE_IMAGE_HEADER) );
+
+	for ( n = 0; n < num_records; n++ ) {
+
+		if ( ( offset + sizeof(MX_DATABASE_IMAGE_RECORD) ) > map.size )
+			break;
+
+		image_record = (MX_DATABASE_IMAGE_RECORD *)(map.base + offset);
+
+		offset += MX_DATABASE_IMAGE_PAD(
+				sizeof(MX_DATABASE_IMAGE_RECORD) );
+
+		field_offset_array[n] = offset;
+
+		for ( i = 0; i < image_record->num_image_fields; i++ ) {
+			if ( ( offset + sizeof(MX_DATABASE_IMAGE_FIELD) )
+							> map.size )
+			{
+				break;
+			}
+
+			image_field = (MX_DATABASE_IMAGE_FIELD *)
+						(map.base + offset);
+
+			padded_bytes = MX_DATABASE_IMAGE_PAD(
+					(size_t) image_field->num_bytes );
+
+			offset += MX_DATABASE_IMAGE_PAD(
+					sizeof(MX_DATABASE_IMAGE_FIELD) )
+					+ padded_bytes;
+
+			if ( ( image_field->num_bytes < 0 )
+			  || ( offset > map.size ) )
+			{
+				break;
+			}
+		}
+
+		if ( i < image_record->num_image_fields )
+			break;
+
+		mx_status = mx_database_image_create_record( record_list,
+					image_record, &record_array[n] );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			break;
+	}
+
+	if ( ( mx_status.code == MXE_SUCCESS ) && ( n < num_records ) ) {
+		mx_status = mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Database image '%s' is truncated or corrupted at offset %lu.",
+			image_filename, (unsigned long) offset );
+	}
+
+	/* Pass 2: Copy in the field values and patch the record pointers. */
+
+	for ( n = 0; ( mx_status.code == MXE_SUCCESS ) && ( n < num_records );
+									n++ )
+	{
+		image_record = (MX_DATABASE_IMAGE_RECORD *)
+			( map.base + field_offset_array[n]
+			- MX_DATABASE_IMAGE_PAD(
+				sizeof(MX_DATABASE_IMAGE_RECORD) ) );
+
+		offset = field_offset_array[n];
+
+		for ( i = 0; i < image_record->num_image_fields; i++ ) {
+			image_field = (MX_DATABASE_IMAGE_FIELD *)
+						(map.base + offset);
+
+			offset += MX_DATABASE_IMAGE_PAD(
+					sizeof(MX_DATABASE_IMAGE_FIELD) );
+
+			mx_status = mx_database_image_load_field(
+					record_array[n], image_field,
+					map.base + offset,
+					num_records, record_array );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				break;
+
+			offset += MX_DATABASE_IMAGE_PAD(
+					(size_t) image_field->num_bytes );
+		}
+
+		if ( mx_status.code == MXE_SUCCESS ) {
+			mx_status = mx_database_image_allocate_other_varargs(
+							record_array[n] );
+		}
+	}
+
+	/* The drivers' finish_record_initialization() functions are not
+	 * called here, since mx_finish_database_initialization() does that
+	 * for text databases and image databases alike.
+	 */
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_database_image_delete_records( num_records, record_array );
+	}
+
+	mx_free( record_array );
+	mx_free( field_offset_array );
+
+	mx_database_image_unmap( &map );
+
+	return mx_status;
+}
+
@@ -0,0 +1,116 @@
+/*
+ * Name:    mx_database_image.h
+ *
+ * Purpose: Header file for precompiled binary images of MX databases.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_DATABASE_IMAGE_H__
+#define __MX_DATABASE_IMAGE_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A database image contains the already parsed values of all of the
+ * MXFF_IN_DESCRIPTION fields of the records in an MX database.  Record
+ * references are stored as indexes into the image's own record list.
+ *
+ * The text database file remains the source of truth.  An image is
+ * only usable by the same build of MX on the same kind of machine that
+ * wrote it, and mx_read_database_image() refuses to load an image if
+ * the MX version, the byte order, the size of a long, or the size and
+ * modification time of the source database file do not match.  The
+ * caller should then fall back to mx_read_database_file().
+ *
+ * Only fields with 0 dimensions, 1-dimensional fields, and fixed size
+ * multidimensional fields are supported.  Varargs fields, whether they
+ * are in the description or not, must be 1-dimensional, since their
+ * arrays are allocated by the loader.  mx_write_database_image()
+ * returns MXE_UNSUPPORTED for databases that contain anything else.
+ *
+ * The file layout is an MX_DATABASE_IMAGE_HEADER followed by one
+ * MX_DATABASE_IMAGE_RECORD for each record.  Each record is followed
+ * by its MX_DATABASE_IMAGE_FIELD entries, each of which is followed by
+ * 'num_bytes' of field data padded to a multiple of
+ * MX_DATABASE_IMAGE_ALIGNMENT.
+ */
+
+#define MX_DATABASE_IMAGE_MAGIC		"MXDBIMG"
+#define MX_DATABASE_IMAGE_VERSION	1
+#define MX_DATABASE_IMAGE_BYTE_ORDER	0x01020304
+
+#define MX_DATABASE_IMAGE_ALIGNMENT	8
+
+typedef struct {
+	char magic[8];
+	uint32_t image_version;
+	uint32_t byte_order;
+	uint32_t sizeof_long;
+	uint32_t sizeof_double;
+	uint32_t header_size;
+	uint32_t num_records;
+	int64_t mx_version;
+	int64_t source_file_size;
+	int64_t source_file_mtime;
+	int64_t image_size;
+} MX_DATABASE_IMAGE_HEADER;
+
+typedef struct {
+	long mx_superclass;
+	long mx_class;
+	long mx_type;
+	long num_record_fields;
+	long num_image_fields;
+	char name[MXU_RECORD_NAME_LENGTH+1];
+} MX_DATABASE_IMAGE_RECORD;
+
+typedef struct {
+	long field_index;
+	long datatype;
+	long num_elements;
+	long num_bytes;
+} MX_DATABASE_IMAGE_FIELD;
+
+/* If 'source_filename' is not NULL, the size and modification time of
+ * the source database file are saved in the image.
+ */
+
+MX_API mx_status_type mx_write_database_image( MX_RECORD *record_list,
+					const char *image_filename,
+					const char *source_filename );
+
+/* mx_read_database_image() takes the place of mx_read_database_file().
+ * As with a text database, the dimensions of all varargs fields are
+ * resolved and their arrays allocated, but the drivers' record
+ * initialization is not finished.  The caller must still invoke
+ * mx_finish_database_initialization(), exactly once.  If the image
+ * cannot be loaded, every record that had already been created from
+ * it is deleted again before the error is returned.
+ */
+
+MX_API mx_status_type mx_read_database_image( MX_RECORD *record_list,
+					const char *image_filename,
+					const char *source_filename );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_DATABASE_IMAGE_H__ */
+
@@ -0,0 +1,582 @@
+/*
+ * Name:    mx_dependency_graph.c
+ *
+ * Purpose: Frozen copy of the record dependencies of an MX database.
+ *
+ *          mx_add_parent_dependency() and mx_add_child_dependency()
+ *          grow the parent and child record arrays of each record by
+ *          MXU_DEPENDENCY_ARRAY_BLOCK_LENGTH elements at a time.  That
+ *          is fine while the database is being built, but walking the
+ *          dependencies afterwards means chasing pointers to many small
+ *          separate arrays.  After mx_finish_database_initialization(),
+ *          the dependencies are copied into a few flat arrays in
+ *          compressed sparse row form, which are then used for opening,
+ *          shutting down and resynchronizing records.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_dependency_graph.h"
+
+#define MXS_DEPGRAPH_UNVISITED		0
+#define MXS_DEPGRAPH_IN_PROGRESS	1
+#define MXS_DEPGRAPH_DONE		2
+
+static void
+mx_dependency_graph_free( MX_DEPENDENCY_GRAPH *graph )
+{
+	if ( graph == (MX_DEPENDENCY_GRAPH *) NULL )
+		return;
+
+	mx_free( graph->record_array );
+	mx_free( graph->parent_start_array );
+	mx_free( graph->parent_index_array );
+	mx_free( graph->child_start_array );
+	mx_free( graph->child_index_array );
+	mx_free( graph->topological_order_array );
+
+	free( graph );
+}
+
+/* Fill in parent_start_array and parent_index_array from the parent
+ * record arrays of the records.  Parents that are not in the graph and
+ * repeated parents are left out.
+ */
+
+static mx_status_type
+mx_dependency_graph_add_parents( MX_DEPENDENCY_GRAPH *graph )
+{
+	static const char fname[] = "mx_dependency_graph_add_parents()";
+
+	MX_RECORD *record;
+	long i, j, k, m, parent, num_parents, start;
+
+	graph->parent_start_array = (long *)
+			calloc( graph->num_records + 1, sizeof(long) );
+
+	if ( graph->parent_start_array == (long *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the parent start array "
+		"for %ld records.", graph->num_records );
+	}
+
+	num_parents = 0;
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		num_parents += graph->record_array[i]->num_parent_records;
+	}
+
+	graph->parent_index_array = (long *)
+			malloc( ( num_parents + 1 ) * sizeof(long) );
+
+	if ( graph->parent_index_array == (long *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the parent index array "
+		"for %ld dependencies.", num_parents );
+	}
+
+	k = 0;
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		record = graph->record_array[i];
+
+		start = k;
+
+		for ( j = 0; j < record->num_parent_records; j++ ) {
+			parent = mx_get_dependency_graph_index( graph,
+					record->parent_record_array[j] );
+
+			if ( ( parent < 0 ) || ( parent == i ) )
+				continue;
+
+			/* Records only have a handful of parents, so a
+			 * linear search for duplicates is cheap.
+			 */
+
+			for ( m = start; m < k; m++ ) {
+				if ( graph->parent_index_array[m] == parent )
+					break;
+			}
+
+			if ( m < k )
+				continue;
+
+			graph->parent_index_array[k] = parent;
+			k++;
+		}
+
+		graph->parent_start_array[i + 1] = k;
+	}
+
+	graph->num_dependencies = k;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* The child arrays are the transpose of the parent arrays, so that the
+ * two directions of the graph always agree with each other.
+ */
+
+static mx_status_type
+mx_dependency_graph_add_children( MX_DEPENDENCY_GRAPH *graph )
+{
+	static const char fname[] = "mx_dependency_graph_add_children()";
+
+	long *fill_array;
+	long i, k, parent;
+
+	graph->child_start_array = (long *)
+			calloc( graph->num_records + 1, sizeof(long) );
+
+	graph->child_index_array = (long *)
+		malloc( ( graph->num_dependencies + 1 ) * sizeof(long) );
+
+	fill_array = (long *) calloc( graph->num_records + 1, sizeof(long) );
+
+	if ( ( graph->child_start_array == (long *) NULL )
+	  || ( graph->child_index_array == (long *) NULL )
+	  || ( fill_array == (long *) NULL ) )
+	{
+		mx_free( fill_array );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the child arrays "
+		"for %ld dependencies.", graph->num_dependencies );
+	}
+
+	for ( k = 0; k < graph->num_dependencies; k++ ) {
+		parent = graph->parent_index_array[k];
+
+		graph->child_start_array[parent + 1]++;
+	}
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		graph->child_start_array[i + 1] += graph->child_start_array[i];
+	}
+
+	/* Visiting the children in increasing order keeps each child
+	 * list in record list order.
+	 */
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		for ( k = graph->parent_start_array[i];
+		    k < graph->parent_start_array[i + 1]; k++ )
+		{
+			parent = graph->parent_index_array[k];
+
+			graph->child_index_array[
+				graph->child_start_array[parent]
+					+ fill_array[parent] ] = i;
+
+			fill_array[parent]++;
+		}
+	}
+
+	mx_free( fill_array );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_dependency_graph_sort( MX_DEPENDENCY_GRAPH *graph )
+{
+	static const char fname[] = "mx_dependency_graph_sort()";
+
+	long *stack, *cursor_array;
+	char *state_array;
+	long i, top, node, parent, num_ordered;
+
+	graph->topological_order_array = (long *)
+			malloc( ( graph->num_records + 1 ) * sizeof(long) );
+
+	stack = (long *) malloc( ( graph->num_records + 1 ) * sizeof(long) );
+
+	cursor_array = (long *)
+			malloc( ( graph->num_records + 1 ) * sizeof(long) );
+
+	state_array = (char *) calloc( graph->num_records + 1, sizeof(char) );
+
+	if ( ( graph->topological_order_array == (long *) NULL )
+	  || ( stack == (long *) NULL )
+	  || ( cursor_array == (long *) NULL )
+	  || ( state_array == (char *) NULL ) )
+	{
+		mx_free( stack );
+		mx_free( cursor_array );
+		mx_free( state_array );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to sort %ld records.",
+			graph->num_records );
+	}
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		cursor_array[i] = graph->parent_start_array[i];
+	}
+
+	num_ordered = 0;
+
+	for ( i = 0; i < graph->num_records; i++ ) {
+		if ( state_array[i] != MXS_DEPGRAPH_UNVISITED )
+			continue;
+
+		top = 0;
+		stack[0] = i;
+		state_array[i] = MXS_DEPGRAPH_IN_PROGRESS;
+
+		while ( top >= 0 ) {
+			node = stack[top];
+
+			parent = -1;
+
+			while ( cursor_array[node]
+				< graph->parent_start_array[node + 1] )
+			{
+				parent = graph->parent_index_array[
+							cursor_array[node] ];
+
+				cursor_array[node]++;
+
+				if ( state_array[parent]
+						== MXS_DEPGRAPH_UNVISITED )
+				{
+					break;
+				}
+
+				parent = -1;
+			}
+
+			if ( parent >= 0 ) {
+				state_array[parent] = MXS_DEPGRAPH_IN_PROGRESS;
+
+				stack[++top] = parent;
+			} else {
+				state_array[node] = MXS_DEPGRAPH_DONE;
+
+				graph->topological_order_array[num_ordered]
+								= node;
+				num_ordered++;
+
+				top--;
+			}
+		}
+	}
+
+	mx_free( stack );
+	mx_free( cursor_array );
+	mx_free( state_array );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_freeze_dependency_graph( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_freeze_dependency_graph()";
+
+	MX_LIST_HEAD *list_head;
+	MX_DEPENDENCY_GRAPH *graph;
+	MX_RECORD *list_head_record, *current_record;
+	long n;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list '%s' is NULL.",
+			record_list->name );
+	}
+
+	mx_invalidate_dependency_graph( record_list );
+
+	graph = (MX_DEPENDENCY_GRAPH *)
+			calloc( 1, sizeof(MX_DEPENDENCY_GRAPH) );
+
+	if ( graph == (MX_DEPENDENCY_GRAPH *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_DEPENDENCY_GRAPH structure." );
+	}
+
+	list_head_record = record_list->list_head;
+
+	for ( current_record = list_head_record->next_record;
+	    current_record != list_head_record;
+	    current_record = current_record->next_record )
+	{
+		graph->num_records++;
+	}
+
+	graph->record_array = (MX_RECORD **)
+		malloc( ( graph->num_records + 1 ) * sizeof(MX_RECORD *) );
+
+	if ( graph->record_array == (MX_RECORD **) NULL ) {
+		mx_dependency_graph_free( graph );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the record array "
+		"for %ld records.", graph->num_records );
+	}
+
+	n = 0;
+
+	for ( current_record = list_head_record->next_record;
+	    current_record != list_head_record;
+	    current_record = current_record->next_record )
+	{
+		graph->record_array[n] = current_record;
+
+		current_record->dependency_graph_index = n;
+
+		n++;
+	}
+
+	mx_status = mx_dependency_graph_add_parents( graph );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_dependency_graph_add_children( graph );
+	}
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_dependency_graph_sort( graph );
+	}
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_dependency_graph_free( graph );
+		return mx_status;
+	}
+
+	list_head->dependency_graph = graph;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_invalidate_dependency_graph( MX_RECORD *record_list )
+{
+	MX_LIST_HEAD *list_head;
+
+	if ( record_list == (MX_RECORD *) NULL )
+		return;
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return;
+
+	mx_dependency_graph_free(
+		(MX_DEPENDENCY_GRAPH *) list_head->dependency_graph );
+
+	list_head->dependency_graph = NULL;
+}
+
+MX_EXPORT mx_status_type
+mx_get_dependency_graph( MX_RECORD *record_list,
+			MX_DEPENDENCY_GRAPH **graph )
+{
+	static const char fname[] = "mx_get_dependency_graph()";
+
+	MX_LIST_HEAD *list_head;
+	MX_DEPENDENCY_GRAPH *current_graph;
+	mx_status_type mx_status;
+
+	if ( ( record_list == (MX_RECORD *) NULL )
+	  || ( graph == (MX_DEPENDENCY_GRAPH **) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list '%s' is NULL.",
+			record_list->name );
+	}
+
+	current_graph = (MX_DEPENDENCY_GRAPH *) list_head->dependency_graph;
+
+	if ( current_graph == (MX_DEPENDENCY_GRAPH *) NULL ) {
+		mx_status = mx_freeze_dependency_graph( record_list );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		current_graph = (MX_DEPENDENCY_GRAPH *)
+					list_head->dependency_graph;
+	}
+
+	*graph = current_graph;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT long
+mx_get_dependency_graph_index( MX_DEPENDENCY_GRAPH *graph,
+				MX_RECORD *record )
+{
+	long i;
+
+	if ( ( graph == (MX_DEPENDENCY_GRAPH *) NULL )
+	  || ( record == (MX_RECORD *) NULL ) )
+	{
+		return -1;
+	}
+
+	/* The index stored in the record is only trusted if the graph
+	 * agrees with it, since the record may have been created after
+	 * the graph was frozen.
+	 */
+
+	i = record->dependency_graph_index;
+
+	if ( ( i < 0 ) || ( i >= graph->num_records ) )
+		return -1;
+
+	if ( graph->record_array[i] != record )
+		return -1;
+
+	return i;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_traverse_dependency_graph( MX_RECORD *record_list,
+				MX_RECORD *start_record,
+				unsigned long flags,
+				MX_DEPENDENCY_GRAPH_FUNCTION *function,
+				void *function_args )
+{
+	static const char fname[] = "mx_traverse_dependency_graph()";
+
+	MX_DEPENDENCY_GRAPH *graph;
+	char *selected_array;
+	long *queue;
+	long i, k, n, node, child, start, queue_head, queue_tail;
+	mx_status_type mx_status, first_failure;
+
+	if ( function == (MX_DEPENDENCY_GRAPH_FUNCTION *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The traversal function pointer passed was NULL." );
+	}
+
+	mx_status = mx_get_dependency_graph( record_list, &graph );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	selected_array = NULL;
+
+	/* If a start record was given, mark it and everything that
+	 * depends on it with a breadth first search of the children.
+	 */
+
+	if ( start_record != (MX_RECORD *) NULL ) {
+		start = mx_get_dependency_graph_index( graph, start_record );
+
+		if ( start < 0 ) {
+			return mx_error( MXE_NOT_FOUND, fname,
+			"Record '%s' is not in the dependency graph "
+			"of record list '%s'.",
+				start_record->name, record_list->name );
+		}
+
+		selected_array = (char *)
+				calloc( graph->num_records + 1, sizeof(char) );
+
+		queue = (long *)
+			malloc( ( graph->num_records + 1 ) * sizeof(long) );
+
+		if ( ( selected_array == (char *) NULL )
+		  || ( queue == (long *) NULL ) )
+		{
+			mx_free( selected_array );
+			mx_free( queue );
+
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to allocate the traversal "
+			"arrays for %ld records.", graph->num_records );
+		}
+
+		queue_head = 0;
+		queue_tail = 0;
+
+		queue[queue_tail++] = start;
+		selected_array[start] = TRUE;
+
+		while ( queue_head < queue_tail ) {
+			node = queue[queue_head++];
+
+			for ( k = graph->child_start_array[node];
+			    k < graph->child_start_array[node + 1]; k++ )
+			{
+				child = graph->child_index_array[k];
+
+				if ( selected_array[child] == FALSE ) {
+					selected_array[child] = TRUE;
+
+					queue[queue_tail++] = child;
+				}
+			}
+		}
+
+		mx_free( queue );
+	}
+
+	first_failure = MX_SUCCESSFUL_RESULT;
+
+	for ( n = 0; n < graph->num_records; n++ ) {
+		if ( flags & MXF_DEPGRAPH_CHILDREN_FIRST ) {
+			i = graph->topological_order_array[
+						graph->num_records - n - 1 ];
+		} else {
+			i = graph->topological_order_array[n];
+		}
+
+		if ( ( selected_array != (char *) NULL )
+		  && ( selected_array[i] == FALSE ) )
+		{
+			continue;
+		}
+
+		mx_status = (*function)( graph->record_array[i],
+						function_args );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			if ( first_failure.code == MXE_SUCCESS ) {
+				first_failure = mx_status;
+			}
+
+			if ( flags & MXF_DEPGRAPH_STOP_ON_ERROR )
+				break;
+		}
+	}
+
+	mx_free( selected_array );
+
+	return first_failure;
+}
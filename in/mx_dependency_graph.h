@@ -0,0 +1,130 @@
+/*
+ * Name:    mx_dependency_graph.h
+ *
+ * Purpose: Header file for the frozen record dependency graph.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_DEPENDENCY_GRAPH_H__
+#define __MX_DEPENDENCY_GRAPH_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The parent and child record arrays of each record are grown a few
+ * elements at a time as dependencies are added, so they are scattered
+ * all over the heap.  Once the database has been loaded, the dependency
+ * graph packs the same information into compressed sparse row form:
+ * the parents of record i are
+ *
+ *   parent_index_array[ parent_start_array[i] ]
+ *     ...
+ *   parent_index_array[ parent_start_array[i+1] - 1 ]
+ *
+ * and likewise for the children.  Records are numbered in record list
+ * order, and the list head itself is not part of the graph.  Only
+ * dependencies between records in the same record list are included.
+ *
+ * The graph is a read only snapshot.  Anything that changes the parent
+ * or child arrays of a record, or adds or deletes records, must call
+ * mx_invalidate_dependency_graph().  The next call to
+ * mx_get_dependency_graph() then builds a new graph.
+ */
+
+typedef struct {
+	long num_records;
+	MX_RECORD **record_array;
+
+	long num_dependencies;
+
+	long *parent_start_array;
+	long *parent_index_array;
+
+	long *child_start_array;
+	long *child_index_array;
+
+	/* Every record comes after all of its parents in this order,
+	 * which otherwise stays as close as possible to the order of
+	 * the record list.  A dependency cycle, which should never
+	 * happen, is broken at the point where it is found.
+	 */
+
+	long *topological_order_array;
+} MX_DEPENDENCY_GRAPH;
+
+#define mx_dependency_graph_num_parents( g, i ) \
+	( (g)->parent_start_array[(i)+1] - (g)->parent_start_array[(i)] )
+
+#define mx_dependency_graph_num_children( g, i ) \
+	( (g)->child_start_array[(i)+1] - (g)->child_start_array[(i)] )
+
+#define mx_dependency_graph_parents( g, i ) \
+	( &( (g)->parent_index_array[ (g)->parent_start_array[(i)] ] ) )
+
+#define mx_dependency_graph_children( g, i ) \
+	( &( (g)->child_index_array[ (g)->child_start_array[(i)] ] ) )
+
+/* Flags for mx_traverse_dependency_graph(). */
+
+#define MXF_DEPGRAPH_PARENTS_FIRST	0x1
+#define MXF_DEPGRAPH_CHILDREN_FIRST	0x2
+#define MXF_DEPGRAPH_STOP_ON_ERROR	0x4
+
+typedef mx_status_type ( MX_DEPENDENCY_GRAPH_FUNCTION )( MX_RECORD *,
+								void * );
+
+MX_API mx_status_type mx_freeze_dependency_graph( MX_RECORD *record_list );
+
+MX_API void mx_invalidate_dependency_graph( MX_RECORD *record_list );
+
+/* mx_get_dependency_graph() freezes a new graph if the record list
+ * does not currently have a valid one.
+ */
+
+MX_API mx_status_type mx_get_dependency_graph( MX_RECORD *record_list,
+					MX_DEPENDENCY_GRAPH **graph );
+
+/* Returns -1 if the record is not part of the graph. */
+
+MX_API long mx_get_dependency_graph_index( MX_DEPENDENCY_GRAPH *graph,
+					MX_RECORD *record );
+
+/* mx_traverse_dependency_graph() calls 'function' for every record in
+ * the database with MXF_DEPGRAPH_PARENTS_FIRST, which is the order
+ * that records must be opened in, or MXF_DEPGRAPH_CHILDREN_FIRST, which
+ * is the order that they must be shut down in.  If 'start_record' is
+ * not NULL, only 'start_record' and the records that depend on it,
+ * directly or indirectly, are visited.
+ *
+ * Without MXF_DEPGRAPH_STOP_ON_ERROR, the traversal continues after a
+ * failure and the first failure is returned at the end.
+ */
+
+MX_API mx_status_type mx_traverse_dependency_graph( MX_RECORD *record_list,
+					MX_RECORD *start_record,
+					unsigned long flags,
+					MX_DEPENDENCY_GRAPH_FUNCTION *function,
+					void *function_args );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_DEPENDENCY_GRAPH_H__ */
+
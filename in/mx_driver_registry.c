@@ -0,0 +1,369 @@
+/*
+ * Name:    mx_driver_registry.c
+ *
+ * Purpose: Hashed index of the MX superclass, class, and type drivers.
+ *
+ *          mx_get_driver_by_type() and friends used to walk the
+ *          next_driver chain of the corresponding driver list.  Since
+ *          they are called at least once for every record created
+ *          while a database is loaded, this made database loading
+ *          quadratic in the number of drivers times the number of
+ *          records.  The driver lists do not change once the driver
+ *          tables have been verified, so we build the indexes once
+ *          and look the drivers up in constant time afterwards.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+#include "mx_hash_table.h"
+
+/* The superclass, class, and type numbers are drawn from overlapping
+ * ranges (MXR_DEVICE and MXI_GPIB are both 3, for example), so each
+ * level of the driver hierarchy gets its own pair of maps.
+ *
+ * The type maps use open addressing keyed by the driver type number.
+ * Slots with a NULL driver pointer are empty.  Drivers are never
+ * removed from the registry except by mx_driver_registry_clear(),
+ * so no deleted slot markers are needed.
+ */
+
+typedef struct {
+	unsigned long num_type_slots;
+	unsigned long num_types;
+	long *type_array;
+	MX_DRIVER **type_driver_array;
+
+	MX_HASH_TABLE *name_table;
+} MX_DRIVER_REGISTRY_LEVEL;
+
+#define MX_NUM_DRIVER_REGISTRY_LEVELS	3
+
+static MX_DRIVER_REGISTRY_LEVEL
+	mx_driver_registry[MX_NUM_DRIVER_REGISTRY_LEVELS];
+
+/* Multiplicative hashing spreads out the clustered type numbers
+ * in mx_driver.h (5000x, 5010x, ...) across the table.
+ */
+
+#define MX_DRIVER_TYPE_HASH(t) \
+	( (uint32_t) ( (uint32_t) (t) * 2654435761U ) )
+
+static MX_DRIVER_REGISTRY_LEVEL *
+mx_driver_registry_get_level( long driver_level )
+{
+	if ( ( driver_level < MXF_DRIVER_SUPERCLASS )
+	  || ( driver_level > MXF_DRIVER_TYPE ) )
+	{
+		return NULL;
+	}
+
+	return &mx_driver_registry[ driver_level - MXF_DRIVER_SUPERCLASS ];
+}
+
+/*------------------------------------------------------------------------*/
+
+static void
+mx_driver_registry_place_type( long *type_array,
+				MX_DRIVER **type_driver_array,
+				unsigned long num_type_slots,
+				long driver_type,
+				MX_DRIVER *driver )
+{
+	unsigned long i, mask;
+
+	mask = num_type_slots - 1;
+
+	for ( i = MX_DRIVER_TYPE_HASH(driver_type) & mask; ;
+						i = (i + 1) & mask )
+	{
+		if ( type_driver_array[i] == (MX_DRIVER *) NULL ) {
+			type_array[i] = driver_type;
+			type_driver_array[i] = driver;
+			return;
+		}
+	}
+}
+
+static MX_DRIVER *
+mx_driver_registry_find_type( MX_DRIVER_REGISTRY_LEVEL *level,
+				long driver_type )
+{
+	unsigned long i, mask;
+
+	if ( level->num_type_slots == 0 )
+		return NULL;
+
+	mask = level->num_type_slots - 1;
+
+	for ( i = MX_DRIVER_TYPE_HASH(driver_type) & mask; ;
+						i = (i + 1) & mask )
+	{
+		if ( level->type_driver_array[i] == (MX_DRIVER *) NULL )
+			return NULL;
+
+		if ( level->type_array[i] == driver_type )
+			return level->type_driver_array[i];
+	}
+
+	MXW_NOT_REACHED( return NULL );
+}
+
+static mx_status_type
+mx_driver_registry_grow_types( MX_DRIVER_REGISTRY_LEVEL *level,
+				unsigned long new_num_type_slots )
+{
+	static const char fname[] = "mx_driver_registry_grow_types()";
+
+	long *new_type_array;
+	MX_DRIVER **new_type_driver_array;
+	unsigned long i;
+
+	new_type_array = (long *) calloc( new_num_type_slots, sizeof(long) );
+
+	new_type_driver_array = (MX_DRIVER **)
+			calloc( new_num_type_slots, sizeof(MX_DRIVER *) );
+
+	if ( ( new_type_array == (long *) NULL )
+	  || ( new_type_driver_array == (MX_DRIVER **) NULL ) )
+	{
+		mx_free( new_type_array );
+		mx_free( new_type_driver_array );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to grow the driver registry "
+		"to %lu slots.", new_num_type_slots );
+	}
+
+	for ( i = 0; i < level->num_type_slots; i++ ) {
+		if ( level->type_driver_array[i] == (MX_DRIVER *) NULL )
+			continue;
+
+		mx_driver_registry_place_type( new_type_array,
+					new_type_driver_array,
+					new_num_type_slots,
+					level->type_array[i],
+					level->type_driver_array[i] );
+	}
+
+	mx_free( level->type_array );
+	mx_free( level->type_driver_array );
+
+	level->type_array = new_type_array;
+	level->type_driver_array = new_type_driver_array;
+	level->num_type_slots = new_num_type_slots;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_driver_registry_add_driver( MX_DRIVER_REGISTRY_LEVEL *level,
+				long driver_type,
+				MX_DRIVER *driver )
+{
+	unsigned long new_num_type_slots;
+	mx_status_type mx_status;
+
+	/* If more than one driver has the same type or the same name,
+	 * the next_driver chain walk would have returned the first one,
+	 * so we do the same here.
+	 */
+
+	if ( level->name_table == (MX_HASH_TABLE *) NULL ) {
+		mx_status = mx_hash_table_create( &(level->name_table), 0 );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	if ( mx_hash_table_lookup( level->name_table, driver->name ) == NULL )
+	{
+		mx_status = mx_hash_table_insert( level->name_table,
+						driver->name, driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	if ( mx_driver_registry_find_type( level, driver_type )
+						!= (MX_DRIVER *) NULL )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	/* Keep the type map at most half full. */
+
+	if ( 2 * (level->num_types + 1) > level->num_type_slots ) {
+		new_num_type_slots = level->num_type_slots;
+
+		if ( new_num_type_slots == 0 )
+			new_num_type_slots = MX_HASH_TABLE_MIN_SLOTS;
+
+		while ( 2 * (level->num_types + 1) > new_num_type_slots ) {
+			new_num_type_slots *= 2;
+		}
+
+		mx_status = mx_driver_registry_grow_types( level,
+							new_num_type_slots );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	mx_driver_registry_place_type( level->type_array,
+					level->type_driver_array,
+					level->num_type_slots,
+					driver_type, driver );
+
+	level->num_types++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static long
+mx_driver_registry_get_type( long driver_level, MX_DRIVER *driver )
+{
+	switch( driver_level ) {
+	case MXF_DRIVER_SUPERCLASS:
+		return driver->mx_superclass;
+	case MXF_DRIVER_CLASS:
+		return driver->mx_class;
+	default:
+		return driver->mx_type;
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_driver_registry_add_table( long driver_level, MX_DRIVER *driver_table )
+{
+	static const char fname[] = "mx_driver_registry_add_table()";
+
+	MX_DRIVER_REGISTRY_LEVEL *level;
+	MX_DRIVER *driver;
+	mx_status_type mx_status;
+
+	if ( driver_table == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The driver table pointer passed was NULL." );
+	}
+
+	level = mx_driver_registry_get_level( driver_level );
+
+	if ( level == (MX_DRIVER_REGISTRY_LEVEL *) NULL ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Illegal driver registry level %ld requested.", driver_level );
+	}
+
+	/* Driver tables are terminated by an entry with an empty name
+	 * and a type of 0.
+	 */
+
+	for ( driver = driver_table;
+	    ( driver->name[0] != '\0' ) || ( driver->mx_type != 0 );
+	    driver++ )
+	{
+		mx_status = mx_driver_registry_add_driver( level,
+			mx_driver_registry_get_type( driver_level, driver ),
+			driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_driver_registry_add_list( long driver_level, MX_DRIVER *driver_list )
+{
+	static const char fname[] = "mx_driver_registry_add_list()";
+
+	MX_DRIVER_REGISTRY_LEVEL *level;
+	MX_DRIVER *driver;
+	mx_status_type mx_status;
+
+	level = mx_driver_registry_get_level( driver_level );
+
+	if ( level == (MX_DRIVER_REGISTRY_LEVEL *) NULL ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Illegal driver registry level %ld requested.", driver_level );
+	}
+
+	for ( driver = driver_list;
+	    driver != (MX_DRIVER *) NULL;
+	    driver = driver->next_driver )
+	{
+		mx_status = mx_driver_registry_add_driver( level,
+			mx_driver_registry_get_type( driver_level, driver ),
+			driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_driver_registry_clear( void )
+{
+	MX_DRIVER_REGISTRY_LEVEL *level;
+	int i;
+
+	for ( i = 0; i < MX_NUM_DRIVER_REGISTRY_LEVELS; i++ ) {
+		level = &mx_driver_registry[i];
+
+		mx_hash_table_destroy( level->name_table );
+
+		mx_free( level->type_array );
+		mx_free( level->type_driver_array );
+
+		memset( level, 0, sizeof(MX_DRIVER_REGISTRY_LEVEL) );
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT MX_DRIVER *
+mx_driver_registry_lookup_type( long driver_level, long driver_type )
+{
+	MX_DRIVER_REGISTRY_LEVEL *level;
+
+	level = mx_driver_registry_get_level( driver_level );
+
+	if ( level == (MX_DRIVER_REGISTRY_LEVEL *) NULL )
+		return NULL;
+
+	return mx_driver_registry_find_type( level, driver_type );
+}
+
+MX_EXPORT MX_DRIVER *
+mx_driver_registry_lookup_name( long driver_level, const char *driver_name )
+{
+	MX_DRIVER_REGISTRY_LEVEL *level;
+
+	level = mx_driver_registry_get_level( driver_level );
+
+	if ( level == (MX_DRIVER_REGISTRY_LEVEL *) NULL )
+		return NULL;
+
+	return (MX_DRIVER *) mx_hash_table_lookup( level->name_table,
+							driver_name );
+}
+
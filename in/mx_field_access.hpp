@@ -0,0 +1,372 @@
+/*
+ * Name:    mx_field_access.hpp
+ *
+ * Purpose: Compile time descriptions of record fields for C++ code.
+ *
+ *          The *_STANDARD_FIELDS macros are normally only used to build
+ *          the MX_RECORD_FIELD_DEFAULTS arrays of the drivers, so the
+ *          location of a field value has to be worked out at run time
+ *          by mx_construct_ptr_to_field_value() from 'structure_id'
+ *          and 'structure_offset'.  This header expands the same macros
+ *          into constexpr tables, so that C++ code can look fields up
+ *          at compile time and read them with a single load, using
+ *
+ *              double position =
+ *                  mx::field<&MX_MOTOR::position>::get( motor_record );
+ *
+ *          Since the tables come from the same macros as the drivers'
+ *          own field defaults, they can never disagree with them.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_FIELD_ACCESS_HPP__
+#define __MX_FIELD_ACCESS_HPP__
+
+#ifndef __cplusplus
+#error mx_field_access.hpp can only be used by C++ code.
+#endif
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include <array>
+#include <type_traits>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+#include "mx_motor.h"
+#include "d_adsc_two_theta.h"
+
+namespace mx {
+
+/*--------------------------------------------------------------------------*/
+
+/* The field defaults tables.  The macros leave the trailing members of
+ * most entries to be zero filled, which is what we want.
+ */
+
+#if defined(__GNUC__)
+#  pragma GCC diagnostic push
+#  pragma GCC diagnostic ignored "-Wmissing-field-initializers"
+#endif
+
+inline constexpr MX_RECORD_FIELD_DEFAULTS record_standard_fields[] = {
+	MX_RECORD_STANDARD_FIELDS
+};
+
+inline constexpr MX_RECORD_FIELD_DEFAULTS motor_standard_fields[] = {
+	MX_MOTOR_STANDARD_FIELDS
+};
+
+inline constexpr MX_RECORD_FIELD_DEFAULTS analog_motor_standard_fields[] = {
+	MX_ANALOG_MOTOR_STANDARD_FIELDS
+};
+
+inline constexpr MX_RECORD_FIELD_DEFAULTS stepper_motor_standard_fields[] = {
+	MX_STEPPER_MOTOR_STANDARD_FIELDS
+};
+
+inline constexpr MX_RECORD_FIELD_DEFAULTS adsc_two_theta_standard_fields[] = {
+	MXD_ADSC_TWO_THETA_STANDARD_FIELDS
+};
+
+#if defined(__GNUC__)
+#  pragma GCC diagnostic pop
+#endif
+
+/*--------------------------------------------------------------------------*/
+
+/* A field_descriptor is the part of an MX_RECORD_FIELD_DEFAULTS entry
+ * that is needed to find and interpret a field value.
+ */
+
+struct field_descriptor {
+	const char *name;
+	long label_value;
+	long datatype;
+	long num_dimensions;
+	short structure_id;
+	size_t structure_offset;
+	long flags;
+};
+
+constexpr bool
+names_match( const char *name_a, const char *name_b )
+{
+	while ( ( *name_a != '\0' ) && ( *name_a == *name_b ) ) {
+		name_a++;
+		name_b++;
+	}
+
+	return ( *name_a == *name_b );
+}
+
+template <size_t N>
+constexpr std::array<field_descriptor, N>
+make_descriptor_table( const MX_RECORD_FIELD_DEFAULTS (&defaults)[N] )
+{
+	std::array<field_descriptor, N> table{};
+
+	for ( size_t i = 0; i < N; i++ ) {
+		table[i].name = defaults[i].name;
+		table[i].label_value = defaults[i].label_value;
+		table[i].datatype = defaults[i].datatype;
+		table[i].num_dimensions = defaults[i].num_dimensions;
+		table[i].structure_id = defaults[i].structure_id;
+		table[i].structure_offset = defaults[i].structure_offset;
+		table[i].flags = defaults[i].flags;
+	}
+
+	return table;
+}
+
+/* Returns the index of the named field, or -1 if there is none. */
+
+template <size_t N>
+constexpr long
+find_field( const std::array<field_descriptor, N> &table, const char *name )
+{
+	for ( size_t i = 0; i < N; i++ ) {
+		if ( names_match( table[i].name, name ) )
+			return (long) i;
+	}
+
+	return -1;
+}
+
+template <size_t N>
+constexpr long
+find_field_by_label_value( const std::array<field_descriptor, N> &table,
+				long label_value )
+{
+	for ( size_t i = 0; i < N; i++ ) {
+		if ( table[i].label_value == label_value )
+			return (long) i;
+	}
+
+	return -1;
+}
+
+inline constexpr auto record_field_table =
+		make_descriptor_table( record_standard_fields );
+
+inline constexpr auto motor_field_table =
+		make_descriptor_table( motor_standard_fields );
+
+inline constexpr auto analog_motor_field_table =
+		make_descriptor_table( analog_motor_standard_fields );
+
+inline constexpr auto stepper_motor_field_table =
+		make_descriptor_table( stepper_motor_standard_fields );
+
+inline constexpr auto adsc_two_theta_field_table =
+		make_descriptor_table( adsc_two_theta_standard_fields );
+
+/*--------------------------------------------------------------------------*/
+
+/* structure_traits says which of the structures hanging off an MX_RECORD
+ * a C structure is.  Using a structure without a specialization here is
+ * a compile time error.
+ */
+
+template <typename S>
+struct structure_traits;
+
+template <>
+struct structure_traits<MX_RECORD> {
+	static constexpr short structure_id = MXF_REC_RECORD_STRUCT;
+};
+
+template <>
+struct structure_traits<MX_MOTOR> {
+	static constexpr short structure_id = MXF_REC_CLASS_STRUCT;
+};
+
+template <>
+struct structure_traits<MX_ADSC_TWO_THETA> {
+	static constexpr short structure_id = MXF_REC_TYPE_STRUCT;
+};
+
+template <typename S>
+inline S *
+structure_of( MX_RECORD *record )
+{
+	constexpr short id = structure_traits<S>::structure_id;
+
+	if constexpr ( id == MXF_REC_RECORD_STRUCT ) {
+		return record;
+	} else if constexpr ( id == MXF_REC_SUPERCLASS_STRUCT ) {
+		return static_cast<S *>( record->record_superclass_struct );
+	} else if constexpr ( id == MXF_REC_CLASS_STRUCT ) {
+		return static_cast<S *>( record->record_class_struct );
+	} else {
+		return static_cast<S *>( record->record_type_struct );
+	}
+}
+
+/* datatype_matches() checks that a C++ member type can hold a field of
+ * the given MX datatype.  Varargs arrays are pointers whose element
+ * type is checked instead.
+ */
+
+template <typename V>
+constexpr bool
+datatype_matches( long datatype )
+{
+	using T = std::remove_cv_t<V>;
+
+	if constexpr ( std::is_array_v<T> || std::is_pointer_v<T> ) {
+		using E = std::remove_cv_t<std::remove_pointer_t<
+					std::remove_all_extents_t<T>>>;
+
+		if constexpr ( std::is_same_v<E, char> ) {
+			if ( datatype == MXFT_STRING )
+				return true;
+		}
+
+		if constexpr ( std::is_same_v<E, MX_RECORD> ) {
+			if ( datatype == MXFT_RECORD )
+				return true;
+		}
+
+		if constexpr ( !std::is_same_v<E, T> ) {
+			return datatype_matches<E>( datatype );
+		} else {
+			return false;
+		}
+	} else if constexpr ( std::is_same_v<T, double> ) {
+		return ( datatype == MXFT_DOUBLE );
+	} else if constexpr ( std::is_same_v<T, float> ) {
+		return ( datatype == MXFT_FLOAT );
+	} else if constexpr ( std::is_same_v<T, char> ) {
+		return ( datatype == MXFT_CHAR );
+	} else if constexpr ( std::is_same_v<T, unsigned char> ) {
+		return ( datatype == MXFT_UCHAR );
+	} else if constexpr ( std::is_same_v<T, short> ) {
+		return ( datatype == MXFT_SHORT );
+	} else if constexpr ( std::is_same_v<T, unsigned short> ) {
+		return ( datatype == MXFT_USHORT );
+	} else if constexpr ( std::is_same_v<T, mx_bool_type> ) {
+		return ( datatype == MXFT_BOOL );
+	} else if constexpr ( std::is_same_v<T, long> ) {
+		return ( datatype == MXFT_LONG )
+			|| ( datatype == MXFT_RECORDTYPE )
+			|| ( ( sizeof(long) == sizeof(int64_t) )
+				&& ( datatype == MXFT_INT64 ) );
+	} else if constexpr ( std::is_same_v<T, unsigned long> ) {
+		return ( datatype == MXFT_ULONG ) || ( datatype == MXFT_HEX )
+			|| ( ( sizeof(unsigned long) == sizeof(uint64_t) )
+				&& ( datatype == MXFT_UINT64 ) );
+	} else if constexpr ( std::is_same_v<T, int64_t> ) {
+		return ( datatype == MXFT_INT64 );
+	} else if constexpr ( std::is_same_v<T, uint64_t> ) {
+		return ( datatype == MXFT_UINT64 );
+	} else if constexpr ( std::is_same_v<T, MX_INTERFACE> ) {
+		return ( datatype == MXFT_INTERFACE );
+	} else {
+		return false;
+	}
+}
+
+/* field_is_consistent() is true if the named entry of a table describes
+ * the given structure member.  It is used with static_assert() through
+ * the MX_VERIFY_FIELD() macro below.
+ */
+
+template <typename V, size_t N>
+constexpr bool
+field_is_consistent( const std::array<field_descriptor, N> &table,
+			const char *name,
+			short structure_id,
+			size_t structure_offset )
+{
+	long i = find_field( table, name );
+
+	if ( i < 0 )
+		return false;
+
+	return ( table[i].structure_id == structure_id )
+		&& ( table[i].structure_offset == structure_offset )
+		&& datatype_matches<V>( table[i].datatype );
+}
+
+#define MX_VERIFY_FIELD( table, field_name, structure, member ) \
+	static_assert( mx::field_is_consistent< \
+			decltype( ((structure *) 0)->member )>( table, \
+			field_name, \
+			mx::structure_traits<structure>::structure_id, \
+			offsetof( structure, member ) ), \
+		"The field '" field_name "' in " #table \
+		" does not match " #structure "::" #member "." )
+
+/*--------------------------------------------------------------------------*/
+
+/* field<&S::member> reads and writes a field of a record directly.
+ * There are no run time checks, so the record must really have an S
+ * structure in the slot that structure_traits<S> names.
+ */
+
+template <auto Member>
+struct field;
+
+template <typename S, typename V, V S::*Member>
+struct field<Member> {
+	using structure_type = S;
+	using value_type = V;
+
+	static constexpr short structure_id =
+				structure_traits<S>::structure_id;
+
+	static V &
+	ref( MX_RECORD *record )
+	{
+		return structure_of<S>( record )->*Member;
+	}
+
+	static const V &
+	get( MX_RECORD *record )
+	{
+		return structure_of<S>( record )->*Member;
+	}
+
+	static void
+	set( MX_RECORD *record, const V &value )
+	{
+		static_assert( !std::is_array_v<V>,
+			"Array fields must be modified through ref()." );
+
+		structure_of<S>( record )->*Member = value;
+	}
+};
+
+/* Check the members that the accessors are most often used with. */
+
+MX_VERIFY_FIELD( record_field_table, "name", MX_RECORD, name );
+MX_VERIFY_FIELD( record_field_table, "label", MX_RECORD, label );
+MX_VERIFY_FIELD( record_field_table, "precision", MX_RECORD, long_precision );
+
+MX_VERIFY_FIELD( motor_field_table, "position", MX_MOTOR, position );
+MX_VERIFY_FIELD( motor_field_table, "destination", MX_MOTOR, destination );
+MX_VERIFY_FIELD( motor_field_table, "set_position", MX_MOTOR, set_position );
+MX_VERIFY_FIELD( motor_field_table, "relative_move", MX_MOTOR, relative_move );
+MX_VERIFY_FIELD( motor_field_table, "scale", MX_MOTOR, scale );
+MX_VERIFY_FIELD( motor_field_table, "offset", MX_MOTOR, offset );
+MX_VERIFY_FIELD( motor_field_table, "units", MX_MOTOR, units );
+MX_VERIFY_FIELD( motor_field_table, "motor_flags", MX_MOTOR, motor_flags );
+
+MX_VERIFY_FIELD( adsc_two_theta_field_table, "height_motor_record",
+			MX_ADSC_TWO_THETA, height_motor_record );
+
+} /* namespace mx */
+
+#endif /* __MX_FIELD_ACCESS_HPP__ */
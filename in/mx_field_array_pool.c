@@ -0,0 +1,452 @@
+/*
+ * Name:    mx_field_array_pool.c
+ *
+ * Purpose: Pooled storage for one dimensional varargs field arrays
+ *          whose length changes often.
+ *
+ *          Scans that change the length of an array field at every
+ *          step, such as the estimated move arrays of a motor, would
+ *          otherwise reallocate the array every time.  See the comments
+ *          in mx_field_array_pool.h for the allocation policy.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_field_array_pool.h"
+
+#define MX_FIELD_ARRAY_POOL_MAX_BLOCK_SIZE \
+	( ((size_t) 1) << ( MX_FIELD_ARRAY_POOL_MIN_SHIFT \
+				+ MX_FIELD_ARRAY_POOL_NUM_CLASSES - 1 ) )
+
+static MX_FIELD_ARRAY_POOL *
+mx_field_array_pool_for_field( MX_RECORD_FIELD *field )
+{
+	MX_RECORD *list_head_record;
+	MX_LIST_HEAD *list_head;
+
+	if ( field->record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head_record = field->record->list_head;
+
+	if ( list_head_record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return NULL;
+
+	return (MX_FIELD_ARRAY_POOL *) list_head->field_array_pool;
+}
+
+/* Returns the size class for a block, or -1 if the block is too large
+ * to be pooled.  'block_size' is rounded up to the size of the class.
+ */
+
+static long
+mx_field_array_size_class( size_t *block_size )
+{
+	size_t class_size;
+	long size_class;
+
+	if ( *block_size > MX_FIELD_ARRAY_POOL_MAX_BLOCK_SIZE )
+		return -1;
+
+	class_size = ((size_t) 1) << MX_FIELD_ARRAY_POOL_MIN_SHIFT;
+	size_class = 0;
+
+	while ( class_size < *block_size ) {
+		class_size <<= 1;
+		size_class++;
+	}
+
+	*block_size = class_size;
+
+	return size_class;
+}
+
+static void *
+mx_field_array_pool_get( MX_FIELD_ARRAY_POOL *pool, size_t block_size )
+{
+	MX_FIELD_ARRAY_BLOCK *block;
+	long size_class;
+
+	size_class = mx_field_array_size_class( &block_size );
+
+	if ( ( pool != (MX_FIELD_ARRAY_POOL *) NULL ) && ( size_class >= 0 ) ) {
+		block = pool->free_list[ size_class ];
+
+		if ( block != (MX_FIELD_ARRAY_BLOCK *) NULL ) {
+			pool->free_list[ size_class ] = block->next_block;
+			pool->num_free_blocks[ size_class ]--;
+			pool->bytes_pooled -= block_size;
+			pool->num_pool_hits++;
+
+			return block;
+		}
+	}
+
+	if ( pool != (MX_FIELD_ARRAY_POOL *) NULL ) {
+		pool->num_mallocs++;
+	}
+
+	return malloc( block_size );
+}
+
+static void
+mx_field_array_pool_put( MX_FIELD_ARRAY_POOL *pool,
+			void *array_ptr,
+			size_t block_size )
+{
+	MX_FIELD_ARRAY_BLOCK *block;
+	size_t class_size;
+	long size_class;
+
+	if ( array_ptr == NULL )
+		return;
+
+	class_size = block_size;
+
+	size_class = mx_field_array_size_class( &class_size );
+
+	if ( ( pool == (MX_FIELD_ARRAY_POOL *) NULL )
+	  || ( size_class < 0 )
+	  || ( class_size != block_size )
+	  || ( pool->num_free_blocks[ size_class ]
+			>= MX_FIELD_ARRAY_POOL_MAX_FREE_BLOCKS ) )
+	{
+		free( array_ptr );
+		return;
+	}
+
+	block = (MX_FIELD_ARRAY_BLOCK *) array_ptr;
+
+	block->next_block = pool->free_list[ size_class ];
+
+	pool->free_list[ size_class ] = block;
+	pool->num_free_blocks[ size_class ]++;
+	pool->bytes_pooled += block_size;
+	pool->num_releases++;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_field_array_pool( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_create_field_array_pool()";
+
+	MX_LIST_HEAD *list_head;
+	MX_FIELD_ARRAY_POOL *pool;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	if ( list_head->field_array_pool != NULL ) {
+		return mx_error( MXE_ALREADY_EXISTS, fname,
+		"The record list already has a field array pool." );
+	}
+
+	pool = (MX_FIELD_ARRAY_POOL *)
+			calloc( 1, sizeof(MX_FIELD_ARRAY_POOL) );
+
+	if ( pool == (MX_FIELD_ARRAY_POOL *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_FIELD_ARRAY_POOL structure." );
+	}
+
+	list_head->field_array_pool = pool;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_field_array_pool( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_delete_field_array_pool()";
+
+	MX_LIST_HEAD *list_head;
+	MX_FIELD_ARRAY_POOL *pool;
+	MX_FIELD_ARRAY_BLOCK *block, *next_block;
+	long i;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	pool = (MX_FIELD_ARRAY_POOL *) list_head->field_array_pool;
+
+	if ( pool == (MX_FIELD_ARRAY_POOL *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	for ( i = 0; i < MX_FIELD_ARRAY_POOL_NUM_CLASSES; i++ ) {
+		block = pool->free_list[i];
+
+		while ( block != (MX_FIELD_ARRAY_BLOCK *) NULL ) {
+			next_block = block->next_block;
+
+			free( block );
+
+			block = next_block;
+		}
+	}
+
+	free( pool );
+
+	list_head->field_array_pool = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT MX_FIELD_ARRAY_POOL *
+mx_get_field_array_pool( MX_RECORD *record_list )
+{
+	MX_LIST_HEAD *list_head;
+
+	if ( record_list == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return NULL;
+
+	return (MX_FIELD_ARRAY_POOL *) list_head->field_array_pool;
+}
+
+MX_EXPORT void
+mx_reset_field_array_pool_statistics( MX_FIELD_ARRAY_POOL *pool )
+{
+	if ( pool == (MX_FIELD_ARRAY_POOL *) NULL )
+		return;
+
+	pool->num_resizes = 0;
+	pool->num_reallocations = 0;
+	pool->num_shrinks = 0;
+	pool->num_pool_hits = 0;
+	pool->num_mallocs = 0;
+	pool->num_releases = 0;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_resize_1d_field_array( MX_RECORD_FIELD *field,
+			long num_elements,
+			unsigned long flags )
+{
+	static const char fname[] = "mx_resize_1d_field_array()";
+
+	MX_FIELD_ARRAY_POOL *pool;
+	void **array_ptr_ptr;
+	char *old_array, *new_array;
+	size_t element_size, old_size, new_size, block_size, copy_size;
+	long old_num_elements;
+	mx_bool_type shrink;
+	mx_status_type mx_status;
+
+	if ( field == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD_FIELD pointer passed was NULL." );
+	}
+
+	if ( ( field->descriptor->num_dimensions != 1 )
+	  || ( ( field->descriptor->flags & MXFF_VARARGS ) == 0 ) )
+	{
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' is not a one dimensional varargs array.",
+			field->descriptor->name );
+	}
+
+	if ( num_elements < 0 ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"The requested length %ld for field '%s' is negative.",
+			num_elements, field->descriptor->name );
+	}
+
+	element_size = field->descriptor->data_element_size[0];
+
+	if ( ( element_size != 0 )
+	  && ( (size_t) num_elements > ((size_t) -1) / element_size ) )
+	{
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+		"The requested length %ld for field '%s' is too large.",
+			num_elements, field->descriptor->name );
+	}
+
+	old_num_elements = field->dimension[0];
+
+	if ( num_elements == old_num_elements )
+		return MX_SUCCESSFUL_RESULT;
+
+	mx_status = mx_make_record_field_private( field );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	pool = mx_field_array_pool_for_field( field );
+
+	if ( pool != (MX_FIELD_ARRAY_POOL *) NULL ) {
+		pool->num_resizes++;
+	}
+
+	array_ptr_ptr = (void **) field->data_pointer;
+
+	old_array = (char *) *array_ptr_ptr;
+
+	if ( ( old_array == (char *) NULL ) || ( old_num_elements <= 0 ) ) {
+		old_size = 0;
+	} else {
+		old_size = old_num_elements * element_size;
+	}
+
+	new_size = num_elements * element_size;
+
+	/* Below the high water mark, only the length changes. */
+
+	if ( ( old_array != (char *) NULL )
+	  && ( new_size <= field->array_allocated_size ) )
+	{
+		shrink = FALSE;
+
+		if ( flags & MXF_FIELD_ARRAY_SHRINK ) {
+			block_size = new_size;
+
+			(void) mx_field_array_size_class( &block_size );
+
+			if ( block_size <= field->array_allocated_size / 4 )
+				shrink = TRUE;
+		}
+
+		if ( shrink == FALSE ) {
+			if ( new_size > old_size ) {
+				memset( old_array + old_size, 0,
+						new_size - old_size );
+			}
+
+			field->dimension[0] = num_elements;
+
+			return MX_SUCCESSFUL_RESULT;
+		}
+
+		if ( pool != (MX_FIELD_ARRAY_POOL *) NULL ) {
+			pool->num_shrinks++;
+		}
+	}
+
+	/* Otherwise the array must move to a block of a different size. */
+
+	block_size = new_size;
+
+	if ( mx_field_array_size_class( &block_size ) < 0 ) {
+		block_size = new_size;
+	}
+
+	new_array = (char *) mx_field_array_pool_get( pool, block_size );
+
+	if ( new_array == (char *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %ld element array "
+		"for field '%s'.", num_elements, field->descriptor->name );
+	}
+
+	if ( old_array == (char *) NULL ) {
+		copy_size = 0;
+	} else
+	if ( new_size < old_size ) {
+		copy_size = new_size;
+	} else {
+		copy_size = old_size;
+	}
+
+	if ( copy_size > 0 ) {
+		memcpy( new_array, old_array, copy_size );
+	}
+
+	memset( new_array + copy_size, 0, block_size - copy_size );
+
+	/* Arrays that were not allocated here may belong to the record
+	 * arena, so they are handed to mx_record_free().
+	 */
+
+	if ( field->array_allocated_size > 0 ) {
+		mx_field_array_pool_put( pool, old_array,
+					field->array_allocated_size );
+	} else {
+		mx_record_free( field->record, old_array );
+	}
+
+	*array_ptr_ptr = new_array;
+
+	field->array_allocated_size = block_size;
+	field->dimension[0] = num_elements;
+
+	if ( pool != (MX_FIELD_ARRAY_POOL *) NULL ) {
+		pool->num_reallocations++;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_release_1d_field_array( MX_RECORD_FIELD *field )
+{
+	void **array_ptr_ptr;
+
+	if ( ( field == (MX_RECORD_FIELD *) NULL )
+	  || ( field->descriptor->num_dimensions != 1 )
+	  || ( ( field->descriptor->flags & MXFF_VARARGS ) == 0 )
+	  || ( field->array_allocated_size == 0 ) )
+	{
+		return;
+	}
+
+	array_ptr_ptr = (void **) field->data_pointer;
+
+	mx_field_array_pool_put( mx_field_array_pool_for_field( field ),
+				*array_ptr_ptr, field->array_allocated_size );
+
+	*array_ptr_ptr = NULL;
+
+	field->array_allocated_size = 0;
+
+	if ( mx_make_record_field_private( field ).code == MXE_SUCCESS ) {
+		field->dimension[0] = 0;
+	}
+}
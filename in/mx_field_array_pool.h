@@ -0,0 +1,116 @@
+/*
+ * Name:    mx_field_array_pool.h
+ *
+ * Purpose: Header file for pooled storage of one dimensional varargs
+ *          field arrays whose length changes often.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_FIELD_ARRAY_POOL_H__
+#define __MX_FIELD_ARRAY_POOL_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* mx_resize_1d_field_array() changes the length of a one dimensional
+ * varargs array field, such as the 'estimated_move_positions' field of
+ * a motor, without reallocating it every time the length changes.
+ *
+ * Arrays are allocated in power of two size classes, and the number of
+ * bytes allocated is remembered in the field's 'array_allocated_size'.
+ * This is the field's high water mark.  The length can change freely
+ * below it, and it only grows when a longer array is asked for.  If
+ * MXF_FIELD_ARRAY_SHRINK is passed and the new array would fit in a
+ * quarter of the current allocation, the array is moved to a smaller
+ * size class instead.
+ *
+ * If the record list has a field array pool, blocks that are given up
+ * by one field are kept on a free list for their size class and are
+ * reused by the next field that needs a block of that size.  Arrays
+ * larger than the largest size class are allocated exactly and are
+ * never pooled.  All blocks come from malloc(), so an array that is
+ * still attached to a field when the pool is deleted remains valid and
+ * may later be freed with free().
+ *
+ * The pool is not thread safe.  It is meant to be used by the thread
+ * that owns the database, like the record arena.
+ */
+
+#define MX_FIELD_ARRAY_POOL_MIN_SHIFT		6	/* 64 bytes */
+#define MX_FIELD_ARRAY_POOL_NUM_CLASSES		15	/* up to 1 MB */
+
+#define MX_FIELD_ARRAY_POOL_MAX_FREE_BLOCKS	16
+
+#define MXF_FIELD_ARRAY_SHRINK			0x1
+
+typedef struct mx_field_array_block_type {
+	struct mx_field_array_block_type *next_block;
+} MX_FIELD_ARRAY_BLOCK;
+
+typedef struct {
+	MX_FIELD_ARRAY_BLOCK *free_list[ MX_FIELD_ARRAY_POOL_NUM_CLASSES ];
+	long num_free_blocks[ MX_FIELD_ARRAY_POOL_NUM_CLASSES ];
+
+	/* Statistics
+	 *
+	 * 'num_resizes' counts the calls that changed the length of an
+	 * array, which is the number of reallocations there would be if
+	 * every length change reallocated the array.  The number that
+	 * actually had to move the array is 'num_reallocations'.
+	 */
+
+	unsigned long num_resizes;
+	unsigned long num_reallocations;
+	unsigned long num_shrinks;
+	unsigned long num_pool_hits;
+	unsigned long num_mallocs;
+	unsigned long num_releases;
+	size_t bytes_pooled;
+} MX_FIELD_ARRAY_POOL;
+
+MX_API_PRIVATE mx_status_type mx_create_field_array_pool(
+					MX_RECORD *record_list );
+
+/* Frees the blocks on the free lists.  Arrays that are in use by
+ * fields are not affected.
+ */
+
+MX_API_PRIVATE mx_status_type mx_delete_field_array_pool(
+					MX_RECORD *record_list );
+
+MX_API MX_FIELD_ARRAY_POOL *mx_get_field_array_pool( MX_RECORD *record_list );
+
+MX_API void mx_reset_field_array_pool_statistics( MX_FIELD_ARRAY_POOL *pool );
+
+MX_API mx_status_type mx_resize_1d_field_array( MX_RECORD_FIELD *field,
+					long num_elements,
+					unsigned long flags );
+
+/* Gives the array of a field back to the pool and sets its length
+ * to zero.  This should be used for pooled fields when their record
+ * is deleted.
+ */
+
+MX_API void mx_release_1d_field_array( MX_RECORD_FIELD *field );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_FIELD_ARRAY_POOL_H__ */
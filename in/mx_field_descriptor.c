@@ -0,0 +1,149 @@
+/*
+ * Name:    mx_field_descriptor.c
+ *
+ * Purpose: Sharing of the immutable parts of record fields between all
+ *          of the records that use the same driver.
+ *
+ *          Everything about a record field that is the same for every
+ *          record of a driver, such as its name, datatype, flags and
+ *          element sizes, is kept in the driver's record field defaults
+ *          entry, which the field points to through its 'descriptor'.
+ *          Only the per-record state (data pointer, last value,
+ *          callback list, active flag and so forth) is actually stored
+ *          in each MX_RECORD_FIELD.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+
+/* The private dimension array always gets the maximum number of
+ * dimensions, so that code which indexes it directly sees the same
+ * layout as in an MX_RECORD_FIELD_DEFAULTS structure.
+ */
+
+static mx_status_type
+mx_allocate_private_dimension_array( MX_RECORD_FIELD *field,
+					long *dimension )
+{
+	static const char fname[] = "mx_allocate_private_dimension_array()";
+
+	long *new_dimension;
+
+	new_dimension = (long *)
+			malloc( MXU_FIELD_MAX_DIMENSIONS * sizeof(long) );
+
+	if ( new_dimension == (long *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the dimension array "
+		"for record field '%s'.", field->descriptor->name );
+	}
+
+	memcpy( new_dimension, dimension,
+			MXU_FIELD_MAX_DIMENSIONS * sizeof(long) );
+
+	field->dimension = new_dimension;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_share_defaults_with_record_field( MX_RECORD_FIELD *field,
+				MX_RECORD_FIELD_DEFAULTS *field_defaults )
+{
+	static const char fname[] = "mx_share_defaults_with_record_field()";
+
+	if ( field == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD_FIELD pointer passed was NULL." );
+	}
+	if ( field_defaults == (MX_RECORD_FIELD_DEFAULTS *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD_FIELD_DEFAULTS pointer passed was NULL." );
+	}
+
+	field->descriptor = field_defaults;
+
+	/* The per-record state starts out empty. */
+
+	field->data_pointer = NULL;
+	field->last_value = 0.0;
+	field->value_has_changed_manual_override = FALSE;
+	field->callback_list = NULL;
+	field->application_ptr = NULL;
+	field->active = FALSE;
+	field->array_allocated_size = 0;
+
+	/* The dimensions of varargs fields depend on the values of
+	 * other fields in the same record, so each record needs its
+	 * own copy.
+	 */
+
+	if ( field_defaults->flags & MXFF_VARARGS ) {
+		return mx_allocate_private_dimension_array( field,
+						field_defaults->dimension );
+	}
+
+	field->dimension = field_defaults->dimension;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_make_record_field_private( MX_RECORD_FIELD *field )
+{
+	static const char fname[] = "mx_make_record_field_private()";
+
+	if ( field == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD_FIELD pointer passed was NULL." );
+	}
+
+	if ( mx_record_field_is_shared( field ) == FALSE )
+		return MX_SUCCESSFUL_RESULT;
+
+	return mx_allocate_private_dimension_array( field, field->dimension );
+}
+
+MX_EXPORT void
+mx_free_record_field_private_arrays( MX_RECORD_FIELD *field )
+{
+	if ( field == (MX_RECORD_FIELD *) NULL )
+		return;
+
+	if ( mx_record_field_is_shared( field ) == FALSE ) {
+		mx_free( field->dimension );
+	}
+
+	field->dimension = NULL;
+}
+
+MX_EXPORT mx_bool_type
+mx_record_field_is_shared( MX_RECORD_FIELD *field )
+{
+	if ( ( field == (MX_RECORD_FIELD *) NULL )
+	  || ( field->descriptor == (MX_RECORD_FIELD_DEFAULTS *) NULL ) )
+	{
+		return FALSE;
+	}
+
+	if ( field->dimension == field->descriptor->dimension )
+		return TRUE;
+
+	return FALSE;
+}
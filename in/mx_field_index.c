@@ -0,0 +1,482 @@
+/*
+ * Name:    mx_field_index.c
+ *
+ * Purpose: Per-driver perfect hash tables for looking up record fields
+ *          by name.
+ *
+ *          The perfect hash uses the "hash, displace, and compress"
+ *          scheme.  Field names are first hashed into buckets.  Each
+ *          bucket gets a displacement value that is used as the seed
+ *          of a second hash which sends every name in the bucket to
+ *          its own slot.  Buckets holding a single name are sent
+ *          directly to a free slot by storing a negative displacement.
+ *          A lookup therefore costs two hash computations and one
+ *          string comparison, no matter how many fields the driver has.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+#define MX_FIELD_INDEX_MAX_DISPLACEMENT		1000000L
+
+/* This is FNV-1a using the displacement as the initial hash value. */
+
+static uint32_t
+mx_field_name_hash( uint32_t seed, const char *name )
+{
+	const unsigned char *ptr;
+	uint32_t hash;
+
+	if ( seed == 0 ) {
+		hash = 2166136261U;
+	} else {
+		hash = seed;
+	}
+
+	for ( ptr = (const unsigned char *) name; *ptr != '\0'; ptr++ ) {
+		hash ^= (uint32_t) *ptr;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static mx_status_type
+mx_field_index_get_defaults( MX_DRIVER *driver,
+			long *num_fields,
+			MX_RECORD_FIELD_DEFAULTS **defaults_array,
+			const char *calling_fname )
+{
+	static const char fname[] = "mx_field_index_get_defaults()";
+
+	/* The outputs are always set, even if an error is returned. */
+
+	*num_fields = 0;
+	*defaults_array = NULL;
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_DRIVER pointer passed by '%s' was NULL.",
+			calling_fname );
+	}
+
+	if ( ( driver->num_record_fields == (long *) NULL )
+	  || ( driver->record_field_defaults_ptr
+			== (MX_RECORD_FIELD_DEFAULTS **) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	*num_fields = *(driver->num_record_fields);
+	*defaults_array = *(driver->record_field_defaults_ptr);
+
+	if ( ( *num_fields > 0 )
+	  && ( *defaults_array == (MX_RECORD_FIELD_DEFAULTS *) NULL ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Driver '%s' claims to have %ld record fields, but its "
+		"record field defaults array pointer is NULL.",
+			driver->name, *num_fields );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static void
+mx_free_field_name_index( MX_FIELD_NAME_INDEX *field_index )
+{
+	if ( field_index == (MX_FIELD_NAME_INDEX *) NULL )
+		return;
+
+	mx_free( field_index->displacement_array );
+	mx_free( field_index->field_index_array );
+
+	free( field_index );
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_field_name_index( MX_DRIVER *driver )
+{
+	static const char fname[] = "mx_create_field_name_index()";
+
+	MX_FIELD_NAME_INDEX *field_index;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	long num_fields, num_buckets_used, i, j, k, b, slot;
+	long bucket_size, max_bucket_size;
+	long *bucket_of_field, *bucket_count, *bucket_start, *bucket_member;
+	long *bucket_order, *slot_array;
+	char *slot_used;
+	uint32_t d;
+	mx_bool_type placed;
+	mx_status_type mx_status;
+
+	mx_status = mx_field_index_get_defaults( driver,
+				&num_fields, &defaults_array, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_delete_field_name_index( driver );
+
+	if ( num_fields <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	field_index = (MX_FIELD_NAME_INDEX *)
+			calloc( 1, sizeof(MX_FIELD_NAME_INDEX) );
+
+	if ( field_index == (MX_FIELD_NAME_INDEX *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an MX_FIELD_NAME_INDEX "
+		"for driver '%s'.", driver->name );
+	}
+
+	field_index->num_fields = num_fields;
+	field_index->record_field_defaults_array = defaults_array;
+
+	field_index->displacement_array = (long *)
+				calloc( num_fields, sizeof(long) );
+
+	field_index->field_index_array = (long *)
+				malloc( num_fields * sizeof(long) );
+
+	/* Scratch arrays used only while the index is being built. */
+
+	bucket_of_field = (long *) malloc( num_fields * sizeof(long) );
+	bucket_count    = (long *) calloc( num_fields + 1, sizeof(long) );
+	bucket_start    = (long *) calloc( num_fields + 1, sizeof(long) );
+	bucket_member   = (long *) malloc( num_fields * sizeof(long) );
+	bucket_order    = (long *) malloc( num_fields * sizeof(long) );
+	slot_array      = (long *) malloc( num_fields * sizeof(long) );
+	slot_used       = (char *) calloc( num_fields, sizeof(char) );
+
+	if ( ( field_index->displacement_array == NULL )
+	  || ( field_index->field_index_array == NULL )
+	  || ( bucket_of_field == NULL ) || ( bucket_count == NULL )
+	  || ( bucket_start == NULL ) || ( bucket_member == NULL )
+	  || ( bucket_order == NULL ) || ( slot_array == NULL )
+	  || ( slot_used == NULL ) )
+	{
+		mx_status = mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to build the field name index "
+		"for driver '%s'.", driver->name );
+
+		goto cleanup;
+	}
+
+	for ( i = 0; i < num_fields; i++ ) {
+		field_index->field_index_array[i] = -1;
+	}
+
+	/* Sort the field names into buckets using the unseeded hash. */
+
+	for ( i = 0; i < num_fields; i++ ) {
+		b = (long) ( mx_field_name_hash( 0, defaults_array[i].name )
+				% (uint32_t) num_fields );
+
+		bucket_of_field[i] = b;
+		bucket_count[b]++;
+	}
+
+	for ( b = 0; b < num_fields; b++ ) {
+		bucket_start[b+1] = bucket_start[b] + bucket_count[b];
+	}
+
+	memset( bucket_count, 0, (num_fields + 1) * sizeof(long) );
+
+	for ( i = 0; i < num_fields; i++ ) {
+		b = bucket_of_field[i];
+
+		bucket_member[ bucket_start[b] + bucket_count[b] ] = i;
+		bucket_count[b]++;
+	}
+
+	/* Handle the buckets in order of decreasing size, since the
+	 * big buckets are the hardest to place.
+	 */
+
+	max_bucket_size = 0;
+
+	for ( b = 0; b < num_fields; b++ ) {
+		if ( bucket_count[b] > max_bucket_size )
+			max_bucket_size = bucket_count[b];
+	}
+
+	k = 0;
+
+	for ( bucket_size = max_bucket_size; bucket_size > 0; bucket_size-- ) {
+		for ( b = 0; b < num_fields; b++ ) {
+			if ( bucket_count[b] == bucket_size ) {
+				bucket_order[k] = b;
+				k++;
+			}
+		}
+	}
+
+	num_buckets_used = k;
+
+	for ( k = 0; k < num_buckets_used; k++ ) {
+		b = bucket_order[k];
+
+		bucket_size = bucket_count[b];
+
+		if ( bucket_size == 1 ) {
+			/* Single entry buckets can go in any free slot. */
+
+			for ( slot = 0; slot < num_fields; slot++ ) {
+				if ( slot_used[slot] == FALSE )
+					break;
+			}
+
+			i = bucket_member[ bucket_start[b] ];
+
+			slot_used[slot] = TRUE;
+			field_index->field_index_array[slot] = i;
+			field_index->displacement_array[b] = - slot - 1;
+
+			continue;
+		}
+
+		/* Search for a displacement that sends every name in
+		 * this bucket to a different free slot.
+		 */
+
+		placed = FALSE;
+
+		for ( d = 1; d < MX_FIELD_INDEX_MAX_DISPLACEMENT; d++ ) {
+
+			for ( j = 0; j < bucket_size; j++ ) {
+				i = bucket_member[ bucket_start[b] + j ];
+
+				slot = (long) ( mx_field_name_hash( d,
+						defaults_array[i].name )
+						% (uint32_t) num_fields );
+
+				if ( slot_used[slot] )
+					break;
+
+				slot_used[slot] = TRUE;
+				slot_array[j] = slot;
+			}
+
+			if ( j >= bucket_size ) {
+				placed = TRUE;
+				break;
+			}
+
+			/* Undo the partial placement and try again. */
+
+			while ( j > 0 ) {
+				j--;
+				slot_used[ slot_array[j] ] = FALSE;
+			}
+		}
+
+		if ( placed == FALSE ) {
+			mx_status = mx_error( MXE_FUNCTION_FAILED, fname,
+			"Could not find a perfect hash for the field names "
+			"of driver '%s'.  Does the driver have two fields "
+			"with the same name?", driver->name );
+
+			goto cleanup;
+		}
+
+		field_index->displacement_array[b] = (long) d;
+
+		for ( j = 0; j < bucket_size; j++ ) {
+			i = bucket_member[ bucket_start[b] + j ];
+
+			field_index->field_index_array[ slot_array[j] ] = i;
+		}
+	}
+
+	driver->field_name_index = field_index;
+
+	field_index = NULL;
+
+	mx_status = MX_SUCCESSFUL_RESULT;
+
+cleanup:
+	mx_free_field_name_index( field_index );
+
+	mx_free( bucket_of_field );
+	mx_free( bucket_count );
+	mx_free( bucket_start );
+	mx_free( bucket_member );
+	mx_free( bucket_order );
+	mx_free( slot_array );
+	mx_free( slot_used );
+
+	return mx_status;
+}
+
+MX_EXPORT mx_status_type
+mx_create_field_name_indexes( MX_DRIVER *driver_list )
+{
+	MX_DRIVER *driver;
+	mx_status_type mx_status;
+
+	for ( driver = driver_list;
+		driver != (MX_DRIVER *) NULL;
+		driver = driver->next_driver )
+	{
+		mx_status = mx_create_field_name_index( driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_delete_field_name_index( MX_DRIVER *driver )
+{
+	if ( driver == (MX_DRIVER *) NULL )
+		return;
+
+	mx_free_field_name_index( (MX_FIELD_NAME_INDEX *)
+					driver->field_name_index );
+
+	driver->field_name_index = NULL;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT long
+mx_get_field_index_by_name( MX_DRIVER *driver, const char *field_name )
+{
+	MX_FIELD_NAME_INDEX *field_index;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	long num_fields, b, d, slot, i;
+
+	if ( ( driver == (MX_DRIVER *) NULL )
+	  || ( field_name == (const char *) NULL ) )
+	{
+		return -1;
+	}
+
+	field_index = (MX_FIELD_NAME_INDEX *) driver->field_name_index;
+
+	if ( field_index == (MX_FIELD_NAME_INDEX *) NULL ) {
+
+		/* No index exists yet, so use a linear search. */
+
+		if ( ( driver->num_record_fields == (long *) NULL )
+		  || ( driver->record_field_defaults_ptr == NULL ) )
+		{
+			return -1;
+		}
+
+		num_fields = *(driver->num_record_fields);
+		defaults_array = *(driver->record_field_defaults_ptr);
+
+		for ( i = 0; i < num_fields; i++ ) {
+			if ( strcmp( field_name, defaults_array[i].name ) == 0 )
+				return i;
+		}
+
+		return -1;
+	}
+
+	num_fields = field_index->num_fields;
+
+	b = (long) ( mx_field_name_hash( 0, field_name )
+			% (uint32_t) num_fields );
+
+	d = field_index->displacement_array[b];
+
+	if ( d < 0 ) {
+		slot = - d - 1;
+	} else {
+		slot = (long) ( mx_field_name_hash( (uint32_t) d, field_name )
+				% (uint32_t) num_fields );
+	}
+
+	i = field_index->field_index_array[slot];
+
+	if ( i < 0 )
+		return -1;
+
+	/* Names that are not in the table still hash to some slot,
+	 * so we must confirm the match.
+	 */
+
+	if ( strcmp( field_name,
+		field_index->record_field_defaults_array[i].name ) != 0 )
+	{
+		return -1;
+	}
+
+	return i;
+}
+
+MX_EXPORT MX_RECORD_FIELD *
+mx_lookup_record_field( MX_RECORD *record, const char *field_name )
+{
+	MX_DRIVER *driver;
+	MX_RECORD_FIELD *field_array;
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	long i;
+
+	if ( ( record == (MX_RECORD *) NULL )
+	  || ( field_name == (const char *) NULL ) )
+	{
+		return NULL;
+	}
+
+	field_array = record->record_field_array;
+
+	if ( field_array == (MX_RECORD_FIELD *) NULL )
+		return NULL;
+
+	driver = mx_get_driver_for_record( record );
+
+	i = mx_get_field_index_by_name( driver, field_name );
+
+	/* The record field array is normally in the same order as the
+	 * driver's field defaults array.  If it is not, we fall through
+	 * to the linear search below.
+	 */
+
+	if ( ( i >= 0 ) && ( i < record->num_record_fields )
+	  && ( field_array[i].descriptor != NULL )
+	  && ( strcmp( field_array[i].descriptor->name, field_name ) == 0 ) )
+	{
+		return &field_array[i];
+	}
+
+	if ( ( i < 0 ) && ( driver != (MX_DRIVER *) NULL )
+	  && ( driver->field_name_index != NULL ) )
+	{
+		return NULL;
+	}
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		descriptor = field_array[i].descriptor;
+
+		if ( descriptor == (MX_RECORD_FIELD_DEFAULTS *) NULL )
+			continue;
+
+		if ( strcmp( descriptor->name, field_name ) == 0 )
+			return &field_array[i];
+	}
+
+	return NULL;
+}
@@ -0,0 +1,409 @@
+/*
+ * Name:    mx_field_label.c
+ *
+ * Purpose: Per-driver dense tables for looking up record fields by
+ *          label value.
+ *
+ *          mx_get_field_by_label_value() and the functions that convert
+ *          between parameter names and parameter types search through
+ *          all of the fields of a record.  They are called for every
+ *          get_parameter and set_parameter request, so each driver
+ *          gets a table that maps a label value straight to its field.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+
+/* Label values that are closer together than this share a range, with
+ * the unused values in between marked as -1.
+ */
+
+#define MX_FIELD_LABEL_MAX_GAP		32
+
+typedef struct {
+	long label_value;
+	long field_index;
+} MX_FIELD_LABEL_PAIR;
+
+static int
+mx_field_label_pair_compare( const void *a, const void *b )
+{
+	const MX_FIELD_LABEL_PAIR *pair_a = (const MX_FIELD_LABEL_PAIR *) a;
+	const MX_FIELD_LABEL_PAIR *pair_b = (const MX_FIELD_LABEL_PAIR *) b;
+
+	if ( pair_a->label_value < pair_b->label_value )
+		return -1;
+
+	if ( pair_a->label_value > pair_b->label_value )
+		return 1;
+
+	/* If two fields share a label value, the first one wins, just
+	 * as it does for a linear search.
+	 */
+
+	if ( pair_a->field_index < pair_b->field_index )
+		return -1;
+
+	if ( pair_a->field_index > pair_b->field_index )
+		return 1;
+
+	return 0;
+}
+
+static void
+mx_free_field_label_index( MX_FIELD_LABEL_INDEX *label_index )
+{
+	if ( label_index == (MX_FIELD_LABEL_INDEX *) NULL )
+		return;
+
+	mx_free( label_index->range_array );
+	mx_free( label_index->field_index_array );
+
+	free( label_index );
+}
+
+MX_EXPORT mx_status_type
+mx_create_field_label_index( MX_DRIVER *driver )
+{
+	static const char fname[] = "mx_create_field_label_index()";
+
+	MX_FIELD_LABEL_INDEX *label_index;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	MX_FIELD_LABEL_PAIR *pair_array;
+	MX_FIELD_LABEL_RANGE *range;
+	long num_fields, num_pairs, num_ranges, num_slots, i, slot;
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_DRIVER pointer passed was NULL." );
+	}
+
+	mx_delete_field_label_index( driver );
+
+	if ( ( driver->num_record_fields == (long *) NULL )
+	  || ( driver->record_field_defaults_ptr
+			== (MX_RECORD_FIELD_DEFAULTS **) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	num_fields = *(driver->num_record_fields);
+	defaults_array = *(driver->record_field_defaults_ptr);
+
+	if ( ( num_fields <= 0 )
+	  || ( defaults_array == (MX_RECORD_FIELD_DEFAULTS *) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	pair_array = (MX_FIELD_LABEL_PAIR *)
+			malloc( num_fields * sizeof(MX_FIELD_LABEL_PAIR) );
+
+	if ( pair_array == (MX_FIELD_LABEL_PAIR *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %ld element "
+		"label array for driver '%s'.", num_fields, driver->name );
+	}
+
+	/* Fields without a label value have a negative one. */
+
+	num_pairs = 0;
+
+	for ( i = 0; i < num_fields; i++ ) {
+		if ( defaults_array[i].label_value < 0 )
+			continue;
+
+		pair_array[num_pairs].label_value =
+					defaults_array[i].label_value;
+		pair_array[num_pairs].field_index = i;
+
+		num_pairs++;
+	}
+
+	if ( num_pairs == 0 ) {
+		mx_free( pair_array );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	qsort( pair_array, num_pairs, sizeof(MX_FIELD_LABEL_PAIR),
+					mx_field_label_pair_compare );
+
+	/* Count the ranges and the slots they need. */
+
+	num_ranges = 1;
+	num_slots = 1;
+
+	for ( i = 1; i < num_pairs; i++ ) {
+		if ( pair_array[i].label_value - pair_array[i-1].label_value
+				> MX_FIELD_LABEL_MAX_GAP )
+		{
+			num_ranges++;
+			num_slots++;
+		} else {
+			num_slots += pair_array[i].label_value
+					- pair_array[i-1].label_value;
+		}
+	}
+
+	label_index = (MX_FIELD_LABEL_INDEX *)
+			calloc( 1, sizeof(MX_FIELD_LABEL_INDEX) );
+
+	if ( label_index != (MX_FIELD_LABEL_INDEX *) NULL ) {
+		label_index->num_ranges = num_ranges;
+		label_index->num_slots = num_slots;
+		label_index->record_field_defaults_array = defaults_array;
+
+		label_index->range_array = (MX_FIELD_LABEL_RANGE *)
+			malloc( num_ranges * sizeof(MX_FIELD_LABEL_RANGE) );
+
+		label_index->field_index_array = (long *)
+			malloc( num_slots * sizeof(long) );
+	}
+
+	if ( ( label_index == (MX_FIELD_LABEL_INDEX *) NULL )
+	  || ( label_index->range_array == (MX_FIELD_LABEL_RANGE *) NULL )
+	  || ( label_index->field_index_array == (long *) NULL ) )
+	{
+		mx_free_field_label_index( label_index );
+		mx_free( pair_array );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to create the label index "
+		"for driver '%s'.", driver->name );
+	}
+
+	for ( i = 0; i < num_slots; i++ ) {
+		label_index->field_index_array[i] = -1;
+	}
+
+	/* Fill in the ranges. */
+
+	range = label_index->range_array;
+
+	range->first_label_value = pair_array[0].label_value;
+	range->num_label_values = 1;
+	range->first_slot = 0;
+
+	label_index->field_index_array[0] = pair_array[0].field_index;
+
+	for ( i = 1; i < num_pairs; i++ ) {
+		if ( pair_array[i].label_value == pair_array[i-1].label_value )
+			continue;
+
+		if ( pair_array[i].label_value - pair_array[i-1].label_value
+				> MX_FIELD_LABEL_MAX_GAP )
+		{
+			slot = range->first_slot + range->num_label_values;
+
+			range++;
+
+			range->first_label_value = pair_array[i].label_value;
+			range->num_label_values = 1;
+			range->first_slot = slot;
+		} else {
+			range->num_label_values = pair_array[i].label_value
+					- range->first_label_value + 1;
+
+			slot = range->first_slot + range->num_label_values - 1;
+		}
+
+		label_index->field_index_array[slot] =
+					pair_array[i].field_index;
+	}
+
+	mx_free( pair_array );
+
+	driver->field_label_index = label_index;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_create_field_label_indexes( MX_DRIVER *driver_list )
+{
+	MX_DRIVER *driver;
+	mx_status_type mx_status;
+
+	for ( driver = driver_list;
+		driver != (MX_DRIVER *) NULL;
+		driver = driver->next_driver )
+	{
+		mx_status = mx_create_field_label_index( driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_delete_field_label_index( MX_DRIVER *driver )
+{
+	if ( driver == (MX_DRIVER *) NULL )
+		return;
+
+	mx_free_field_label_index( (MX_FIELD_LABEL_INDEX *)
+					driver->field_label_index );
+
+	driver->field_label_index = NULL;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT long
+mx_get_field_index_by_label_value( MX_DRIVER *driver, long label_value )
+{
+	MX_FIELD_LABEL_INDEX *label_index;
+	MX_FIELD_LABEL_RANGE *range;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	long num_fields, low, high, middle, i;
+
+	if ( ( driver == (MX_DRIVER *) NULL ) || ( label_value < 0 ) )
+		return -1;
+
+	label_index = (MX_FIELD_LABEL_INDEX *) driver->field_label_index;
+
+	if ( label_index == (MX_FIELD_LABEL_INDEX *) NULL ) {
+
+		/* No index exists yet, so use a linear search. */
+
+		if ( ( driver->num_record_fields == (long *) NULL )
+		  || ( driver->record_field_defaults_ptr == NULL ) )
+		{
+			return -1;
+		}
+
+		num_fields = *(driver->num_record_fields);
+		defaults_array = *(driver->record_field_defaults_ptr);
+
+		for ( i = 0; i < num_fields; i++ ) {
+			if ( defaults_array[i].label_value == label_value )
+				return i;
+		}
+
+		return -1;
+	}
+
+	/* There are only a handful of ranges, so this search takes at
+	 * most two or three steps.
+	 */
+
+	low = 0;
+	high = label_index->num_ranges - 1;
+
+	while ( low < high ) {
+		middle = ( low + high + 1 ) / 2;
+
+		if ( label_index->range_array[middle].first_label_value
+							<= label_value )
+		{
+			low = middle;
+		} else {
+			high = middle - 1;
+		}
+	}
+
+	range = &(label_index->range_array[low]);
+
+	if ( ( label_value < range->first_label_value )
+	  || ( label_value >= range->first_label_value
+				+ range->num_label_values ) )
+	{
+		return -1;
+	}
+
+	return label_index->field_index_array[ range->first_slot
+			+ ( label_value - range->first_label_value ) ];
+}
+
+MX_EXPORT MX_RECORD_FIELD *
+mx_lookup_field_by_label_value( MX_RECORD *record, long label_value )
+{
+	MX_DRIVER *driver;
+	MX_RECORD_FIELD *field_array;
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	long i;
+
+	if ( record == (MX_RECORD *) NULL )
+		return NULL;
+
+	field_array = record->record_field_array;
+
+	if ( field_array == (MX_RECORD_FIELD *) NULL )
+		return NULL;
+
+	driver = mx_get_driver_for_record( record );
+
+	i = mx_get_field_index_by_label_value( driver, label_value );
+
+	/* As in mx_lookup_record_field(), the record field array is
+	 * normally in the same order as the driver's field defaults.
+	 */
+
+	if ( ( i >= 0 ) && ( i < record->num_record_fields )
+	  && ( field_array[i].descriptor != NULL )
+	  && ( field_array[i].descriptor->label_value == label_value ) )
+	{
+		return &field_array[i];
+	}
+
+	if ( ( i < 0 ) && ( driver != (MX_DRIVER *) NULL )
+	  && ( driver->field_label_index != NULL ) )
+	{
+		return NULL;
+	}
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		descriptor = field_array[i].descriptor;
+
+		if ( descriptor == (MX_RECORD_FIELD_DEFAULTS *) NULL )
+			continue;
+
+		if ( descriptor->label_value == label_value )
+			return &field_array[i];
+	}
+
+	return NULL;
+}
+
+MX_EXPORT const char *
+mx_lookup_parameter_name( MX_RECORD *record, long parameter_type )
+{
+	MX_RECORD_FIELD *field;
+
+	field = mx_lookup_field_by_label_value( record, parameter_type );
+
+	if ( field == (MX_RECORD_FIELD *) NULL )
+		return NULL;
+
+	return field->descriptor->name;
+}
+
+MX_EXPORT long
+mx_lookup_parameter_type( MX_RECORD *record, const char *parameter_name )
+{
+	MX_RECORD_FIELD *field;
+
+	field = mx_lookup_record_field( record, parameter_name );
+
+	if ( field == (MX_RECORD_FIELD *) NULL )
+		return -1;
+
+	return field->descriptor->label_value;
+}
@@ -0,0 +1,381 @@
+/*
+ * Name:    mx_hash_table.c
+ *
+ * Purpose: String keyed hash tables used to speed up name lookups
+ *          in MX databases.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_hash_table.h"
+
+/* Slots whose key has been deleted point to this marker, so that
+ * probe sequences running through them are not broken.
+ */
+
+static const char mx_hash_table_deleted_key[] = "";
+
+#define MX_HASH_SLOT_IS_DELETED(e) \
+		( (e)->key == mx_hash_table_deleted_key )
+
+/* We use the 32-bit FNV-1a hash function. */
+
+#define MX_FNV_OFFSET_BASIS	2166136261U
+#define MX_FNV_PRIME		16777619U
+
+MX_EXPORT uint32_t
+mx_hash_string( const char *string )
+{
+	const unsigned char *ptr;
+	uint32_t hash;
+
+	hash = MX_FNV_OFFSET_BASIS;
+
+	if ( string == NULL )
+		return hash;
+
+	for ( ptr = (const unsigned char *) string; *ptr != '\0'; ptr++ ) {
+		hash ^= (uint32_t) *ptr;
+		hash *= MX_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+MX_EXPORT uint32_t
+mx_hash_string_n( const char *string, size_t length )
+{
+	const unsigned char *ptr;
+	uint32_t hash;
+	size_t i;
+
+	hash = MX_FNV_OFFSET_BASIS;
+
+	if ( string == NULL )
+		return hash;
+
+	ptr = (const unsigned char *) string;
+
+	for ( i = 0; i < length; i++ ) {
+		hash ^= (uint32_t) ptr[i];
+		hash *= MX_FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/*------------------------------------------------------------------------*/
+
+static unsigned long
+mx_hash_table_slots_for_keys( unsigned long num_keys )
+{
+	unsigned long num_slots, needed_slots;
+
+	needed_slots = ( 100 * num_keys ) / MX_HASH_TABLE_MAX_LOAD_PERCENT + 1;
+
+	num_slots = MX_HASH_TABLE_MIN_SLOTS;
+
+	while ( num_slots < needed_slots ) {
+		num_slots *= 2;
+	}
+
+	return num_slots;
+}
+
+MX_EXPORT mx_status_type
+mx_hash_table_create( MX_HASH_TABLE **hash_table,
+			unsigned long expected_num_keys )
+{
+	static const char fname[] = "mx_hash_table_create()";
+
+	MX_HASH_TABLE *table;
+
+	if ( hash_table == (MX_HASH_TABLE **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_HASH_TABLE pointer passed was NULL." );
+	}
+
+	table = (MX_HASH_TABLE *) malloc( sizeof(MX_HASH_TABLE) );
+
+	if ( table == (MX_HASH_TABLE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an MX_HASH_TABLE." );
+	}
+
+	table->num_slots = mx_hash_table_slots_for_keys( expected_num_keys );
+	table->num_keys = 0;
+	table->num_deleted_slots = 0;
+
+	table->entry_array = (MX_HASH_TABLE_ENTRY *)
+		calloc( table->num_slots, sizeof(MX_HASH_TABLE_ENTRY) );
+
+	if ( table->entry_array == (MX_HASH_TABLE_ENTRY *) NULL ) {
+		free( table );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a %lu slot hash table.",
+			mx_hash_table_slots_for_keys( expected_num_keys ) );
+	}
+
+	*hash_table = table;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_hash_table_destroy( MX_HASH_TABLE *hash_table )
+{
+	if ( hash_table == (MX_HASH_TABLE *) NULL )
+		return;
+
+	mx_free( hash_table->entry_array );
+
+	free( hash_table );
+}
+
+/*------------------------------------------------------------------------*/
+
+static MX_HASH_TABLE_ENTRY *
+mx_hash_table_find_entry( MX_HASH_TABLE *hash_table,
+			const char *key,
+			size_t key_length,
+			uint32_t hash )
+{
+	MX_HASH_TABLE_ENTRY *entry;
+	unsigned long i, mask;
+
+	mask = hash_table->num_slots - 1;
+
+	for ( i = hash & mask; ; i = (i + 1) & mask ) {
+
+		entry = &(hash_table->entry_array[i]);
+
+		if ( entry->key == NULL )
+			return NULL;
+
+		if ( MX_HASH_SLOT_IS_DELETED(entry) )
+			continue;
+
+		if ( ( entry->hash == hash )
+		  && ( strncmp( entry->key, key, key_length ) == 0 )
+		  && ( entry->key[key_length] == '\0' ) )
+		{
+			return entry;
+		}
+	}
+
+	MXW_NOT_REACHED( return NULL );
+}
+
+static void
+mx_hash_table_place_entry( MX_HASH_TABLE_ENTRY *entry_array,
+			unsigned long num_slots,
+			const char *key,
+			uint32_t hash,
+			void *value )
+{
+	MX_HASH_TABLE_ENTRY *entry;
+	unsigned long i, mask;
+
+	mask = num_slots - 1;
+
+	for ( i = hash & mask; ; i = (i + 1) & mask ) {
+
+		entry = &entry_array[i];
+
+		if ( ( entry->key == NULL ) || MX_HASH_SLOT_IS_DELETED(entry) )
+		{
+			entry->key = key;
+			entry->hash = hash;
+			entry->value = value;
+			return;
+		}
+	}
+}
+
+static mx_status_type
+mx_hash_table_resize( MX_HASH_TABLE *hash_table, unsigned long new_num_slots )
+{
+	static const char fname[] = "mx_hash_table_resize()";
+
+	MX_HASH_TABLE_ENTRY *old_entry_array, *new_entry_array, *entry;
+	unsigned long i;
+
+	new_entry_array = (MX_HASH_TABLE_ENTRY *)
+		calloc( new_num_slots, sizeof(MX_HASH_TABLE_ENTRY) );
+
+	if ( new_entry_array == (MX_HASH_TABLE_ENTRY *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to grow a hash table to %lu slots.",
+			new_num_slots );
+	}
+
+	old_entry_array = hash_table->entry_array;
+
+	for ( i = 0; i < hash_table->num_slots; i++ ) {
+		entry = &old_entry_array[i];
+
+		if ( ( entry->key == NULL ) || MX_HASH_SLOT_IS_DELETED(entry) )
+			continue;
+
+		mx_hash_table_place_entry( new_entry_array, new_num_slots,
+					entry->key, entry->hash, entry->value );
+	}
+
+	free( old_entry_array );
+
+	hash_table->entry_array = new_entry_array;
+	hash_table->num_slots = new_num_slots;
+	hash_table->num_deleted_slots = 0;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_hash_table_insert( MX_HASH_TABLE *hash_table,
+			const char *key,
+			void *value )
+{
+	static const char fname[] = "mx_hash_table_insert()";
+
+	MX_HASH_TABLE_ENTRY *entry;
+	unsigned long used_slots;
+	uint32_t hash;
+	mx_status_type mx_status;
+
+	if ( hash_table == (MX_HASH_TABLE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_HASH_TABLE pointer passed was NULL." );
+	}
+	if ( key == (const char *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The key pointer passed was NULL." );
+	}
+
+	hash = mx_hash_string( key );
+
+	entry = mx_hash_table_find_entry( hash_table,
+					key, strlen(key), hash );
+
+	if ( entry != (MX_HASH_TABLE_ENTRY *) NULL ) {
+		entry->key = key;
+		entry->value = value;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	/* Deleted slots count against the load factor, since they
+	 * lengthen probe sequences just like live keys do.
+	 */
+
+	used_slots = hash_table->num_keys + hash_table->num_deleted_slots + 1;
+
+	if ( (100 * used_slots) >
+	    (MX_HASH_TABLE_MAX_LOAD_PERCENT * hash_table->num_slots) )
+	{
+		mx_status = mx_hash_table_resize( hash_table,
+			mx_hash_table_slots_for_keys( hash_table->num_keys+1 ));
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	mx_hash_table_place_entry( hash_table->entry_array,
+				hash_table->num_slots, key, hash, value );
+
+	hash_table->num_keys++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_hash_table_delete( MX_HASH_TABLE *hash_table,
+			const char *key,
+			void *value )
+{
+	static const char fname[] = "mx_hash_table_delete()";
+
+	MX_HASH_TABLE_ENTRY *entry;
+
+	if ( hash_table == (MX_HASH_TABLE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_HASH_TABLE pointer passed was NULL." );
+	}
+	if ( key == (const char *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The key pointer passed was NULL." );
+	}
+
+	entry = mx_hash_table_find_entry( hash_table,
+				key, strlen(key), mx_hash_string(key) );
+
+	if ( entry == (MX_HASH_TABLE_ENTRY *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( ( value != NULL ) && ( entry->value != value ) )
+		return MX_SUCCESSFUL_RESULT;
+
+	entry->key = mx_hash_table_deleted_key;
+	entry->value = NULL;
+
+	hash_table->num_keys--;
+	hash_table->num_deleted_slots++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void *
+mx_hash_table_lookup( MX_HASH_TABLE *hash_table, const char *key )
+{
+	MX_HASH_TABLE_ENTRY *entry;
+
+	if ( ( hash_table == (MX_HASH_TABLE *) NULL )
+	  || ( key == (const char *) NULL ) )
+	{
+		return NULL;
+	}
+
+	entry = mx_hash_table_find_entry( hash_table,
+				key, strlen(key), mx_hash_string(key) );
+
+	if ( entry == (MX_HASH_TABLE_ENTRY *) NULL )
+		return NULL;
+
+	return entry->value;
+}
+
+MX_EXPORT void *
+mx_hash_table_lookup_n( MX_HASH_TABLE *hash_table,
+			const char *key,
+			size_t key_length )
+{
+	MX_HASH_TABLE_ENTRY *entry;
+
+	if ( ( hash_table == (MX_HASH_TABLE *) NULL )
+	  || ( key == (const char *) NULL ) )
+	{
+		return NULL;
+	}
+
+	entry = mx_hash_table_find_entry( hash_table, key, key_length,
+				mx_hash_string_n( key, key_length ) );
+
+	if ( entry == (MX_HASH_TABLE_ENTRY *) NULL )
+		return NULL;
+
+	return entry->value;
+}
@@ -0,0 +1,94 @@
+/*
+ * Name:    mx_hash_table.h
+ *
+ * Purpose: Header file for string keyed hash tables used to speed up
+ *          name lookups in MX databases.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_HASH_TABLE_H__
+#define __MX_HASH_TABLE_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MX hash tables use open addressing with linear probing.  The number
+ * of slots is always a power of 2 and the table is resized when it
+ * becomes more than MX_HASH_TABLE_MAX_LOAD_PERCENT full.
+ *
+ * The hash table does _not_ make copies of the keys.  The caller must
+ * make sure that the key strings stay valid for as long as they are
+ * in the table.  For record names, this is true since the key is
+ * just a pointer to the 'name' array in the MX_RECORD itself.
+ */
+
+#define MX_HASH_TABLE_MIN_SLOTS			16
+#define MX_HASH_TABLE_MAX_LOAD_PERCENT		70
+
+typedef struct {
+	const char *key;
+	uint32_t hash;
+	void *value;
+} MX_HASH_TABLE_ENTRY;
+
+typedef struct {
+	unsigned long num_slots;
+	unsigned long num_keys;
+	unsigned long num_deleted_slots;
+	MX_HASH_TABLE_ENTRY *entry_array;
+} MX_HASH_TABLE;
+
+MX_API uint32_t mx_hash_string( const char *string );
+
+MX_API uint32_t mx_hash_string_n( const char *string, size_t length );
+
+MX_API mx_status_type mx_hash_table_create( MX_HASH_TABLE **hash_table,
+					unsigned long expected_num_keys );
+
+MX_API void mx_hash_table_destroy( MX_HASH_TABLE *hash_table );
+
+/* mx_hash_table_insert() replaces the value of a key that is already
+ * present in the table.
+ */
+
+MX_API mx_status_type mx_hash_table_insert( MX_HASH_TABLE *hash_table,
+					const char *key,
+					void *value );
+
+/* mx_hash_table_delete() only removes the key if it currently maps to
+ * 'value'.  If 'value' is NULL, the key is removed unconditionally.
+ */
+
+MX_API mx_status_type mx_hash_table_delete( MX_HASH_TABLE *hash_table,
+					const char *key,
+					void *value );
+
+MX_API void *mx_hash_table_lookup( MX_HASH_TABLE *hash_table,
+					const char *key );
+
+/* mx_hash_table_lookup_n() looks up a key that is not null terminated. */
+
+MX_API void *mx_hash_table_lookup_n( MX_HASH_TABLE *hash_table,
+					const char *key,
+					size_t key_length );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_HASH_TABLE_H__ */
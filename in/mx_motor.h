@@ -62,6 +62,7 @@ extern "C" {
 #define MXF_MTR_ACCEL_NONE			0
 #define MXF_MTR_ACCEL_RATE			1	/* in units/sec**2 */
 #define MXF_MTR_ACCEL_TIME			2	/* in sec */
+#define MXF_MTR_ACCEL_S_CURVE			3	/* rate, then jerk */
 
 #define MXF_MTR_ACCEL_OTHER			0x10000
 
@@ -378,8 +379,111 @@ typedef struct {
 	double integral_limit;
 	double extra_gain;
 
+	/* Drivers that call mx_motor_notify_move_complete() at the end of
+	 * every move set completion_events_supported to TRUE, so that
+	 * mx_wait_for_motor_array_completion() does not need to poll them.
+	 * completion_event_count is incremented by every notification
+	 * and is only accessed under the record list notifier's mutex.
+	 */
+
+	mx_bool_type completion_events_supported;
+	unsigned long completion_event_count;
+
+	void *state_cache;	/* Ptr to MX_MOTOR_STATE_CACHE */
+
+	void *position_chain;	/* Ptr to MX_MOTOR_POSITION_CHAIN */
+
 } MX_MOTOR;
 
+/* An MX_MOTOR_STATE_SNAPSHOT is a consistent copy of the state of
+ * a motor returned by mx_motor_get_state_snapshot().
+ */
+
+typedef struct {
+	double position;
+	unsigned long status;
+	mx_bool_type busy;
+	char extended_status[ MXU_EXTENDED_STATUS_STRING_LENGTH + 1 ];
+	MX_CLOCK_TICK timestamp;
+} MX_MOTOR_STATE_SNAPSHOT;
+
+/* An MX_MOTOR_WAIT_STATE tracks one moving motor for the completion
+ * wait functions.  Times are in seconds since the start of the wait.
+ */
+
+typedef struct {
+	MX_RECORD *motor_record;
+	MX_MOTOR *motor;
+	unsigned long flags;
+	mx_bool_type done;
+	mx_bool_type failed;
+	unsigned long event_count;
+	double poll_interval;
+	double next_poll_time;
+	double predicted_end_time;
+} MX_MOTOR_WAIT_STATE;
+
+/* An MX_MOTOR_POSITION_TRANSFORM describes how a pseudomotor maps its
+ * raw position onto the position of the motor it depends on.  The
+ * transform functions convert between the raw (unscaled) position of
+ * the pseudomotor and the user units position of the dependent motor.
+ * They must not do any I/O, since they are called from inside the
+ * loops of mx_motor_chain_compute_real_positions().
+ */
+
+typedef double (*MX_MOTOR_TRANSFORM_FUNCTION)( double position,
+						void *transform_args );
+
+typedef struct {
+	MX_RECORD *dependent_motor_record;
+	MX_MOTOR_TRANSFORM_FUNCTION dependent_from_raw_pseudomotor;
+	MX_MOTOR_TRANSFORM_FUNCTION raw_pseudomotor_from_dependent;
+	void *transform_args;
+} MX_MOTOR_POSITION_TRANSFORM;
+
+/* An MX_MOTOR_POSITION_CHAIN is a stack of pseudomotors flattened by
+ * mx_motor_compile_position_chain().  stage_array[0] is the pseudomotor
+ * itself and the dependent motor of the last stage is the real motor.
+ * The scale and offset of each stage are read from its MX_MOTOR at
+ * conversion time, so changing them does not require a recompile.
+ */
+
+#define MXU_MOTOR_CHAIN_MAX_STAGES	16
+
+typedef struct {
+	MX_MOTOR *motor;
+	MX_MOTOR_POSITION_TRANSFORM transform;
+} MX_MOTOR_CHAIN_STAGE;
+
+typedef struct {
+	MX_RECORD *pseudomotor_record;
+	MX_RECORD *real_motor_record;
+
+	long num_stages;
+	MX_MOTOR_CHAIN_STAGE stage_array[ MXU_MOTOR_CHAIN_MAX_STAGES ];
+} MX_MOTOR_POSITION_CHAIN;
+
+/* An MX_MOTOR_MOVE_PROFILE holds the kinematic parameters used to
+ * estimate move durations, in user units.  ramp_time and ramp_distance
+ * describe a full ramp from base_speed up to speed.
+ */
+
+#define MXF_MTR_PROFILE_CONSTANT_SPEED		0
+#define MXF_MTR_PROFILE_TRAPEZOIDAL		1
+#define MXF_MTR_PROFILE_S_CURVE			2
+
+typedef struct {
+	long profile_type;
+
+	double speed;
+	double base_speed;
+	double acceleration;
+	double jerk;
+
+	double ramp_time;
+	double ramp_distance;
+} MX_MOTOR_MOVE_PROFILE;
+
 #define MXLV_MTR_BUSY					1001
 #define MXLV_MTR_DESTINATION				1002
 #define MXLV_MTR_POSITION				1003
@@ -956,6 +1060,26 @@ typedef struct {
 	mx_status_type ( *special_home_search )( MX_MOTOR *motor );
 	mx_status_type ( *setup_triggered_move )( MX_MOTOR *motor );
 	mx_status_type ( *trigger_move )( MX_MOTOR *motor );
+
+	/* The following optional functions read the positions or statuses
+	 * of several motors that all use this driver, so that a driver for
+	 * a multiaxis controller can read all of the axes that share a
+	 * controller with a single query.  They must fill in the same
+	 * MX_MOTOR fields as get_position() and get_status().
+	 */
+
+	mx_status_type ( *get_position_array )( long num_motors,
+						MX_MOTOR **motor_array );
+	mx_status_type ( *get_status_array )( long num_motors,
+						MX_MOTOR **motor_array );
+
+	/* Pseudomotor drivers whose position is a pure function of the
+	 * position of a single dependent motor fill in 'transform', so
+	 * that stacks of them can be flattened into a position chain.
+	 */
+
+	mx_status_type ( *get_position_transform )( MX_MOTOR *motor,
+				MX_MOTOR_POSITION_TRANSFORM *transform );
 } MX_MOTOR_FUNCTION_LIST;
 
 typedef mx_status_type
@@ -1033,6 +1157,83 @@ MX_API mx_status_type mx_wait_for_motor_array_stop(
 			MX_RECORD **motor_record_array,
 			unsigned long flags );
 
+/* mx_wait_for_motor_array_completion() waits for all of the motors to
+ * stop while blocking on the record list's motor completion notifier.
+ * Motors with completion events are only checked when they report
+ * that a move has finished.  The rest are polled at an interval that
+ * backs off during long moves and tightens again near the predicted
+ * end of the move.  If the record list has no notifier, or the motors
+ * belong to record lists with different notifiers, the function sleeps
+ * between polls instead.  A negative timeout waits forever.
+ *
+ * As with mx_wait_for_motor_array_stop(), the wait ends with an error
+ * if a motor reports an error in its status, or if the user interrupts
+ * it, which also stops the motors.  MXF_MTR_IGNORE_ERRORS,
+ * MXF_MTR_IGNORE_LIMIT_SWITCHES, MXF_MTR_IGNORE_KEYBOARD and
+ * MXF_MTR_IGNORE_PAUSE in 'flags' turn these checks off.
+ */
+
+MX_API mx_status_type mx_wait_for_motor_array_completion(
+			long num_motor_records,
+			MX_RECORD **motor_record_array,
+			unsigned long flags,
+			double timeout_in_seconds );
+
+MX_API void mx_motor_notify_move_complete( MX_RECORD *motor_record );
+
+/* The motor state cache lets several clients share one controller
+ * query.  mx_motor_get_state_snapshot() returns the cached state if
+ * it is younger than the cache's time to live, and otherwise reads
+ * the motor again.  Readers never block on a refresh in progress as
+ * long as there is a valid snapshot to return.  Without a cache, the
+ * motor is always read.  mx_motor_disable_state_cache() must not be
+ * called while other threads are using the cache.  Motor drivers call
+ * it from their delete_record handlers to free the cache.
+ */
+
+MX_API mx_status_type mx_motor_enable_state_cache( MX_RECORD *motor_record,
+						double time_to_live );
+
+MX_API mx_status_type mx_motor_disable_state_cache( MX_RECORD *motor_record );
+
+MX_API void mx_motor_invalidate_state_cache( MX_RECORD *motor_record );
+
+MX_API mx_status_type mx_motor_get_state_snapshot( MX_RECORD *motor_record,
+					MX_MOTOR_STATE_SNAPSHOT *snapshot );
+
+MX_API mx_status_type mx_motor_get_state_cache_statistics(
+					MX_RECORD *motor_record,
+					unsigned long *num_hits,
+					unsigned long *num_misses );
+
+MX_API_PRIVATE mx_status_type mx_create_motor_completion_notifier(
+			MX_RECORD *record_list );
+
+MX_API_PRIVATE mx_status_type mx_delete_motor_completion_notifier(
+			MX_RECORD *record_list );
+
+/* mx_motor_wait_step() does one round of the completion wait for
+ * the motors in 'state_array' and returns the number still moving.
+ * It sleeps for at most 'max_seconds_to_wait', or until the next
+ * poll is due if 'max_seconds_to_wait' is negative.  If checking
+ * a motor fails, or its status reports an error that the 'flags'
+ * given to mx_motor_wait_state_init() do not ignore, its state is
+ * marked as done and failed, and the error is returned.
+ */
+
+MX_API_PRIVATE mx_status_type mx_motor_wait_state_init(
+			MX_MOTOR_WAIT_STATE *state,
+			MX_RECORD *motor_record,
+			double now,
+			unsigned long flags );
+
+MX_API_PRIVATE mx_status_type mx_motor_wait_step(
+			long num_states,
+			MX_MOTOR_WAIT_STATE *state_array,
+			MX_CLOCK_TICK start_tick,
+			double max_seconds_to_wait,
+			long *num_remaining );
+
 MX_API mx_status_type mx_motor_internal_move_absolute( MX_RECORD *motor_record,
 							double destination );
 
@@ -1078,6 +1279,20 @@ MX_API mx_status_type mx_motor_constant_velocity_move(
 MX_API mx_status_type mx_motor_get_status( MX_RECORD *motor_record,
 						unsigned long *motor_status );
 
+/* mx_motor_array_get_position() and mx_motor_array_get_status() group
+ * the motors by driver and make one get_position_array() or
+ * get_status_array() call per group.  Motors whose driver does not
+ * have the array function are read one at a time.
+ */
+
+MX_API mx_status_type mx_motor_array_get_position( long num_motor_records,
+						MX_RECORD **motor_record_array,
+						double *position_array );
+
+MX_API mx_status_type mx_motor_array_get_status( long num_motor_records,
+						MX_RECORD **motor_record_array,
+						unsigned long *status_array );
+
 MX_API mx_status_type mx_motor_get_extended_status( MX_RECORD *motor_record,
 						double *motor_position,
 						unsigned long *motor_status );
@@ -1207,6 +1422,46 @@ MX_API mx_status_type mx_motor_get_real_motor_record(
 				MX_RECORD *pseudomotor_record,
 				MX_RECORD **real_motor_record );
 
+/* mx_motor_compile_position_chain() is called by the
+ * finish_record_initialization() function of a pseudomotor driver.
+ * If some motor in the stack cannot be flattened, no chain is built and
+ * the mx_motor_chain_*() functions fall back to the recursive functions
+ * above.  Since the dependent motors may not have been initialized yet,
+ * a dependent motor without a get_position_transform() function is
+ * taken to be the real motor unless it is already flagged as a
+ * pseudomotor.  The driver's delete_record() function frees the chain
+ * with mx_motor_free_position_chain().
+ */
+
+MX_API mx_status_type mx_motor_compile_position_chain(
+				MX_RECORD *pseudomotor_record );
+
+MX_API void mx_motor_free_position_chain( MX_RECORD *pseudomotor_record );
+
+MX_API void mx_motor_position_chain_real_from_pseudo(
+				MX_MOTOR_POSITION_CHAIN *chain,
+				long num_positions,
+				double *pseudomotor_position_array,
+				double *real_position_array );
+
+MX_API void mx_motor_position_chain_pseudo_from_real(
+				MX_MOTOR_POSITION_CHAIN *chain,
+				long num_positions,
+				double *real_position_array,
+				double *pseudomotor_position_array );
+
+MX_API mx_status_type mx_motor_chain_compute_real_positions(
+				MX_RECORD *pseudomotor_record,
+				long num_positions,
+				double *pseudomotor_position_array,
+				double *real_position_array );
+
+MX_API mx_status_type mx_motor_chain_compute_pseudomotor_positions(
+				MX_RECORD *pseudomotor_record,
+				long num_positions,
+				double *real_position_array,
+				double *pseudomotor_position_array );
+
 MX_API mx_status_type mx_alternate_motor_can_use_this_motors_mce(
 				MX_RECORD *motor_record,
 				MX_RECORD *alternate_motor_record,
@@ -1267,6 +1522,43 @@ MX_API mx_status_type mx_motor_get_total_estimated_move_duration(
 					MX_RECORD *motor_record,
 					double *total_estimated_duration );
 
+/* mx_motor_get_move_profile() builds a profile from the speed, base
+ * speed and acceleration fields of the motor without talking to the
+ * controller.  For MXF_MTR_ACCEL_S_CURVE, raw_acceleration_parameters[0]
+ * is the acceleration in raw units/sec**2 and [1] is the jerk in raw
+ * units/sec**3.  Motors with other acceleration types fall back to the
+ * acceleration_time computed by the driver, if any.
+ *
+ * mx_motor_estimate_move_duration() is the scalar reference version of
+ * mx_motor_estimate_move_durations(), which is written so that the
+ * compiler can vectorize it over the position array.  The first move
+ * starts from 'start_position'.  'total_duration' may be NULL.  The
+ * position and duration arrays must not overlap.
+ */
+
+MX_API mx_status_type mx_motor_get_move_profile( MX_RECORD *motor_record,
+					MX_MOTOR_MOVE_PROFILE *profile );
+
+MX_API double mx_motor_estimate_move_duration(
+					MX_MOTOR_MOVE_PROFILE *profile,
+					double move_distance );
+
+MX_API void mx_motor_estimate_move_durations(
+					MX_MOTOR_MOVE_PROFILE *profile,
+					double start_position,
+					long num_positions,
+					double *position_array,
+					double *duration_array,
+					double *total_duration );
+
+/* Fills in estimated_move_durations and total_estimated_move_duration
+ * from estimated_move_positions, starting at the motor's last known
+ * position.
+ */
+
+MX_API mx_status_type mx_motor_compute_estimated_move_durations(
+					MX_RECORD *motor_record );
+
 /* === Move by steps functions. (MXC_MTR_STEPPER) === */
 
 MX_API mx_status_type mx_motor_move_relative_steps_with_report(
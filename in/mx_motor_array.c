@@ -0,0 +1,255 @@
+/*
+ * Name:    mx_motor_array.c
+ *
+ * Purpose: Reads the positions and statuses of many motors at once.
+ *
+ *          mx_motor_get_position() and mx_motor_get_status() make one
+ *          driver call per motor, so polling all of the axes of a 40 axis
+ *          controller costs 40 round trips to the controller.  The
+ *          functions here group the motors by driver and hand each
+ *          group to the driver's get_position_array() or
+ *          get_status_array() function, which can read every axis of
+ *          a controller with a single command.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+typedef struct {
+	MX_MOTOR **motor_array;
+	MX_MOTOR_FUNCTION_LIST **function_list_array;
+	MX_MOTOR **group_motor_array;
+	long *group_index_array;
+	mx_bool_type *done_array;
+} MX_MOTOR_ARRAY_WORKSPACE;
+
+static void
+mx_motor_array_free_workspace( MX_MOTOR_ARRAY_WORKSPACE *workspace )
+{
+	mx_free( workspace->motor_array );
+	mx_free( workspace->function_list_array );
+	mx_free( workspace->group_motor_array );
+	mx_free( workspace->group_index_array );
+	mx_free( workspace->done_array );
+}
+
+static mx_status_type
+mx_motor_array_read( long num_motor_records,
+			MX_RECORD **motor_record_array,
+			MX_MOTOR_ARRAY_WORKSPACE *workspace,
+			double *position_array,
+			unsigned long *status_array,
+			const char *calling_fname )
+{
+	mx_status_type ( *array_fn )( long, MX_MOTOR ** );
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR *motor;
+	long i, j, k, num_group_motors;
+	double raw_position;
+	mx_status_type mx_status;
+
+	for ( i = 0; i < num_motor_records; i++ ) {
+		mx_status = mx_motor_get_pointers( motor_record_array[i],
+					&(workspace->motor_array[i]),
+					&(workspace->function_list_array[i]),
+					calling_fname );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		workspace->done_array[i] = FALSE;
+	}
+
+	for ( i = 0; i < num_motor_records; i++ ) {
+		if ( workspace->done_array[i] )
+			continue;
+
+		function_list = workspace->function_list_array[i];
+
+		if ( position_array != (double *) NULL ) {
+			array_fn = function_list->get_position_array;
+		} else {
+			array_fn = function_list->get_status_array;
+		}
+
+		/* Drivers without an array function are read one motor
+		 * at a time.
+		 */
+
+		if ( array_fn == NULL ) {
+			if ( position_array != (double *) NULL ) {
+				mx_status = mx_motor_get_position(
+						motor_record_array[i],
+						&position_array[i] );
+			} else {
+				mx_status = mx_motor_get_status(
+						motor_record_array[i],
+						&status_array[i] );
+			}
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+
+			workspace->done_array[i] = TRUE;
+			continue;
+		}
+
+		/* Collect the rest of the motors that use this driver. */
+
+		num_group_motors = 0;
+
+		for ( j = i; j < num_motor_records; j++ ) {
+			if ( ( workspace->done_array[j] == FALSE )
+			  && ( workspace->function_list_array[j]
+					== function_list ) )
+			{
+				workspace->group_motor_array[num_group_motors]
+						= workspace->motor_array[j];
+
+				workspace->group_index_array[num_group_motors]
+						= j;
+
+				workspace->done_array[j] = TRUE;
+
+				num_group_motors++;
+			}
+		}
+
+		mx_status = (*array_fn)( num_group_motors,
+					workspace->group_motor_array );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		for ( k = 0; k < num_group_motors; k++ ) {
+			motor = workspace->group_motor_array[k];
+			j = workspace->group_index_array[k];
+
+			if ( position_array == (double *) NULL ) {
+				status_array[j] = motor->status;
+				continue;
+			}
+
+			if ( motor->subclass == MXC_MTR_STEPPER ) {
+				raw_position =
+					(double) motor->raw_position.stepper;
+			} else {
+				raw_position = motor->raw_position.analog;
+			}
+
+			motor->position = motor->offset
+					+ motor->scale * raw_position;
+
+			position_array[j] = motor->position;
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_motor_array_get_values( long num_motor_records,
+			MX_RECORD **motor_record_array,
+			double *position_array,
+			unsigned long *status_array,
+			const char *calling_fname )
+{
+	MX_MOTOR_ARRAY_WORKSPACE workspace;
+	mx_status_type mx_status;
+
+	if ( motor_record_array == (MX_RECORD **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, calling_fname,
+		"The motor record array pointer passed was NULL." );
+	}
+
+	if ( num_motor_records <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	workspace.motor_array = (MX_MOTOR **)
+			malloc( num_motor_records * sizeof(MX_MOTOR *) );
+
+	workspace.function_list_array = (MX_MOTOR_FUNCTION_LIST **)
+		malloc( num_motor_records * sizeof(MX_MOTOR_FUNCTION_LIST *) );
+
+	workspace.group_motor_array = (MX_MOTOR **)
+			malloc( num_motor_records * sizeof(MX_MOTOR *) );
+
+	workspace.group_index_array = (long *)
+			malloc( num_motor_records * sizeof(long) );
+
+	workspace.done_array = (mx_bool_type *)
+			malloc( num_motor_records * sizeof(mx_bool_type) );
+
+	if ( ( workspace.motor_array == (MX_MOTOR **) NULL )
+	  || ( workspace.function_list_array
+				== (MX_MOTOR_FUNCTION_LIST **) NULL )
+	  || ( workspace.group_motor_array == (MX_MOTOR **) NULL )
+	  || ( workspace.group_index_array == (long *) NULL )
+	  || ( workspace.done_array == (mx_bool_type *) NULL ) )
+	{
+		mx_motor_array_free_workspace( &workspace );
+
+		return mx_error( MXE_OUT_OF_MEMORY, calling_fname,
+		"Ran out of memory trying to allocate workspace "
+		"for %ld motors.", num_motor_records );
+	}
+
+	mx_status = mx_motor_array_read( num_motor_records,
+				motor_record_array, &workspace,
+				position_array, status_array,
+				calling_fname );
+
+	mx_motor_array_free_workspace( &workspace );
+
+	return mx_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_array_get_position( long num_motor_records,
+				MX_RECORD **motor_record_array,
+				double *position_array )
+{
+	static const char fname[] = "mx_motor_array_get_position()";
+
+	if ( position_array == (double *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The position array pointer passed was NULL." );
+	}
+
+	return mx_motor_array_get_values( num_motor_records,
+				motor_record_array, position_array,
+				NULL, fname );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_array_get_status( long num_motor_records,
+				MX_RECORD **motor_record_array,
+				unsigned long *status_array )
+{
+	static const char fname[] = "mx_motor_array_get_status()";
+
+	if ( status_array == (unsigned long *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The status array pointer passed was NULL." );
+	}
+
+	return mx_motor_array_get_values( num_motor_records,
+				motor_record_array, NULL,
+				status_array, fname );
+}
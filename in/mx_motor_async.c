@@ -0,0 +1,574 @@
+/*
+ * Name:    mx_motor_async.c
+ *
+ * Purpose: Starts motor moves without blocking and tracks them with
+ *          completion handles.
+ *
+ *          The pending moves of a context are checked together by
+ *          mx_motor_wait_step(), so that a single thread can wait for
+ *          hundreds of moves using the same completion events and
+ *          adaptive polling as mx_wait_for_motor_array_completion().
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+#include "mx_motor_async.h"
+
+#define MX_MOTOR_ASYNC_INITIAL_HANDLES	16
+
+static double
+mx_motor_async_elapsed_time( MX_CLOCK_TICK start_tick )
+{
+	return mx_convert_clock_ticks_to_seconds(
+			mx_subtract_clock_ticks( mx_current_clock_tick(),
+						start_tick ) );
+}
+
+static void
+mx_motor_async_remove_pending_handle( MX_MOTOR_ASYNC_CONTEXT *context,
+					MX_MOTOR_HANDLE *handle )
+{
+	long i, num_to_move;
+
+	for ( i = 0; i < context->num_pending_handles; i++ ) {
+		if ( context->pending_handle_array[i] == handle )
+			break;
+	}
+
+	if ( i >= context->num_pending_handles )
+		return;
+
+	num_to_move = context->num_pending_handles - i - 1;
+
+	memmove( &(context->pending_handle_array[i]),
+		&(context->pending_handle_array[i+1]),
+		num_to_move * sizeof(MX_MOTOR_HANDLE *) );
+
+	memmove( &(context->wait_state_array[i]),
+		&(context->wait_state_array[i+1]),
+		num_to_move * sizeof(MX_MOTOR_WAIT_STATE) );
+
+	context->num_pending_handles--;
+}
+
+/* The continuations are only called after the finished handles have
+ * been removed from the context, since they may start new moves.
+ */
+
+static void
+mx_motor_async_run_continuations( MX_MOTOR_HANDLE *completed_list )
+{
+	MX_MOTOR_HANDLE *handle, *next_handle;
+
+	handle = completed_list;
+
+	while ( handle != (MX_MOTOR_HANDLE *) NULL ) {
+		next_handle = handle->next_completed_handle;
+
+		handle->next_completed_handle = NULL;
+
+		if ( handle->continuation != NULL ) {
+			( *(handle->continuation) )( handle,
+						handle->continuation_args );
+		}
+
+		handle = next_handle;
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_async_context_create( MX_RECORD *record_list,
+				MX_MOTOR_ASYNC_CONTEXT **context )
+{
+	static const char fname[] = "mx_motor_async_context_create()";
+
+	MX_MOTOR_ASYNC_CONTEXT *new_context;
+
+	if ( ( record_list == (MX_RECORD *) NULL )
+	  || ( context == (MX_MOTOR_ASYNC_CONTEXT **) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	new_context = (MX_MOTOR_ASYNC_CONTEXT *)
+			calloc( 1, sizeof(MX_MOTOR_ASYNC_CONTEXT) );
+
+	if ( new_context == (MX_MOTOR_ASYNC_CONTEXT *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_MOTOR_ASYNC_CONTEXT structure." );
+	}
+
+	new_context->list_head_record = record_list->list_head;
+	new_context->start_tick = mx_current_clock_tick();
+
+	*context = new_context;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_motor_async_context_destroy( MX_MOTOR_ASYNC_CONTEXT *context )
+{
+	static const char fname[] = "mx_motor_async_context_destroy()";
+
+	MX_MOTOR_HANDLE *handle;
+	long i;
+
+	if ( context == (MX_MOTOR_ASYNC_CONTEXT *) NULL )
+		return;
+
+	for ( i = 0; i < context->num_pending_handles; i++ ) {
+		handle = context->pending_handle_array[i];
+
+		handle->context = NULL;
+		handle->state = MXS_MOTOR_HANDLE_CANCELLED;
+
+		handle->result = mx_error( MXE_INTERRUPTED, fname,
+			"The context tracking the move of motor '%s' "
+			"was destroyed.", handle->motor_record->name );
+	}
+
+	mx_free( context->pending_handle_array );
+	mx_free( context->wait_state_array );
+	mx_free( context );
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_move_absolute_async( MX_MOTOR_ASYNC_CONTEXT *context,
+				MX_RECORD *motor_record,
+				double destination,
+				unsigned long flags,
+				MX_MOTOR_HANDLE **handle )
+{
+	static const char fname[] = "mx_motor_move_absolute_async()";
+
+	MX_MOTOR_HANDLE *new_handle, **new_handle_array;
+	MX_MOTOR_WAIT_STATE *new_state_array;
+	long new_allocated_handles;
+	mx_status_type mx_status;
+
+	if ( ( context == (MX_MOTOR_ASYNC_CONTEXT *) NULL )
+	  || ( motor_record == (MX_RECORD *) NULL )
+	  || ( handle == (MX_MOTOR_HANDLE **) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	if ( motor_record->list_head != context->list_head_record ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Motor '%s' does not belong to the database "
+		"of this context.", motor_record->name );
+	}
+
+	if ( context->num_pending_handles >= context->allocated_handles ) {
+		if ( context->allocated_handles <= 0 ) {
+			new_allocated_handles = MX_MOTOR_ASYNC_INITIAL_HANDLES;
+		} else {
+			new_allocated_handles = 2 * context->allocated_handles;
+		}
+
+		new_handle_array = (MX_MOTOR_HANDLE **)
+			realloc( context->pending_handle_array,
+			new_allocated_handles * sizeof(MX_MOTOR_HANDLE *) );
+
+		if ( new_handle_array == (MX_MOTOR_HANDLE **) NULL ) {
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to track %ld moves.",
+				new_allocated_handles );
+		}
+
+		context->pending_handle_array = new_handle_array;
+
+		new_state_array = (MX_MOTOR_WAIT_STATE *)
+			realloc( context->wait_state_array,
+			new_allocated_handles * sizeof(MX_MOTOR_WAIT_STATE) );
+
+		if ( new_state_array == (MX_MOTOR_WAIT_STATE *) NULL ) {
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to track %ld moves.",
+				new_allocated_handles );
+		}
+
+		context->wait_state_array = new_state_array;
+		context->allocated_handles = new_allocated_handles;
+	}
+
+	new_handle = (MX_MOTOR_HANDLE *) calloc( 1, sizeof(MX_MOTOR_HANDLE) );
+
+	if ( new_handle == (MX_MOTOR_HANDLE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_MOTOR_HANDLE structure." );
+	}
+
+	mx_status = mx_motor_move_absolute( motor_record, destination,
+						flags | MXF_MTR_NOWAIT );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_free( new_handle );
+		return mx_status;
+	}
+
+	mx_status = mx_motor_wait_state_init(
+		&(context->wait_state_array[context->num_pending_handles]),
+		motor_record,
+		mx_motor_async_elapsed_time( context->start_tick ),
+		flags );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_free( new_handle );
+		return mx_status;
+	}
+
+	new_handle->context = context;
+	new_handle->motor_record = motor_record;
+	new_handle->destination = destination;
+	new_handle->state = MXS_MOTOR_HANDLE_PENDING;
+	new_handle->result = MX_SUCCESSFUL_RESULT;
+
+	context->pending_handle_array[context->num_pending_handles]
+							= new_handle;
+
+	context->num_pending_handles++;
+
+	*handle = new_handle;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_motor_handle_free( MX_MOTOR_HANDLE *handle )
+{
+	if ( handle == (MX_MOTOR_HANDLE *) NULL )
+		return;
+
+	if ( ( handle->state == MXS_MOTOR_HANDLE_PENDING )
+	  && ( handle->context != (MX_MOTOR_ASYNC_CONTEXT *) NULL ) )
+	{
+		mx_motor_async_remove_pending_handle( handle->context,
+							handle );
+	}
+
+	mx_free( handle );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_handle_set_continuation( MX_MOTOR_HANDLE *handle,
+		void ( *continuation )( MX_MOTOR_HANDLE *, void * ),
+				void *continuation_args )
+{
+	static const char fname[] = "mx_motor_handle_set_continuation()";
+
+	if ( handle == (MX_MOTOR_HANDLE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_HANDLE pointer passed was NULL." );
+	}
+
+	handle->continuation = continuation;
+	handle->continuation_args = continuation_args;
+
+	if ( ( handle->state != MXS_MOTOR_HANDLE_PENDING )
+	  && ( continuation != NULL ) )
+	{
+		( *continuation )( handle, continuation_args );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_handle_cancel( MX_MOTOR_HANDLE *handle )
+{
+	static const char fname[] = "mx_motor_handle_cancel()";
+
+	mx_status_type mx_status;
+
+	if ( handle == (MX_MOTOR_HANDLE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_HANDLE pointer passed was NULL." );
+	}
+
+	if ( handle->state != MXS_MOTOR_HANDLE_PENDING )
+		return MX_SUCCESSFUL_RESULT;
+
+	mx_status = mx_motor_soft_abort( handle->motor_record );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( handle->context != (MX_MOTOR_ASYNC_CONTEXT *) NULL ) {
+		mx_motor_async_remove_pending_handle( handle->context,
+							handle );
+	}
+
+	handle->state = MXS_MOTOR_HANDLE_CANCELLED;
+
+	handle->result = mx_error( MXE_INTERRUPTED, fname,
+		"The move of motor '%s' to %g was cancelled.",
+		handle->motor_record->name, handle->destination );
+
+	mx_motor_async_run_continuations( handle );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_async_run_once( MX_MOTOR_ASYNC_CONTEXT *context,
+			double max_seconds_to_wait,
+			long *num_pending_handles )
+{
+	static const char fname[] = "mx_motor_async_run_once()";
+
+	MX_MOTOR_HANDLE *handle, *completed_list, *completed_tail;
+	MX_MOTOR_WAIT_STATE *state;
+	long i, j, num_remaining;
+	mx_bool_type failure_assigned;
+	mx_status_type mx_status;
+
+	if ( context == (MX_MOTOR_ASYNC_CONTEXT *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_ASYNC_CONTEXT pointer passed was NULL." );
+	}
+
+	if ( context->num_pending_handles > 0 ) {
+		mx_status = mx_motor_wait_step( context->num_pending_handles,
+					context->wait_state_array,
+					context->start_tick,
+					max_seconds_to_wait,
+					&num_remaining );
+	} else {
+		mx_status = MX_SUCCESSFUL_RESULT;
+	}
+
+	/* Move the finished handles to the completed list while keeping
+	 * the pending ones in order.  If checking a motor failed, the
+	 * error belongs to that motor's handle.
+	 */
+
+	completed_list = completed_tail = NULL;
+
+	failure_assigned = FALSE;
+
+	for ( i = 0, j = 0; i < context->num_pending_handles; i++ ) {
+		handle = context->pending_handle_array[i];
+		state = &(context->wait_state_array[i]);
+
+		if ( state->done == FALSE ) {
+			if ( i != j ) {
+				context->pending_handle_array[j] = handle;
+				context->wait_state_array[j] = *state;
+			}
+
+			j++;
+			continue;
+		}
+
+		if ( state->failed ) {
+			handle->state = MXS_MOTOR_HANDLE_FAILED;
+			handle->result = mx_status;
+
+			failure_assigned = TRUE;
+		} else {
+			handle->state = MXS_MOTOR_HANDLE_COMPLETE;
+			handle->result = MX_SUCCESSFUL_RESULT;
+		}
+
+		if ( completed_tail == (MX_MOTOR_HANDLE *) NULL ) {
+			completed_list = handle;
+		} else {
+			completed_tail->next_completed_handle = handle;
+		}
+
+		completed_tail = handle;
+	}
+
+	context->num_pending_handles = j;
+
+	mx_motor_async_run_continuations( completed_list );
+
+	if ( num_pending_handles != (long *) NULL ) {
+		*num_pending_handles = context->num_pending_handles;
+	}
+
+	if ( failure_assigned )
+		return MX_SUCCESSFUL_RESULT;
+
+	return mx_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_status_type
+mx_motor_async_wait( long num_handles,
+			MX_MOTOR_HANDLE **handle_array,
+			mx_bool_type wait_for_all,
+			double timeout_in_seconds,
+			long *handle_index,
+			const char *calling_fname )
+{
+	MX_MOTOR_ASYNC_CONTEXT *context;
+	MX_MOTOR_HANDLE *handle;
+	MX_CLOCK_TICK start_tick;
+	long i, num_pending;
+	double elapsed_time, max_seconds_to_wait;
+	mx_bool_type polled;
+	mx_status_type mx_status;
+
+	if ( handle_array == (MX_MOTOR_HANDLE **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, calling_fname,
+		"The handle array pointer passed was NULL." );
+	}
+
+	context = NULL;
+
+	for ( i = 0; i < num_handles; i++ ) {
+		handle = handle_array[i];
+
+		if ( handle == (MX_MOTOR_HANDLE *) NULL ) {
+			return mx_error( MXE_NULL_ARGUMENT, calling_fname,
+			"Handle %ld of the handle array is NULL.", i );
+		}
+
+		if ( handle->state != MXS_MOTOR_HANDLE_PENDING )
+			continue;
+
+		if ( context == (MX_MOTOR_ASYNC_CONTEXT *) NULL ) {
+			context = handle->context;
+		} else
+		if ( handle->context != context ) {
+			return mx_error( MXE_ILLEGAL_ARGUMENT, calling_fname,
+			"The pending handles passed do not all belong "
+			"to the same context." );
+		}
+	}
+
+	start_tick = mx_current_clock_tick();
+
+	polled = FALSE;
+
+	while ( TRUE ) {
+		num_pending = 0;
+
+		for ( i = 0; i < num_handles; i++ ) {
+			handle = handle_array[i];
+
+			if ( handle->state == MXS_MOTOR_HANDLE_PENDING ) {
+				num_pending++;
+				continue;
+			}
+
+			if ( wait_for_all == FALSE ) {
+				*handle_index = i;
+				return MX_SUCCESSFUL_RESULT;
+			}
+		}
+
+		if ( ( num_pending == 0 ) && wait_for_all ) {
+			for ( i = 0; i < num_handles; i++ ) {
+				if ( handle_array[i]->state
+					!= MXS_MOTOR_HANDLE_COMPLETE )
+				{
+					return handle_array[i]->result;
+				}
+			}
+
+			return MX_SUCCESSFUL_RESULT;
+		}
+
+		if ( num_pending == 0 ) {
+			return mx_error( MXE_ILLEGAL_ARGUMENT, calling_fname,
+			"No handles were passed to wait for." );
+		}
+
+		max_seconds_to_wait = -1.0;
+
+		if ( timeout_in_seconds >= 0.0 ) {
+			elapsed_time = mx_motor_async_elapsed_time(
+							start_tick );
+
+			if ( polled
+			  && ( elapsed_time >= timeout_in_seconds ) )
+			{
+				return mx_error( MXE_TIMED_OUT, calling_fname,
+				"Timed out after %g seconds waiting for "
+				"%ld motor moves.", timeout_in_seconds,
+					num_pending );
+			}
+
+			max_seconds_to_wait = timeout_in_seconds - elapsed_time;
+
+			if ( max_seconds_to_wait < 0.0 )
+				max_seconds_to_wait = 0.0;
+		}
+
+		mx_status = mx_motor_async_run_once( context,
+					max_seconds_to_wait, NULL );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		polled = TRUE;
+	}
+}
+
+MX_EXPORT mx_status_type
+mx_motor_handle_wait( MX_MOTOR_HANDLE *handle,
+			double timeout_in_seconds )
+{
+	static const char fname[] = "mx_motor_handle_wait()";
+
+	return mx_motor_async_wait( 1, &handle, TRUE,
+				timeout_in_seconds, NULL, fname );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_handle_wait_all( long num_handles,
+			MX_MOTOR_HANDLE **handle_array,
+			double timeout_in_seconds )
+{
+	static const char fname[] = "mx_motor_handle_wait_all()";
+
+	return mx_motor_async_wait( num_handles, handle_array, TRUE,
+				timeout_in_seconds, NULL, fname );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_handle_wait_any( long num_handles,
+			MX_MOTOR_HANDLE **handle_array,
+			double timeout_in_seconds,
+			long *handle_index )
+{
+	static const char fname[] = "mx_motor_handle_wait_any()";
+
+	if ( handle_index == (long *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The handle_index pointer passed was NULL." );
+	}
+
+	return mx_motor_async_wait( num_handles, handle_array, FALSE,
+				timeout_in_seconds, handle_index, fname );
+}
@@ -0,0 +1,167 @@
+/*
+ * Name:    mx_motor_async.h
+ *
+ * Purpose: Header file for starting motor moves that are waited for
+ *          through completion handles.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_MOTOR_ASYNC_H__
+#define __MX_MOTOR_ASYNC_H__
+
+#include "mx_util.h"
+#include "mx_clock.h"
+#include "mx_record.h"
+#include "mx_motor.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* mx_motor_move_absolute_async() starts a move and returns at once with
+ * an MX_MOTOR_HANDLE that completes when the motor stops.  The handles
+ * belong to an MX_MOTOR_ASYNC_CONTEXT, which checks all of its pending
+ * moves together in the same way as mx_wait_for_motor_array_completion(),
+ * so one thread can drive many concurrent moves by calling
+ * mx_motor_async_run_once() in a loop or by waiting on the handles.
+ *
+ * When a handle completes, its continuation, if any, is called from
+ * inside mx_motor_async_run_once() or one of the wait functions.  A
+ * continuation may start new moves and may free its own handle, but
+ * must not free any other handle, nor its own if some caller is still
+ * waiting on it.
+ *
+ * A context and its handles must only be used by one thread at a time.
+ * All of the motors in a context must come from the same database.
+ */
+
+#define MXS_MOTOR_HANDLE_PENDING	0
+#define MXS_MOTOR_HANDLE_COMPLETE	1
+#define MXS_MOTOR_HANDLE_FAILED		2
+#define MXS_MOTOR_HANDLE_CANCELLED	3
+
+typedef struct mx_motor_async_context_type MX_MOTOR_ASYNC_CONTEXT;
+
+typedef struct mx_motor_handle_type {
+	MX_MOTOR_ASYNC_CONTEXT *context;
+	MX_RECORD *motor_record;
+	double destination;
+
+	long state;
+
+	/* 'result' is MX_SUCCESSFUL_RESULT for a complete handle, and the
+	 * error that ended the move for a failed or cancelled handle.
+	 */
+
+	mx_status_type result;
+
+	void ( *continuation )( struct mx_motor_handle_type *handle,
+				void *continuation_args );
+	void *continuation_args;
+
+	struct mx_motor_handle_type *next_completed_handle;
+} MX_MOTOR_HANDLE;
+
+struct mx_motor_async_context_type {
+	MX_RECORD *list_head_record;
+	MX_CLOCK_TICK start_tick;
+
+	long num_pending_handles;
+	long allocated_handles;
+
+	/* These arrays are parallel.  wait_state_array is passed straight
+	 * to mx_motor_wait_step().
+	 */
+
+	MX_MOTOR_HANDLE **pending_handle_array;
+	MX_MOTOR_WAIT_STATE *wait_state_array;
+};
+
+MX_API mx_status_type mx_motor_async_context_create( MX_RECORD *record_list,
+					MX_MOTOR_ASYNC_CONTEXT **context );
+
+/* Destroying a context marks its pending handles as cancelled without
+ * calling their continuations.  The motors are not stopped.  The handles
+ * must still be freed with mx_motor_handle_free().
+ */
+
+MX_API void mx_motor_async_context_destroy( MX_MOTOR_ASYNC_CONTEXT *context );
+
+/* MXF_MTR_NOWAIT is always added to 'flags'.  The flags also decide
+ * which motor status errors fail the handle, as they do for
+ * mx_wait_for_motor_array_completion().
+ */
+
+MX_API mx_status_type mx_motor_move_absolute_async(
+					MX_MOTOR_ASYNC_CONTEXT *context,
+					MX_RECORD *motor_record,
+					double destination,
+					unsigned long flags,
+					MX_MOTOR_HANDLE **handle );
+
+/* Freeing a pending handle stops tracking the move, but does not stop
+ * the motor.
+ */
+
+MX_API void mx_motor_handle_free( MX_MOTOR_HANDLE *handle );
+
+/* If the handle has already finished, the continuation is called before
+ * mx_motor_handle_set_continuation() returns.
+ */
+
+MX_API mx_status_type mx_motor_handle_set_continuation(
+					MX_MOTOR_HANDLE *handle,
+		void ( *continuation )( MX_MOTOR_HANDLE *, void * ),
+					void *continuation_args );
+
+/* Soft aborts the move and completes the handle as cancelled. */
+
+MX_API mx_status_type mx_motor_handle_cancel( MX_MOTOR_HANDLE *handle );
+
+/* Checks the pending moves once, completing the handles of the motors
+ * that have stopped and running their continuations.  If moves are still
+ * pending, it then sleeps for at most 'max_seconds_to_wait' until a poll
+ * is due or a motor reports the end of a move.  'num_pending_handles'
+ * may be NULL.
+ */
+
+MX_API mx_status_type mx_motor_async_run_once( MX_MOTOR_ASYNC_CONTEXT *context,
+					double max_seconds_to_wait,
+					long *num_pending_handles );
+
+/* The wait functions return the error that ended a failed or cancelled
+ * move.  A negative timeout waits forever.
+ */
+
+MX_API mx_status_type mx_motor_handle_wait( MX_MOTOR_HANDLE *handle,
+					double timeout_in_seconds );
+
+MX_API mx_status_type mx_motor_handle_wait_all( long num_handles,
+					MX_MOTOR_HANDLE **handle_array,
+					double timeout_in_seconds );
+
+/* Returns the index in 'handle_array' of the first handle found to have
+ * finished.  The handle may have failed, so check its state.
+ */
+
+MX_API mx_status_type mx_motor_handle_wait_any( long num_handles,
+					MX_MOTOR_HANDLE **handle_array,
+					double timeout_in_seconds,
+					long *handle_index );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_MOTOR_ASYNC_H__ */
@@ -0,0 +1,130 @@
+/*
+ * Name:    mx_motor_async.hpp
+ *
+ * Purpose: C++20 coroutine support for MX motor completion handles.
+ *
+ *          A coroutine can wait for a move started with
+ *          mx_motor_move_absolute_async() by writing
+ *
+ *              mx_status_type mx_status =
+ *                  co_await mx::await_motor( handle );
+ *
+ *          The coroutine is resumed by the handle's continuation, so it
+ *          continues inside mx_motor_async_run_once() on the thread that
+ *          drives the context.  Coroutines of type mx::motor_task start
+ *          at once and free their own frames when they finish.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_MOTOR_ASYNC_HPP__
+#define __MX_MOTOR_ASYNC_HPP__
+
+#ifndef __cplusplus
+#error mx_motor_async.hpp can only be used by C++ code.
+#endif
+
+#if !defined(__cpp_impl_coroutine)
+#error mx_motor_async.hpp requires C++20 coroutines.
+#endif
+
+#include <stdio.h>
+
+#include <coroutine>
+#include <exception>
+
+#include "mx_util.h"
+#include "mx_motor_async.h"
+
+namespace mx {
+
+class motor_awaiter {
+public:
+	explicit motor_awaiter( MX_MOTOR_HANDLE *handle ) noexcept
+		: handle_( handle )
+	{
+	}
+
+	bool await_ready() const noexcept
+	{
+		return ( handle_->state != MXS_MOTOR_HANDLE_PENDING );
+	}
+
+	/* Returning false resumes the coroutine at once, which covers
+	 * a handle that finished between await_ready() and here.
+	 */
+
+	bool await_suspend( std::coroutine_handle<> coroutine ) noexcept
+	{
+		if ( handle_->state != MXS_MOTOR_HANDLE_PENDING )
+			return false;
+
+		handle_->continuation = resume;
+		handle_->continuation_args = coroutine.address();
+
+		return true;
+	}
+
+	mx_status_type await_resume() const noexcept
+	{
+		return handle_->result;
+	}
+
+private:
+	static void resume( MX_MOTOR_HANDLE *, void *address )
+	{
+		std::coroutine_handle<>::from_address( address ).resume();
+	}
+
+	MX_MOTOR_HANDLE *handle_;
+};
+
+inline motor_awaiter
+await_motor( MX_MOTOR_HANDLE *handle ) noexcept
+{
+	return motor_awaiter( handle );
+}
+
+/* A fire and forget coroutine.  MX errors are returned as status values,
+ * so an exception escaping a motor_task is a bug and terminates.
+ */
+
+struct motor_task {
+	struct promise_type {
+		motor_task get_return_object() noexcept
+		{
+			return motor_task();
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return {};
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return {};
+		}
+
+		void return_void() noexcept
+		{
+		}
+
+		void unhandled_exception() noexcept
+		{
+			std::terminate();
+		}
+	};
+};
+
+} /* namespace mx */
+
+#endif /* __MX_MOTOR_ASYNC_HPP__ */
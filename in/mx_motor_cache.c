@@ -0,0 +1,388 @@
+/*
+ * Name:    mx_motor_cache.c
+ *
+ * Purpose: Per-motor cache of the position and status of a motor.
+ *
+ *          When several GUIs and scripts watch the same motor, each of
+ *          them queries the controller separately.  The state cache
+ *          keeps the last position, status, extended status and busy
+ *          flag read from the motor, and only reads the motor again
+ *          once the cached state is older than its time to live.
+ *
+ *          The cached state is protected by a sequence lock.  The
+ *          thread that refreshes the cache makes the sequence number
+ *          odd while it writes the new state, and readers retry if
+ *          the sequence number was odd or changed while they were
+ *          copying, so readers never take a lock.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_atomic.h"
+#include "mx_mutex.h"
+#include "mx_motor.h"
+
+typedef struct {
+	int32_t sequence;
+
+	mx_bool_type valid;
+	MX_CLOCK_TICK expiration_tick;
+	MX_MOTOR_STATE_SNAPSHOT snapshot;
+
+	/* Only the thread holding the refresh mutex may write the
+	 * fields above or change the time to live.
+	 */
+
+	MX_MUTEX *refresh_mutex;
+	MX_CLOCK_TICK time_to_live;
+
+	int32_t num_hits;
+	int32_t num_misses;
+} MX_MOTOR_STATE_CACHE;
+
+static mx_bool_type
+mx_motor_state_cache_read( MX_MOTOR_STATE_CACHE *cache,
+			MX_MOTOR_STATE_SNAPSHOT *snapshot,
+			MX_CLOCK_TICK *expiration_tick )
+{
+	int32_t start_sequence, end_sequence;
+	mx_bool_type valid;
+
+	while ( TRUE ) {
+		start_sequence = mx_atomic_read32( &(cache->sequence) );
+
+		if ( start_sequence & 1 )
+			continue;
+
+		valid = cache->valid;
+		*snapshot = cache->snapshot;
+		*expiration_tick = cache->expiration_tick;
+
+		mx_atomic_memory_barrier();
+
+		end_sequence = mx_atomic_read32( &(cache->sequence) );
+
+		if ( end_sequence == start_sequence )
+			return valid;
+	}
+}
+
+/* The caller must hold the refresh mutex.  A NULL snapshot marks the
+ * cache as invalid.
+ */
+
+static void
+mx_motor_state_cache_write( MX_MOTOR_STATE_CACHE *cache,
+			MX_MOTOR_STATE_SNAPSHOT *snapshot )
+{
+	(void) mx_atomic_increment32( &(cache->sequence) );
+
+	if ( snapshot == (MX_MOTOR_STATE_SNAPSHOT *) NULL ) {
+		cache->valid = FALSE;
+	} else {
+		cache->snapshot = *snapshot;
+
+		cache->expiration_tick = mx_add_clock_ticks(
+				snapshot->timestamp, cache->time_to_live );
+
+		cache->valid = TRUE;
+	}
+
+	(void) mx_atomic_increment32( &(cache->sequence) );
+}
+
+static mx_status_type
+mx_motor_state_cache_read_motor( MX_RECORD *motor_record,
+				MX_MOTOR *motor,
+				MX_MOTOR_STATE_SNAPSHOT *snapshot )
+{
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_extended_status( motor_record,
+					&(snapshot->position),
+					&(snapshot->status) );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( snapshot->status & MXSF_MTR_IS_BUSY ) {
+		snapshot->busy = TRUE;
+	} else {
+		snapshot->busy = FALSE;
+	}
+
+	strlcpy( snapshot->extended_status, motor->extended_status,
+				sizeof(snapshot->extended_status) );
+
+	snapshot->timestamp = mx_current_clock_tick();
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_enable_state_cache( MX_RECORD *motor_record, double time_to_live )
+{
+	static const char fname[] = "mx_motor_enable_state_cache()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR_STATE_CACHE *cache;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_pointers( motor_record,
+					&motor, &function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( time_to_live < 0.0 ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"The time to live (%g seconds) requested for the state "
+		"cache of motor '%s' is negative.",
+			time_to_live, motor_record->name );
+	}
+
+	cache = (MX_MOTOR_STATE_CACHE *) motor->state_cache;
+
+	if ( cache != (MX_MOTOR_STATE_CACHE *) NULL ) {
+		if ( mx_mutex_lock( cache->refresh_mutex ) != MXE_SUCCESS ) {
+			return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+			"Unable to lock the state cache mutex for motor '%s'.",
+				motor_record->name );
+		}
+
+		cache->time_to_live =
+			mx_convert_seconds_to_clock_ticks( time_to_live );
+
+		mx_motor_state_cache_write( cache, NULL );
+
+		(void) mx_mutex_unlock( cache->refresh_mutex );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	cache = (MX_MOTOR_STATE_CACHE *)
+			calloc( 1, sizeof(MX_MOTOR_STATE_CACHE) );
+
+	if ( cache == (MX_MOTOR_STATE_CACHE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a state cache "
+		"for motor '%s'.", motor_record->name );
+	}
+
+	mx_status = mx_mutex_create( &(cache->refresh_mutex) );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_free( cache );
+		return mx_status;
+	}
+
+	cache->time_to_live = mx_convert_seconds_to_clock_ticks( time_to_live );
+	cache->valid = FALSE;
+
+	motor->state_cache = cache;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_disable_state_cache( MX_RECORD *motor_record )
+{
+	static const char fname[] = "mx_motor_disable_state_cache()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR_STATE_CACHE *cache;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_pointers( motor_record,
+					&motor, &function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	cache = (MX_MOTOR_STATE_CACHE *) motor->state_cache;
+
+	if ( cache == (MX_MOTOR_STATE_CACHE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	motor->state_cache = NULL;
+
+	(void) mx_mutex_destroy( cache->refresh_mutex );
+
+	mx_free( cache );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Commands that change the state of the motor, such as the start of
+ * a move, should invalidate the cache so that the next reader sees it.
+ */
+
+MX_EXPORT void
+mx_motor_invalidate_state_cache( MX_RECORD *motor_record )
+{
+	MX_MOTOR *motor;
+	MX_MOTOR_STATE_CACHE *cache;
+
+	if ( motor_record == (MX_RECORD *) NULL )
+		return;
+
+	motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	if ( motor == (MX_MOTOR *) NULL )
+		return;
+
+	cache = (MX_MOTOR_STATE_CACHE *) motor->state_cache;
+
+	if ( cache == (MX_MOTOR_STATE_CACHE *) NULL )
+		return;
+
+	if ( mx_mutex_lock( cache->refresh_mutex ) != MXE_SUCCESS )
+		return;
+
+	mx_motor_state_cache_write( cache, NULL );
+
+	(void) mx_mutex_unlock( cache->refresh_mutex );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_state_snapshot( MX_RECORD *motor_record,
+			MX_MOTOR_STATE_SNAPSHOT *snapshot )
+{
+	static const char fname[] = "mx_motor_get_state_snapshot()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR_STATE_CACHE *cache;
+	MX_MOTOR_STATE_SNAPSHOT new_snapshot;
+	MX_CLOCK_TICK expiration_tick;
+	mx_bool_type valid;
+	mx_status_type mx_status;
+
+	if ( snapshot == (MX_MOTOR_STATE_SNAPSHOT *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_STATE_SNAPSHOT pointer passed was NULL." );
+	}
+
+	mx_status = mx_motor_get_pointers( motor_record,
+					&motor, &function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	cache = (MX_MOTOR_STATE_CACHE *) motor->state_cache;
+
+	if ( cache == (MX_MOTOR_STATE_CACHE *) NULL ) {
+		return mx_motor_state_cache_read_motor( motor_record,
+							motor, snapshot );
+	}
+
+	valid = mx_motor_state_cache_read( cache, snapshot, &expiration_tick );
+
+	if ( valid && ( mx_compare_clock_ticks( mx_current_clock_tick(),
+						expiration_tick ) < 0 ) )
+	{
+		(void) mx_atomic_increment32( &(cache->num_hits) );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	(void) mx_atomic_increment32( &(cache->num_misses) );
+
+	/* If another thread is already refreshing the cache, return the
+	 * stale snapshot rather than wait, if there is one.
+	 */
+
+	if ( mx_mutex_trylock( cache->refresh_mutex ) != MXE_SUCCESS ) {
+		if ( valid )
+			return MX_SUCCESSFUL_RESULT;
+
+		if ( mx_mutex_lock( cache->refresh_mutex ) != MXE_SUCCESS ) {
+			return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+			"Unable to lock the state cache mutex for motor '%s'.",
+				motor_record->name );
+		}
+	}
+
+	/* The cache may have been refreshed while we waited for the
+	 * mutex.
+	 */
+
+	valid = mx_motor_state_cache_read( cache, snapshot, &expiration_tick );
+
+	if ( valid && ( mx_compare_clock_ticks( mx_current_clock_tick(),
+						expiration_tick ) < 0 ) )
+	{
+		(void) mx_mutex_unlock( cache->refresh_mutex );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	mx_status = mx_motor_state_cache_read_motor( motor_record,
+							motor, &new_snapshot );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_motor_state_cache_write( cache, &new_snapshot );
+
+		*snapshot = new_snapshot;
+	}
+
+	(void) mx_mutex_unlock( cache->refresh_mutex );
+
+	return mx_status;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_state_cache_statistics( MX_RECORD *motor_record,
+				unsigned long *num_hits,
+				unsigned long *num_misses )
+{
+	static const char fname[] = "mx_motor_get_state_cache_statistics()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR_STATE_CACHE *cache;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_pointers( motor_record,
+					&motor, &function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	cache = (MX_MOTOR_STATE_CACHE *) motor->state_cache;
+
+	if ( cache == (MX_MOTOR_STATE_CACHE *) NULL ) {
+		return mx_error( MXE_NOT_AVAILABLE, fname,
+		"Motor '%s' does not have a state cache.",
+			motor_record->name );
+	}
+
+	if ( num_hits != (unsigned long *) NULL ) {
+		*num_hits = (unsigned long)
+				mx_atomic_read32( &(cache->num_hits) );
+	}
+
+	if ( num_misses != (unsigned long *) NULL ) {
+		*num_misses = (unsigned long)
+				mx_atomic_read32( &(cache->num_misses) );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,341 @@
+/*
+ * Name:    mx_motor_chain.c
+ *
+ * Purpose: Flattens stacks of pseudomotors into position chains.
+ *
+ *          mx_motor_compute_real_position_from_pseudomotor_position()
+ *          and its inverse go through the generic motor API once for
+ *          every pseudomotor in a stack such as energy -> monochromator
+ *          -> theta -> real axis, checking the pointers and returning a
+ *          status at every level.  A position chain collects the scale,
+ *          offset and transform functions of every level once, when the
+ *          record is initialized, so that positions can then be
+ *          converted with a plain loop over the stages.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+MX_EXPORT mx_status_type
+mx_motor_compile_position_chain( MX_RECORD *pseudomotor_record )
+{
+	static const char fname[] = "mx_motor_compile_position_chain()";
+
+	MX_MOTOR_POSITION_CHAIN *chain;
+	MX_MOTOR_CHAIN_STAGE *stage;
+	MX_MOTOR *motor, *pseudomotor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_RECORD *current_record;
+	long i;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_pointers( pseudomotor_record, &pseudomotor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_motor_free_position_chain( pseudomotor_record );
+
+	chain = (MX_MOTOR_POSITION_CHAIN *)
+			calloc( 1, sizeof(MX_MOTOR_POSITION_CHAIN) );
+
+	if ( chain == (MX_MOTOR_POSITION_CHAIN *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_MOTOR_POSITION_CHAIN structure for motor '%s'.",
+			pseudomotor_record->name );
+	}
+
+	chain->pseudomotor_record = pseudomotor_record;
+
+	current_record = pseudomotor_record;
+	motor = pseudomotor;
+
+	while ( function_list->get_position_transform != NULL ) {
+
+		if ( chain->num_stages >= MXU_MOTOR_CHAIN_MAX_STAGES ) {
+			mx_free( chain );
+
+			return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+			"The pseudomotor stack below motor '%s' is more than "
+			"%d levels deep.  Is there a loop in the stack?",
+				pseudomotor_record->name,
+				MXU_MOTOR_CHAIN_MAX_STAGES );
+		}
+
+		stage = &(chain->stage_array[chain->num_stages]);
+
+		stage->motor = motor;
+
+		mx_status = ( *(function_list->get_position_transform) )
+						( motor, &(stage->transform) );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_free( chain );
+			return mx_status;
+		}
+
+		chain->num_stages++;
+
+		current_record = stage->transform.dependent_motor_record;
+
+		mx_status = mx_motor_get_pointers( current_record, &motor,
+						&function_list, fname );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_free( chain );
+			return mx_status;
+		}
+	}
+
+	/* The stack ended in a pseudomotor that cannot be flattened, so
+	 * the recursive functions must be used instead.
+	 */
+
+	if ( ( chain->num_stages == 0 )
+	  || ( motor->motor_flags & MXF_MTR_IS_PSEUDOMOTOR ) )
+	{
+		mx_free( chain );
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( i = 0; i < chain->num_stages; i++ ) {
+		stage = &(chain->stage_array[i]);
+
+		if ( ( stage->transform.dependent_from_raw_pseudomotor == NULL )
+		  || ( stage->transform.raw_pseudomotor_from_dependent
+								== NULL ) )
+		{
+			/* 'stage' points into the chain, so the error must
+			 * be reported before the chain is freed.
+			 */
+
+			mx_status = mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+			"The position transform of motor '%s' in the stack "
+			"below '%s' is missing a transform function.",
+				stage->motor->record->name,
+				pseudomotor_record->name );
+
+			mx_free( chain );
+
+			return mx_status;
+		}
+	}
+
+	chain->real_motor_record = current_record;
+
+	pseudomotor->position_chain = chain;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_motor_free_position_chain( MX_RECORD *pseudomotor_record )
+{
+	MX_MOTOR *motor;
+
+	if ( pseudomotor_record == (MX_RECORD *) NULL )
+		return;
+
+	motor = (MX_MOTOR *) pseudomotor_record->record_class_struct;
+
+	if ( motor == (MX_MOTOR *) NULL )
+		return;
+
+	mx_free( motor->position_chain );
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Each stage converts a user units position of its pseudomotor to a
+ * user units position of the next motor down the stack.
+ */
+
+MX_EXPORT void
+mx_motor_position_chain_real_from_pseudo( MX_MOTOR_POSITION_CHAIN *chain,
+					long num_positions,
+					double *pseudomotor_position_array,
+					double *real_position_array )
+{
+	MX_MOTOR_CHAIN_STAGE *stage;
+	MX_MOTOR_TRANSFORM_FUNCTION transform_fn;
+	void *transform_args;
+	double scale, offset;
+	long i, n;
+
+	if ( pseudomotor_position_array != real_position_array ) {
+		for ( n = 0; n < num_positions; n++ ) {
+			real_position_array[n] = pseudomotor_position_array[n];
+		}
+	}
+
+	for ( i = 0; i < chain->num_stages; i++ ) {
+		stage = &(chain->stage_array[i]);
+
+		scale = stage->motor->scale;
+		offset = stage->motor->offset;
+
+		transform_fn = stage->transform.dependent_from_raw_pseudomotor;
+		transform_args = stage->transform.transform_args;
+
+		for ( n = 0; n < num_positions; n++ ) {
+			real_position_array[n] = ( *transform_fn )(
+				( real_position_array[n] - offset ) / scale,
+				transform_args );
+		}
+	}
+}
+
+MX_EXPORT void
+mx_motor_position_chain_pseudo_from_real( MX_MOTOR_POSITION_CHAIN *chain,
+					long num_positions,
+					double *real_position_array,
+					double *pseudomotor_position_array )
+{
+	MX_MOTOR_CHAIN_STAGE *stage;
+	MX_MOTOR_TRANSFORM_FUNCTION transform_fn;
+	void *transform_args;
+	double scale, offset;
+	long i, n;
+
+	if ( real_position_array != pseudomotor_position_array ) {
+		for ( n = 0; n < num_positions; n++ ) {
+			pseudomotor_position_array[n] = real_position_array[n];
+		}
+	}
+
+	for ( i = chain->num_stages - 1; i >= 0; i-- ) {
+		stage = &(chain->stage_array[i]);
+
+		scale = stage->motor->scale;
+		offset = stage->motor->offset;
+
+		transform_fn = stage->transform.raw_pseudomotor_from_dependent;
+		transform_args = stage->transform.transform_args;
+
+		for ( n = 0; n < num_positions; n++ ) {
+			pseudomotor_position_array[n] = offset
+				+ scale * ( *transform_fn )(
+					pseudomotor_position_array[n],
+					transform_args );
+		}
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_chain_compute_real_positions( MX_RECORD *pseudomotor_record,
+					long num_positions,
+					double *pseudomotor_position_array,
+					double *real_position_array )
+{
+	static const char fname[] = "mx_motor_chain_compute_real_positions()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	long n;
+	mx_status_type mx_status;
+
+	if ( ( pseudomotor_position_array == (double *) NULL )
+	  || ( real_position_array == (double *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the position array pointers passed "
+		"were NULL." );
+	}
+
+	mx_status = mx_motor_get_pointers( pseudomotor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( motor->position_chain != NULL ) {
+		mx_motor_position_chain_real_from_pseudo(
+			(MX_MOTOR_POSITION_CHAIN *) motor->position_chain,
+			num_positions, pseudomotor_position_array,
+			real_position_array );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( n = 0; n < num_positions; n++ ) {
+		mx_status =
+		    mx_motor_compute_real_position_from_pseudomotor_position(
+				pseudomotor_record,
+				pseudomotor_position_array[n],
+				&real_position_array[n], TRUE );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_chain_compute_pseudomotor_positions( MX_RECORD *pseudomotor_record,
+					long num_positions,
+					double *real_position_array,
+					double *pseudomotor_position_array )
+{
+	static const char fname[] =
+			"mx_motor_chain_compute_pseudomotor_positions()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	long n;
+	mx_status_type mx_status;
+
+	if ( ( real_position_array == (double *) NULL )
+	  || ( pseudomotor_position_array == (double *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the position array pointers passed "
+		"were NULL." );
+	}
+
+	mx_status = mx_motor_get_pointers( pseudomotor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( motor->position_chain != NULL ) {
+		mx_motor_position_chain_pseudo_from_real(
+			(MX_MOTOR_POSITION_CHAIN *) motor->position_chain,
+			num_positions, real_position_array,
+			pseudomotor_position_array );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( n = 0; n < num_positions; n++ ) {
+		mx_status =
+		    mx_motor_compute_pseudomotor_position_from_real_position(
+				pseudomotor_record,
+				real_position_array[n],
+				&pseudomotor_position_array[n], TRUE );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
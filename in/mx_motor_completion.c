@@ -0,0 +1,702 @@
+/*
+ * Name:    mx_motor_completion.c
+ *
+ * Purpose: Waits for motors to finish moving without polling every motor
+ *          at a fixed interval.
+ *
+ *          Drivers whose controllers report the end of a move call
+ *          mx_motor_notify_move_complete(), which wakes up any thread
+ *          waiting in mx_wait_for_motor_array_completion() on the
+ *          record list's notifier.  Motors whose drivers cannot do that
+ *          are polled, but the poll interval grows during long moves and
+ *          shrinks again as the predicted end of the move approaches.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_mutex.h"
+#include "mx_condition_variable.h"
+#include "mx_motor.h"
+
+/* Poll intervals are in seconds.  Motors with completion events are
+ * still checked every MX_MOTOR_WAIT_EVENT_CHECK_INTERVAL seconds, in
+ * case a notification is lost.  If the record list has no notifier,
+ * they are polled like any other motor.
+ */
+
+#define MX_MOTOR_WAIT_MIN_POLL_INTERVAL		0.01
+#define MX_MOTOR_WAIT_MAX_POLL_INTERVAL		1.0
+#define MX_MOTOR_WAIT_EVENT_CHECK_INTERVAL	5.0
+
+typedef struct {
+	MX_MUTEX *mutex;
+	MX_CONDITION_VARIABLE *condition;
+	unsigned long event_count;
+} MX_MOTOR_COMPLETION_NOTIFIER;
+
+static MX_MOTOR_COMPLETION_NOTIFIER *
+mx_motor_completion_get_notifier( MX_RECORD *record )
+{
+	MX_RECORD *list_head_record;
+	MX_LIST_HEAD *list_head;
+
+	if ( record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head_record = record->list_head;
+
+	if ( list_head_record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return NULL;
+
+	return (MX_MOTOR_COMPLETION_NOTIFIER *)
+			list_head->motor_completion_notifier;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_motor_completion_notifier( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_create_motor_completion_notifier()";
+
+	MX_LIST_HEAD *list_head;
+	MX_MOTOR_COMPLETION_NOTIFIER *notifier;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	if ( list_head->motor_completion_notifier != NULL ) {
+		return mx_error( MXE_ALREADY_EXISTS, fname,
+		"The record list already has a motor completion notifier." );
+	}
+
+	notifier = (MX_MOTOR_COMPLETION_NOTIFIER *)
+			calloc( 1, sizeof(MX_MOTOR_COMPLETION_NOTIFIER) );
+
+	if ( notifier == (MX_MOTOR_COMPLETION_NOTIFIER *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_MOTOR_COMPLETION_NOTIFIER structure." );
+	}
+
+	mx_status = mx_mutex_create( &(notifier->mutex) );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_free( notifier );
+		return mx_status;
+	}
+
+	mx_status = mx_condition_variable_create( &(notifier->condition) );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		(void) mx_mutex_destroy( notifier->mutex );
+		mx_free( notifier );
+		return mx_status;
+	}
+
+	list_head->motor_completion_notifier = notifier;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* mx_delete_motor_completion_notifier() must not be called while any
+ * thread may still be waiting on, or notifying, the notifier.
+ */
+
+MX_EXPORT mx_status_type
+mx_delete_motor_completion_notifier( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_delete_motor_completion_notifier()";
+
+	MX_LIST_HEAD *list_head;
+	MX_MOTOR_COMPLETION_NOTIFIER *notifier;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	notifier = (MX_MOTOR_COMPLETION_NOTIFIER *)
+			list_head->motor_completion_notifier;
+
+	if ( notifier == (MX_MOTOR_COMPLETION_NOTIFIER *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	list_head->motor_completion_notifier = NULL;
+
+	(void) mx_condition_variable_destroy( notifier->condition );
+	(void) mx_mutex_destroy( notifier->mutex );
+
+	mx_free( notifier );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Drivers call this, possibly from another thread, when a motor
+ * reports that its move has finished.  The motor's event count is
+ * only ever changed or read under the notifier's mutex.  Without a
+ * notifier, waiters poll every motor, so there is nothing to count.
+ */
+
+MX_EXPORT void
+mx_motor_notify_move_complete( MX_RECORD *motor_record )
+{
+	MX_MOTOR_COMPLETION_NOTIFIER *notifier;
+	MX_MOTOR *motor;
+
+	if ( motor_record == (MX_RECORD *) NULL )
+		return;
+
+	motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	if ( motor == (MX_MOTOR *) NULL )
+		return;
+
+	notifier = mx_motor_completion_get_notifier( motor_record );
+
+	if ( notifier == (MX_MOTOR_COMPLETION_NOTIFIER *) NULL )
+		return;
+
+	if ( mx_mutex_lock( notifier->mutex ) != MXE_SUCCESS )
+		return;
+
+	motor->completion_event_count++;
+	notifier->event_count++;
+
+	(void) mx_condition_variable_broadcast( notifier->condition );
+
+	(void) mx_mutex_unlock( notifier->mutex );
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Returns the time in seconds that a move started now should take,
+ * or -1 if there is no way to tell.  This uses the last known position,
+ * so that no extra round trip to the controller is needed.
+ */
+
+static double
+mx_motor_completion_predict_move_time( MX_MOTOR *motor )
+{
+	double distance;
+
+	if ( ( motor->speed <= 0.0 ) || ( motor->busy == FALSE ) )
+		return -1.0;
+
+	distance = fabs( motor->destination - motor->position );
+
+	return ( distance / motor->speed ) + motor->acceleration_time;
+}
+
+static double
+mx_motor_completion_next_interval( MX_MOTOR_WAIT_STATE *state,
+					double now,
+					mx_bool_type use_events )
+{
+	double interval, remaining_time;
+
+	if ( use_events && state->motor->completion_events_supported )
+		return MX_MOTOR_WAIT_EVENT_CHECK_INTERVAL;
+
+	/* Back off while the motor keeps moving... */
+
+	interval = 2.0 * state->poll_interval;
+
+	if ( interval > MX_MOTOR_WAIT_MAX_POLL_INTERVAL )
+		interval = MX_MOTOR_WAIT_MAX_POLL_INTERVAL;
+
+	/* ...but never sleep past half of the predicted remaining time,
+	 * and start over from the minimum once the motor is overdue.
+	 */
+
+	if ( state->predicted_end_time >= 0.0 ) {
+		remaining_time = state->predicted_end_time - now;
+
+		if ( remaining_time <= 0.0 ) {
+			state->predicted_end_time = -1.0;
+
+			interval = MX_MOTOR_WAIT_MIN_POLL_INTERVAL;
+		} else
+		if ( interval > 0.5 * remaining_time ) {
+			interval = 0.5 * remaining_time;
+		}
+	}
+
+	if ( interval < MX_MOTOR_WAIT_MIN_POLL_INTERVAL )
+		interval = MX_MOTOR_WAIT_MIN_POLL_INTERVAL;
+
+	return interval;
+}
+
+static double
+mx_motor_completion_elapsed_time( MX_CLOCK_TICK start_tick )
+{
+	return mx_convert_clock_ticks_to_seconds(
+			mx_subtract_clock_ticks( mx_current_clock_tick(),
+						start_tick ) );
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_wait_state_init( MX_MOTOR_WAIT_STATE *state,
+			MX_RECORD *motor_record,
+			double now,
+			unsigned long flags )
+{
+	static const char fname[] = "mx_motor_wait_state_init()";
+
+	MX_MOTOR_COMPLETION_NOTIFIER *notifier;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	double predicted_move_time;
+	mx_status_type mx_status;
+
+	if ( state == (MX_MOTOR_WAIT_STATE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_WAIT_STATE pointer passed was NULL." );
+	}
+
+	mx_status = mx_motor_get_pointers( motor_record, &(state->motor),
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	state->motor_record = motor_record;
+	state->flags = flags;
+	state->done = FALSE;
+	state->failed = FALSE;
+
+	/* The event count is sampled before the first poll, so that a
+	 * move that finishes in between is not missed.
+	 */
+
+	state->event_count = 0;
+
+	notifier = mx_motor_completion_get_notifier( motor_record );
+
+	if ( notifier != (MX_MOTOR_COMPLETION_NOTIFIER *) NULL ) {
+		if ( mx_mutex_lock( notifier->mutex ) != MXE_SUCCESS ) {
+			return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+			"Unable to lock the motor completion notifier mutex." );
+		}
+
+		state->event_count = state->motor->completion_event_count;
+
+		(void) mx_mutex_unlock( notifier->mutex );
+	}
+
+	state->poll_interval = MX_MOTOR_WAIT_MIN_POLL_INTERVAL;
+	state->next_poll_time = now;
+
+	predicted_move_time =
+		mx_motor_completion_predict_move_time( state->motor );
+
+	if ( predicted_move_time < 0.0 ) {
+		state->predicted_end_time = -1.0;
+	} else {
+		state->predicted_end_time = now + predicted_move_time;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Reads the motor status and decides whether the motor is still moving.
+ * Error bits in the status end the wait for the motor unless the flags
+ * the motor was moved with say to ignore them.
+ */
+
+static mx_status_type
+mx_motor_wait_check_status( MX_MOTOR_WAIT_STATE *state,
+				mx_bool_type *busy )
+{
+	static const char fname[] = "mx_motor_wait_check_status()";
+
+	unsigned long motor_status, error_bits;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_status( state->motor_record, &motor_status );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( motor_status & MXSF_MTR_IS_BUSY ) {
+		*busy = TRUE;
+	} else {
+		*busy = FALSE;
+	}
+
+	if ( state->flags & MXF_MTR_IGNORE_ERRORS )
+		return MX_SUCCESSFUL_RESULT;
+
+	error_bits = motor_status & MXSF_MTR_ERROR_BITMASK;
+
+	if ( state->flags & MXF_MTR_IGNORE_LIMIT_SWITCHES ) {
+		error_bits &= ~( MXSF_MTR_POSITIVE_LIMIT_HIT
+				| MXSF_MTR_NEGATIVE_LIMIT_HIT
+				| MXSF_MTR_SOFT_POSITIVE_LIMIT_HIT
+				| MXSF_MTR_SOFT_NEGATIVE_LIMIT_HIT );
+	}
+
+	if ( error_bits == 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( error_bits & ( MXSF_MTR_POSITIVE_LIMIT_HIT
+				| MXSF_MTR_NEGATIVE_LIMIT_HIT
+				| MXSF_MTR_SOFT_POSITIVE_LIMIT_HIT
+				| MXSF_MTR_SOFT_NEGATIVE_LIMIT_HIT ) )
+	{
+		return mx_error( MXE_LIMIT_WAS_EXCEEDED, fname,
+		"Motor '%s' hit a limit.  Motor status = %#lx.",
+			state->motor_record->name, motor_status );
+	}
+
+	return mx_error( MXE_DEVICE_ACTION_FAILED, fname,
+	"Motor '%s' reported an error.  Motor status = %#lx.",
+		state->motor_record->name, motor_status );
+}
+
+/* mx_motor_wait_step() checks the motors whose events have arrived or
+ * whose polls are due, and then, if any are still moving, sleeps until
+ * the next poll is due, an event arrives, or 'max_seconds_to_wait' is
+ * up.  A negative 'max_seconds_to_wait' does not limit the sleep.
+ * Events are only used if all of the motors share one notifier.
+ */
+
+MX_EXPORT mx_status_type
+mx_motor_wait_step( long num_states,
+			MX_MOTOR_WAIT_STATE *state_array,
+			MX_CLOCK_TICK start_tick,
+			double max_seconds_to_wait,
+			long *num_remaining )
+{
+	static const char fname[] = "mx_motor_wait_step()";
+
+	MX_MOTOR_COMPLETION_NOTIFIER *notifier;
+	MX_MOTOR_WAIT_STATE *state;
+	MX_MOTOR *motor;
+	unsigned long seen_event_count;
+	long i, remaining;
+	double now, wait_time;
+	mx_bool_type busy;
+	mx_status_type mx_status;
+
+	if ( ( state_array == (MX_MOTOR_WAIT_STATE *) NULL )
+	  || ( num_remaining == (long *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	*num_remaining = 0;
+
+	if ( num_states <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	notifier = mx_motor_completion_get_notifier(
+					state_array[0].motor_record );
+
+	/* A single condition variable cannot wake us for motors that
+	 * belong to different record lists, so in that case all of the
+	 * motors are polled instead.
+	 */
+
+	for ( i = 1; i < num_states; i++ ) {
+		if ( notifier == (MX_MOTOR_COMPLETION_NOTIFIER *) NULL )
+			break;
+
+		if ( mx_motor_completion_get_notifier(
+				state_array[i].motor_record ) != notifier )
+		{
+			notifier = NULL;
+		}
+	}
+
+	seen_event_count = 0;
+
+	now = mx_motor_completion_elapsed_time( start_tick );
+
+	/* Motors that have reported the end of a move are checked
+	 * right away.
+	 */
+
+	if ( notifier != (MX_MOTOR_COMPLETION_NOTIFIER *) NULL ) {
+		if ( mx_mutex_lock( notifier->mutex ) != MXE_SUCCESS ) {
+			return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+			"Unable to lock the motor completion notifier mutex." );
+		}
+
+		seen_event_count = notifier->event_count;
+
+		for ( i = 0; i < num_states; i++ ) {
+			state = &state_array[i];
+
+			if ( state->done )
+				continue;
+
+			motor = state->motor;
+
+			if ( state->event_count
+				!= motor->completion_event_count )
+			{
+				state->event_count =
+					motor->completion_event_count;
+
+				state->next_poll_time = now;
+			}
+		}
+
+		(void) mx_mutex_unlock( notifier->mutex );
+	}
+
+	remaining = 0;
+	wait_time = -1.0;
+
+	for ( i = 0; i < num_states; i++ ) {
+		state = &state_array[i];
+
+		if ( state->done )
+			continue;
+
+		if ( state->next_poll_time <= now ) {
+			mx_status = mx_motor_wait_check_status( state, &busy );
+
+			if ( mx_status.code != MXE_SUCCESS ) {
+				state->done = TRUE;
+				state->failed = TRUE;
+
+				return mx_status;
+			}
+
+			if ( busy == FALSE ) {
+				state->done = TRUE;
+				continue;
+			}
+
+			state->poll_interval =
+			    mx_motor_completion_next_interval( state, now,
+				( notifier != NULL ) );
+
+			state->next_poll_time = now + state->poll_interval;
+		}
+
+		remaining++;
+
+		if ( ( wait_time < 0.0 )
+		  || ( state->next_poll_time - now < wait_time ) )
+		{
+			wait_time = state->next_poll_time - now;
+		}
+	}
+
+	*num_remaining = remaining;
+
+	if ( remaining == 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( ( max_seconds_to_wait >= 0.0 )
+	  && ( max_seconds_to_wait < wait_time ) )
+	{
+		wait_time = max_seconds_to_wait;
+	}
+
+	if ( wait_time <= 0.0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( notifier == (MX_MOTOR_COMPLETION_NOTIFIER *) NULL ) {
+		mx_msleep( (unsigned long) ceil( 1000.0 * wait_time ) );
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	if ( mx_mutex_lock( notifier->mutex ) != MXE_SUCCESS ) {
+		return mx_error( MXE_OPERATING_SYSTEM_ERROR, fname,
+		"Unable to lock the motor completion notifier mutex." );
+	}
+
+	if ( notifier->event_count == seen_event_count ) {
+		(void) mx_condition_variable_timed_wait( notifier->condition,
+						notifier->mutex, wait_time );
+	}
+
+	(void) mx_mutex_unlock( notifier->mutex );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Checks for a user interrupt in the same way as mx_wait_for_motor_stop().
+ * An abort request stops the motors that are still moving.
+ */
+
+static mx_status_type
+mx_motor_wait_check_interrupt( long num_states,
+				MX_MOTOR_WAIT_STATE *state_array,
+				unsigned long flags )
+{
+	static const char fname[] = "mx_motor_wait_check_interrupt()";
+
+	long i;
+	int interrupt;
+
+	if ( flags & MXF_MTR_IGNORE_KEYBOARD )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( flags & MXF_MTR_IGNORE_PAUSE ) {
+		interrupt = mx_user_requested_interrupt();
+	} else {
+		interrupt = mx_user_requested_interrupt_or_pause();
+	}
+
+	switch( interrupt ) {
+	case MXF_USER_INT_NONE:
+		return MX_SUCCESSFUL_RESULT;
+
+	case MXF_USER_INT_ERROR:
+		return mx_error( MXE_FUNCTION_FAILED, fname,
+		"An error occurred while checking for a user interrupt." );
+
+	case MXF_USER_INT_PAUSE:
+		return mx_error( MXE_PAUSE_REQUESTED, fname,
+		"Pause requested by user." );
+
+	default:
+		for ( i = 0; i < num_states; i++ ) {
+			if ( state_array[i].done == FALSE ) {
+				(void) mx_motor_soft_abort(
+					state_array[i].motor_record );
+			}
+		}
+
+		return mx_error( MXE_INTERRUPTED, fname,
+		"Motor move aborted by user." );
+	}
+}
+
+MX_EXPORT mx_status_type
+mx_wait_for_motor_array_completion( long num_motor_records,
+				MX_RECORD **motor_record_array,
+				unsigned long flags,
+				double timeout_in_seconds )
+{
+	static const char fname[] = "mx_wait_for_motor_array_completion()";
+
+	MX_MOTOR_WAIT_STATE *state_array;
+	MX_CLOCK_TICK start_tick;
+	long i, num_remaining;
+	double now, max_seconds_to_wait;
+	mx_status_type mx_status;
+
+	if ( motor_record_array == (MX_RECORD **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The motor record array pointer passed was NULL." );
+	}
+
+	if ( num_motor_records <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	state_array = (MX_MOTOR_WAIT_STATE *)
+		calloc( num_motor_records, sizeof(MX_MOTOR_WAIT_STATE) );
+
+	if ( state_array == (MX_MOTOR_WAIT_STATE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate wait state "
+		"for %ld motors.", num_motor_records );
+	}
+
+	start_tick = mx_current_clock_tick();
+
+	for ( i = 0; i < num_motor_records; i++ ) {
+		mx_status = mx_motor_wait_state_init( &state_array[i],
+					motor_record_array[i], 0.0, flags );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_free( state_array );
+			return mx_status;
+		}
+	}
+
+	while ( TRUE ) {
+		mx_status = mx_motor_wait_check_interrupt( num_motor_records,
+							state_array, flags );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			break;
+
+		max_seconds_to_wait = -1.0;
+
+		if ( timeout_in_seconds >= 0.0 ) {
+			now = mx_motor_completion_elapsed_time( start_tick );
+
+			max_seconds_to_wait = timeout_in_seconds - now;
+
+			if ( max_seconds_to_wait < 0.0 )
+				max_seconds_to_wait = 0.0;
+		}
+
+		mx_status = mx_motor_wait_step( num_motor_records,
+					state_array, start_tick,
+					max_seconds_to_wait, &num_remaining );
+
+		if ( ( mx_status.code != MXE_SUCCESS )
+		  || ( num_remaining == 0 ) )
+		{
+			break;
+		}
+
+		if ( ( timeout_in_seconds >= 0.0 )
+		  && ( mx_motor_completion_elapsed_time( start_tick )
+						>= timeout_in_seconds ) )
+		{
+			mx_status = mx_error( MXE_TIMED_OUT, fname,
+			"Timed out after %g seconds waiting for "
+			"%ld motors to stop.", timeout_in_seconds,
+				num_remaining );
+			break;
+		}
+	}
+
+	mx_free( state_array );
+
+	return mx_status;
+}
@@ -0,0 +1,474 @@
+/*
+ * Name:    mx_motor_estimate.c
+ *
+ * Purpose: Estimates how long a motor will take to make a series of moves.
+ *
+ *          The scan planner asks for the durations of thousands of moves
+ *          at a time, so the durations are computed from an
+ *          MX_MOTOR_MOVE_PROFILE built once from the motor's speed and
+ *          acceleration fields.  The kernels below have no branches or
+ *          function calls in their inner loops, so that the compiler
+ *          can vectorize them over the position array.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+/* The number of bisection steps used by the reference estimate to find
+ * the peak speed of an S-curve move too short to reach full speed.  The
+ * ramp time goes as the square root of a small speed change, so the
+ * bisection is carried on well past the resolution of a double relative
+ * to the speed range.
+ */
+
+#define MX_MOTOR_S_CURVE_ITERATIONS	200
+
+/* The time taken by an S-curve ramp that changes the speed by
+ * 'speed_change'.  The acceleration only reaches its maximum if the
+ * change in speed is at least acceleration**2 / jerk.
+ */
+
+static double
+mx_motor_s_curve_ramp_time( MX_MOTOR_MOVE_PROFILE *profile,
+				double speed_change )
+{
+	double a, j;
+
+	a = profile->acceleration;
+	j = profile->jerk;
+
+	if ( speed_change >= ( a * a / j ) ) {
+		return ( speed_change / a ) + ( a / j );
+	} else {
+		return 2.0 * sqrt( speed_change / j );
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_get_move_profile( MX_RECORD *motor_record,
+			MX_MOTOR_MOVE_PROFILE *profile )
+{
+	static const char fname[] = "mx_motor_get_move_profile()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	double scale, speed_change;
+	mx_status_type mx_status;
+
+	if ( profile == (MX_MOTOR_MOVE_PROFILE *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_MOTOR_MOVE_PROFILE pointer passed was NULL." );
+	}
+
+	mx_status = mx_motor_get_pointers( motor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( motor->speed <= 0.0 ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Cannot estimate move durations for motor '%s', since its "
+		"speed (%g) is not positive.",
+			motor_record->name, motor->speed );
+	}
+
+	scale = fabs( motor->scale );
+
+	profile->speed = motor->speed;
+	profile->base_speed = motor->base_speed;
+
+	if ( ( profile->base_speed < 0.0 )
+	  || ( profile->base_speed > profile->speed ) )
+	{
+		profile->base_speed = 0.0;
+	}
+
+	speed_change = profile->speed - profile->base_speed;
+
+	profile->profile_type = MXF_MTR_PROFILE_TRAPEZOIDAL;
+	profile->acceleration = 0.0;
+	profile->jerk = 0.0;
+
+	switch( motor->acceleration_type ) {
+	case MXF_MTR_ACCEL_RATE:
+		profile->acceleration =
+			scale * motor->raw_acceleration_parameters[0];
+		break;
+
+	case MXF_MTR_ACCEL_TIME:
+		if ( motor->raw_acceleration_parameters[0] > 0.0 ) {
+			profile->acceleration = speed_change
+				/ motor->raw_acceleration_parameters[0];
+		}
+		break;
+
+	case MXF_MTR_ACCEL_S_CURVE:
+		profile->acceleration =
+			scale * motor->raw_acceleration_parameters[0];
+		profile->jerk =
+			scale * motor->raw_acceleration_parameters[1];
+
+		if ( profile->jerk > 0.0 ) {
+			profile->profile_type = MXF_MTR_PROFILE_S_CURVE;
+		}
+		break;
+
+	default:
+		if ( motor->acceleration_time > 0.0 ) {
+			profile->acceleration =
+				speed_change / motor->acceleration_time;
+		}
+		break;
+	}
+
+	if ( ( profile->acceleration <= 0.0 ) || ( speed_change <= 0.0 ) ) {
+		profile->profile_type = MXF_MTR_PROFILE_CONSTANT_SPEED;
+		profile->ramp_time = 0.0;
+		profile->ramp_distance = 0.0;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	if ( profile->profile_type == MXF_MTR_PROFILE_S_CURVE ) {
+		profile->ramp_time =
+			mx_motor_s_curve_ramp_time( profile, speed_change );
+	} else {
+		profile->ramp_time = speed_change / profile->acceleration;
+	}
+
+	profile->ramp_distance = 0.5 * ( profile->base_speed + profile->speed )
+					* profile->ramp_time;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Each move is taken to accelerate from base_speed and decelerate back
+ * to it, with a cruise at full speed in between if the move is long
+ * enough.  Shorter moves ramp to a lower peak speed and straight back.
+ */
+
+MX_EXPORT double
+mx_motor_estimate_move_duration( MX_MOTOR_MOVE_PROFILE *profile,
+				double move_distance )
+{
+	double distance, v0, peak_speed, low, high, middle, ramp_time;
+	int i;
+
+	distance = fabs( move_distance );
+
+	if ( distance == 0.0 )
+		return 0.0;
+
+	if ( profile->profile_type == MXF_MTR_PROFILE_CONSTANT_SPEED )
+		return distance / profile->speed;
+
+	if ( distance >= 2.0 * profile->ramp_distance ) {
+		return 2.0 * profile->ramp_time
+		    + ( distance - 2.0 * profile->ramp_distance )
+				/ profile->speed;
+	}
+
+	v0 = profile->base_speed;
+
+	if ( profile->profile_type == MXF_MTR_PROFILE_TRAPEZOIDAL ) {
+		peak_speed = sqrt( v0 * v0
+				+ profile->acceleration * distance );
+
+		return 2.0 * ( peak_speed - v0 ) / profile->acceleration;
+	}
+
+	/* For an S-curve, search for the change in speed whose two ramps
+	 * just cover the distance.
+	 */
+
+	low = 0.0;
+	high = profile->speed - v0;
+
+	for ( i = 0; i < MX_MOTOR_S_CURVE_ITERATIONS; i++ ) {
+		middle = 0.5 * ( low + high );
+
+		ramp_time = mx_motor_s_curve_ramp_time( profile, middle );
+
+		if ( ( 2.0 * v0 + middle ) * ramp_time > distance ) {
+			high = middle;
+		} else {
+			low = middle;
+		}
+	}
+
+	return 2.0 * mx_motor_s_curve_ramp_time( profile, 0.5 * (low + high) );
+}
+
+/*------------------------------------------------------------------------*/
+
+/* In the kernels below, both sides of each choice are computed and then
+ * blended arithmetically.  GCC will not turn a ?: into a vector select
+ * when one side calls sqrt(), unless -fno-trapping-math is given.  The
+ * sqrt() calls themselves only vectorize with -fno-math-errno.
+ */
+
+static void
+mx_motor_estimate_trapezoidal_durations( MX_MOTOR_MOVE_PROFILE *profile,
+					long num_positions,
+					double *duration_array )
+{
+	double v0, v0_squared, inverse_speed, inverse_acceleration;
+	double acceleration, ramp_time, full_distance;
+	double distance, cruise_time, short_time, is_long;
+	long n;
+
+	v0 = profile->base_speed;
+	v0_squared = v0 * v0;
+	acceleration = profile->acceleration;
+	inverse_speed = 1.0 / profile->speed;
+	inverse_acceleration = 1.0 / acceleration;
+	ramp_time = profile->ramp_time;
+	full_distance = 2.0 * profile->ramp_distance;
+
+	for ( n = 0; n < num_positions; n++ ) {
+		distance = duration_array[n];
+
+		cruise_time = 2.0 * ramp_time
+			+ ( distance - full_distance ) * inverse_speed;
+
+		short_time = 2.0 * inverse_acceleration
+		    * ( sqrt( v0_squared + acceleration * distance ) - v0 );
+
+		is_long = ( distance >= full_distance );
+
+		duration_array[n] = short_time
+				+ is_long * ( cruise_time - short_time );
+	}
+}
+
+/* A short S-curve move peaks at a speed change 'dv' above base_speed,
+ * and its distance is ( 2 v0 + dv ) times the ramp time.  If the
+ * acceleration saturates, this is a quadratic in dv.  If not, the ramp
+ * time is 2u with dv = j u**2, and the distance gives the cubic
+ *
+ *     u**3 + p u - d / ( 2 j ) = 0,    p = 2 v0 / j
+ *
+ * which has a single real root.  mx_motor_estimate_move_duration()
+ * finds the same peak speed by bisection instead, so that the two can
+ * be checked against each other.
+ *
+ * cbrt() does not vectorize, so the main loop leaves the moves that are
+ * too short either to cruise or for the acceleration to saturate as
+ * negative distances, and a second, scalar loop solves the cubic for
+ * just those moves.  A zero length move is left as zero either way.
+ */
+
+static void
+mx_motor_estimate_s_curve_durations( MX_MOTOR_MOVE_PROFILE *profile,
+					long num_positions,
+					double *duration_array )
+{
+	double v0, inverse_speed, inverse_acceleration, inverse_jerk;
+	double acceleration, ramp_time, full_distance, saturated_distance;
+	double a_over_j, quad_b, p, p_cubed_over_27;
+	double distance, cruise_time, speed_change, saturated_time;
+	double long_time, is_cruise, is_saturated, half_q, root, u;
+	long n;
+
+	v0 = profile->base_speed;
+	acceleration = profile->acceleration;
+	inverse_speed = 1.0 / profile->speed;
+	inverse_acceleration = 1.0 / acceleration;
+	inverse_jerk = 1.0 / profile->jerk;
+	ramp_time = profile->ramp_time;
+	full_distance = 2.0 * profile->ramp_distance;
+
+	a_over_j = acceleration * inverse_jerk;
+
+	/* The shortest move in which the acceleration saturates. */
+
+	saturated_distance = 2.0 * a_over_j
+				* ( 2.0 * v0 + acceleration * a_over_j );
+
+	quad_b = 2.0 * v0 * inverse_acceleration + a_over_j;
+
+	for ( n = 0; n < num_positions; n++ ) {
+		distance = duration_array[n];
+
+		cruise_time = 2.0 * ramp_time
+			+ ( distance - full_distance ) * inverse_speed;
+
+		speed_change = 0.5 * acceleration * ( sqrt( quad_b * quad_b
+			- 4.0 * inverse_acceleration
+			    * ( 2.0 * v0 * a_over_j - distance ) ) - quad_b );
+
+		saturated_time = 2.0 * ( speed_change * inverse_acceleration
+						+ a_over_j );
+
+		/* A move long enough to cruise always does, even if it is
+		 * shorter than saturated_distance.  That happens when the
+		 * acceleration never saturates before full speed is reached.
+		 */
+
+		is_cruise = ( distance >= full_distance );
+		is_saturated = ( ( distance >= saturated_distance )
+				|| ( distance >= full_distance ) );
+
+		long_time = saturated_time
+				+ is_cruise * ( cruise_time - saturated_time );
+
+		duration_array[n] = -distance
+				+ is_saturated * ( long_time + distance );
+	}
+
+	p = 2.0 * v0 * inverse_jerk;
+	p_cubed_over_27 = p * p * p / 27.0;
+
+	for ( n = 0; n < num_positions; n++ ) {
+		if ( duration_array[n] >= 0.0 )
+			continue;
+
+		distance = -duration_array[n];
+
+		half_q = 0.25 * distance * inverse_jerk;
+
+		root = sqrt( half_q * half_q + p_cubed_over_27 );
+
+		u = cbrt( half_q + root ) + cbrt( half_q - root );
+
+		/* Cardano's formula loses precision when p dominates,
+		 * so polish the root with two Newton steps.
+		 */
+
+		u -= ( u * ( u * u + p ) - 2.0 * half_q ) / ( 3.0 * u * u + p );
+		u -= ( u * ( u * u + p ) - 2.0 * half_q ) / ( 3.0 * u * u + p );
+
+		duration_array[n] = 4.0 * u;
+	}
+}
+
+MX_EXPORT void
+mx_motor_estimate_move_durations( MX_MOTOR_MOVE_PROFILE *profile,
+				double start_position,
+				long num_positions,
+				double *position_array,
+				double *duration_array,
+				double *total_duration )
+{
+	double inverse_speed, total;
+	long n;
+
+	if ( num_positions <= 0 ) {
+		if ( total_duration != (double *) NULL ) {
+			*total_duration = 0.0;
+		}
+		return;
+	}
+
+	/* The move distances are computed first, in place. */
+
+	duration_array[0] = fabs( position_array[0] - start_position );
+
+	for ( n = 1; n < num_positions; n++ ) {
+		duration_array[n] =
+			fabs( position_array[n] - position_array[n-1] );
+	}
+
+	switch( profile->profile_type ) {
+	case MXF_MTR_PROFILE_TRAPEZOIDAL:
+		mx_motor_estimate_trapezoidal_durations( profile,
+					num_positions, duration_array );
+		break;
+
+	case MXF_MTR_PROFILE_S_CURVE:
+		mx_motor_estimate_s_curve_durations( profile,
+					num_positions, duration_array );
+		break;
+
+	default:
+		inverse_speed = 1.0 / profile->speed;
+
+		for ( n = 0; n < num_positions; n++ ) {
+			duration_array[n] *= inverse_speed;
+		}
+		break;
+	}
+
+	if ( total_duration != (double *) NULL ) {
+		total = 0.0;
+
+		for ( n = 0; n < num_positions; n++ ) {
+			total += duration_array[n];
+		}
+
+		*total_duration = total;
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_motor_compute_estimated_move_durations( MX_RECORD *motor_record )
+{
+	static const char fname[] =
+			"mx_motor_compute_estimated_move_durations()";
+
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	MX_MOTOR_MOVE_PROFILE profile;
+	mx_status_type mx_status;
+
+	mx_status = mx_motor_get_pointers( motor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( motor->num_estimated_move_positions
+			> motor->estimated_move_array_size )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"num_estimated_move_positions (%ld) for motor '%s' is "
+		"larger than the allocated array size (%ld).",
+			motor->num_estimated_move_positions,
+			motor_record->name,
+			motor->estimated_move_array_size );
+	}
+
+	if ( motor->num_estimated_move_positions <= 0 ) {
+		motor->total_estimated_move_duration = 0.0;
+		motor->must_recalculate_estimated_move_duration = FALSE;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	mx_status = mx_motor_get_move_profile( motor_record, &profile );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_motor_estimate_move_durations( &profile, motor->position,
+				motor->num_estimated_move_positions,
+				motor->estimated_move_positions,
+				motor->estimated_move_durations,
+				&(motor->total_estimated_move_duration) );
+
+	motor->must_recalculate_estimated_move_duration = FALSE;
+
+	return MX_SUCCESSFUL_RESULT;
+}
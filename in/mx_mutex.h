@@ -0,0 +1,53 @@
+/*
+ * Name:    mx_mutex.h
+ *
+ * Purpose: Header file for MX mutex functions.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2005-2006, 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_MUTEX_H__
+#define __MX_MUTEX_H__
+
+#include "mx_util.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+	long mutex_type;
+	void *mutex_ptr;
+	void *application_ptr;
+} MX_MUTEX;
+
+MX_API mx_status_type mx_mutex_create( MX_MUTEX **mutex );
+
+MX_API mx_status_type mx_mutex_destroy( MX_MUTEX *mutex );
+
+/* The lock functions return MXE_SUCCESS on success.  mx_mutex_trylock()
+ * returns MXE_NOT_AVAILABLE if the mutex is already locked.
+ */
+
+MX_API long mx_mutex_lock( MX_MUTEX *mutex );
+
+MX_API long mx_mutex_unlock( MX_MUTEX *mutex );
+
+MX_API long mx_mutex_trylock( MX_MUTEX *mutex );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_MUTEX_H__ */
+
@@ -0,0 +1,864 @@
+/*
+ * Name:    mx_number.c
+ *
+ * Purpose: Locale independent conversion of numbers to and from record
+ *          descriptions.
+ *
+ *          Large array fields, such as calibration tables or lists of
+ *          scan positions, may contain tens of thousands of numbers.
+ *          Converting each of them by copying it into a null terminated
+ *          buffer and calling strtol() or strtod() was slow, and the
+ *          result of strtod() also depended on the locale.  Going the
+ *          other way, printf() with a fixed precision either loses
+ *          digits or writes more of them than are needed.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <float.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_number.h"
+
+/* Powers of ten up to 10^22 are exactly representable as doubles. */
+
+#define MX_NUMBER_MAX_EXACT_POWER	22
+
+static const double mx_number_exact_power_of_ten[] = {
+	1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+	1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+	1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/* Integers up to 2^53 are exactly representable as doubles. */
+
+#define MX_NUMBER_MAX_EXACT_MANTISSA	( ((uint64_t) 1) << 53 )
+
+#define MX_NUMBER_MAX_DIGITS		19
+
+#define MX_NUMBER_MAX_STRTOD_LENGTH	400
+
+static int
+mx_number_digit_value( char c )
+{
+	if ( ( c >= '0' ) && ( c <= '9' ) )
+		return c - '0';
+
+	if ( ( c >= 'a' ) && ( c <= 'z' ) )
+		return c - 'a' + 10;
+
+	if ( ( c >= 'A' ) && ( c <= 'Z' ) )
+		return c - 'A' + 10;
+
+	return 99;
+}
+
+/* Converts the digits of an unsigned number.  The sign, if any, has
+ * already been consumed by the caller.
+ */
+
+static long
+mx_number_parse_magnitude( const char *string, size_t length, int base,
+			uint64_t limit, uint64_t *value,
+			size_t *num_chars_used )
+{
+	size_t i;
+	uint64_t result;
+	int digit;
+	mx_bool_type overflow;
+
+	i = 0;
+
+	if ( base == 0 ) {
+		if ( ( length >= 2 ) && ( string[0] == '0' )
+		  && ( ( string[1] == 'x' ) || ( string[1] == 'X' ) ) )
+		{
+			base = 16;
+		} else
+		if ( ( length >= 1 ) && ( string[0] == '0' ) ) {
+			base = 8;
+		} else {
+			base = 10;
+		}
+	}
+
+	/* A '0x' prefix is only skipped if a hex digit follows it, so
+	 * that "0x" by itself is read as the number 0, as strtol() does.
+	 */
+
+	if ( ( base == 16 ) && ( length >= 3 ) && ( string[0] == '0' )
+	  && ( ( string[1] == 'x' ) || ( string[1] == 'X' ) )
+	  && ( mx_number_digit_value( string[2] ) < 16 ) )
+	{
+		i = 2;
+	}
+
+	if ( ( i >= length ) || ( mx_number_digit_value( string[i] ) >= base ) )
+		return MXE_UNPARSEABLE_STRING;
+
+	result = 0;
+	overflow = FALSE;
+
+	for ( ; i < length; i++ ) {
+		digit = mx_number_digit_value( string[i] );
+
+		if ( digit >= base )
+			break;
+
+		if ( result > ( ( limit - digit ) / base ) ) {
+			overflow = TRUE;
+		} else {
+			result = result * base + digit;
+		}
+	}
+
+	*value = result;
+	*num_chars_used = i;
+
+	if ( overflow )
+		return MXE_WOULD_EXCEED_LIMIT;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_parse_uint64_n( const char *string, size_t length, int base,
+			uint64_t *value, size_t *num_chars_used )
+{
+	size_t i, num_digit_chars;
+	long status;
+
+	if ( ( string == (const char *) NULL ) || ( length == 0 ) )
+		return MXE_UNPARSEABLE_STRING;
+
+	i = 0;
+
+	if ( string[0] == '+' ) {
+		i = 1;
+	}
+
+	status = mx_number_parse_magnitude( string + i, length - i, base,
+				~((uint64_t) 0), value, &num_digit_chars );
+
+	if ( status == MXE_UNPARSEABLE_STRING )
+		return status;
+
+	*num_chars_used = i + num_digit_chars;
+
+	return status;
+}
+
+MX_EXPORT long
+mx_parse_int64_n( const char *string, size_t length, int base,
+			int64_t *value, size_t *num_chars_used )
+{
+	size_t i, num_digit_chars;
+	uint64_t magnitude, limit;
+	mx_bool_type negative;
+	long status;
+
+	if ( ( string == (const char *) NULL ) || ( length == 0 ) )
+		return MXE_UNPARSEABLE_STRING;
+
+	i = 0;
+	negative = FALSE;
+
+	if ( string[0] == '-' ) {
+		negative = TRUE;
+		i = 1;
+	} else
+	if ( string[0] == '+' ) {
+		i = 1;
+	}
+
+	/* The most negative int64_t has a magnitude one larger than
+	 * the most positive one.
+	 */
+
+	limit = ( ((uint64_t) 1) << 63 ) - 1;
+
+	if ( negative ) {
+		limit++;
+	}
+
+	status = mx_number_parse_magnitude( string + i, length - i, base,
+					limit, &magnitude, &num_digit_chars );
+
+	if ( status == MXE_UNPARSEABLE_STRING )
+		return status;
+
+	if ( negative ) {
+		*value = (int64_t) ( ~magnitude + 1 );
+	} else {
+		*value = (int64_t) magnitude;
+	}
+
+	*num_chars_used = i + num_digit_chars;
+
+	return status;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Copies the number to a buffer and converts it with strtod().  The
+ * decimal point is translated to the one used by the current locale.
+ */
+
+static long
+mx_number_parse_double_slowly( const char *string, size_t length,
+				double *value, size_t *num_chars_used )
+{
+	char buffer[ MX_NUMBER_MAX_STRTOD_LENGTH + 1 ];
+	char *endptr, *point_ptr;
+	struct lconv *locale_info;
+	char decimal_point;
+
+	if ( length > MX_NUMBER_MAX_STRTOD_LENGTH ) {
+		length = MX_NUMBER_MAX_STRTOD_LENGTH;
+	}
+
+	memcpy( buffer, string, length );
+
+	buffer[length] = '\0';
+
+	/* strtod() would skip leading whitespace, which we must not. */
+
+	if ( ( buffer[0] == ' ' ) || ( buffer[0] == '\t' )
+	  || ( buffer[0] == '\n' ) || ( buffer[0] == '\r' ) )
+	{
+		return MXE_UNPARSEABLE_STRING;
+	}
+
+	locale_info = localeconv();
+
+	if ( ( locale_info != (struct lconv *) NULL )
+	  && ( locale_info->decimal_point != (char *) NULL ) )
+	{
+		decimal_point = locale_info->decimal_point[0];
+	} else {
+		decimal_point = '.';
+	}
+
+	if ( decimal_point != '.' ) {
+		point_ptr = strchr( buffer, '.' );
+
+		if ( point_ptr != (char *) NULL ) {
+			*point_ptr = decimal_point;
+		}
+	}
+
+	*value = strtod( buffer, &endptr );
+
+	if ( endptr == buffer )
+		return MXE_UNPARSEABLE_STRING;
+
+	*num_chars_used = endptr - buffer;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_parse_double_n( const char *string, size_t length,
+			double *value, size_t *num_chars_used )
+{
+	size_t i, j, num_digits, num_significant_digits;
+	uint64_t mantissa;
+	long exponent, explicit_exponent, sign_of_exponent;
+	mx_bool_type negative, saw_point, truncated;
+	double result;
+	char c;
+
+	if ( ( string == (const char *) NULL ) || ( length == 0 ) )
+		return MXE_UNPARSEABLE_STRING;
+
+	i = 0;
+	negative = FALSE;
+
+	if ( string[0] == '-' ) {
+		negative = TRUE;
+		i = 1;
+	} else
+	if ( string[0] == '+' ) {
+		i = 1;
+	}
+
+	/* Hexadecimal floating point such as '0x1p3' would otherwise be
+	 * read as the number 0 followed by junk.
+	 */
+
+	if ( ( ( i + 1 ) < length ) && ( string[i] == '0' )
+	  && ( ( string[i+1] == 'x' ) || ( string[i+1] == 'X' ) ) )
+	{
+		return mx_number_parse_double_slowly( string, length,
+						value, num_chars_used );
+	}
+
+	mantissa = 0;
+	exponent = 0;
+	num_digits = 0;
+	num_significant_digits = 0;
+	saw_point = FALSE;
+	truncated = FALSE;
+
+	for ( ; i < length; i++ ) {
+		c = string[i];
+
+		if ( ( c >= '0' ) && ( c <= '9' ) ) {
+			num_digits++;
+
+			if ( ( mantissa == 0 ) && ( c == '0' ) ) {
+				/* Leading zeros are not significant. */
+			} else
+			if ( num_significant_digits < MX_NUMBER_MAX_DIGITS ) {
+				mantissa = 10 * mantissa + ( c - '0' );
+				num_significant_digits++;
+			} else {
+				if ( c != '0' ) {
+					truncated = TRUE;
+				}
+
+				exponent++;
+			}
+
+			if ( saw_point ) {
+				exponent--;
+			}
+		} else
+		if ( ( c == '.' ) && ( saw_point == FALSE ) ) {
+			saw_point = TRUE;
+		} else {
+			break;
+		}
+	}
+
+	/* No digits at all means 'inf', 'nan', or not a number.
+	 * Let strtod() sort it out.
+	 */
+
+	if ( num_digits == 0 ) {
+		return mx_number_parse_double_slowly( string, length,
+						value, num_chars_used );
+	}
+
+	if ( ( i < length )
+	  && ( ( string[i] == 'e' ) || ( string[i] == 'E' ) ) )
+	{
+		j = i + 1;
+		sign_of_exponent = 1;
+
+		if ( ( j < length ) && ( string[j] == '-' ) ) {
+			sign_of_exponent = -1;
+			j++;
+		} else
+		if ( ( j < length ) && ( string[j] == '+' ) ) {
+			j++;
+		}
+
+		/* "1e" and "1e+" are the number 1 followed by junk. */
+
+		if ( ( j < length ) && ( string[j] >= '0' )
+		  && ( string[j] <= '9' ) )
+		{
+			explicit_exponent = 0;
+
+			for ( ; j < length; j++ ) {
+				c = string[j];
+
+				if ( ( c < '0' ) || ( c > '9' ) )
+					break;
+
+				if ( explicit_exponent < 100000 ) {
+					explicit_exponent *= 10;
+					explicit_exponent += c - '0';
+				}
+			}
+
+			exponent += sign_of_exponent * explicit_exponent;
+
+			i = j;
+		}
+	}
+
+	*num_chars_used = i;
+
+	/* Clinger's fast path: if both the mantissa and the power of
+	 * ten are exact doubles, a single correctly rounded multiply or
+	 * divide gives the correctly rounded result.
+	 */
+
+	if ( ( truncated == FALSE )
+	  && ( mantissa <= MX_NUMBER_MAX_EXACT_MANTISSA )
+	  && ( exponent >= -MX_NUMBER_MAX_EXACT_POWER )
+	  && ( exponent <= MX_NUMBER_MAX_EXACT_POWER ) )
+	{
+		result = (double) mantissa;
+
+		if ( exponent < 0 ) {
+			result /= mx_number_exact_power_of_ten[ -exponent ];
+		} else {
+			result *= mx_number_exact_power_of_ten[ exponent ];
+		}
+
+		if ( negative ) {
+			result = -result;
+		}
+
+		*value = result;
+
+		return MXE_SUCCESS;
+	}
+
+	if ( mantissa == 0 ) {
+		*value = negative ? -0.0 : 0.0;
+
+		return MXE_SUCCESS;
+	}
+
+	return mx_number_parse_double_slowly( string, *num_chars_used,
+						value, num_chars_used );
+}
+
+/*========================================================================*/
+
+static const char mx_number_digit_pairs[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char mx_number_hex_digits[] = "0123456789abcdef";
+
+MX_EXPORT size_t
+mx_format_uint64( char *buffer, uint64_t value, int base )
+{
+	char digits[ MXU_NUMBER_FORMAT_LENGTH ];
+	char *ptr, *end;
+	unsigned pair;
+	size_t length;
+
+	end = digits + sizeof(digits);
+	ptr = end;
+
+	if ( base == 16 ) {
+		do {
+			*(--ptr) = mx_number_hex_digits[ value & 0xf ];
+			value >>= 4;
+		} while ( value != 0 );
+	} else {
+		/* Two digits at a time halves the number of divisions. */
+
+		while ( value >= 100 ) {
+			pair = (unsigned) ( value % 100 ) * 2;
+			value /= 100;
+
+			*(--ptr) = mx_number_digit_pairs[ pair + 1 ];
+			*(--ptr) = mx_number_digit_pairs[ pair ];
+		}
+
+		if ( value >= 10 ) {
+			pair = (unsigned) value * 2;
+
+			*(--ptr) = mx_number_digit_pairs[ pair + 1 ];
+			*(--ptr) = mx_number_digit_pairs[ pair ];
+		} else {
+			*(--ptr) = (char) ( '0' + value );
+		}
+	}
+
+	length = end - ptr;
+
+	memcpy( buffer, ptr, length );
+
+	buffer[length] = '\0';
+
+	return length;
+}
+
+MX_EXPORT size_t
+mx_format_int64( char *buffer, int64_t value )
+{
+	if ( value < 0 ) {
+		buffer[0] = '-';
+
+		return 1 + mx_format_uint64( buffer + 1,
+					~((uint64_t) value) + 1, 10 );
+	}
+
+	return mx_format_uint64( buffer, (uint64_t) value, 10 );
+}
+
+/* printf() uses the decimal point of the current locale, but record
+ * descriptions always use '.'.
+ */
+
+static void
+mx_number_fix_decimal_point( char *buffer )
+{
+	struct lconv *locale_info;
+	char decimal_point;
+	char *ptr;
+
+	locale_info = localeconv();
+
+	if ( ( locale_info == (struct lconv *) NULL )
+	  || ( locale_info->decimal_point == (char *) NULL ) )
+	{
+		return;
+	}
+
+	decimal_point = locale_info->decimal_point[0];
+
+	if ( ( decimal_point == '.' ) || ( decimal_point == '\0' ) )
+		return;
+
+	ptr = strchr( buffer, decimal_point );
+
+	if ( ptr != (char *) NULL ) {
+		*ptr = '.';
+	}
+}
+
+/* NaN and the infinities are written the way strtod() reads them. */
+
+static size_t
+mx_number_format_special( char *buffer, double value )
+{
+	if ( value != value ) {
+		strlcpy( buffer, "nan", MXU_NUMBER_FORMAT_LENGTH );
+	} else
+	if ( value > 0.0 ) {
+		strlcpy( buffer, "inf", MXU_NUMBER_FORMAT_LENGTH );
+	} else {
+		strlcpy( buffer, "-inf", MXU_NUMBER_FORMAT_LENGTH );
+	}
+
+	return strlen( buffer );
+}
+
+/* Whole numbers small enough to be exact are by far the most common
+ * values in databases, and are written as integers without going
+ * through printf() at all.  Negative zero is left to printf() so that
+ * its sign is kept.
+ */
+
+#define MX_NUMBER_IS_SMALL_INTEGER(v) \
+	( ( (v) >= -9007199254740992.0 ) && ( (v) <= 9007199254740992.0 ) \
+	  && ( (v) == (double) (int64_t) (v) ) \
+	  && ( ( (v) != 0.0 ) || ( 1.0 / (v) > 0.0 ) ) )
+
+/* The rest of a double or float is written from the digits of one
+ * "%.<max_precision-1>e" conversion.  Shorter precisions are made by
+ * rounding that digit string, rather than by calling snprintf() again
+ * for each of them, and the result is laid out just as "%g" would lay
+ * it out.  Rounding the already rounded digits gives the same answer
+ * as rounding the exact value, except when the digits that are dropped
+ * are exactly '5' followed by zeros.  The exact value might then be on
+ * either side of the halfway point, so snprintf() is used for that
+ * precision instead.
+ */
+
+#define MXU_NUMBER_MAX_DIGITS	17
+
+/* Rounds the 'num_digits' digits in 'digits' to 'precision' digits.
+ * Returns FALSE if the result cannot be determined from the digits.
+ */
+
+static mx_bool_type
+mx_number_round_digits( const char *digits, int num_digits, int precision,
+			char *rounded, int *exponent )
+{
+	int i;
+	mx_bool_type round_up, exactly_half;
+
+	memcpy( rounded, digits, precision );
+
+	if ( digits[precision] < '5' )
+		return TRUE;
+
+	round_up = TRUE;
+
+	if ( digits[precision] == '5' ) {
+		exactly_half = TRUE;
+
+		for ( i = precision + 1; i < num_digits; i++ ) {
+			if ( digits[i] != '0' ) {
+				exactly_half = FALSE;
+				break;
+			}
+		}
+
+		if ( exactly_half )
+			return FALSE;
+	}
+
+	for ( i = precision - 1; ( i >= 0 ) && round_up; i-- ) {
+		if ( rounded[i] == '9' ) {
+			rounded[i] = '0';
+		} else {
+			rounded[i]++;
+			round_up = FALSE;
+		}
+	}
+
+	/* 99...9 became 00...0, so it is really 10...0. */
+
+	if ( round_up ) {
+		rounded[0] = '1';
+		(*exponent)++;
+	}
+
+	return TRUE;
+}
+
+/* Writes 'precision' digits, the first of which is in the 10**exponent
+ * place, the way that "%.<precision>g" does.
+ */
+
+static size_t
+mx_number_format_digits( char *buffer, mx_bool_type negative,
+			const char *digits, int precision, int exponent )
+{
+	char *ptr;
+	int i, num_digits, abs_exponent;
+
+	ptr = buffer;
+
+	if ( negative ) {
+		*ptr++ = '-';
+	}
+
+	/* Trailing zeros are never written. */
+
+	num_digits = precision;
+
+	while ( ( num_digits > 1 ) && ( digits[num_digits-1] == '0' ) ) {
+		num_digits--;
+	}
+
+	if ( ( exponent < -4 ) || ( exponent >= precision ) ) {
+		*ptr++ = digits[0];
+
+		if ( num_digits > 1 ) {
+			*ptr++ = '.';
+
+			for ( i = 1; i < num_digits; i++ ) {
+				*ptr++ = digits[i];
+			}
+		}
+
+		*ptr++ = 'e';
+
+		if ( exponent < 0 ) {
+			*ptr++ = '-';
+			abs_exponent = -exponent;
+		} else {
+			*ptr++ = '+';
+			abs_exponent = exponent;
+		}
+
+		if ( abs_exponent >= 100 ) {
+			*ptr++ = (char) ( '0' + abs_exponent / 100 );
+		}
+
+		*ptr++ = (char) ( '0' + ( abs_exponent / 10 ) % 10 );
+		*ptr++ = (char) ( '0' + abs_exponent % 10 );
+	} else
+	if ( exponent >= 0 ) {
+		for ( i = 0; i <= exponent; i++ ) {
+			if ( i < num_digits ) {
+				*ptr++ = digits[i];
+			} else {
+				*ptr++ = '0';
+			}
+		}
+
+		if ( num_digits > exponent + 1 ) {
+			*ptr++ = '.';
+
+			for ( i = exponent + 1; i < num_digits; i++ ) {
+				*ptr++ = digits[i];
+			}
+		}
+	} else {
+		*ptr++ = '0';
+		*ptr++ = '.';
+
+		for ( i = exponent + 1; i < 0; i++ ) {
+			*ptr++ = '0';
+		}
+
+		for ( i = 0; i < num_digits; i++ ) {
+			*ptr++ = digits[i];
+		}
+	}
+
+	*ptr = '\0';
+
+	return (size_t) ( ptr - buffer );
+}
+
+static mx_bool_type
+mx_number_reads_back( const char *buffer, size_t length,
+			double value, mx_bool_type is_float )
+{
+	double parsed_value;
+	size_t num_chars_used;
+	long status;
+
+	status = mx_parse_double_n( buffer, length,
+				&parsed_value, &num_chars_used );
+
+	if ( status != MXE_SUCCESS )
+		return FALSE;
+
+	if ( is_float ) {
+		return ( (float) parsed_value == (float) value );
+	}
+
+	return ( parsed_value == value );
+}
+
+static size_t
+mx_number_format_round_trip( char *buffer, double value,
+			int min_precision, int max_precision,
+			mx_bool_type is_float )
+{
+	char scratch[MXU_NUMBER_FORMAT_LENGTH];
+	char digits[MXU_NUMBER_MAX_DIGITS + 1];
+	char rounded[MXU_NUMBER_MAX_DIGITS + 1];
+	char *ptr;
+	mx_bool_type negative, exponent_negative;
+	int num_digits, exponent, rounded_exponent, precision;
+	size_t length;
+
+	snprintf( scratch, sizeof(scratch), "%.*e", max_precision - 1, value );
+
+	/* Pick out the sign, the digits and the exponent.  Whatever is
+	 * between the first digit and the rest is the decimal point of
+	 * the current locale, and is skipped.
+	 */
+
+	ptr = scratch;
+
+	negative = ( *ptr == '-' );
+
+	if ( negative ) {
+		ptr++;
+	}
+
+	num_digits = 0;
+
+	while ( ( *ptr != 'e' ) && ( *ptr != '\0' ) ) {
+		if ( ( *ptr >= '0' ) && ( *ptr <= '9' )
+		  && ( num_digits < max_precision ) )
+		{
+			digits[num_digits++] = *ptr;
+		}
+		ptr++;
+	}
+
+	if ( ( *ptr != 'e' ) || ( num_digits != max_precision ) ) {
+		snprintf( buffer, MXU_NUMBER_FORMAT_LENGTH,
+				"%.*g", max_precision, value );
+
+		mx_number_fix_decimal_point( buffer );
+
+		return strlen( buffer );
+	}
+
+	ptr++;
+
+	exponent_negative = ( *ptr == '-' );
+
+	if ( ( *ptr == '-' ) || ( *ptr == '+' ) ) {
+		ptr++;
+	}
+
+	for ( exponent = 0; ( *ptr >= '0' ) && ( *ptr <= '9' ); ptr++ ) {
+		exponent = 10 * exponent + ( *ptr - '0' );
+	}
+
+	if ( exponent_negative ) {
+		exponent = -exponent;
+	}
+
+	for ( precision = min_precision; precision < max_precision;
+							precision++ )
+	{
+		rounded_exponent = exponent;
+
+		if ( mx_number_round_digits( digits, num_digits, precision,
+					rounded, &rounded_exponent ) )
+		{
+			length = mx_number_format_digits( buffer, negative,
+					rounded, precision, rounded_exponent );
+		} else {
+			snprintf( buffer, MXU_NUMBER_FORMAT_LENGTH,
+					"%.*g", precision, value );
+
+			mx_number_fix_decimal_point( buffer );
+
+			length = strlen( buffer );
+		}
+
+		if ( mx_number_reads_back( buffer, length, value, is_float ) )
+			return length;
+	}
+
+	return mx_number_format_digits( buffer, negative,
+					digits, max_precision, exponent );
+}
+
+MX_EXPORT size_t
+mx_format_double( char *buffer, double value )
+{
+	if ( ( value != value )
+	  || ( value > DBL_MAX ) || ( value < -DBL_MAX ) )
+	{
+		return mx_number_format_special( buffer, value );
+	}
+
+	if ( MX_NUMBER_IS_SMALL_INTEGER( value ) )
+		return mx_format_int64( buffer, (int64_t) value );
+
+	/* 17 significant digits always round trip, but most values
+	 * need fewer, so try the shorter forms first.
+	 */
+
+	return mx_number_format_round_trip( buffer, value, 15, 17, FALSE );
+}
+
+MX_EXPORT size_t
+mx_format_float( char *buffer, float value )
+{
+	if ( ( value != value )
+	  || ( value > FLT_MAX ) || ( value < -FLT_MAX ) )
+	{
+		return mx_number_format_special( buffer, value );
+	}
+
+	if ( MX_NUMBER_IS_SMALL_INTEGER( value ) )
+		return mx_format_int64( buffer, (int64_t) value );
+
+	return mx_number_format_round_trip( buffer, (double) value,
+						6, 9, TRUE );
+}
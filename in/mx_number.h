@@ -0,0 +1,93 @@
+/*
+ * Name:    mx_number.h
+ *
+ * Purpose: Header file for locale independent number conversion.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_NUMBER_H__
+#define __MX_NUMBER_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* These functions convert the number at the beginning of a string that
+ * does not need to be null terminated.  At most 'length' characters are
+ * examined.  Unlike strtol() and strtod(), they never skip leading
+ * whitespace and never depend on the current locale.
+ *
+ * The number of characters that make up the number is returned in
+ * '*num_chars_used'.  The return value is MXE_SUCCESS,
+ * MXE_UNPARSEABLE_STRING if there is no number at the start of the
+ * string, or MXE_WOULD_EXCEED_LIMIT if the number does not fit.  No
+ * error message is generated, since these are meant to be called in
+ * tight loops.
+ *
+ * A 'base' of 0 works the same way as for strtol(): a leading '0x' means
+ * hexadecimal and a leading '0' means octal.
+ */
+
+MX_API long mx_parse_int64_n( const char *string, size_t length, int base,
+				int64_t *value, size_t *num_chars_used );
+
+MX_API long mx_parse_uint64_n( const char *string, size_t length, int base,
+				uint64_t *value, size_t *num_chars_used );
+
+/* mx_parse_double_n() converts numbers with at most 19 significant
+ * digits and a small enough decimal exponent exactly with a single
+ * floating point multiply or divide.  Anything else, including 'inf',
+ * 'nan' and hexadecimal floating point such as '0x1p3', is handed to
+ * strtod().
+ */
+
+MX_API long mx_parse_double_n( const char *string, size_t length,
+				double *value, size_t *num_chars_used );
+
+/*---*/
+
+/* The mx_format_...() functions are the reverse of the functions above.
+ * They write the number into 'buffer', which must be at least
+ * MXU_NUMBER_FORMAT_LENGTH bytes long, add a null terminator, and
+ * return the number of characters written.
+ *
+ * mx_format_double() and mx_format_float() write a string that
+ * mx_parse_double_n() reads back as exactly the same value, so that
+ * saving and reloading a database never changes a number.  Whole
+ * numbers are written as integers.  Other values are written with the
+ * first of %.15g, %.16g and %.17g (%.6g to %.9g for floats) that reads
+ * back exactly.  This is usually the shortest such string, but not
+ * always, since a shorter string that is not the correctly rounded
+ * one may also read back exactly.  The decimal point is always '.',
+ * whatever the locale.
+ */
+
+#define MXU_NUMBER_FORMAT_LENGTH	40
+
+MX_API size_t mx_format_int64( char *buffer, int64_t value );
+
+MX_API size_t mx_format_uint64( char *buffer, uint64_t value, int base );
+
+MX_API size_t mx_format_double( char *buffer, double value );
+
+MX_API size_t mx_format_float( char *buffer, float value );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_NUMBER_H__ */
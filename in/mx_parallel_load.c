@@ -0,0 +1,485 @@
+/*
+ * Name:    mx_parallel_load.c
+ *
+ * Purpose: Creates the records of an MX database on several threads.
+ *
+ *          Each record description can be parsed independently of the
+ *          others, up to the point where references to other records
+ *          must be resolved.  MX already handles references to records
+ *          that have not been created yet by making placeholder records
+ *          and fixing them up afterwards.  Here, each worker thread
+ *          builds the records for one part of the database in a scratch
+ *          record list, so that every reference to a record in another
+ *          part becomes a placeholder.  The scratch lists are then
+ *          linked together in order and all of the placeholders are
+ *          resolved in one serial pass.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_arena.h"
+#include "mx_thread.h"
+
+typedef struct {
+	MX_RECORD *scratch_list;
+	char **description_array;
+	long first_description;
+	long num_descriptions;
+	unsigned long flags;
+
+	MX_THREAD *thread;
+	long failed_description;
+	mx_status_type mx_status;
+} MX_PARALLEL_LOAD_CHUNK;
+
+static mx_bool_type
+mx_parallel_load_is_comment( char *description )
+{
+	char *ptr;
+
+	if ( description == (char *) NULL )
+		return TRUE;
+
+	for ( ptr = description; isspace( (int)(unsigned char) *ptr ); ptr++ );
+
+	if ( ( *ptr == '#' ) || ( *ptr == '\0' ) )
+		return TRUE;
+
+	return FALSE;
+}
+
+static mx_status_type
+mx_parallel_load_worker( MX_THREAD *thread, void *args )
+{
+	MX_PARALLEL_LOAD_CHUNK *chunk;
+	MX_RECORD *created_record;
+	char *description;
+	long i;
+	mx_status_type mx_status;
+
+	MXW_UNUSED( thread );
+
+	chunk = (MX_PARALLEL_LOAD_CHUNK *) args;
+
+	for ( i = 0; i < chunk->num_descriptions; i++ ) {
+		description = chunk->description_array[i];
+
+		if ( mx_parallel_load_is_comment( description ) )
+			continue;
+
+		mx_status = mx_create_record_from_description(
+				chunk->scratch_list, description,
+				&created_record, chunk->flags );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			chunk->failed_description =
+					chunk->first_description + i;
+
+			chunk->mx_status = mx_status;
+
+			return mx_status;
+		}
+	}
+
+	chunk->mx_status = MX_SUCCESSFUL_RESULT;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_status_type
+mx_parallel_load_create_scratch_list( MX_LIST_HEAD *list_head,
+					MX_PARALLEL_LOAD_CHUNK *chunk )
+{
+	MX_LIST_HEAD *scratch_list_head;
+	MX_ARENA *arena, *scratch_arena;
+	mx_status_type mx_status;
+
+	mx_status = mx_create_empty_database( &(chunk->scratch_list) );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	scratch_list_head =
+		mx_get_record_list_head_struct( chunk->scratch_list );
+
+	/* Drivers may look at these while creating their records,
+	 * so they must match the real list head.
+	 */
+
+	scratch_list_head->is_server = list_head->is_server;
+	scratch_list_head->plotting_enabled = list_head->plotting_enabled;
+	scratch_list_head->default_precision = list_head->default_precision;
+	scratch_list_head->default_data_format =
+					list_head->default_data_format;
+
+	/* Arenas are not thread safe, so each scratch list gets an arena
+	 * of its own which is later merged into the real one.
+	 */
+
+	arena = (MX_ARENA *) list_head->record_arena;
+
+	if ( arena != (MX_ARENA *) NULL ) {
+		mx_status = mx_arena_create( &scratch_arena,
+					arena->block_size, arena->flags );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		scratch_list_head->record_arena = scratch_arena;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_parallel_load_merge_fixups( MX_LIST_HEAD *list_head,
+				MX_LIST_HEAD *scratch_list_head )
+{
+	static const char fname[] = "mx_parallel_load_merge_fixups()";
+
+	void **new_fixup_record_array;
+	long i, num_fixup_records;
+
+	if ( scratch_list_head->num_fixup_records <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	num_fixup_records = list_head->num_fixup_records
+				+ scratch_list_head->num_fixup_records;
+
+	new_fixup_record_array = (void **)
+		realloc( list_head->fixup_record_array,
+			num_fixup_records * sizeof(void *) );
+
+	if ( new_fixup_record_array == (void **) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to grow the fixup record array "
+		"to %ld elements.", num_fixup_records );
+	}
+
+	for ( i = 0; i < scratch_list_head->num_fixup_records; i++ ) {
+		new_fixup_record_array[ list_head->num_fixup_records + i ] =
+				scratch_list_head->fixup_record_array[i];
+	}
+
+	list_head->fixup_record_array = new_fixup_record_array;
+	list_head->num_fixup_records = num_fixup_records;
+	list_head->fixup_records_in_use = TRUE;
+
+	/* The placeholders now belong to the real list head. */
+
+	scratch_list_head->num_fixup_records = 0;
+	scratch_list_head->fixup_records_in_use = FALSE;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Move the records of a scratch list onto the end of the real record
+ * list.  Duplicate record names are detected here, since the worker
+ * threads cannot see each other's records.
+ */
+
+static mx_status_type
+mx_parallel_load_link_chunk( MX_RECORD *record_list,
+				MX_PARALLEL_LOAD_CHUNK *chunk )
+{
+	static const char fname[] = "mx_parallel_load_link_chunk()";
+
+	MX_RECORD *list_head_record, *scratch_head_record;
+	MX_RECORD *record, *last_record;
+	MX_LIST_HEAD *list_head, *scratch_list_head;
+	mx_status_type mx_status;
+
+	list_head_record = record_list->list_head;
+	scratch_head_record = chunk->scratch_list->list_head;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	scratch_list_head = (MX_LIST_HEAD *)
+			scratch_head_record->record_superclass_struct;
+
+	/* The records are allocated from the scratch list's arena, which
+	 * is destroyed along with the scratch list.  The real list takes
+	 * over its blocks before any record is moved, so that a record
+	 * that has already been linked in stays valid if linking a later
+	 * one fails.
+	 */
+
+	mx_arena_adopt( (MX_ARENA *) list_head->record_arena,
+			(MX_ARENA *) scratch_list_head->record_arena );
+
+	while ( scratch_head_record->next_record != scratch_head_record ) {
+
+		record = scratch_head_record->next_record;
+
+		if ( mx_record_name_index_lookup( record_list, record->name )
+							!= (MX_RECORD *) NULL )
+		{
+			return mx_error( MXE_ALREADY_EXISTS, fname,
+			"A record named '%s' already exists in the database.",
+				record->name );
+		}
+
+		/* Unlink the record from the scratch list. */
+
+		scratch_head_record->next_record = record->next_record;
+		record->next_record->previous_record = scratch_head_record;
+
+		/* Add it to the end of the real list. */
+
+		last_record = list_head_record->previous_record;
+
+		record->previous_record = last_record;
+		record->next_record = list_head_record;
+
+		last_record->next_record = record;
+		list_head_record->previous_record = record;
+
+		record->list_head = list_head_record;
+
+		list_head->num_records++;
+
+		if ( scratch_list_head->num_records > 0 ) {
+			scratch_list_head->num_records--;
+		}
+
+		mx_status = mx_record_name_index_add( record );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		/* Earlier chunks may be waiting for this record. */
+
+		mx_status = mx_resolve_pending_references( record );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	mx_status = mx_parallel_load_merge_fixups( list_head,
+						scratch_list_head );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	/* References to records in later chunks stay pending until
+	 * those chunks are linked.
+	 */
+
+	mx_status = mx_merge_pending_references( record_list,
+						chunk->scratch_list );
+
+	return mx_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_read_database_from_array_in_parallel( MX_RECORD *record_list,
+					long num_descriptions,
+					char **description_array,
+					unsigned long flags,
+					unsigned long num_worker_threads )
+{
+	static const char fname[] = "mx_read_database_from_array_in_parallel()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PARALLEL_LOAD_CHUNK *chunk_array, *chunk;
+	unsigned long i, num_chunks, max_chunks;
+	long first_description, chunk_size, thread_exit_status;
+	mx_status_type mx_status, thread_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+	if ( ( num_descriptions > 0 )
+	  && ( description_array == (char **) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The description array pointer passed was NULL." );
+	}
+
+	flags &= ~MXFC_PARALLEL_LOAD;
+
+	max_chunks = (unsigned long) ( num_descriptions
+			/ MX_PARALLEL_LOAD_MIN_DESCRIPTIONS_PER_THREAD );
+
+	num_chunks = num_worker_threads;
+
+	if ( num_chunks > max_chunks )
+		num_chunks = max_chunks;
+
+	if ( ( num_chunks <= 1 )
+	  || ( flags & MXFC_ALLOW_RECORD_REPLACEMENT )
+	  || ( flags & MXFC_ALLOW_SCAN_REPLACEMENT ) )
+	{
+		return mx_read_database_from_array( record_list,
+				num_descriptions, description_array, flags );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	chunk_array = (MX_PARALLEL_LOAD_CHUNK *)
+			calloc( num_chunks, sizeof(MX_PARALLEL_LOAD_CHUNK) );
+
+	if ( chunk_array == (MX_PARALLEL_LOAD_CHUNK *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate %lu load chunks.",
+			num_chunks );
+	}
+
+	/* Split the descriptions into contiguous chunks, one per thread. */
+
+	first_description = 0;
+
+	mx_status = MX_SUCCESSFUL_RESULT;
+
+	for ( i = 0; i < num_chunks; i++ ) {
+		chunk = &chunk_array[i];
+
+		chunk_size = ( num_descriptions - first_description )
+					/ (long) ( num_chunks - i );
+
+		chunk->description_array =
+				description_array + first_description;
+		chunk->first_description = first_description;
+		chunk->num_descriptions = chunk_size;
+		chunk->flags = flags;
+		chunk->failed_description = -1;
+		chunk->mx_status = MX_SUCCESSFUL_RESULT;
+
+		first_description += chunk_size;
+
+		mx_status = mx_parallel_load_create_scratch_list(
+							list_head, chunk );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			break;
+	}
+
+	/* Start the worker threads. */
+
+	for ( i = 0; ( mx_status.code == MXE_SUCCESS ) && ( i < num_chunks );
+									i++ )
+	{
+		chunk = &chunk_array[i];
+
+		mx_status = mx_thread_create( &(chunk->thread),
+					mx_parallel_load_worker, chunk );
+	}
+
+	/* Wait for all of the threads that were started, even if one of
+	 * them could not be created.
+	 */
+
+	for ( i = 0; i < num_chunks; i++ ) {
+		chunk = &chunk_array[i];
+
+		if ( chunk->thread == (MX_THREAD *) NULL )
+			continue;
+
+		thread_status = mx_thread_wait( chunk->thread,
+					&thread_exit_status, -1.0 );
+
+		if ( ( thread_status.code != MXE_SUCCESS )
+		  && ( mx_status.code == MXE_SUCCESS ) )
+		{
+			mx_status = thread_status;
+		}
+
+		(void) mx_thread_free_data_structures( chunk->thread );
+
+		chunk->thread = NULL;
+	}
+
+	/* The merge checks every new record name against the real list,
+	 * so make sure that those checks go through the name index.
+	 */
+
+	if ( ( mx_status.code == MXE_SUCCESS )
+	  && ( list_head->record_name_index == NULL ) )
+	{
+		mx_status = mx_create_record_name_index( record_list );
+	}
+
+	/* Link the chunks together in their original order.  If a chunk
+	 * failed, the records that it created before the failure are
+	 * still linked in, just as they would have been by a serial load,
+	 * but none of the later chunks are.
+	 */
+
+	for ( i = 0; ( mx_status.code == MXE_SUCCESS ) && ( i < num_chunks );
+									i++ )
+	{
+		chunk = &chunk_array[i];
+
+		mx_status = mx_parallel_load_link_chunk( record_list, chunk );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			break;
+
+		if ( chunk->mx_status.code != MXE_SUCCESS ) {
+			mx_status = chunk->mx_status;
+			break;
+		}
+	}
+
+	/* Resolve the references between records in different chunks,
+	 * along with any forward references within a chunk.
+	 */
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_fixup_placeholder_records( record_list );
+	}
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_check_pending_references( record_list );
+	}
+
+	/* The scratch lists are deleted last, since the placeholder
+	 * records may still refer to their list heads until the fixups
+	 * have been done.
+	 */
+
+	for ( i = 0; i < num_chunks; i++ ) {
+		chunk = &chunk_array[i];
+
+		if ( chunk->scratch_list == (MX_RECORD *) NULL )
+			continue;
+
+		(void) mx_delete_pending_reference_table( chunk->scratch_list );
+
+		(void) mx_delete_record_name_index( chunk->scratch_list );
+
+		(void) mx_delete_record_list( chunk->scratch_list );
+	}
+
+	mx_free( chunk_array );
+
+	return mx_status;
+}
+
@@ -0,0 +1,486 @@
+/*
+ * Name:    mx_parallel_open.c
+ *
+ * Purpose: Opens the records of an MX database on several threads.
+ *
+ *          Many MX controllers take a second or more to answer their
+ *          first command, so opening a large database one record at a
+ *          time can take minutes.  Records that do not depend on each
+ *          other through their parent record arrays can safely be
+ *          opened at the same time, so we split the database into
+ *          independent subtrees and hand them out to a pool of worker
+ *          threads.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_clock.h"
+#include "mx_dependency_graph.h"
+#include "mx_thread.h"
+#include "mx_mutex.h"
+
+typedef struct {
+	MX_RECORD *record;
+	long component;
+	mx_status_type mx_status;
+	double open_seconds;
+	double path_seconds;
+	long critical_parent;
+} MX_PARALLEL_OPEN_NODE;
+
+/* The nodes are numbered the same way as the records in the frozen
+ * dependency graph, so the graph's parent arrays and topological order
+ * can be used directly.
+ */
+
+typedef struct {
+	MX_DEPENDENCY_GRAPH *graph;
+
+	long num_nodes;
+	MX_PARALLEL_OPEN_NODE *node_array;
+
+	long num_components;
+	long *component_start_array;
+	long *component_order_array;
+
+	MX_MUTEX *mutex;
+	long next_component;
+	mx_bool_type abort_requested;
+	unsigned long inithw_flags;
+} MX_PARALLEL_OPEN;
+
+static long
+mx_parallel_open_find_component( MX_PARALLEL_OPEN_NODE *node_array, long i )
+{
+	long root, next;
+
+	for ( root = i; node_array[root].component != root;
+				root = node_array[root].component );
+
+	/* Path compression. */
+
+	while ( node_array[i].component != root ) {
+		next = node_array[i].component;
+		node_array[i].component = root;
+		i = next;
+	}
+
+	return root;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Group the records into subtrees that are connected by parent
+ * dependencies.  Within each subtree, the records are kept in the
+ * topological order of the dependency graph.
+ */
+
+static mx_status_type
+mx_parallel_open_find_subtrees( MX_PARALLEL_OPEN *schedule )
+{
+	static const char fname[] = "mx_parallel_open_find_subtrees()";
+
+	MX_PARALLEL_OPEN_NODE *node_array;
+	MX_DEPENDENCY_GRAPH *graph;
+	long *component_number_array, *fill_array, *order_array;
+	long i, k, n, parent, root_i, root_parent, component;
+
+	node_array = schedule->node_array;
+	graph = schedule->graph;
+	order_array = graph->topological_order_array;
+
+	for ( i = 0; i < schedule->num_nodes; i++ ) {
+		for ( k = graph->parent_start_array[i];
+		    k < graph->parent_start_array[i + 1]; k++ )
+		{
+			parent = graph->parent_index_array[k];
+
+			root_i = mx_parallel_open_find_component(
+							node_array, i );
+			root_parent = mx_parallel_open_find_component(
+							node_array, parent );
+
+			if ( root_i != root_parent ) {
+				node_array[root_i].component = root_parent;
+			}
+		}
+	}
+
+	/* Number the subtrees in the order that their first record
+	 * appears in the sorted order.
+	 */
+
+	component_number_array = (long *)
+			malloc( (schedule->num_nodes + 1) * sizeof(long) );
+
+	fill_array = (long *) calloc( schedule->num_nodes + 1, sizeof(long) );
+
+	schedule->component_start_array = (long *)
+			calloc( schedule->num_nodes + 1, sizeof(long) );
+
+	schedule->component_order_array = (long *)
+			malloc( (schedule->num_nodes + 1) * sizeof(long) );
+
+	if ( ( component_number_array == (long *) NULL )
+	  || ( fill_array == (long *) NULL )
+	  || ( schedule->component_start_array == (long *) NULL )
+	  || ( schedule->component_order_array == (long *) NULL ) )
+	{
+		mx_free( component_number_array );
+		mx_free( fill_array );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the subtree arrays "
+		"for %ld records.", schedule->num_nodes );
+	}
+
+	for ( i = 0; i < schedule->num_nodes; i++ ) {
+		component_number_array[i] = -1;
+	}
+
+	schedule->num_components = 0;
+
+	for ( n = 0; n < schedule->num_nodes; n++ ) {
+		i = order_array[n];
+
+		root_i = mx_parallel_open_find_component( node_array, i );
+
+		if ( component_number_array[root_i] < 0 ) {
+			component_number_array[root_i] =
+						schedule->num_components;
+
+			schedule->num_components++;
+		}
+
+		component = component_number_array[root_i];
+
+		schedule->component_start_array[component + 1]++;
+	}
+
+	for ( i = 0; i < schedule->num_components; i++ ) {
+		schedule->component_start_array[i + 1] +=
+				schedule->component_start_array[i];
+	}
+
+	for ( n = 0; n < schedule->num_nodes; n++ ) {
+		i = order_array[n];
+
+		component = component_number_array[
+			mx_parallel_open_find_component( node_array, i ) ];
+
+		schedule->component_order_array[
+			schedule->component_start_array[component]
+				+ fill_array[component] ] = i;
+
+		fill_array[component]++;
+	}
+
+	mx_free( component_number_array );
+	mx_free( fill_array );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_status_type
+mx_parallel_open_worker( MX_THREAD *thread, void *args )
+{
+	MX_PARALLEL_OPEN *schedule;
+	MX_PARALLEL_OPEN_NODE *node;
+	MX_CLOCK_TICK start_tick, finish_tick;
+	long component, n;
+	mx_bool_type abort_requested;
+
+	MXW_UNUSED( thread );
+
+	schedule = (MX_PARALLEL_OPEN *) args;
+
+	for (;;) {
+		(void) mx_mutex_lock( schedule->mutex );
+
+		component = schedule->next_component;
+		schedule->next_component++;
+
+		abort_requested = schedule->abort_requested;
+
+		(void) mx_mutex_unlock( schedule->mutex );
+
+		if ( abort_requested
+		  || ( component >= schedule->num_components ) )
+		{
+			break;
+		}
+
+		for ( n = schedule->component_start_array[component];
+		    n < schedule->component_start_array[component + 1];
+		    n++ )
+		{
+			node = &(schedule->node_array[
+					schedule->component_order_array[n] ]);
+
+			start_tick = mx_current_clock_tick();
+
+			node->mx_status = mx_open_hardware( node->record );
+
+			finish_tick = mx_current_clock_tick();
+
+			node->open_seconds = mx_convert_clock_ticks_to_seconds(
+				mx_subtract_clock_ticks( finish_tick,
+							start_tick ) );
+
+			if ( schedule->inithw_flags & MXF_INITHW_TRACE_OPENS ) {
+				mx_info( "Opened record '%s' in %g seconds.",
+					node->record->name,
+					node->open_seconds );
+			}
+
+			if ( ( node->mx_status.code != MXE_SUCCESS )
+			  && ( schedule->inithw_flags
+					& MXF_INITHW_ABORT_ON_FAULT ) )
+			{
+				(void) mx_mutex_lock( schedule->mutex );
+
+				schedule->abort_requested = TRUE;
+
+				(void) mx_mutex_unlock( schedule->mutex );
+
+				break;
+			}
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static void
+mx_parallel_open_show_critical_path( MX_PARALLEL_OPEN *schedule,
+					double elapsed_seconds )
+{
+	MX_PARALLEL_OPEN_NODE *node_array, *node;
+	MX_DEPENDENCY_GRAPH *graph;
+	long i, k, n, parent, last_node;
+	double max_path_seconds;
+
+	node_array = schedule->node_array;
+	graph = schedule->graph;
+
+	/* Since the records are visited in dependency order, the path
+	 * lengths of all of a record's parents are already known.
+	 */
+
+	last_node = -1;
+	max_path_seconds = -1.0;
+
+	for ( n = 0; n < schedule->num_nodes; n++ ) {
+		i = graph->topological_order_array[n];
+
+		node = &node_array[i];
+
+		node->critical_parent = -1;
+		node->path_seconds = 0.0;
+
+		for ( k = graph->parent_start_array[i];
+		    k < graph->parent_start_array[i + 1]; k++ )
+		{
+			parent = graph->parent_index_array[k];
+
+			if ( node_array[parent].path_seconds
+						> node->path_seconds )
+			{
+				node->path_seconds =
+					node_array[parent].path_seconds;
+
+				node->critical_parent = parent;
+			}
+		}
+
+		node->path_seconds += node->open_seconds;
+
+		if ( node->path_seconds > max_path_seconds ) {
+			max_path_seconds = node->path_seconds;
+			last_node = i;
+		}
+	}
+
+	mx_info( "Opened %ld records in %ld independent subtrees "
+		"in %g seconds.", schedule->num_nodes, schedule->num_components,
+		elapsed_seconds );
+
+	if ( last_node < 0 )
+		return;
+
+	mx_info( "The critical path takes %g seconds and ends with:",
+		max_path_seconds );
+
+	for ( i = last_node; i >= 0; i = node_array[i].critical_parent ) {
+		mx_info( "    '%s' (%g seconds)",
+			node_array[i].record->name,
+			node_array[i].open_seconds );
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+static void
+mx_parallel_open_free( MX_PARALLEL_OPEN *schedule )
+{
+	if ( schedule->mutex != (MX_MUTEX *) NULL ) {
+		(void) mx_mutex_destroy( schedule->mutex );
+	}
+
+	mx_free( schedule->node_array );
+	mx_free( schedule->component_start_array );
+	mx_free( schedule->component_order_array );
+}
+
+MX_EXPORT mx_status_type
+mx_open_hardware_in_parallel( MX_RECORD *record_list,
+				unsigned long inithw_flags,
+				unsigned long num_worker_threads )
+{
+	static const char fname[] = "mx_open_hardware_in_parallel()";
+
+	MX_PARALLEL_OPEN schedule;
+	MX_THREAD **thread_array;
+	MX_CLOCK_TICK start_tick, finish_tick, elapsed_ticks;
+	unsigned long i, num_threads;
+	long n, thread_exit_status;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	memset( &schedule, 0, sizeof(schedule) );
+
+	schedule.inithw_flags = inithw_flags;
+
+	mx_status = mx_get_dependency_graph( record_list, &(schedule.graph) );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	schedule.num_nodes = schedule.graph->num_records;
+
+	schedule.node_array = (MX_PARALLEL_OPEN_NODE *)
+		calloc( schedule.num_nodes + 1, sizeof(MX_PARALLEL_OPEN_NODE) );
+
+	if ( schedule.node_array == (MX_PARALLEL_OPEN_NODE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate the open schedule "
+		"for %ld records.", schedule.num_nodes );
+	}
+
+	for ( n = 0; n < schedule.num_nodes; n++ ) {
+		schedule.node_array[n].record = schedule.graph->record_array[n];
+		schedule.node_array[n].component = n;
+		schedule.node_array[n].mx_status = MX_SUCCESSFUL_RESULT;
+	}
+
+	mx_status = mx_parallel_open_find_subtrees( &schedule );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_mutex_create( &(schedule.mutex) );
+	}
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		mx_parallel_open_free( &schedule );
+		return mx_status;
+	}
+
+	num_threads = num_worker_threads;
+
+	if ( num_threads > (unsigned long) schedule.num_components )
+		num_threads = schedule.num_components;
+
+	start_tick = mx_current_clock_tick();
+
+	if ( num_threads <= 1 ) {
+		(void) mx_parallel_open_worker( NULL, &schedule );
+	} else {
+		thread_array = (MX_THREAD **)
+			calloc( num_threads, sizeof(MX_THREAD *) );
+
+		if ( thread_array == (MX_THREAD **) NULL ) {
+			mx_parallel_open_free( &schedule );
+
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to allocate %lu "
+			"thread pointers.", num_threads );
+		}
+
+		for ( i = 0; i < num_threads; i++ ) {
+			mx_status = mx_thread_create( &thread_array[i],
+					mx_parallel_open_worker, &schedule );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				break;
+		}
+
+		/* If some of the threads could not be created, the
+		 * ones that were will still finish all of the work.
+		 * If none were created, do it all in this thread.
+		 */
+
+		if ( i == 0 ) {
+			(void) mx_parallel_open_worker( NULL, &schedule );
+		}
+
+		num_threads = i;
+
+		for ( i = 0; i < num_threads; i++ ) {
+			(void) mx_thread_wait( thread_array[i],
+					&thread_exit_status, -1.0 );
+
+			(void) mx_thread_free_data_structures(
+					thread_array[i] );
+		}
+
+		mx_free( thread_array );
+	}
+
+	finish_tick = mx_current_clock_tick();
+
+	if ( inithw_flags & MXF_INITHW_TRACE_OPENS ) {
+		elapsed_ticks = mx_subtract_clock_ticks( finish_tick,
+							start_tick );
+
+		mx_parallel_open_show_critical_path( &schedule,
+			mx_convert_clock_ticks_to_seconds( elapsed_ticks ) );
+	}
+
+	/* Report the failure of the first record in the record list
+	 * that failed to open, as a serial open would have done.
+	 */
+
+	mx_status = MX_SUCCESSFUL_RESULT;
+
+	for ( n = 0; n < schedule.num_nodes; n++ ) {
+		if ( schedule.node_array[n].mx_status.code != MXE_SUCCESS ) {
+			mx_status = schedule.node_array[n].mx_status;
+			break;
+		}
+	}
+
+	mx_parallel_open_free( &schedule );
+
+	return mx_status;
+}
+
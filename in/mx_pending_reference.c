@@ -0,0 +1,624 @@
+/*
+ * Name:    mx_pending_reference.c
+ *
+ * Purpose: Table of references to records that have not been created yet.
+ *
+ *          A record description may refer to records that are defined
+ *          further down in the database file.  Such forward references
+ *          used to be handled by making a placeholder record for each
+ *          of them, adding it to the list head's fixup record array,
+ *          and then rescanning every record field of every record in
+ *          mx_fixup_placeholder_records().  For databases with many
+ *          forward references, that rescan dominated the load time.
+ *
+ *          The pending reference table instead remembers, for each
+ *          record name that has not been defined yet, the address of
+ *          every record pointer that refers to it.  When the record is
+ *          finally created, those pointers are patched at once and the
+ *          entry is discarded, so each reference is touched exactly one
+ *          more time after it has been parsed.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_hash_table.h"
+
+#define MX_PENDING_REFERENCE_INITIAL_SIZE	4
+
+/* Each pending record name owns a placeholder record.  Until the real
+ * record is created, every reference to that name points at the
+ * placeholder, so code that runs in the meantime sees a valid record
+ * with the right name and the MXR_PLACEHOLDER superclass.
+ */
+
+typedef struct mx_pending_reference_type {
+	MX_RECORD placeholder_record;
+	MX_RECORD *referencing_record;
+
+	long num_references;
+	long num_allocated_references;
+	MX_RECORD ***reference_array;
+
+	struct mx_pending_reference_type *previous_entry;
+	struct mx_pending_reference_type *next_entry;
+} MX_PENDING_REFERENCE;
+
+typedef struct {
+	MX_HASH_TABLE *name_table;
+
+	/* Entries are kept in the order that they were created in, so
+	 * that unresolved references are reported in database order.
+	 */
+
+	MX_PENDING_REFERENCE *first_entry;
+	MX_PENDING_REFERENCE *last_entry;
+
+	long num_pending_records;
+	long num_pending_references;
+} MX_PENDING_REFERENCE_TABLE;
+
+static mx_status_type
+mx_pending_reference_get_table( MX_RECORD *record,
+				MX_LIST_HEAD **list_head,
+				MX_PENDING_REFERENCE_TABLE **table,
+				const char *calling_fname )
+{
+	static const char fname[] = "mx_pending_reference_get_table()";
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD pointer passed by '%s' was NULL.",
+			calling_fname );
+	}
+
+	*list_head = mx_get_record_list_head_struct( record );
+
+	if ( *list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record '%s' is NULL.",
+			record->name );
+	}
+
+	*table = (MX_PENDING_REFERENCE_TABLE *)
+			(*list_head)->pending_reference_table;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static void
+mx_pending_reference_unlink( MX_PENDING_REFERENCE_TABLE *table,
+				MX_PENDING_REFERENCE *entry )
+{
+	if ( entry->previous_entry == (MX_PENDING_REFERENCE *) NULL ) {
+		table->first_entry = entry->next_entry;
+	} else {
+		entry->previous_entry->next_entry = entry->next_entry;
+	}
+
+	if ( entry->next_entry == (MX_PENDING_REFERENCE *) NULL ) {
+		table->last_entry = entry->previous_entry;
+	} else {
+		entry->next_entry->previous_entry = entry->previous_entry;
+	}
+
+	entry->previous_entry = NULL;
+	entry->next_entry = NULL;
+
+	table->num_pending_records--;
+	table->num_pending_references -= entry->num_references;
+}
+
+static void
+mx_pending_reference_link( MX_PENDING_REFERENCE_TABLE *table,
+				MX_PENDING_REFERENCE *entry )
+{
+	entry->previous_entry = table->last_entry;
+	entry->next_entry = NULL;
+
+	if ( table->last_entry == (MX_PENDING_REFERENCE *) NULL ) {
+		table->first_entry = entry;
+	} else {
+		table->last_entry->next_entry = entry;
+	}
+
+	table->last_entry = entry;
+
+	table->num_pending_records++;
+	table->num_pending_references += entry->num_references;
+}
+
+static void
+mx_pending_reference_free( MX_PENDING_REFERENCE *entry )
+{
+	if ( entry == (MX_PENDING_REFERENCE *) NULL )
+		return;
+
+	mx_free( entry->reference_array );
+
+	free( entry );
+}
+
+static mx_status_type
+mx_pending_reference_append( MX_PENDING_REFERENCE *entry,
+				MX_RECORD **reference )
+{
+	static const char fname[] = "mx_pending_reference_append()";
+
+	MX_RECORD ***new_reference_array;
+	long new_size;
+
+	if ( entry->num_references >= entry->num_allocated_references ) {
+
+		/* Grow geometrically, so that a record that is referred
+		 * to many times costs amortized constant time per
+		 * reference.
+		 */
+
+		if ( entry->num_allocated_references <= 0 ) {
+			new_size = MX_PENDING_REFERENCE_INITIAL_SIZE;
+		} else {
+			new_size = 2 * entry->num_allocated_references;
+		}
+
+		new_reference_array = (MX_RECORD ***)
+			realloc( entry->reference_array,
+				new_size * sizeof(MX_RECORD **) );
+
+		if ( new_reference_array == (MX_RECORD ***) NULL ) {
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to grow the reference array "
+			"for record '%s' to %ld elements.",
+				entry->placeholder_record.name, new_size );
+		}
+
+		entry->reference_array = new_reference_array;
+		entry->num_allocated_references = new_size;
+	}
+
+	entry->reference_array[ entry->num_references ] = reference;
+
+	entry->num_references++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_pending_reference_table( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_create_pending_reference_table()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+	mx_status_type mx_status;
+
+	mx_status = mx_pending_reference_get_table( record_list,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( table != (MX_PENDING_REFERENCE_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	/* Every record name that is looked up here must be found through
+	 * the record name index, since mx_record_name_index_lookup() would
+	 * otherwise walk the whole record list for each reference.
+	 */
+
+	if ( list_head->record_name_index == NULL ) {
+		mx_status = mx_create_record_name_index( record_list );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	table = (MX_PENDING_REFERENCE_TABLE *)
+			calloc( 1, sizeof(MX_PENDING_REFERENCE_TABLE) );
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_PENDING_REFERENCE_TABLE structure." );
+	}
+
+	mx_status = mx_hash_table_create( &(table->name_table), 0 );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		free( table );
+		return mx_status;
+	}
+
+	list_head->pending_reference_table = table;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_pending_reference_table( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_delete_pending_reference_table()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+	MX_PENDING_REFERENCE *entry, *next_entry;
+	long i;
+	mx_status_type mx_status;
+
+	mx_status = mx_pending_reference_get_table( record_list,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	/* Any reference that is still pending would be left pointing
+	 * at freed memory, so set it to NULL instead.
+	 */
+
+	entry = table->first_entry;
+
+	while ( entry != (MX_PENDING_REFERENCE *) NULL ) {
+		next_entry = entry->next_entry;
+
+		for ( i = 0; i < entry->num_references; i++ ) {
+			*(entry->reference_array[i]) = NULL;
+		}
+
+		mx_pending_reference_free( entry );
+
+		entry = next_entry;
+	}
+
+	mx_hash_table_destroy( table->name_table );
+
+	free( table );
+
+	list_head->pending_reference_table = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_add_pending_reference( MX_RECORD *referencing_record,
+			const char *record_name,
+			MX_RECORD **reference )
+{
+	static const char fname[] = "mx_add_pending_reference()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+	MX_PENDING_REFERENCE *entry;
+	MX_RECORD *record;
+	mx_status_type mx_status;
+
+	if ( ( record_name == (const char *) NULL )
+	  || ( reference == (MX_RECORD **) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"A NULL record name or reference pointer was passed." );
+	}
+
+	mx_status = mx_pending_reference_get_table( referencing_record,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	/* Creating the table also creates the record name index. */
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL ) {
+		mx_status = mx_create_pending_reference_table(
+						referencing_record );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		table = (MX_PENDING_REFERENCE_TABLE *)
+				list_head->pending_reference_table;
+	}
+
+	/* If the record already exists, there is nothing to wait for. */
+
+	record = mx_record_name_index_lookup( referencing_record->list_head,
+							record_name );
+
+	if ( record != (MX_RECORD *) NULL ) {
+		*reference = record;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	entry = (MX_PENDING_REFERENCE *)
+			mx_hash_table_lookup( table->name_table, record_name );
+
+	if ( entry == (MX_PENDING_REFERENCE *) NULL ) {
+		entry = (MX_PENDING_REFERENCE *)
+				calloc( 1, sizeof(MX_PENDING_REFERENCE) );
+
+		if ( entry == (MX_PENDING_REFERENCE *) NULL ) {
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to allocate a pending "
+			"reference to record '%s'.", record_name );
+		}
+
+		strlcpy( entry->placeholder_record.name, record_name,
+				sizeof(entry->placeholder_record.name) );
+
+		entry->placeholder_record.mx_superclass = MXR_PLACEHOLDER;
+		entry->placeholder_record.list_head =
+					referencing_record->list_head;
+
+		entry->referencing_record = referencing_record;
+
+		/* The key is the name inside the placeholder record, so
+		 * it lives exactly as long as the entry does.
+		 */
+
+		mx_status = mx_hash_table_insert( table->name_table,
+					entry->placeholder_record.name, entry );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_pending_reference_free( entry );
+			return mx_status;
+		}
+
+		mx_pending_reference_link( table, entry );
+	}
+
+	mx_status = mx_pending_reference_append( entry, reference );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	table->num_pending_references++;
+
+	*reference = &(entry->placeholder_record);
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_resolve_pending_references( MX_RECORD *record )
+{
+	static const char fname[] = "mx_resolve_pending_references()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+	MX_PENDING_REFERENCE *entry;
+	long i;
+	mx_status_type mx_status;
+
+	mx_status = mx_pending_reference_get_table( record,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	entry = (MX_PENDING_REFERENCE *)
+			mx_hash_table_lookup( table->name_table, record->name );
+
+	if ( entry == (MX_PENDING_REFERENCE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	for ( i = 0; i < entry->num_references; i++ ) {
+		*(entry->reference_array[i]) = record;
+	}
+
+	mx_pending_reference_unlink( table, entry );
+
+	mx_status = mx_hash_table_delete( table->name_table,
+					entry->placeholder_record.name, entry );
+
+	mx_pending_reference_free( entry );
+
+	return mx_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* mx_merge_pending_references() moves the pending references of a
+ * scratch record list into the table of 'record_list'.  References to
+ * records that already exist in 'record_list' are resolved on the way.
+ */
+
+MX_EXPORT mx_status_type
+mx_merge_pending_references( MX_RECORD *record_list,
+				MX_RECORD *scratch_record_list )
+{
+	static const char fname[] = "mx_merge_pending_references()";
+
+	MX_LIST_HEAD *list_head, *scratch_list_head;
+	MX_PENDING_REFERENCE_TABLE *table, *scratch_table;
+	MX_PENDING_REFERENCE *entry, *next_entry, *existing_entry;
+	MX_RECORD *record;
+	long i;
+	mx_status_type mx_status;
+
+	mx_status = mx_pending_reference_get_table( scratch_record_list,
+				&scratch_list_head, &scratch_table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( ( scratch_table == (MX_PENDING_REFERENCE_TABLE *) NULL )
+	  || ( scratch_table->first_entry == (MX_PENDING_REFERENCE *) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	mx_status = mx_create_pending_reference_table( record_list );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_status = mx_pending_reference_get_table( record_list,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	entry = scratch_table->first_entry;
+
+	while ( entry != (MX_PENDING_REFERENCE *) NULL ) {
+		next_entry = entry->next_entry;
+
+		mx_pending_reference_unlink( scratch_table, entry );
+
+		mx_status = mx_hash_table_delete( scratch_table->name_table,
+					entry->placeholder_record.name, entry );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_pending_reference_free( entry );
+			return mx_status;
+		}
+
+		record = mx_record_name_index_lookup( record_list,
+					entry->placeholder_record.name );
+
+		existing_entry = (MX_PENDING_REFERENCE *)
+			mx_hash_table_lookup( table->name_table,
+					entry->placeholder_record.name );
+
+		if ( record != (MX_RECORD *) NULL ) {
+			for ( i = 0; i < entry->num_references; i++ ) {
+				*(entry->reference_array[i]) = record;
+			}
+
+			mx_pending_reference_free( entry );
+
+		} else if ( existing_entry != (MX_PENDING_REFERENCE *) NULL ) {
+
+			/* Fold the references into the existing entry. */
+
+			for ( i = 0; i < entry->num_references; i++ ) {
+				*(entry->reference_array[i]) =
+				    &(existing_entry->placeholder_record);
+
+				mx_status = mx_pending_reference_append(
+					existing_entry,
+					entry->reference_array[i] );
+
+				if ( mx_status.code != MXE_SUCCESS ) {
+					mx_pending_reference_free( entry );
+					return mx_status;
+				}
+
+				table->num_pending_references++;
+			}
+
+			mx_pending_reference_free( entry );
+		} else {
+			entry->placeholder_record.list_head =
+						record_list->list_head;
+
+			mx_status = mx_hash_table_insert( table->name_table,
+					entry->placeholder_record.name, entry );
+
+			if ( mx_status.code != MXE_SUCCESS ) {
+				mx_pending_reference_free( entry );
+				return mx_status;
+			}
+
+			mx_pending_reference_link( table, entry );
+		}
+
+		entry = next_entry;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT long
+mx_get_num_pending_references( MX_RECORD *record_list )
+{
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+
+	if ( record_list == (MX_RECORD *) NULL )
+		return 0;
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return 0;
+
+	table = (MX_PENDING_REFERENCE_TABLE *)
+			list_head->pending_reference_table;
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL )
+		return 0;
+
+	return table->num_pending_references;
+}
+
+/* mx_check_pending_references() is called once all of the record
+ * descriptions have been read.  Any reference that is still pending
+ * at that point is to a record that the database never defines.
+ */
+
+MX_EXPORT mx_status_type
+mx_check_pending_references( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_check_pending_references()";
+
+	MX_LIST_HEAD *list_head;
+	MX_PENDING_REFERENCE_TABLE *table;
+	MX_PENDING_REFERENCE *entry;
+	mx_status_type mx_status;
+
+	mx_status = mx_pending_reference_get_table( record_list,
+						&list_head, &table, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( table == (MX_PENDING_REFERENCE_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	entry = table->first_entry;
+
+	if ( entry == (MX_PENDING_REFERENCE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( table->num_pending_records == 1 ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"Record '%s' refers to record '%s', which does not exist "
+		"in the database.",
+			entry->referencing_record->name,
+			entry->placeholder_record.name );
+	}
+
+	return mx_error( MXE_NOT_FOUND, fname,
+	"Record '%s' refers to record '%s', which does not exist "
+	"in the database.  References to %ld other missing records "
+	"were also found.",
+		entry->referencing_record->name,
+		entry->placeholder_record.name,
+		table->num_pending_records - 1 );
+}
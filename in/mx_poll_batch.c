@@ -0,0 +1,614 @@
+/*
+ * Name:    mx_poll_batch.c
+ *
+ * Purpose: Tests many polled record fields for value changes at once.
+ *
+ *          See mx_poll_batch.h for a description of how the fields of
+ *          a batch are tested.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_poll_batch.h"
+
+#define MX_POLL_BATCH_INITIAL_SIZE	64
+
+MX_EXPORT mx_status_type
+mx_poll_batch_create( MX_POLL_BATCH **poll_batch )
+{
+	static const char fname[] = "mx_poll_batch_create()";
+
+	if ( poll_batch == (MX_POLL_BATCH **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_POLL_BATCH pointer passed was NULL." );
+	}
+
+	*poll_batch = (MX_POLL_BATCH *) calloc( 1, sizeof(MX_POLL_BATCH) );
+
+	if ( *poll_batch == (MX_POLL_BATCH *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate an "
+		"MX_POLL_BATCH structure." );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_poll_batch_destroy( MX_POLL_BATCH *poll_batch )
+{
+	long i;
+
+	if ( poll_batch == (MX_POLL_BATCH *) NULL )
+		return;
+
+	mx_free( poll_batch->field_array );
+	mx_free( poll_batch->value_pointer_array );
+	mx_free( poll_batch->datatype_array );
+	mx_free( poll_batch->current_value_array );
+	mx_free( poll_batch->last_value_array );
+	mx_free( poll_batch->threshold_array );
+	mx_free( poll_batch->changed_array );
+	mx_free( poll_batch->changed_field_array );
+
+	if ( poll_batch->snapshot_array != (void **) NULL ) {
+		for ( i = 0; i < poll_batch->allocated_fields; i++ ) {
+			mx_free( poll_batch->snapshot_array[i] );
+		}
+
+		free( poll_batch->snapshot_array );
+	}
+
+	mx_free( poll_batch->snapshot_size_array );
+
+	free( poll_batch );
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_bool_type
+mx_poll_batch_grow_array( void **array_ptr, size_t new_size )
+{
+	void *new_array;
+
+	new_array = realloc( *array_ptr, new_size );
+
+	if ( new_array == NULL )
+		return FALSE;
+
+	*array_ptr = new_array;
+
+	return TRUE;
+}
+
+static mx_status_type
+mx_poll_batch_grow( MX_POLL_BATCH *poll_batch )
+{
+	static const char fname[] = "mx_poll_batch_grow()";
+
+	long i, n;
+	mx_bool_type grown;
+
+	if ( poll_batch->allocated_fields <= 0 ) {
+		n = MX_POLL_BATCH_INITIAL_SIZE;
+	} else {
+		n = 2 * poll_batch->allocated_fields;
+	}
+
+	/* If one of these fails, the arrays that were already grown are
+	 * simply larger than they need to be.
+	 */
+
+	grown = mx_poll_batch_grow_array(
+			(void **) &(poll_batch->field_array),
+			n * sizeof(MX_RECORD_FIELD *) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->value_pointer_array),
+			n * sizeof(void *) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->datatype_array),
+			n * sizeof(long) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->current_value_array),
+			n * sizeof(double) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->last_value_array),
+			n * sizeof(double) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->threshold_array),
+			n * sizeof(double) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->changed_array),
+			n * sizeof(mx_bool_type) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->changed_field_array),
+			n * sizeof(MX_RECORD_FIELD *) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->snapshot_array),
+			n * sizeof(void *) )
+	    && mx_poll_batch_grow_array(
+			(void **) &(poll_batch->snapshot_size_array),
+			n * sizeof(size_t) );
+
+	if ( grown == FALSE ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to grow a poll batch "
+		"to %ld fields.", n );
+	}
+
+	/* The new snapshot slots start out empty. */
+
+	for ( i = poll_batch->allocated_fields; i < n; i++ ) {
+		poll_batch->snapshot_array[i] = NULL;
+		poll_batch->snapshot_size_array[i] = 0;
+	}
+
+	poll_batch->allocated_fields = n;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_poll_batch_add_field( MX_POLL_BATCH *poll_batch, MX_RECORD_FIELD *field )
+{
+	static const char fname[] = "mx_poll_batch_add_field()";
+
+	mx_status_type mx_status;
+
+	if ( ( poll_batch == (MX_POLL_BATCH *) NULL )
+	  || ( field == (MX_RECORD_FIELD *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	if ( poll_batch->num_fields >= poll_batch->allocated_fields ) {
+		mx_status = mx_poll_batch_grow( poll_batch );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	poll_batch->field_array[ poll_batch->num_fields ] = field;
+
+	poll_batch->num_fields++;
+
+	poll_batch->needs_sort = TRUE;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_poll_batch_add_record( MX_POLL_BATCH *poll_batch, MX_RECORD *record )
+{
+	static const char fname[] = "mx_poll_batch_add_record()";
+
+	MX_RECORD_FIELD *field;
+	long i;
+	mx_status_type mx_status;
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD pointer passed was NULL." );
+	}
+
+	if ( record->record_field_array == (MX_RECORD_FIELD *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		field = &(record->record_field_array[i]);
+
+		if ( ( field->descriptor->flags & MXFF_POLL ) == 0 )
+			continue;
+
+		mx_status = mx_poll_batch_add_field( poll_batch, field );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_poll_batch_add_record_list( MX_POLL_BATCH *poll_batch,
+				MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_poll_batch_add_record_list()";
+
+	MX_RECORD *list_head_record, *current_record;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head_record = record_list->list_head;
+
+	for ( current_record = list_head_record->next_record;
+	    current_record != list_head_record;
+	    current_record = current_record->next_record )
+	{
+		mx_status = mx_poll_batch_add_record( poll_batch,
+							current_record );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_bool_type
+mx_poll_batch_uses_threshold( MX_RECORD_FIELD *field )
+{
+	if ( field->descriptor->value_changed_test_function != NULL )
+		return FALSE;
+
+	if ( field->descriptor->num_dimensions != 0 )
+		return FALSE;
+
+	switch( field->descriptor->datatype ) {
+	case MXFT_CHAR:
+	case MXFT_UCHAR:
+	case MXFT_SHORT:
+	case MXFT_USHORT:
+	case MXFT_BOOL:
+	case MXFT_LONG:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+	case MXFT_INT64:
+	case MXFT_UINT64:
+	case MXFT_FLOAT:
+	case MXFT_DOUBLE:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* Moves the threshold tested fields to the front of the batch, keeping
+ * the fields in each group in the order they were added, and caches
+ * their value pointers.
+ *
+ * Since fields are only ever added to the end of the batch, the other
+ * fields that were already in the batch keep their positions relative
+ * to the first of them.  Thus, snapshot_array[i - num_threshold_fields]
+ * still belongs to field_array[i] after a later sort.
+ */
+
+static void
+mx_poll_batch_sort( MX_POLL_BATCH *poll_batch )
+{
+	MX_RECORD_FIELD **field_array, **other_array, *field;
+	long i, num_threshold, num_other;
+
+	field_array = poll_batch->field_array;
+
+	/* changed_field_array is only used as scratch space here. */
+
+	other_array = poll_batch->changed_field_array;
+
+	num_threshold = 0;
+	num_other = 0;
+
+	for ( i = 0; i < poll_batch->num_fields; i++ ) {
+		field = field_array[i];
+
+		if ( mx_poll_batch_uses_threshold( field ) ) {
+			field_array[ num_threshold ] = field;
+			num_threshold++;
+		} else {
+			other_array[ num_other ] = field;
+			num_other++;
+		}
+	}
+
+	for ( i = 0; i < num_other; i++ ) {
+		field_array[ num_threshold + i ] = other_array[i];
+	}
+
+	for ( i = 0; i < num_threshold; i++ ) {
+		field = field_array[i];
+
+		poll_batch->value_pointer_array[i] =
+				mx_get_field_value_pointer( field );
+
+		poll_batch->datatype_array[i] = field->descriptor->datatype;
+	}
+
+	poll_batch->num_threshold_fields = num_threshold;
+	poll_batch->num_changed_fields = 0;
+	poll_batch->needs_sort = FALSE;
+}
+
+static double
+mx_poll_batch_get_value( void *value_ptr, long datatype )
+{
+	switch( datatype ) {
+	case MXFT_CHAR:
+		return (double) *((char *) value_ptr);
+	case MXFT_UCHAR:
+		return (double) *((unsigned char *) value_ptr);
+	case MXFT_SHORT:
+		return (double) *((short *) value_ptr);
+	case MXFT_USHORT:
+		return (double) *((unsigned short *) value_ptr);
+	case MXFT_BOOL:
+		return (double) *((mx_bool_type *) value_ptr);
+	case MXFT_LONG:
+		return (double) *((long *) value_ptr);
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		return (double) *((unsigned long *) value_ptr);
+	case MXFT_INT64:
+		return (double) *((int64_t *) value_ptr);
+	case MXFT_UINT64:
+		return (double) *((uint64_t *) value_ptr);
+	case MXFT_FLOAT:
+		return (double) *((float *) value_ptr);
+	default:
+		return *((double *) value_ptr);
+	}
+}
+
+/* Returns the number of bytes of field data that the default test
+ * compares, or 0 if the data is not stored in one contiguous block.
+ */
+
+static size_t
+mx_poll_batch_get_field_size( MX_RECORD_FIELD *field )
+{
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	size_t num_bytes;
+	long i;
+
+	descriptor = field->descriptor;
+
+	switch( descriptor->datatype ) {
+	case MXFT_STRING:
+	case MXFT_CHAR:
+	case MXFT_UCHAR:
+		num_bytes = sizeof(char);
+		break;
+	case MXFT_SHORT:
+	case MXFT_USHORT:
+		num_bytes = sizeof(short);
+		break;
+	case MXFT_BOOL:
+		num_bytes = sizeof(mx_bool_type);
+		break;
+	case MXFT_LONG:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		num_bytes = sizeof(long);
+		break;
+	case MXFT_INT64:
+	case MXFT_UINT64:
+		num_bytes = sizeof(int64_t);
+		break;
+	case MXFT_FLOAT:
+		num_bytes = sizeof(float);
+		break;
+	case MXFT_DOUBLE:
+		num_bytes = sizeof(double);
+		break;
+	case MXFT_RECORD:
+		num_bytes = sizeof(MX_RECORD *);
+		break;
+	default:
+		return 0;
+	}
+
+	/* Multidimensional varargs arrays are arrays of pointers to
+	 * separately allocated rows.
+	 */
+
+	if ( ( descriptor->num_dimensions > 1 )
+	  && ( descriptor->flags & MXFF_VARARGS ) )
+	{
+		return 0;
+	}
+
+	for ( i = 0; i < descriptor->num_dimensions; i++ ) {
+		if ( field->dimension[i] < 0 )
+			return 0;
+
+		num_bytes *= field->dimension[i];
+	}
+
+	return num_bytes;
+}
+
+/* The default test for fields that cannot use the threshold test and
+ * have no value_changed_test_function.  The field's data is compared
+ * byte for byte with a snapshot taken the last time that the field was
+ * reported as changed.  Like last_value for the threshold test, the
+ * snapshot starts out as all zeros.
+ */
+
+static mx_status_type
+mx_poll_batch_default_test( MX_POLL_BATCH *poll_batch,
+				long snapshot_index,
+				MX_RECORD_FIELD *field,
+				mx_bool_type *value_changed )
+{
+	static const char fname[] = "mx_poll_batch_default_test()";
+
+	void *value_ptr, *snapshot;
+	size_t num_bytes;
+
+	*value_changed = field->value_has_changed_manual_override;
+
+	field->value_has_changed_manual_override = FALSE;
+
+	value_ptr = mx_get_field_value_pointer( field );
+
+	num_bytes = mx_poll_batch_get_field_size( field );
+
+	if ( ( value_ptr == NULL ) || ( num_bytes == 0 ) )
+		return MX_SUCCESSFUL_RESULT;
+
+	snapshot = poll_batch->snapshot_array[ snapshot_index ];
+
+	if ( num_bytes != poll_batch->snapshot_size_array[ snapshot_index ] )
+	{
+		/* A varargs array has changed length. */
+
+		mx_free( poll_batch->snapshot_array[ snapshot_index ] );
+
+		poll_batch->snapshot_size_array[ snapshot_index ] = 0;
+
+		snapshot = calloc( 1, num_bytes );
+
+		if ( snapshot == NULL ) {
+			return mx_error( MXE_OUT_OF_MEMORY, fname,
+			"Ran out of memory trying to allocate a %lu byte "
+			"snapshot of field '%s.%s'.", (unsigned long) num_bytes,
+				field->record->name, field->descriptor->name );
+		}
+
+		poll_batch->snapshot_array[ snapshot_index ] = snapshot;
+		poll_batch->snapshot_size_array[ snapshot_index ] = num_bytes;
+	}
+
+	if ( memcmp( value_ptr, snapshot, num_bytes ) != 0 ) {
+		*value_changed = TRUE;
+	}
+
+	if ( *value_changed ) {
+		memcpy( snapshot, value_ptr, num_bytes );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_poll_batch_test_for_changes( MX_POLL_BATCH *poll_batch,
+				int direction,
+				long *num_changed_fields )
+{
+	static const char fname[] = "mx_poll_batch_test_for_changes()";
+
+	MX_RECORD_FIELD *field;
+	double *current_value_array, *last_value_array, *threshold_array;
+	mx_bool_type *changed_array;
+	mx_bool_type value_changed;
+	long i, n, num_changed;
+	mx_status_type mx_status;
+
+	if ( poll_batch == (MX_POLL_BATCH *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_POLL_BATCH pointer passed was NULL." );
+	}
+
+	if ( poll_batch->needs_sort ) {
+		mx_poll_batch_sort( poll_batch );
+	}
+
+	n = poll_batch->num_threshold_fields;
+
+	current_value_array = poll_batch->current_value_array;
+	last_value_array = poll_batch->last_value_array;
+	threshold_array = poll_batch->threshold_array;
+	changed_array = poll_batch->changed_array;
+
+	/* Gather the values of the threshold tested fields.  The last
+	 * value and the threshold are read from the field every time,
+	 * since other code may change them between polls.
+	 */
+
+	for ( i = 0; i < n; i++ ) {
+		field = poll_batch->field_array[i];
+
+		current_value_array[i] = mx_poll_batch_get_value(
+					poll_batch->value_pointer_array[i],
+					poll_batch->datatype_array[i] );
+
+		last_value_array[i] = field->last_value;
+		threshold_array[i] = field->descriptor->value_change_threshold;
+	}
+
+	/* This loop has no calls and no data dependent branches, so that
+	 * it can be vectorized.
+	 */
+
+	for ( i = 0; i < n; i++ ) {
+		changed_array[i] = ( fabs( current_value_array[i]
+				- last_value_array[i] ) > threshold_array[i] );
+	}
+
+	num_changed = 0;
+
+	for ( i = 0; i < n; i++ ) {
+		field = poll_batch->field_array[i];
+
+		if ( field->value_has_changed_manual_override ) {
+			field->value_has_changed_manual_override = FALSE;
+		} else
+		if ( changed_array[i] == FALSE ) {
+			continue;
+		}
+
+		field->last_value = current_value_array[i];
+
+		poll_batch->changed_field_array[ num_changed ] = field;
+		num_changed++;
+	}
+
+	/* Now the fields that need their own test function or the
+	 * default test.
+	 */
+
+	for ( i = n; i < poll_batch->num_fields; i++ ) {
+		field = poll_batch->field_array[i];
+
+		value_changed = FALSE;
+
+		if ( field->descriptor->value_changed_test_function == NULL )
+		{
+			mx_status = mx_poll_batch_default_test( poll_batch,
+						i - n, field, &value_changed );
+		} else {
+			mx_status =
+			    (*(field->descriptor->value_changed_test_function))(
+					field, direction, &value_changed );
+		}
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			poll_batch->num_changed_fields = num_changed;
+			return mx_status;
+		}
+
+		if ( value_changed ) {
+			poll_batch->changed_field_array[ num_changed ] = field;
+			num_changed++;
+		}
+	}
+
+	poll_batch->num_changed_fields = num_changed;
+
+	if ( num_changed_fields != (long *) NULL ) {
+		*num_changed_fields = num_changed;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,124 @@
+/*
+ * Name:    mx_poll_batch.h
+ *
+ * Purpose: Header file for testing many polled record fields for value
+ *          changes at once.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_POLL_BATCH_H__
+#define __MX_POLL_BATCH_H__
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An MX_POLL_BATCH tests a set of record fields for value changes in
+ * one pass rather than one field at a time.
+ *
+ * Scalar numeric fields that do not have a value_changed_test_function
+ * are handled by the threshold test.  Their current values, last values
+ * and thresholds are gathered into parallel arrays of doubles, so that
+ * the comparison itself is a simple loop over arrays that the compiler
+ * can vectorize.  A field is changed if
+ *
+ *     fabs( current_value - last_value ) > value_change_threshold
+ *
+ * or if its value_has_changed_manual_override flag is set.  The
+ * last_value of a changed field is then updated in both the batch and
+ * the MX_RECORD_FIELD.
+ *
+ * Fields with a custom test function like
+ * mx_motor_vctest_extended_status() are passed to their
+ * value_changed_test_function one at a time.  All other fields, such
+ * as strings and arrays, get the default test, which compares the
+ * field's data byte for byte with a snapshot of the value that was
+ * last reported.  The snapshot starts out as all zeros, and is resized
+ * if the length of a varargs array changes.  Multidimensional varargs
+ * arrays are only reported through the manual override flag.
+ *
+ * The batch keeps pointers to the fields and their values, so it must
+ * be rebuilt if records are added to or deleted from the database.
+ */
+
+typedef struct {
+	long num_fields;
+	long allocated_fields;
+
+	MX_RECORD_FIELD **field_array;
+
+	/* The threshold tested fields come first, followed by the fields
+	 * that need their value_changed_test_function.
+	 */
+
+	long num_threshold_fields;
+	mx_bool_type needs_sort;
+
+	void **value_pointer_array;
+	long *datatype_array;
+
+	double *current_value_array;
+	double *last_value_array;
+	double *threshold_array;
+	mx_bool_type *changed_array;
+
+	/* Snapshots for the default test.  Entry i belongs to the field
+	 * at field_array[ num_threshold_fields + i ].
+	 */
+
+	void **snapshot_array;
+	size_t *snapshot_size_array;
+
+	/* Filled in by mx_poll_batch_test_for_changes(). */
+
+	long num_changed_fields;
+	MX_RECORD_FIELD **changed_field_array;
+} MX_POLL_BATCH;
+
+MX_API mx_status_type mx_poll_batch_create( MX_POLL_BATCH **poll_batch );
+
+MX_API void mx_poll_batch_destroy( MX_POLL_BATCH *poll_batch );
+
+MX_API mx_status_type mx_poll_batch_add_field( MX_POLL_BATCH *poll_batch,
+					MX_RECORD_FIELD *field );
+
+/* Adds all of the MXFF_POLL fields of a record. */
+
+MX_API mx_status_type mx_poll_batch_add_record( MX_POLL_BATCH *poll_batch,
+					MX_RECORD *record );
+
+/* Adds all of the MXFF_POLL fields of all of the records in a database. */
+
+MX_API mx_status_type mx_poll_batch_add_record_list( MX_POLL_BATCH *poll_batch,
+					MX_RECORD *record_list );
+
+/* Tests all of the fields in the batch.  The fields that changed are
+ * left in 'changed_field_array'.  'direction' is passed through to the
+ * value_changed_test_function of each field that has one.
+ */
+
+MX_API mx_status_type mx_poll_batch_test_for_changes(
+					MX_POLL_BATCH *poll_batch,
+					int direction,
+					long *num_changed_fields );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_POLL_BATCH_H__ */
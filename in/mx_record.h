@@ -95,34 +95,37 @@ extern "C" {
 #define MXFF_UPDATE_ALL			0x40000000
 #define MXFF_SHOW_ALL			0x80000000
 
+/* The parts of a record field that are the same for every record of a
+ * given driver, such as its name, datatype, flags and element sizes,
+ * are not stored in the MX_RECORD_FIELD.  Instead, 'descriptor' points
+ * to the field's entry in the driver's record field defaults array,
+ * which is shared by all of the records of that driver.  'dimension'
+ * points to the descriptor's dimension array unless the record needs
+ * dimensions of its own, as varargs fields do.
+ */
+
+struct mx_record_field_defaults_type;
+
 typedef struct mx_record_field_type {
-	long label_value;
-	long field_number;
-	char *name;
-	long datatype;
-	void *typeinfo;
-	long num_dimensions;
 	long *dimension;
 	void *data_pointer;
-	size_t *data_element_size;
-	mx_status_type (*process_function) (void *, void *, int);
-	long flags;
-	long timer_interval;
-
-	double value_change_threshold;
 	double last_value;
 	mx_bool_type value_has_changed_manual_override;
-
-	mx_status_type (*value_changed_test_function)(
-			struct mx_record_field_type *, int, mx_bool_type *);
-
 	void *callback_list;
 	void *application_ptr;
 	struct mx_record_type *record;
 	mx_bool_type active;
+
+	struct mx_record_field_defaults_type *descriptor;
+
+	/* Bytes allocated for a varargs array by mx_resize_1d_field_array().
+	 * This is 0 if the array was allocated some other way.
+	 */
+
+	size_t array_allocated_size;
 } MX_RECORD_FIELD;
 
-typedef struct {
+typedef struct mx_record_field_defaults_type {
 	long label_value;
 	long field_number;
 	char name[MXU_FIELD_NAME_LENGTH+1];
@@ -194,6 +197,8 @@ typedef struct mx_record_type {
 	void *event_queue;		/* Ptr to MXSRV_QUEUED_EVENT */
 
 	void *application_ptr;
+
+	long dependency_graph_index;
 } MX_RECORD;
 
 typedef struct {
@@ -334,6 +339,12 @@ typedef struct {
 
 #define MXF_REC_CAN_LATCH_VALUE		0x100
 
+/* Set by mx_record_allocate() when the record's structures come from
+ * the record list's arena.
+ */
+
+#define MXF_REC_ARENA_ALLOCATED		0x200
+
 /* Definition of bits in the 'record_processing_flags' field of the record. */
 
 #define MXF_PROC_BYPASS_DEFAULT_PROCESSING	0x1
@@ -372,8 +383,69 @@ typedef struct mx_driver_type {
 	long *num_record_fields;
 	MX_RECORD_FIELD_DEFAULTS **record_field_defaults_ptr;
 	struct mx_driver_type *next_driver;
+
+	void *field_name_index;		/* Ptr to MX_FIELD_NAME_INDEX */
+	void *varargs_plan;		/* Ptr to MX_VARARGS_PLAN */
+	void *field_label_index;	/* Ptr to MX_FIELD_LABEL_INDEX */
 } MX_DRIVER;
 
+/* MX_FIELD_NAME_INDEX is a minimal perfect hash of the field names
+ * in a driver's record field defaults array.  It is built once per
+ * driver by mx_initialize_drivers() after the driver's own
+ * initialize_driver function has run.
+ */
+
+typedef struct {
+	long num_fields;
+	long *displacement_array;
+	long *field_index_array;
+	MX_RECORD_FIELD_DEFAULTS *record_field_defaults_array;
+} MX_FIELD_NAME_INDEX;
+
+/* MX_FIELD_LABEL_INDEX maps the label values of a driver's fields to
+ * field indexes.  Label values come in a few clustered ranges, such
+ * as 1001 onwards and 5001 onwards for motors, so each cluster gets a
+ * dense array of field indexes, with -1 for unused label values.  It
+ * is also built by mx_initialize_drivers().
+ */
+
+typedef struct {
+	long first_label_value;
+	long num_label_values;
+	long first_slot;
+} MX_FIELD_LABEL_RANGE;
+
+typedef struct {
+	long num_ranges;
+	MX_FIELD_LABEL_RANGE *range_array;
+	long num_slots;
+	long *field_index_array;
+	MX_RECORD_FIELD_DEFAULTS *record_field_defaults_array;
+} MX_FIELD_LABEL_INDEX;
+
+/* MX_VARARGS_PLAN lists every varargs cookie in a driver's record field
+ * defaults, already decoded, in an order where each field comes after
+ * any varargs field that its cookies refer to.  The steps for each
+ * field are contiguous, starting at field_first_step[field_index].
+ * Like MX_FIELD_NAME_INDEX, it is built once per driver by
+ * mx_initialize_drivers().
+ */
+
+typedef struct {
+	long field_index;
+	long dimension_index;
+	long referenced_field_index;
+	long array_in_field_index;
+} MX_VARARGS_STEP;
+
+typedef struct {
+	long num_fields;
+	long num_steps;
+	MX_VARARGS_STEP *step_array;
+	long *field_first_step;
+	long *field_num_steps;
+} MX_VARARGS_PLAN;
+
 typedef struct {
 	char *description;
 	char *separators;
@@ -476,6 +548,13 @@ typedef struct {
 	double poll_callback_interval;		/* in seconds */
 
 	void *module_list;
+
+	void *record_name_index;	/* Ptr to MX_HASH_TABLE */
+	void *record_arena;		/* Ptr to MX_ARENA */
+	void *pending_reference_table;	/* Ptr to MX_PENDING_REFERENCE_TABLE */
+	void *dependency_graph;		/* Ptr to MX_DEPENDENCY_GRAPH */
+	void *field_array_pool;		/* Ptr to MX_FIELD_ARRAY_POOL */
+	void *motor_completion_notifier;
 } MX_LIST_HEAD;
 
 /* --- Record list handling functions. --- */
@@ -487,11 +566,31 @@ typedef struct {
 #define MXFC_ALLOW_RECORD_REPLACEMENT	0x1
 #define MXFC_ALLOW_SCAN_REPLACEMENT	0x2
 #define MXFC_DELETE_BROKEN_RECORDS	0x4
+#define MXFC_PARALLEL_LOAD		0x8
 
 /* The following are flags for mx_initialize_hardware(). */
 
 #define MXF_INITHW_TRACE_OPENS		0x1
 #define MXF_INITHW_ABORT_ON_FAULT	0x2
+#define MXF_INITHW_PARALLEL_OPEN	0x4
+
+/* mx_open_hardware_in_parallel() opens the records in a database using
+ * a pool of worker threads.  Records that are connected to each other,
+ * directly or indirectly, through their parent record arrays form an
+ * independent subtree, which is opened by a single worker in an order
+ * that puts every parent ahead of its children.  Different subtrees
+ * are opened concurrently.  Thus, two devices that share an interface
+ * are never opened at the same time.
+ *
+ * If MXF_INITHW_TRACE_OPENS is set, the time taken to open each record
+ * is reported, followed by the longest chain of parent dependencies,
+ * which is the shortest time that the open could possibly take.
+ */
+
+MX_API_PRIVATE mx_status_type mx_open_hardware_in_parallel(
+					MX_RECORD *record_list,
+					unsigned long inithw_flags,
+					unsigned long num_worker_threads );
 
 MX_API mx_bool_type mx_verify_driver_type( MX_RECORD *record,
 					long mx_superclass,
@@ -516,6 +615,31 @@ MX_API mx_status_type mx_verify_driver( MX_DRIVER *driver );
 
 MX_API mx_status_type mx_verify_driver_tables( void );
 
+/* The driver registry provides hashed lookups of superclass, class,
+ * and type drivers by name or by numerical type.  Driver tables are
+ * added to it by mx_add_driver_table() and mx_verify_driver_tables().
+ * If a type or name appears more than once, the first driver added
+ * wins, just as it does for a walk of the next_driver chain.
+ */
+
+#define MXF_DRIVER_SUPERCLASS	1
+#define MXF_DRIVER_CLASS	2
+#define MXF_DRIVER_TYPE		3
+
+MX_API_PRIVATE mx_status_type mx_driver_registry_add_table( long driver_level,
+						MX_DRIVER *driver_table );
+
+MX_API_PRIVATE mx_status_type mx_driver_registry_add_list( long driver_level,
+						MX_DRIVER *driver_list );
+
+MX_API_PRIVATE void mx_driver_registry_clear( void );
+
+MX_API MX_DRIVER *mx_driver_registry_lookup_type( long driver_level,
+						long driver_type );
+
+MX_API MX_DRIVER *mx_driver_registry_lookup_name( long driver_level,
+						const char *driver_name );
+
 /*---*/
 
 MX_API long  mx_get_parameter_type_from_name( MX_RECORD *record, char *name );
@@ -534,6 +658,59 @@ MX_API mx_status_type  mx_insert_after_record( MX_RECORD *old_record,
 MX_API MX_RECORD      *mx_get_record( MX_RECORD *record_list,
 						const char *record_name );
 
+/* The record name index is a hash table owned by the MX_LIST_HEAD that
+ * maps record names to MX_RECORD pointers.  Once it has been created,
+ * record insertion and deletion must keep it up to date by calling
+ * mx_record_name_index_add() and mx_record_name_index_delete().
+ * mx_record_name_index_lookup() falls back to walking the record list
+ * if the index has not been created.
+ *
+ * Record names must be unique.  mx_create_record_name_index() fails if
+ * the list contains a duplicate name and mx_record_name_index_add()
+ * refuses to add one, so the index always agrees with mx_get_record().
+ * mx_delete_record_list() must call mx_delete_record_name_index() before
+ * it frees the list head.
+ */
+
+MX_API mx_status_type  mx_create_record_name_index( MX_RECORD *record_list );
+
+MX_API mx_status_type  mx_delete_record_name_index( MX_RECORD *record_list );
+
+MX_API_PRIVATE mx_status_type  mx_record_name_index_add( MX_RECORD *record );
+
+MX_API_PRIVATE mx_status_type  mx_record_name_index_delete(
+							MX_RECORD *record );
+
+MX_API MX_RECORD      *mx_record_name_index_lookup( MX_RECORD *record_list,
+						const char *record_name );
+
+MX_API MX_RECORD      *mx_record_name_index_lookup_n( MX_RECORD *record_list,
+						const char *record_name,
+						size_t record_name_length );
+
+/* If a record list has an arena, mx_record_allocate() takes the memory
+ * for record structures from it and sets MXF_REC_ARENA_ALLOCATED in the
+ * record's 'record_flags'.  Otherwise, it just calls calloc().  Memory
+ * that came from the arena is released all at once when the arena is
+ * deleted, so mx_record_free() uses the flag to decide whether there is
+ * anything to free.  Thus, mx_record_free() must only be given memory
+ * that came from mx_record_allocate() for the same record, and drivers
+ * that use mx_record_allocate() need a delete_record handler that calls
+ * mx_record_free() rather than free().
+ */
+
+MX_API_PRIVATE mx_status_type  mx_create_record_arena( MX_RECORD *record_list,
+						size_t block_size,
+						unsigned long arena_flags );
+
+MX_API_PRIVATE mx_status_type  mx_delete_record_arena(
+						MX_RECORD *record_list );
+
+MX_API void           *mx_record_allocate( MX_RECORD *record,
+						size_t num_bytes );
+
+MX_API void            mx_record_free( MX_RECORD *record, void *ptr );
+
 MX_API mx_status_type  mx_default_delete_record_handler( MX_RECORD *record );
 
 MX_API mx_status_type  mx_delete_record_list( MX_RECORD *record_list );
@@ -597,6 +774,28 @@ MX_API mx_status_type  mx_read_database_from_array( MX_RECORD *record_list,
 						long num_descriptions,
 						char **description_array,
 						unsigned long flags );
+
+/* mx_read_database_from_array_in_parallel() creates the records on
+ * several worker threads, each of which works on a contiguous part of
+ * the description array using a scratch record list of its own.  The
+ * scratch lists are then linked onto the end of 'record_list' in order
+ * and the record references between them are resolved by a single
+ * call to mx_fixup_placeholder_records().  The resulting database is
+ * the same as the one built by mx_read_database_from_array().
+ *
+ * If MXFC_ALLOW_RECORD_REPLACEMENT or MXFC_ALLOW_SCAN_REPLACEMENT are
+ * set, the results would depend on the order in which the records are
+ * created, so the descriptions are read serially instead.
+ */
+
+#define MX_PARALLEL_LOAD_MIN_DESCRIPTIONS_PER_THREAD	64
+
+MX_API mx_status_type  mx_read_database_from_array_in_parallel(
+					MX_RECORD *record_list,
+					long num_descriptions,
+					char **description_array,
+					unsigned long flags,
+					unsigned long num_worker_threads );
 /* --- */
 
 /* These functions return the record list pointer as the function return
@@ -727,6 +926,31 @@ MX_API_PRIVATE mx_status_type mx_copy_defaults_to_record_field(
 			MX_RECORD_FIELD *field,
 			MX_RECORD_FIELD_DEFAULTS *field_defaults );
 
+/* mx_share_defaults_with_record_field() sets up a record field to use
+ * the driver's record field defaults entry as its descriptor, which is
+ * then shared by every record of that driver.  The field's dimension
+ * array also points into the descriptor, except for varargs fields,
+ * which have per-record dimensions and so always get a private array.
+ * Since MX_RECORD_FIELD no longer has copies of the scalar defaults,
+ * mx_copy_defaults_to_record_field() must now do the same thing.
+ *
+ * Code that wants to modify 'dimension' in place must first call
+ * mx_make_record_field_private(), which copies the shared array on
+ * first use.
+ */
+
+MX_API_PRIVATE mx_status_type mx_share_defaults_with_record_field(
+			MX_RECORD_FIELD *field,
+			MX_RECORD_FIELD_DEFAULTS *field_defaults );
+
+MX_API_PRIVATE mx_status_type mx_make_record_field_private(
+			MX_RECORD_FIELD *field );
+
+MX_API_PRIVATE void mx_free_record_field_private_arrays(
+			MX_RECORD_FIELD *field );
+
+MX_API mx_bool_type mx_record_field_is_shared( MX_RECORD_FIELD *field );
+
 MX_API_PRIVATE mx_status_type  mx_parse_record_fields( MX_RECORD *record,
 			MX_RECORD_FIELD_DEFAULTS *record_field_defaults_array,
 			MX_RECORD_FIELD_PARSE_STATUS *parse_status );
@@ -755,6 +979,110 @@ MX_API_PRIVATE mx_status_type mx_get_token_constructor( long field_type,
 
 MX_API_PRIVATE long mx_get_max_string_token_length( MX_RECORD_FIELD *field );
 
+/* mx_get_next_record_token_view() is a version of
+ * mx_get_next_record_token() that does not copy the token.  Instead,
+ * it returns a pointer to the token inside the record description and
+ * its length.  The token is _not_ null terminated.  Quoted tokens are
+ * returned without their quotes.  The view is only valid for as long
+ * as the description string itself.
+ */
+
+typedef struct {
+	const char *ptr;
+	size_t length;
+} MX_RECORD_TOKEN;
+
+typedef mx_status_type ( MX_RECORD_TOKEN_PARSER )( void *dataptr,
+					MX_RECORD_TOKEN *token,
+					MX_RECORD *record,
+					MX_RECORD_FIELD *record_field,
+				MX_RECORD_FIELD_PARSE_STATUS *parse_status );
+
+MX_API_PRIVATE mx_status_type  mx_get_next_record_token_view(
+				MX_RECORD_FIELD_PARSE_STATUS *parse_status,
+				MX_RECORD_TOKEN *token );
+
+MX_API_PRIVATE mx_status_type  mx_get_token_view_parser( long field_type,
+				MX_RECORD_TOKEN_PARSER **token_parser );
+
+/* mx_parse_numeric_row() converts the 'num_elements' numbers of the
+ * innermost dimension of a numeric array field in a single pass over
+ * the record description, without calling a token parser for each
+ * element.  mx_parse_array_description() should use it for every
+ * datatype for which mx_numeric_row_parser_is_available() is TRUE.
+ */
+
+MX_API_PRIVATE mx_bool_type    mx_numeric_row_parser_is_available(
+					long datatype );
+
+MX_API_PRIVATE mx_status_type  mx_parse_numeric_row( void *row_ptr,
+				long datatype,
+				long num_elements,
+				MX_RECORD *record,
+				MX_RECORD_FIELD *record_field,
+				MX_RECORD_FIELD_PARSE_STATUS *parse_status );
+
+/* An MX_DESCRIPTION_BUFFER is a growable, null terminated output buffer
+ * for record descriptions.  Unlike the fixed MXU_RECORD_DESCRIPTION_LENGTH
+ * buffers used by mx_create_description_from_record(), it never
+ * truncates the description of a record with large array fields.
+ * Initialize it with mx_description_buffer_init() and release it with
+ * mx_description_buffer_free().  It may be reused after calling
+ * mx_description_buffer_reset().
+ */
+
+typedef struct {
+	char *data;
+	size_t length;
+	size_t allocated_length;
+} MX_DESCRIPTION_BUFFER;
+
+MX_API void mx_description_buffer_init( MX_DESCRIPTION_BUFFER *buffer );
+
+MX_API void mx_description_buffer_free( MX_DESCRIPTION_BUFFER *buffer );
+
+MX_API void mx_description_buffer_reset( MX_DESCRIPTION_BUFFER *buffer );
+
+MX_API mx_status_type mx_description_buffer_reserve(
+				MX_DESCRIPTION_BUFFER *buffer,
+				size_t num_bytes );
+
+MX_API mx_status_type mx_description_buffer_append(
+				MX_DESCRIPTION_BUFFER *buffer,
+				const char *string, size_t length );
+
+/* Token writers append one token for the value at 'dataptr' to the
+ * buffer.  They are the growable buffer versions of the token
+ * constructors returned by mx_get_token_constructor().
+ */
+
+typedef mx_status_type ( MX_RECORD_TOKEN_WRITER )( void *dataptr,
+					MX_DESCRIPTION_BUFFER *buffer,
+					MX_RECORD *record,
+					MX_RECORD_FIELD *record_field );
+
+MX_API_PRIVATE mx_status_type  mx_get_token_writer( long field_type,
+				MX_RECORD_TOKEN_WRITER **token_writer );
+
+MX_API_PRIVATE mx_status_type  mx_write_array_description( void *array_ptr,
+				long dimension_level,
+				MX_DESCRIPTION_BUFFER *buffer,
+				MX_RECORD *record,
+				MX_RECORD_FIELD *record_field,
+				MX_RECORD_TOKEN_WRITER *token_writer );
+
+MX_API_PRIVATE mx_status_type  mx_write_field_description(
+				MX_RECORD *record,
+				MX_RECORD_FIELD *record_field,
+				MX_DESCRIPTION_BUFFER *buffer );
+
+/* mx_write_record_description() appends the description of the record
+ * that mx_create_description_from_record() would have created.
+ */
+
+MX_API mx_status_type  mx_write_record_description( MX_RECORD *record,
+					MX_DESCRIPTION_BUFFER *buffer );
+
 /* --- */
 
 MX_API_PRIVATE mx_status_type mx_convert_varargs_cookie_to_value(
@@ -771,6 +1099,26 @@ MX_API_PRIVATE mx_status_type mx_replace_varargs_cookies_with_values(
 		MX_RECORD *record, long i,
 		mx_bool_type allow_forward_references );
 
+/* The following functions use the driver's MX_VARARGS_PLAN if there is
+ * one.  mx_resolve_varargs_field() is a drop in replacement for
+ * mx_replace_varargs_cookies_with_values().  mx_resolve_record_varargs()
+ * resolves every varargs field of a record in a single pass, once all
+ * of the fields that the cookies refer to have their values.
+ */
+
+MX_API_PRIVATE mx_status_type mx_create_varargs_plan( MX_DRIVER *driver );
+
+MX_API_PRIVATE mx_status_type mx_create_varargs_plans(
+						MX_DRIVER *driver_list );
+
+MX_API_PRIVATE void mx_delete_varargs_plan( MX_DRIVER *driver );
+
+MX_API_PRIVATE mx_status_type mx_resolve_varargs_field( MX_RECORD *record,
+				long field_index,
+				mx_bool_type allow_forward_references );
+
+MX_API_PRIVATE mx_status_type mx_resolve_record_varargs( MX_RECORD *record );
+
 /* --- */
 
 MX_API_PRIVATE mx_status_type  mx_find_record_field_defaults(
@@ -783,6 +1131,52 @@ MX_API_PRIVATE mx_status_type  mx_find_record_field_defaults_index(
 		const char *name_of_field_to_find,
 		long *index_of_field_that_was_found );
 
+/* The following functions use the driver's MX_FIELD_NAME_INDEX if it
+ * exists and fall back to a linear search of the field defaults if not.
+ */
+
+MX_API_PRIVATE mx_status_type  mx_create_field_name_index( MX_DRIVER *driver );
+
+MX_API_PRIVATE mx_status_type  mx_create_field_name_indexes(
+						MX_DRIVER *driver_list );
+
+MX_API_PRIVATE void            mx_delete_field_name_index( MX_DRIVER *driver );
+
+MX_API_PRIVATE long            mx_get_field_index_by_name( MX_DRIVER *driver,
+						const char *field_name );
+
+MX_API MX_RECORD_FIELD        *mx_lookup_record_field( MX_RECORD *record,
+						const char *field_name );
+
+/* The following functions are table driven versions of
+ * mx_get_field_by_label_value(), mx_get_parameter_name_from_type()
+ * and mx_get_parameter_type_from_name().  They use the driver's
+ * MX_FIELD_LABEL_INDEX and MX_FIELD_NAME_INDEX if they exist and fall
+ * back to a linear search of the fields if not.
+ */
+
+MX_API_PRIVATE mx_status_type  mx_create_field_label_index(
+						MX_DRIVER *driver );
+
+MX_API_PRIVATE mx_status_type  mx_create_field_label_indexes(
+						MX_DRIVER *driver_list );
+
+MX_API_PRIVATE void            mx_delete_field_label_index(
+						MX_DRIVER *driver );
+
+MX_API_PRIVATE long            mx_get_field_index_by_label_value(
+						MX_DRIVER *driver,
+						long label_value );
+
+MX_API MX_RECORD_FIELD *mx_lookup_field_by_label_value( MX_RECORD *record,
+						long label_value );
+
+MX_API const char      *mx_lookup_parameter_name( MX_RECORD *record,
+						long parameter_type );
+
+MX_API long             mx_lookup_parameter_type( MX_RECORD *record,
+						const char *parameter_name );
+
 MX_API long mx_get_datatype_from_datatype_name( const char *datatype_name );
 
 MX_API const char *mx_get_datatype_name_from_datatype( long datatype );
@@ -815,6 +1209,42 @@ MX_API_PRIVATE mx_status_type  mx_construct_placeholder_record(
 MX_API_PRIVATE mx_status_type  mx_fixup_placeholder_records(
 					MX_RECORD *record_list );
 
+/* The pending reference table keeps track of references to records
+ * that have not been created yet.  mx_add_pending_reference() stores
+ * either the record itself or a placeholder record in '*reference'.
+ * mx_resolve_pending_references() must be called after a record has
+ * been added to the record list and to the record name index, and
+ * patches every reference to it that is still pending.
+ *
+ * mx_create_pending_reference_table() creates the record name index if
+ * the list does not have one yet, so that the lookups made while
+ * resolving references never fall back to walking the record list.
+ */
+
+MX_API_PRIVATE mx_status_type  mx_create_pending_reference_table(
+					MX_RECORD *record_list );
+
+MX_API_PRIVATE mx_status_type  mx_delete_pending_reference_table(
+					MX_RECORD *record_list );
+
+MX_API_PRIVATE mx_status_type  mx_add_pending_reference(
+					MX_RECORD *referencing_record,
+					const char *record_name,
+					MX_RECORD **reference );
+
+MX_API_PRIVATE mx_status_type  mx_resolve_pending_references(
+					MX_RECORD *record );
+
+MX_API_PRIVATE mx_status_type  mx_merge_pending_references(
+					MX_RECORD *record_list,
+					MX_RECORD *scratch_record_list );
+
+MX_API_PRIVATE long            mx_get_num_pending_references(
+					MX_RECORD *record_list );
+
+MX_API_PRIVATE mx_status_type  mx_check_pending_references(
+					MX_RECORD *record_list );
+
 /* --- */
 
 MX_API mx_status_type  mx_get_datatype_sizeof_array( long datatype,
@@ -866,6 +1296,28 @@ MX_API_PRIVATE mx_status_type  mx_traverse_field_array(
 					void *array_ptr,
 					long dimension_level );
 
+/* MX_TRAVERSE_SPAN_HANDLER functions are called by
+ * mx_traverse_field_spans() once for each run of 'num_elements' leaf
+ * elements of a field that are contiguous in memory, starting at
+ * 'span_ptr'.  'first_element' is the index of the first element of
+ * the span in the flattened field.  For string fields, each element is
+ * a whole string of 'element_size' characters.
+ */
+
+typedef mx_status_type MX_TRAVERSE_SPAN_HANDLER(
+				MX_RECORD *record,
+				MX_RECORD_FIELD *field,
+				void *handler_data_ptr,
+				void *span_ptr,
+				long first_element,
+				long num_elements,
+				size_t element_size );
+
+MX_API mx_status_type  mx_traverse_field_spans( MX_RECORD *record,
+					MX_RECORD_FIELD *field,
+					MX_TRAVERSE_SPAN_HANDLER *handler_fn,
+					void *handler_data_ptr );
+
 /* --- */
 
 MX_API_PRIVATE mx_status_type  mx_record_array_dependency_handler(
@@ -876,6 +1328,15 @@ MX_API_PRIVATE mx_status_type  mx_record_array_dependency_handler(
 					void *array_ptr,
 					long dimension_level );
 
+MX_API_PRIVATE mx_status_type  mx_record_array_dependency_span_handler(
+					MX_RECORD *record,
+					MX_RECORD_FIELD *record_field,
+					void *dependency_struct_ptr,
+					void *span_ptr,
+					long first_element,
+					long num_elements,
+					size_t element_size );
+
 MX_API_PRIVATE mx_status_type  mx_add_parent_dependency(
 				MX_RECORD *current_record,
 				MX_RECORD_FIELD *current_field,
@@ -0,0 +1,151 @@
+/*
+ * Name:    mx_record_arena.c
+ *
+ * Purpose: Allocation of record structures from the arena owned by
+ *          an MX record list.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_arena.h"
+
+static MX_ARENA *
+mx_record_get_arena( MX_RECORD *record )
+{
+	MX_RECORD *list_head_record;
+	MX_LIST_HEAD *list_head;
+
+	if ( record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head_record = record->list_head;
+
+	if ( list_head_record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	if ( list_head == (MX_LIST_HEAD *) NULL )
+		return NULL;
+
+	return (MX_ARENA *) list_head->record_arena;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_record_arena( MX_RECORD *record_list,
+			size_t block_size,
+			unsigned long arena_flags )
+{
+	static const char fname[] = "mx_create_record_arena()";
+
+	MX_LIST_HEAD *list_head;
+	MX_ARENA *arena;
+	mx_status_type mx_status;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	if ( list_head->record_arena != NULL ) {
+		return mx_error( MXE_ALREADY_EXISTS, fname,
+		"The record list already has an arena." );
+	}
+
+	mx_status = mx_arena_create( &arena, block_size, arena_flags );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	list_head->record_arena = arena;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* mx_delete_record_arena() must only be called after all of the records
+ * in the list have been deleted, since it frees their memory.
+ */
+
+MX_EXPORT mx_status_type
+mx_delete_record_arena( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_delete_record_arena()";
+
+	MX_LIST_HEAD *list_head;
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record list pointer passed was NULL." );
+	}
+
+	list_head = mx_get_record_list_head_struct( record_list );
+
+	if ( list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record list %p is NULL.",
+			record_list );
+	}
+
+	mx_arena_destroy( (MX_ARENA *) list_head->record_arena );
+
+	list_head->record_arena = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT void *
+mx_record_allocate( MX_RECORD *record, size_t num_bytes )
+{
+	MX_ARENA *arena;
+
+	arena = mx_record_get_arena( record );
+
+	if ( arena == (MX_ARENA *) NULL )
+		return calloc( 1, num_bytes );
+
+	record->record_flags |= MXF_REC_ARENA_ALLOCATED;
+
+	return mx_arena_allocate( arena, num_bytes );
+}
+
+MX_EXPORT void
+mx_record_free( MX_RECORD *record, void *ptr )
+{
+	if ( ptr == NULL )
+		return;
+
+	if ( ( record == (MX_RECORD *) NULL )
+	  || ( ( record->record_flags & MXF_REC_ARENA_ALLOCATED ) == 0 ) )
+	{
+		free( ptr );
+		return;
+	}
+
+	mx_arena_free( mx_record_get_arena( record ), ptr );
+}
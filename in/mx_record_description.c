@@ -0,0 +1,793 @@
+/*
+ * Name:    mx_record_description.c
+ *
+ * Purpose: Writes record descriptions into growable buffers.
+ *
+ *          mx_create_description_from_record() and the token
+ *          constructors it uses write into fixed buffers of
+ *          MXU_RECORD_DESCRIPTION_LENGTH characters, so the descriptions
+ *          of records with large array fields were silently truncated
+ *          when a database file was saved.  The functions here append
+ *          to an MX_DESCRIPTION_BUFFER that grows as needed, and write
+ *          numbers with the shortest form that reads back exactly.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_number.h"
+
+#define MX_DESCRIPTION_BUFFER_MINIMUM_LENGTH	256
+
+MX_EXPORT void
+mx_description_buffer_init( MX_DESCRIPTION_BUFFER *buffer )
+{
+	if ( buffer == (MX_DESCRIPTION_BUFFER *) NULL )
+		return;
+
+	buffer->data = NULL;
+	buffer->length = 0;
+	buffer->allocated_length = 0;
+}
+
+MX_EXPORT void
+mx_description_buffer_free( MX_DESCRIPTION_BUFFER *buffer )
+{
+	if ( buffer == (MX_DESCRIPTION_BUFFER *) NULL )
+		return;
+
+	mx_free( buffer->data );
+
+	buffer->length = 0;
+	buffer->allocated_length = 0;
+}
+
+MX_EXPORT void
+mx_description_buffer_reset( MX_DESCRIPTION_BUFFER *buffer )
+{
+	if ( buffer == (MX_DESCRIPTION_BUFFER *) NULL )
+		return;
+
+	buffer->length = 0;
+
+	if ( buffer->data != (char *) NULL ) {
+		buffer->data[0] = '\0';
+	}
+}
+
+/* Makes sure that there is room for at least 'num_bytes' more characters
+ * plus the null terminator.
+ */
+
+MX_EXPORT mx_status_type
+mx_description_buffer_reserve( MX_DESCRIPTION_BUFFER *buffer,
+				size_t num_bytes )
+{
+	static const char fname[] = "mx_description_buffer_reserve()";
+
+	char *new_data;
+	size_t needed_length, new_length;
+
+	if ( buffer == (MX_DESCRIPTION_BUFFER *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_DESCRIPTION_BUFFER pointer passed was NULL." );
+	}
+
+	needed_length = buffer->length + num_bytes + 1;
+
+	if ( needed_length <= buffer->allocated_length )
+		return MX_SUCCESSFUL_RESULT;
+
+	new_length = buffer->allocated_length;
+
+	if ( new_length < MX_DESCRIPTION_BUFFER_MINIMUM_LENGTH ) {
+		new_length = MX_DESCRIPTION_BUFFER_MINIMUM_LENGTH;
+	}
+
+	while ( new_length < needed_length ) {
+		new_length *= 2;
+	}
+
+	new_data = (char *) realloc( buffer->data, new_length );
+
+	if ( new_data == (char *) NULL ) {
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to grow a description buffer "
+		"to %lu bytes.", (unsigned long) new_length );
+	}
+
+	if ( buffer->data == (char *) NULL ) {
+		new_data[0] = '\0';
+	}
+
+	buffer->data = new_data;
+	buffer->allocated_length = new_length;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_description_buffer_append( MX_DESCRIPTION_BUFFER *buffer,
+				const char *string, size_t length )
+{
+	mx_status_type mx_status;
+
+	mx_status = mx_description_buffer_reserve( buffer, length );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	memcpy( buffer->data + buffer->length, string, length );
+
+	buffer->length += length;
+
+	buffer->data[ buffer->length ] = '\0';
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Tokens are separated by a single space. */
+
+static mx_status_type
+mx_description_buffer_start_token( MX_DESCRIPTION_BUFFER *buffer )
+{
+	if ( buffer->length == 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	return mx_description_buffer_append( buffer, " ", 1 );
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Strings that are empty or that contain separators must be quoted for
+ * mx_get_next_record_token() to read them back as a single token.
+ */
+
+static mx_status_type
+mx_write_string_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	const char *string_ptr;
+	size_t length;
+	mx_status_type mx_status;
+
+	MXW_UNUSED( record );
+	MXW_UNUSED( record_field );
+
+	string_ptr = (const char *) dataptr;
+
+	length = strlen( string_ptr );
+
+	if ( ( length > 0 )
+	  && ( strpbrk( string_ptr, MX_RECORD_FIELD_SEPARATORS ) == NULL ) )
+	{
+		return mx_description_buffer_append( buffer,
+						string_ptr, length );
+	}
+
+	mx_status = mx_description_buffer_reserve( buffer, length + 2 );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	buffer->data[ buffer->length ] = '"';
+
+	memcpy( buffer->data + buffer->length + 1, string_ptr, length );
+
+	buffer->data[ buffer->length + length + 1 ] = '"';
+
+	buffer->length += length + 2;
+
+	buffer->data[ buffer->length ] = '\0';
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_write_char_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	char string[2];
+
+	string[0] = *((char *) dataptr);
+	string[1] = '\0';
+
+	return mx_write_string_token( string, buffer, record, record_field );
+}
+
+static mx_status_type
+mx_write_signed_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_write_signed_token()";
+
+	char number[ MXU_NUMBER_FORMAT_LENGTH ];
+	int64_t value;
+	size_t length;
+
+	switch( record_field->descriptor->datatype ) {
+	case MXFT_SHORT:
+		value = *((short *) dataptr);
+		break;
+	case MXFT_BOOL:
+		value = *((mx_bool_type *) dataptr);
+		break;
+	case MXFT_LONG:
+		value = *((long *) dataptr);
+		break;
+	case MXFT_INT64:
+		value = *((int64_t *) dataptr);
+		break;
+	default:
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' of record '%s' has unexpected datatype %ld.",
+			record_field->descriptor->name, record->name,
+			record_field->descriptor->datatype );
+	}
+
+	length = mx_format_int64( number, value );
+
+	return mx_description_buffer_append( buffer, number, length );
+}
+
+static mx_status_type
+mx_write_unsigned_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_write_unsigned_token()";
+
+	char number[ MXU_NUMBER_FORMAT_LENGTH + 2 ];
+	uint64_t value;
+	size_t length;
+
+	switch( record_field->descriptor->datatype ) {
+	case MXFT_UCHAR:
+		value = *((unsigned char *) dataptr);
+		break;
+	case MXFT_USHORT:
+		value = *((unsigned short *) dataptr);
+		break;
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		value = *((unsigned long *) dataptr);
+		break;
+	case MXFT_UINT64:
+		value = *((uint64_t *) dataptr);
+		break;
+	default:
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' of record '%s' has unexpected datatype %ld.",
+			record_field->descriptor->name, record->name,
+			record_field->descriptor->datatype );
+	}
+
+	if ( record_field->descriptor->datatype == MXFT_HEX ) {
+		number[0] = '0';
+		number[1] = 'x';
+
+		length = 2 + mx_format_uint64( number + 2, value, 16 );
+	} else {
+		length = mx_format_uint64( number, value, 10 );
+	}
+
+	return mx_description_buffer_append( buffer, number, length );
+}
+
+static mx_status_type
+mx_write_floating_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	char number[ MXU_NUMBER_FORMAT_LENGTH ];
+	size_t length;
+
+	MXW_UNUSED( record );
+
+	if ( record_field->descriptor->datatype == MXFT_FLOAT ) {
+		length = mx_format_float( number, *((float *) dataptr) );
+	} else {
+		length = mx_format_double( number, *((double *) dataptr) );
+	}
+
+	return mx_description_buffer_append( buffer, number, length );
+}
+
+static mx_status_type
+mx_write_record_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_write_record_token()";
+
+	MX_RECORD *referenced_record;
+
+	referenced_record = *((MX_RECORD **) dataptr);
+
+	if ( referenced_record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field '%s' of record '%s' contains a NULL record pointer.",
+			record_field->descriptor->name, record->name );
+	}
+
+	return mx_description_buffer_append( buffer, referenced_record->name,
+					strlen( referenced_record->name ) );
+}
+
+static mx_status_type
+mx_write_recordtype_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_write_recordtype_token()";
+
+	MX_DRIVER *driver;
+	long driver_level, driver_type;
+
+	driver_type = *((long *) dataptr);
+
+	if ( strcmp( record_field->descriptor->name, "mx_superclass" ) == 0 ) {
+		driver_level = MXF_DRIVER_SUPERCLASS;
+	} else
+	if ( strcmp( record_field->descriptor->name, "mx_class" ) == 0 ) {
+		driver_level = MXF_DRIVER_CLASS;
+	} else {
+		driver_level = MXF_DRIVER_TYPE;
+	}
+
+	driver = mx_driver_registry_lookup_type( driver_level, driver_type );
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"There is no driver with type %ld for field '%s' "
+		"of record '%s'.", driver_type,
+			record_field->descriptor->name, record->name );
+	}
+
+	return mx_description_buffer_append( buffer, driver->name,
+						strlen( driver->name ) );
+}
+
+static mx_status_type
+mx_write_interface_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	MX_INTERFACE *interface;
+	size_t address_length;
+	mx_status_type mx_status;
+
+	interface = (MX_INTERFACE *) dataptr;
+
+	mx_status = mx_write_record_token( &(interface->record),
+					buffer, record, record_field );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	address_length = strlen( interface->address_name );
+
+	if ( address_length == 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	mx_status = mx_description_buffer_append( buffer, ":", 1 );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	return mx_description_buffer_append( buffer,
+				interface->address_name, address_length );
+}
+
+static mx_status_type
+mx_write_record_field_token( void *dataptr,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field )
+{
+	static const char fname[] = "mx_write_record_field_token()";
+
+	MX_RECORD_FIELD *referenced_field;
+	const char *field_name;
+	mx_status_type mx_status;
+
+	referenced_field = *((MX_RECORD_FIELD **) dataptr);
+
+	if ( ( referenced_field == (MX_RECORD_FIELD *) NULL )
+	  || ( referenced_field->record == (MX_RECORD *) NULL ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field '%s' of record '%s' does not point to a valid "
+		"record field.", record_field->descriptor->name, record->name );
+	}
+
+	mx_status = mx_write_record_token( &(referenced_field->record),
+					buffer, record, record_field );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_status = mx_description_buffer_append( buffer, ".", 1 );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	field_name = referenced_field->descriptor->name;
+
+	return mx_description_buffer_append( buffer, field_name,
+						strlen( field_name ) );
+}
+
+MX_EXPORT mx_status_type
+mx_get_token_writer( long field_type,
+			MX_RECORD_TOKEN_WRITER **token_writer )
+{
+	static const char fname[] = "mx_get_token_writer()";
+
+	if ( token_writer == (MX_RECORD_TOKEN_WRITER **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The token_writer pointer passed was NULL." );
+	}
+
+	switch( field_type ) {
+	case MXFT_STRING:
+		*token_writer = mx_write_string_token;
+		break;
+	case MXFT_CHAR:
+		*token_writer = mx_write_char_token;
+		break;
+	case MXFT_SHORT:
+	case MXFT_BOOL:
+	case MXFT_LONG:
+	case MXFT_INT64:
+		*token_writer = mx_write_signed_token;
+		break;
+	case MXFT_UCHAR:
+	case MXFT_USHORT:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+	case MXFT_UINT64:
+		*token_writer = mx_write_unsigned_token;
+		break;
+	case MXFT_FLOAT:
+	case MXFT_DOUBLE:
+		*token_writer = mx_write_floating_token;
+		break;
+	case MXFT_RECORD:
+		*token_writer = mx_write_record_token;
+		break;
+	case MXFT_RECORDTYPE:
+		*token_writer = mx_write_recordtype_token;
+		break;
+	case MXFT_INTERFACE:
+		*token_writer = mx_write_interface_token;
+		break;
+	case MXFT_RECORD_FIELD:
+		*token_writer = mx_write_record_field_token;
+		break;
+	default:
+		*token_writer = NULL;
+
+		return mx_error( MXE_UNSUPPORTED, fname,
+		"Field type %ld is not supported.", field_type );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* The innermost dimension of a numeric array is written in a single
+ * loop that formats each number straight into the buffer, with room
+ * for the whole row reserved up front.
+ */
+
+static mx_bool_type
+mx_numeric_row_writer_is_available( long datatype )
+{
+	switch( datatype ) {
+	case MXFT_SHORT:
+	case MXFT_LONG:
+	case MXFT_INT64:
+	case MXFT_USHORT:
+	case MXFT_ULONG:
+	case MXFT_UINT64:
+	case MXFT_FLOAT:
+	case MXFT_DOUBLE:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+static mx_status_type
+mx_write_numeric_row( char *row_ptr,
+			long num_elements,
+			size_t element_size,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD_FIELD *record_field )
+{
+	char *element_ptr, *output_ptr;
+	long n;
+	mx_status_type mx_status;
+
+	mx_status = mx_description_buffer_reserve( buffer,
+		num_elements * (size_t) ( MXU_NUMBER_FORMAT_LENGTH + 1 ) );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	output_ptr = buffer->data + buffer->length;
+
+	for ( n = 0; n < num_elements; n++ ) {
+		if ( output_ptr != buffer->data ) {
+			*output_ptr++ = ' ';
+		}
+
+		element_ptr = row_ptr + n * element_size;
+
+		switch( record_field->descriptor->datatype ) {
+		case MXFT_SHORT:
+			output_ptr += mx_format_int64( output_ptr,
+						*((short *) element_ptr) );
+			break;
+		case MXFT_LONG:
+			output_ptr += mx_format_int64( output_ptr,
+						*((long *) element_ptr) );
+			break;
+		case MXFT_INT64:
+			output_ptr += mx_format_int64( output_ptr,
+						*((int64_t *) element_ptr) );
+			break;
+		case MXFT_USHORT:
+			output_ptr += mx_format_uint64( output_ptr,
+				*((unsigned short *) element_ptr), 10 );
+			break;
+		case MXFT_ULONG:
+			output_ptr += mx_format_uint64( output_ptr,
+				*((unsigned long *) element_ptr), 10 );
+			break;
+		case MXFT_UINT64:
+			output_ptr += mx_format_uint64( output_ptr,
+				*((uint64_t *) element_ptr), 10 );
+			break;
+		case MXFT_FLOAT:
+			output_ptr += mx_format_float( output_ptr,
+						*((float *) element_ptr) );
+			break;
+		case MXFT_DOUBLE:
+			output_ptr += mx_format_double( output_ptr,
+						*((double *) element_ptr) );
+			break;
+		}
+	}
+
+	buffer->length = output_ptr - buffer->data;
+
+	buffer->data[ buffer->length ] = '\0';
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_write_array_description( void *array_ptr,
+			long dimension_level,
+			MX_DESCRIPTION_BUFFER *buffer,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_TOKEN_WRITER *token_writer )
+{
+	static const char fname[] = "mx_write_array_description()";
+
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	char *element_ptr;
+	long i, num_elements, num_dimensions;
+	size_t element_size;
+	mx_status_type mx_status;
+
+	if ( ( array_ptr == NULL )
+	  || ( buffer == (MX_DESCRIPTION_BUFFER *) NULL )
+	  || ( record == (MX_RECORD *) NULL )
+	  || ( record_field == (MX_RECORD_FIELD *) NULL )
+	  || ( token_writer == (MX_RECORD_TOKEN_WRITER *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	descriptor = record_field->descriptor;
+
+	num_dimensions = descriptor->num_dimensions;
+
+	if ( ( dimension_level < 0 ) || ( dimension_level >= num_dimensions ) )
+	{
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Dimension level %ld for field '%s' of record '%s' is "
+		"outside the allowed range of 0 to %ld.",
+			dimension_level, descriptor->name, record->name,
+			num_dimensions - 1 );
+	}
+
+	/* The innermost dimension of a string field is the string itself. */
+
+	if ( ( descriptor->datatype == MXFT_STRING )
+	  && ( dimension_level == num_dimensions - 1 ) )
+	{
+		mx_status = mx_description_buffer_start_token( buffer );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		return (*token_writer)( array_ptr,
+					buffer, record, record_field );
+	}
+
+	num_elements = record_field->dimension[ dimension_level ];
+
+	element_size = descriptor->data_element_size[
+				num_dimensions - dimension_level - 1 ];
+
+	if ( element_size == 0 ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The element size for dimension %ld of field '%s' in "
+		"record '%s' is 0.", dimension_level,
+			descriptor->name, record->name );
+	}
+
+	if ( ( dimension_level == num_dimensions - 1 )
+	  && ( token_writer == mx_write_signed_token
+	    || token_writer == mx_write_unsigned_token
+	    || token_writer == mx_write_floating_token )
+	  && mx_numeric_row_writer_is_available( descriptor->datatype ) )
+	{
+		return mx_write_numeric_row( (char *) array_ptr,
+			num_elements, element_size, buffer, record_field );
+	}
+
+	for ( i = 0; i < num_elements; i++ ) {
+		element_ptr = (char *) array_ptr + i * element_size;
+
+		if ( dimension_level == num_dimensions - 1 ) {
+			mx_status = mx_description_buffer_start_token( buffer );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+
+			mx_status = (*token_writer)( element_ptr,
+					buffer, record, record_field );
+		} else {
+			/* The rows of varargs arrays are separately
+			 * allocated, while those of fixed size arrays
+			 * follow each other in memory.
+			 */
+
+			if ( descriptor->flags & MXFF_VARARGS ) {
+				element_ptr = *((char **) element_ptr);
+			}
+
+			mx_status = mx_write_array_description( element_ptr,
+					dimension_level + 1, buffer,
+					record, record_field, token_writer );
+		}
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_write_field_description( MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_DESCRIPTION_BUFFER *buffer )
+{
+	static const char fname[] = "mx_write_field_description()";
+
+	MX_RECORD_TOKEN_WRITER *token_writer;
+	void *value_ptr;
+	mx_status_type mx_status;
+
+	if ( ( record == (MX_RECORD *) NULL )
+	  || ( record_field == (MX_RECORD_FIELD *) NULL )
+	  || ( buffer == (MX_DESCRIPTION_BUFFER *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	mx_status = mx_get_token_writer( record_field->descriptor->datatype,
+						&token_writer );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	value_ptr = mx_get_field_value_pointer( record_field );
+
+	if ( value_ptr == NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The value pointer for field '%s' of record '%s' is NULL.",
+			record_field->descriptor->name, record->name );
+	}
+
+	if ( record_field->descriptor->num_dimensions == 0 ) {
+		mx_status = mx_description_buffer_start_token( buffer );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		return (*token_writer)( value_ptr,
+					buffer, record, record_field );
+	}
+
+	return mx_write_array_description( value_ptr, 0, buffer,
+					record, record_field, token_writer );
+}
+
+MX_EXPORT mx_status_type
+mx_write_record_description( MX_RECORD *record,
+			MX_DESCRIPTION_BUFFER *buffer )
+{
+	static const char fname[] = "mx_write_record_description()";
+
+	MX_RECORD_FIELD *record_field;
+	long i;
+	mx_status_type mx_status;
+
+	if ( ( record == (MX_RECORD *) NULL )
+	  || ( buffer == (MX_DESCRIPTION_BUFFER *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	if ( record->record_field_array == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The record_field_array for record '%s' is NULL.",
+			record->name );
+	}
+
+	for ( i = 0; i < record->num_record_fields; i++ ) {
+		record_field = &(record->record_field_array[i]);
+
+		if ( ( record_field->descriptor->flags
+				& MXFF_IN_DESCRIPTION ) == 0 )
+		{
+			continue;
+		}
+
+		mx_status = mx_write_field_description( record,
+						record_field, buffer );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
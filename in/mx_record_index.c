@@ -0,0 +1,336 @@
+/*
+ * Name:    mx_record_index.c
+ *
+ * Purpose: Hash table index of the record names in an MX database.
+ *
+ *          Looking up a record by name used to require walking the
+ *          record list one record at a time.  For large databases
+ *          that are queried by name on every client request, the
+ *          record name index makes the lookup cost independent of
+ *          the number of records in the database.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_hash_table.h"
+
+static mx_status_type
+mx_record_index_get_pointers( MX_RECORD *record,
+			MX_LIST_HEAD **list_head,
+			MX_HASH_TABLE **name_index,
+			const char *calling_fname )
+{
+	static const char fname[] = "mx_record_index_get_pointers()";
+
+	/* The outputs are always set, even if an error is returned. */
+
+	*list_head = NULL;
+
+	if ( name_index != (MX_HASH_TABLE **) NULL ) {
+		*name_index = NULL;
+	}
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD pointer passed by '%s' was NULL.",
+			calling_fname );
+	}
+
+	*list_head = mx_get_record_list_head_struct( record );
+
+	if ( *list_head == (MX_LIST_HEAD *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The MX_LIST_HEAD pointer for record '%s' is NULL.",
+			record->name );
+	}
+
+	if ( name_index != (MX_HASH_TABLE **) NULL ) {
+		*name_index = (MX_HASH_TABLE *)
+				(*list_head)->record_name_index;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_create_record_name_index( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_create_record_name_index()";
+
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	MX_RECORD *list_head_record, *current_record;
+	mx_status_type mx_status;
+
+	mx_status = mx_record_index_get_pointers( record_list,
+						&list_head, NULL, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	/* Throw away any index that already exists and start over. */
+
+	if ( list_head->record_name_index != NULL ) {
+		mx_hash_table_destroy(
+			(MX_HASH_TABLE *) list_head->record_name_index );
+
+		list_head->record_name_index = NULL;
+	}
+
+	mx_status = mx_hash_table_create( &name_index,
+					list_head->num_records + 1 );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	list_head_record = record_list->list_head;
+
+	current_record = list_head_record;
+
+	do {
+		/* Record names must be unique.  If they were not, the
+		 * index could not agree with mx_get_record() once records
+		 * started to be added and deleted.
+		 */
+
+		if ( mx_hash_table_lookup( name_index,
+					current_record->name ) != NULL )
+		{
+			mx_hash_table_destroy( name_index );
+
+			return mx_error( MXE_ALREADY_EXISTS, fname,
+			"The database contains more than one record "
+			"named '%s'.", current_record->name );
+		}
+
+		mx_status = mx_hash_table_insert( name_index,
+				current_record->name, current_record );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			mx_hash_table_destroy( name_index );
+			return mx_status;
+		}
+
+		current_record = current_record->next_record;
+
+	} while ( ( current_record != list_head_record )
+		&& ( current_record != (MX_RECORD *) NULL ) );
+
+	list_head->record_name_index = name_index;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_record_name_index( MX_RECORD *record_list )
+{
+	static const char fname[] = "mx_delete_record_name_index()";
+
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	mx_status_type mx_status;
+
+	mx_status = mx_record_index_get_pointers( record_list,
+					&list_head, &name_index, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	mx_hash_table_destroy( name_index );
+
+	list_head->record_name_index = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_record_name_index_add( MX_RECORD *record )
+{
+	static const char fname[] = "mx_record_name_index_add()";
+
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	MX_RECORD *existing_record;
+	mx_status_type mx_status;
+
+	mx_status = mx_record_index_get_pointers( record,
+					&list_head, &name_index, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( name_index == (MX_HASH_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	/* A second record with the same name is rejected rather than
+	 * replacing the first one, so the index keeps returning the same
+	 * record that mx_get_record() finds.  Record replacement must
+	 * delete the old record before adding the new one.
+	 */
+
+	existing_record = (MX_RECORD *)
+			mx_hash_table_lookup( name_index, record->name );
+
+	if ( existing_record == record )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( existing_record != (MX_RECORD *) NULL ) {
+		return mx_error( MXE_ALREADY_EXISTS, fname,
+		"A record named '%s' already exists in the database.",
+			record->name );
+	}
+
+	mx_status = mx_hash_table_insert( name_index, record->name, record );
+
+	return mx_status;
+}
+
+MX_EXPORT mx_status_type
+mx_record_name_index_delete( MX_RECORD *record )
+{
+	static const char fname[] = "mx_record_name_index_delete()";
+
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	mx_status_type mx_status;
+
+	mx_status = mx_record_index_get_pointers( record,
+					&list_head, &name_index, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( name_index == (MX_HASH_TABLE *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	/* Only remove the entry if it refers to this particular record.
+	 * A record whose mx_record_name_index_add() was rejected as a
+	 * duplicate must not take the name away from the record that
+	 * owns it.
+	 */
+
+	mx_status = mx_hash_table_delete( name_index, record->name, record );
+
+	return mx_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT MX_RECORD *
+mx_record_name_index_lookup( MX_RECORD *record_list, const char *record_name )
+{
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	MX_RECORD *list_head_record, *current_record;
+
+	if ( ( record_list == (MX_RECORD *) NULL )
+	  || ( record_name == (const char *) NULL ) )
+	{
+		return NULL;
+	}
+
+	list_head_record = record_list->list_head;
+
+	if ( list_head_record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	if ( list_head != (MX_LIST_HEAD *) NULL ) {
+		name_index = (MX_HASH_TABLE *) list_head->record_name_index;
+
+		if ( name_index != (MX_HASH_TABLE *) NULL ) {
+			return (MX_RECORD *)
+			    mx_hash_table_lookup( name_index, record_name );
+		}
+	}
+
+	/* There is no index, so we must walk the list. */
+
+	current_record = list_head_record;
+
+	do {
+		if ( strcmp( record_name, current_record->name ) == 0 )
+			return current_record;
+
+		current_record = current_record->next_record;
+
+	} while ( ( current_record != list_head_record )
+		&& ( current_record != (MX_RECORD *) NULL ) );
+
+	return NULL;
+}
+
+/* mx_record_name_index_lookup_n() looks up a record name that is not
+ * null terminated, such as a token in a record description.
+ */
+
+MX_EXPORT MX_RECORD *
+mx_record_name_index_lookup_n( MX_RECORD *record_list,
+				const char *record_name,
+				size_t record_name_length )
+{
+	MX_LIST_HEAD *list_head;
+	MX_HASH_TABLE *name_index;
+	MX_RECORD *list_head_record, *current_record;
+
+	if ( ( record_list == (MX_RECORD *) NULL )
+	  || ( record_name == (const char *) NULL )
+	  || ( record_name_length > MXU_RECORD_NAME_LENGTH ) )
+	{
+		return NULL;
+	}
+
+	list_head_record = record_list->list_head;
+
+	if ( list_head_record == (MX_RECORD *) NULL )
+		return NULL;
+
+	list_head = (MX_LIST_HEAD *)
+			list_head_record->record_superclass_struct;
+
+	if ( list_head != (MX_LIST_HEAD *) NULL ) {
+		name_index = (MX_HASH_TABLE *) list_head->record_name_index;
+
+		if ( name_index != (MX_HASH_TABLE *) NULL ) {
+			return (MX_RECORD *) mx_hash_table_lookup_n(
+				name_index, record_name, record_name_length );
+		}
+	}
+
+	current_record = list_head_record;
+
+	do {
+		if ( ( strncmp( record_name, current_record->name,
+					record_name_length ) == 0 )
+		  && ( current_record->name[record_name_length] == '\0' ) )
+		{
+			return current_record;
+		}
+
+		current_record = current_record->next_record;
+
+	} while ( ( current_record != list_head_record )
+		&& ( current_record != (MX_RECORD *) NULL ) );
+
+	return NULL;
+}
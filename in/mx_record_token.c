@@ -0,0 +1,836 @@
+/*
+ * Name:    mx_record_token.c
+ *
+ * Purpose: Tokenizer for record descriptions that does not copy tokens.
+ *
+ *          mx_get_next_record_token() copies each token into a buffer
+ *          supplied by the caller and tests every character against the
+ *          separator list, which made it the most expensive part of
+ *          reading a database.  The functions here instead return a view
+ *          of each token inside the original description.  The common
+ *          case, where the separators are MX_RECORD_FIELD_SEPARATORS,
+ *          looks for the end of the token eight bytes at a time.
+ *
+ *          The view based token parsers convert a token directly into
+ *          the field value, so that nothing needs to be copied except
+ *          the characters of string fields.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_number.h"
+
+/* Looking at a whole word at a time may read a few bytes past the end
+ * of the description.  The reads are aligned, so they can never cross
+ * into another page, but AddressSanitizer still reports them.
+ */
+
+#if defined(__SANITIZE_ADDRESS__)
+#  define MX_RECORD_TOKEN_WORD_SCAN	FALSE
+#elif defined(__has_feature)
+#  if __has_feature(address_sanitizer)
+#    define MX_RECORD_TOKEN_WORD_SCAN	FALSE
+#  else
+#    define MX_RECORD_TOKEN_WORD_SCAN	TRUE
+#  endif
+#else
+#  define MX_RECORD_TOKEN_WORD_SCAN	TRUE
+#endif
+
+#define MX_TOKEN_ONES		( ~((uint64_t) 0) / 255 )
+#define MX_TOKEN_HIGHS		( MX_TOKEN_ONES << 7 )
+
+/* MX_TOKEN_HAS_ZERO() is nonzero if any byte of 'v' is zero.  Bytes
+ * above the first zero byte may be flagged by mistake, so the exact
+ * position must be found by looking at the bytes one at a time.
+ */
+
+#define MX_TOKEN_HAS_ZERO(v) \
+	( ( (v) - MX_TOKEN_ONES ) & ~(v) & MX_TOKEN_HIGHS )
+
+#define MX_TOKEN_HAS_BYTE(v,c) \
+	MX_TOKEN_HAS_ZERO( (v) ^ ( MX_TOKEN_ONES * (uint64_t) (c) ) )
+
+#define MX_TOKEN_IS_DEFAULT_SEPARATOR(c) \
+	( ( (c) == ' ' ) || ( (c) == '\t' ) || ( (c) == '\n' ) )
+
+static mx_bool_type
+mx_record_token_is_separator( MX_RECORD_FIELD_PARSE_STATUS *parse_status,
+				mx_bool_type default_separators,
+				char c )
+{
+	if ( default_separators ) {
+		return MX_TOKEN_IS_DEFAULT_SEPARATOR( c );
+	}
+
+	if ( c == '\0' )
+		return FALSE;
+
+	if ( memchr( parse_status->separators, c,
+			parse_status->num_separators ) != NULL )
+	{
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Find the first default separator or null byte at or after 'ptr'. */
+
+static const char *
+mx_record_token_find_default_separator( const char *ptr )
+{
+	uint64_t word;
+
+	if ( MX_RECORD_TOKEN_WORD_SCAN ) {
+		while ( ( (uintptr_t) ptr ) & 7 ) {
+			if ( ( *ptr == '\0' )
+			  || MX_TOKEN_IS_DEFAULT_SEPARATOR( *ptr ) )
+			{
+				return ptr;
+			}
+
+			ptr++;
+		}
+
+		for (;;) {
+			memcpy( &word, ptr, sizeof(word) );
+
+			if ( MX_TOKEN_HAS_ZERO( word )
+			  | MX_TOKEN_HAS_BYTE( word, ' ' )
+			  | MX_TOKEN_HAS_BYTE( word, '\t' )
+			  | MX_TOKEN_HAS_BYTE( word, '\n' ) )
+			{
+				break;
+			}
+
+			ptr += sizeof(word);
+		}
+	}
+
+	while ( ( *ptr != '\0' )
+	  && ( ! MX_TOKEN_IS_DEFAULT_SEPARATOR( *ptr ) ) )
+	{
+		ptr++;
+	}
+
+	return ptr;
+}
+
+/* Find the first double quote or null byte at or after 'ptr'. */
+
+static const char *
+mx_record_token_find_quote( const char *ptr )
+{
+	uint64_t word;
+
+	if ( MX_RECORD_TOKEN_WORD_SCAN ) {
+		while ( ( (uintptr_t) ptr ) & 7 ) {
+			if ( ( *ptr == '\0' ) || ( *ptr == '"' ) )
+				return ptr;
+
+			ptr++;
+		}
+
+		for (;;) {
+			memcpy( &word, ptr, sizeof(word) );
+
+			if ( MX_TOKEN_HAS_ZERO( word )
+			  | MX_TOKEN_HAS_BYTE( word, '"' ) )
+			{
+				break;
+			}
+
+			ptr += sizeof(word);
+		}
+	}
+
+	while ( ( *ptr != '\0' ) && ( *ptr != '"' ) ) {
+		ptr++;
+	}
+
+	return ptr;
+}
+
+MX_EXPORT mx_status_type
+mx_get_next_record_token_view( MX_RECORD_FIELD_PARSE_STATUS *parse_status,
+				MX_RECORD_TOKEN *token )
+{
+	static const char fname[] = "mx_get_next_record_token_view()";
+
+	const char *ptr, *start, *end;
+	mx_bool_type default_separators;
+
+	if ( ( parse_status == (MX_RECORD_FIELD_PARSE_STATUS *) NULL )
+	  || ( token == (MX_RECORD_TOKEN *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	if ( parse_status->description == (char *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The record description pointer is NULL." );
+	}
+
+	if ( ( parse_status->separators == (char *) NULL )
+	  || ( strcmp( parse_status->separators,
+			MX_RECORD_FIELD_SEPARATORS ) == 0 ) )
+	{
+		default_separators = TRUE;
+	} else {
+		default_separators = FALSE;
+	}
+
+	ptr = parse_status->description;
+
+	/* Skip over the separators in front of the token.  There is
+	 * usually only one of them, so this is not worth vectorizing.
+	 */
+
+	while ( mx_record_token_is_separator( parse_status,
+					default_separators, *ptr ) )
+	{
+		ptr++;
+	}
+
+	if ( ( *ptr == '\0' )
+	  || ( ( parse_status->start_of_trailing_whitespace != NULL )
+	    && ( ptr >= parse_status->start_of_trailing_whitespace ) ) )
+	{
+		token->ptr = ptr;
+		token->length = 0;
+
+		return mx_error( MXE_UNEXPECTED_END_OF_DATA, fname,
+		"Unexpected end of record description." );
+	}
+
+	if ( *ptr == '"' ) {
+		start = ptr + 1;
+
+		end = mx_record_token_find_quote( start );
+
+		token->ptr = start;
+		token->length = end - start;
+
+		/* An unterminated quote extends to the end of the
+		 * description.
+		 */
+
+		if ( *end == '"' ) {
+			parse_status->description = (char *) ( end + 1 );
+		} else {
+			parse_status->description = (char *) end;
+		}
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	start = ptr;
+
+	if ( default_separators ) {
+		end = mx_record_token_find_default_separator( start );
+	} else {
+		end = start;
+
+		while ( ( *end != '\0' )
+		  && ( ! mx_record_token_is_separator( parse_status,
+						FALSE, *end ) ) )
+		{
+			end++;
+		}
+	}
+
+	if ( ( parse_status->start_of_trailing_whitespace != NULL )
+	  && ( end > parse_status->start_of_trailing_whitespace ) )
+	{
+		end = parse_status->start_of_trailing_whitespace;
+	}
+
+	token->ptr = start;
+	token->length = end - start;
+
+	parse_status->description = (char *) end;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Numbers are converted directly from the token by the functions in
+ * mx_number.c, which return a bare status code.
+ */
+
+static mx_status_type
+mx_record_token_number_error( long status_code,
+				MX_RECORD_TOKEN *token,
+				MX_RECORD *record,
+				MX_RECORD_FIELD *record_field,
+				const char *calling_fname )
+{
+	if ( status_code == MXE_WOULD_EXCEED_LIMIT ) {
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, calling_fname,
+		"The number '%.*s' for field '%s' of record '%s' "
+		"is out of range.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name );
+	}
+
+	return mx_error( MXE_UNPARSEABLE_STRING, calling_fname,
+	"The token '%.*s' for field '%s' of record '%s' "
+	"is not a valid number.",
+		(int) token->length, token->ptr,
+		record_field->descriptor->name, record->name );
+}
+
+static mx_status_type
+mx_parse_string_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	char *string_ptr;
+	size_t max_length, length;
+
+	MXW_UNUSED( record );
+
+	string_ptr = (char *) dataptr;
+
+	max_length = parse_status->max_string_token_length;
+
+	if ( max_length == 0 ) {
+		max_length = (size_t) mx_get_max_string_token_length(
+							record_field );
+	}
+
+	length = token->length;
+
+	if ( ( max_length > 0 ) && ( length >= max_length ) ) {
+		length = max_length - 1;
+	}
+
+	memcpy( string_ptr, token->ptr, length );
+
+	string_ptr[length] = '\0';
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_parse_char_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	MXW_UNUSED( record );
+	MXW_UNUSED( record_field );
+	MXW_UNUSED( parse_status );
+
+	if ( token->length == 0 ) {
+		*((char *) dataptr) = '\0';
+	} else {
+		*((char *) dataptr) = token->ptr[0];
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* All of the signed integer types are converted as int64_t values
+ * and all of the unsigned ones as uint64_t values.  The whole token must
+ * be a number, and the value must fit in the field's datatype, just as
+ * for mx_parse_numeric_row().
+ */
+
+static mx_status_type
+mx_parse_signed_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_signed_token_view()";
+
+	int64_t value;
+	size_t num_chars_used;
+	long status_code;
+
+	MXW_UNUSED( parse_status );
+
+	status_code = mx_parse_int64_n( token->ptr, token->length, 10,
+					&value, &num_chars_used );
+
+	if ( ( status_code == MXE_SUCCESS )
+	  && ( num_chars_used != token->length ) )
+	{
+		status_code = MXE_UNPARSEABLE_STRING;
+	}
+
+	if ( status_code == MXE_SUCCESS ) {
+		switch( record_field->descriptor->datatype ) {
+		case MXFT_SHORT:
+			if ( ( value < SHRT_MIN ) || ( value > SHRT_MAX ) ) {
+				status_code = MXE_WOULD_EXCEED_LIMIT;
+			}
+			break;
+		case MXFT_LONG:
+			if ( ( value < LONG_MIN ) || ( value > LONG_MAX ) ) {
+				status_code = MXE_WOULD_EXCEED_LIMIT;
+			}
+			break;
+		}
+	}
+
+	if ( status_code != MXE_SUCCESS ) {
+		return mx_record_token_number_error( status_code, token,
+						record, record_field, fname );
+	}
+
+	switch( record_field->descriptor->datatype ) {
+	case MXFT_SHORT:
+		*((short *) dataptr) = (short) value;
+		break;
+	case MXFT_BOOL:
+		*((mx_bool_type *) dataptr) = ( value != 0 );
+		break;
+	case MXFT_LONG:
+		*((long *) dataptr) = (long) value;
+		break;
+	case MXFT_INT64:
+		*((int64_t *) dataptr) = value;
+		break;
+	default:
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' of record '%s' has unexpected datatype %ld.",
+			record_field->descriptor->name, record->name,
+			record_field->descriptor->datatype );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_parse_unsigned_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_unsigned_token_view()";
+
+	uint64_t value;
+	size_t num_chars_used;
+	long status_code;
+	int base;
+
+	MXW_UNUSED( parse_status );
+
+	if ( record_field->descriptor->datatype == MXFT_HEX ) {
+		base = 16;
+	} else {
+		base = 10;
+	}
+
+	status_code = mx_parse_uint64_n( token->ptr, token->length, base,
+					&value, &num_chars_used );
+
+	if ( ( status_code == MXE_SUCCESS )
+	  && ( num_chars_used != token->length ) )
+	{
+		status_code = MXE_UNPARSEABLE_STRING;
+	}
+
+	if ( status_code == MXE_SUCCESS ) {
+		switch( record_field->descriptor->datatype ) {
+		case MXFT_UCHAR:
+			if ( value > UCHAR_MAX ) {
+				status_code = MXE_WOULD_EXCEED_LIMIT;
+			}
+			break;
+		case MXFT_USHORT:
+			if ( value > USHRT_MAX ) {
+				status_code = MXE_WOULD_EXCEED_LIMIT;
+			}
+			break;
+		case MXFT_ULONG:
+		case MXFT_HEX:
+			if ( value > ULONG_MAX ) {
+				status_code = MXE_WOULD_EXCEED_LIMIT;
+			}
+			break;
+		}
+	}
+
+	if ( status_code != MXE_SUCCESS ) {
+		return mx_record_token_number_error( status_code, token,
+						record, record_field, fname );
+	}
+
+	switch( record_field->descriptor->datatype ) {
+	case MXFT_UCHAR:
+		*((unsigned char *) dataptr) = (unsigned char) value;
+		break;
+	case MXFT_USHORT:
+		*((unsigned short *) dataptr) = (unsigned short) value;
+		break;
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		*((unsigned long *) dataptr) = (unsigned long) value;
+		break;
+	case MXFT_UINT64:
+		*((uint64_t *) dataptr) = value;
+		break;
+	default:
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' of record '%s' has unexpected datatype %ld.",
+			record_field->descriptor->name, record->name,
+			record_field->descriptor->datatype );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+mx_parse_floating_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_floating_token_view()";
+
+	double value;
+	size_t num_chars_used;
+	long status_code;
+
+	MXW_UNUSED( parse_status );
+
+	status_code = mx_parse_double_n( token->ptr, token->length,
+					&value, &num_chars_used );
+
+	if ( ( status_code == MXE_SUCCESS )
+	  && ( num_chars_used != token->length ) )
+	{
+		status_code = MXE_UNPARSEABLE_STRING;
+	}
+
+	if ( status_code != MXE_SUCCESS ) {
+		return mx_record_token_number_error( status_code, token,
+						record, record_field, fname );
+	}
+
+	if ( record_field->descriptor->datatype == MXFT_FLOAT ) {
+		*((float *) dataptr) = (float) value;
+	} else {
+		*((double *) dataptr) = value;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static mx_status_type
+mx_parse_record_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_record_token_view()";
+
+	MX_RECORD **record_ptr;
+	char record_name[ MXU_RECORD_NAME_LENGTH + 1 ];
+	mx_status_type mx_status;
+
+	MXW_UNUSED( parse_status );
+
+	record_ptr = (MX_RECORD **) dataptr;
+
+	*record_ptr = mx_record_name_index_lookup_n( record->list_head,
+						token->ptr, token->length );
+
+	if ( *record_ptr != (MX_RECORD *) NULL )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( token->length > MXU_RECORD_NAME_LENGTH ) {
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+		"The record name '%.*s' in field '%s' of record '%s' is "
+		"longer than the maximum of %d characters.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name,
+			MXU_RECORD_NAME_LENGTH );
+	}
+
+	/* The record has not been created yet, so the reference must
+	 * wait until it is.  Only here does the name need a copy.
+	 */
+
+	memcpy( record_name, token->ptr, token->length );
+
+	record_name[ token->length ] = '\0';
+
+	mx_status = mx_add_pending_reference( record, record_name,
+						record_ptr );
+
+	return mx_status;
+}
+
+static mx_status_type
+mx_parse_recordtype_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_recordtype_token_view()";
+
+	MX_DRIVER *driver;
+	char driver_name[ MXU_DRIVER_NAME_LENGTH + 1 ];
+	long driver_level;
+
+	MXW_UNUSED( parse_status );
+
+	if ( token->length > MXU_DRIVER_NAME_LENGTH ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"There is no driver named '%.*s'.",
+			(int) token->length, token->ptr );
+	}
+
+	memcpy( driver_name, token->ptr, token->length );
+
+	driver_name[ token->length ] = '\0';
+
+	if ( strcmp( record_field->descriptor->name, "mx_superclass" ) == 0 ) {
+		driver_level = MXF_DRIVER_SUPERCLASS;
+	} else
+	if ( strcmp( record_field->descriptor->name, "mx_class" ) == 0 ) {
+		driver_level = MXF_DRIVER_CLASS;
+	} else {
+		driver_level = MXF_DRIVER_TYPE;
+	}
+
+	driver = mx_driver_registry_lookup_name( driver_level, driver_name );
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"There is no driver named '%s' for field '%s' of record '%s'.",
+			driver_name, record_field->descriptor->name,
+			record->name );
+	}
+
+	switch( driver_level ) {
+	case MXF_DRIVER_SUPERCLASS:
+		*((long *) dataptr) = driver->mx_superclass;
+		break;
+	case MXF_DRIVER_CLASS:
+		*((long *) dataptr) = driver->mx_class;
+		break;
+	default:
+		*((long *) dataptr) = driver->mx_type;
+		break;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Interface tokens have the form 'record_name:address_name'. */
+
+static mx_status_type
+mx_parse_interface_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_interface_token_view()";
+
+	MX_INTERFACE *interface;
+	MX_RECORD_TOKEN record_token;
+	const char *colon_ptr, *address_ptr;
+	size_t address_length;
+	char *endptr;
+	mx_status_type mx_status;
+
+	interface = (MX_INTERFACE *) dataptr;
+
+	colon_ptr = (const char *) memchr( token->ptr, ':', token->length );
+
+	if ( colon_ptr == (const char *) NULL ) {
+		record_token = *token;
+		address_ptr = token->ptr + token->length;
+	} else {
+		record_token.ptr = token->ptr;
+		record_token.length = colon_ptr - token->ptr;
+		address_ptr = colon_ptr + 1;
+	}
+
+	address_length = ( token->ptr + token->length ) - address_ptr;
+
+	if ( address_length > MXU_INTERFACE_ADDRESS_NAME_LENGTH ) {
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+		"The interface address in '%.*s' for field '%s' of "
+		"record '%s' is longer than the maximum of %d characters.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name,
+			MXU_INTERFACE_ADDRESS_NAME_LENGTH );
+	}
+
+	memcpy( interface->address_name, address_ptr, address_length );
+
+	interface->address_name[ address_length ] = '\0';
+
+	interface->address = strtol( interface->address_name, &endptr, 0 );
+
+	if ( ( endptr == interface->address_name ) || ( *endptr != '\0' ) ) {
+		interface->address = 0;
+	}
+
+	mx_status = mx_parse_record_token_view( &(interface->record),
+			&record_token, record, record_field, parse_status );
+
+	return mx_status;
+}
+
+/* Record field tokens have the form 'record_name.field_name'.  The
+ * record must already exist.
+ */
+
+static mx_status_type
+mx_parse_record_field_token_view( void *dataptr,
+			MX_RECORD_TOKEN *token,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *record_field,
+			MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	static const char fname[] = "mx_parse_record_field_token_view()";
+
+	MX_RECORD *target_record;
+	MX_RECORD_FIELD *target_field;
+	const char *dot_ptr, *field_ptr;
+	char field_name[ MXU_FIELD_NAME_LENGTH + 1 ];
+	size_t field_length;
+
+	MXW_UNUSED( parse_status );
+
+	dot_ptr = (const char *) memchr( token->ptr, '.', token->length );
+
+	if ( dot_ptr == (const char *) NULL ) {
+		return mx_error( MXE_UNPARSEABLE_STRING, fname,
+		"The token '%.*s' for field '%s' of record '%s' is not of "
+		"the form 'record.field'.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name );
+	}
+
+	field_ptr = dot_ptr + 1;
+	field_length = ( token->ptr + token->length ) - field_ptr;
+
+	target_record = mx_record_name_index_lookup_n( record->list_head,
+					token->ptr, dot_ptr - token->ptr );
+
+	if ( ( target_record == (MX_RECORD *) NULL )
+	  || ( field_length > MXU_FIELD_NAME_LENGTH ) )
+	{
+		return mx_error( MXE_NOT_FOUND, fname,
+		"Record field '%.*s' used by field '%s' of record '%s' "
+		"does not exist.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name );
+	}
+
+	memcpy( field_name, field_ptr, field_length );
+
+	field_name[ field_length ] = '\0';
+
+	target_field = mx_lookup_record_field( target_record, field_name );
+
+	if ( target_field == (MX_RECORD_FIELD *) NULL ) {
+		return mx_error( MXE_NOT_FOUND, fname,
+		"Record field '%.*s' used by field '%s' of record '%s' "
+		"does not exist.",
+			(int) token->length, token->ptr,
+			record_field->descriptor->name, record->name );
+	}
+
+	*((MX_RECORD_FIELD **) dataptr) = target_field;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+MX_EXPORT mx_status_type
+mx_get_token_view_parser( long field_type,
+			MX_RECORD_TOKEN_PARSER **token_parser )
+{
+	static const char fname[] = "mx_get_token_view_parser()";
+
+	if ( token_parser == (MX_RECORD_TOKEN_PARSER **) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The token_parser pointer passed was NULL." );
+	}
+
+	switch( field_type ) {
+	case MXFT_STRING:
+		*token_parser = mx_parse_string_token_view;
+		break;
+	case MXFT_CHAR:
+		*token_parser = mx_parse_char_token_view;
+		break;
+	case MXFT_SHORT:
+	case MXFT_BOOL:
+	case MXFT_LONG:
+	case MXFT_INT64:
+		*token_parser = mx_parse_signed_token_view;
+		break;
+	case MXFT_UCHAR:
+	case MXFT_USHORT:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+	case MXFT_UINT64:
+		*token_parser = mx_parse_unsigned_token_view;
+		break;
+	case MXFT_FLOAT:
+	case MXFT_DOUBLE:
+		*token_parser = mx_parse_floating_token_view;
+		break;
+	case MXFT_RECORD:
+		*token_parser = mx_parse_record_token_view;
+		break;
+	case MXFT_RECORDTYPE:
+		*token_parser = mx_parse_recordtype_token_view;
+		break;
+	case MXFT_INTERFACE:
+		*token_parser = mx_parse_interface_token_view;
+		break;
+	case MXFT_RECORD_FIELD:
+		*token_parser = mx_parse_record_field_token_view;
+		break;
+	default:
+		*token_parser = NULL;
+
+		return mx_error( MXE_UNSUPPORTED, fname,
+		"Field type %ld is not supported.", field_type );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,59 @@
+/*
+ * Name:    mx_thread.h
+ *
+ * Purpose: Header file for MX thread functions.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2005-2007, 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#ifndef __MX_THREAD_H__
+#define __MX_THREAD_H__
+
+#include "mx_util.h"
+
+/* Make the header file C++ safe. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct mx_thread_type {
+	long thread_exit_status;
+	void *stop_request_handler;
+	void *stop_request_arguments;
+	void *thread_private;
+} MX_THREAD;
+
+typedef mx_status_type (MX_THREAD_FUNCTION)( MX_THREAD *, void * );
+
+MX_API mx_status_type mx_thread_create( MX_THREAD **thread,
+					MX_THREAD_FUNCTION *thread_function,
+					void *thread_arguments );
+
+MX_API void mx_thread_exit( MX_THREAD *thread,
+					long thread_exit_status );
+
+MX_API mx_status_type mx_thread_free_data_structures( MX_THREAD *thread );
+
+/* A negative value for max_seconds_to_wait means wait forever. */
+
+MX_API mx_status_type mx_thread_wait( MX_THREAD *thread,
+					long *thread_exit_status,
+					double max_seconds_to_wait );
+
+MX_API MX_THREAD *mx_get_current_thread_pointer( void );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MX_THREAD_H__ */
+
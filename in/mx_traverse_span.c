@@ -0,0 +1,326 @@
+/*
+ * Name:    mx_traverse_span.c
+ *
+ * Purpose: Traverses the values of a record field a span at a time.
+ *
+ *          mx_traverse_field() recurses once for every dimension of a
+ *          field and calls its handler once for every single element.
+ *          For large multidimensional fields, the cost of the calls
+ *          through the handler pointer dominates the cost of whatever
+ *          the handler actually does.  mx_traverse_field_spans() instead
+ *          walks the field without recursion and hands the handler
+ *          whole runs of elements that are contiguous in memory.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+
+/* A span is handed to the handler only once it can no longer be
+ * extended by the row that follows it.
+ */
+
+typedef struct {
+	char *ptr;
+	long first_element;
+	long num_elements;
+} MX_TRAVERSE_SPAN;
+
+static mx_status_type
+mx_traverse_span_add_row( MX_TRAVERSE_SPAN *span,
+			char *row_ptr,
+			long num_elements,
+			size_t element_size,
+			MX_RECORD *record,
+			MX_RECORD_FIELD *field,
+			MX_TRAVERSE_SPAN_HANDLER *handler_fn,
+			void *handler_data_ptr )
+{
+	mx_status_type mx_status;
+
+	if ( num_elements <= 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	if ( ( span->num_elements > 0 )
+	  && ( row_ptr == span->ptr + span->num_elements * element_size ) )
+	{
+		span->num_elements += num_elements;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	if ( span->num_elements > 0 ) {
+		mx_status = (*handler_fn)( record, field, handler_data_ptr,
+				span->ptr, span->first_element,
+				span->num_elements, element_size );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		span->first_element += span->num_elements;
+	}
+
+	span->ptr = row_ptr;
+	span->num_elements = num_elements;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_traverse_field_spans( MX_RECORD *record,
+			MX_RECORD_FIELD *field,
+			MX_TRAVERSE_SPAN_HANDLER *handler_fn,
+			void *handler_data_ptr )
+{
+	static const char fname[] = "mx_traverse_field_spans()";
+
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	char *level_ptr[ MXU_FIELD_MAX_DIMENSIONS ];
+	long level_index[ MXU_FIELD_MAX_DIMENSIONS ];
+	MX_TRAVERSE_SPAN span;
+	char *value_ptr, *child_ptr;
+	long i, level, last_level, num_leaf_dimensions;
+	long num_elements, row_length;
+	size_t element_size;
+	mx_status_type mx_status;
+
+	if ( ( record == (MX_RECORD *) NULL )
+	  || ( field == (MX_RECORD_FIELD *) NULL )
+	  || ( handler_fn == (MX_TRAVERSE_SPAN_HANDLER *) NULL ) )
+	{
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"One or more of the arguments passed were NULL." );
+	}
+
+	descriptor = field->descriptor;
+
+	if ( ( descriptor->num_dimensions < 0 )
+	  || ( descriptor->num_dimensions > MXU_FIELD_MAX_DIMENSIONS ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field '%s' of record '%s' has an illegal number of "
+		"dimensions (%ld).", descriptor->name, record->name,
+			descriptor->num_dimensions );
+	}
+
+	value_ptr = (char *) mx_get_field_value_pointer( field );
+
+	if ( value_ptr == (char *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The value pointer for field '%s' of record '%s' is NULL.",
+			descriptor->name, record->name );
+	}
+
+	/* The elements handed to the handler are the leaves of the array.
+	 * For string fields, the leaves are whole strings rather than
+	 * the individual characters.
+	 */
+
+	if ( descriptor->num_dimensions == 0 ) {
+		return (*handler_fn)( record, field, handler_data_ptr,
+				value_ptr, 0, 1, descriptor->data_element_size[0] );
+	}
+
+	element_size = descriptor->data_element_size[0];
+
+	if ( element_size == 0 ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"The element size of field '%s' in record '%s' is 0.",
+			descriptor->name, record->name );
+	}
+
+	/* For string fields, the last dimension is the length of each
+	 * string, so there is one less dimension of leaves.
+	 */
+
+	if ( descriptor->datatype == MXFT_STRING ) {
+		element_size *=
+			field->dimension[ descriptor->num_dimensions - 1 ];
+
+		num_leaf_dimensions = descriptor->num_dimensions - 1;
+	} else {
+		num_leaf_dimensions = descriptor->num_dimensions;
+	}
+
+	if ( num_leaf_dimensions == 0 ) {
+		return (*handler_fn)( record, field, handler_data_ptr,
+				value_ptr, 0, 1, element_size );
+	}
+
+	/* The elements of a fixed size array follow each other in memory,
+	 * so the whole array is a single span.
+	 */
+
+	if ( ( descriptor->flags & MXFF_VARARGS ) == 0 ) {
+		num_elements = 1;
+
+		for ( i = 0; i < num_leaf_dimensions; i++ ) {
+			num_elements *= field->dimension[i];
+		}
+
+		if ( num_elements <= 0 )
+			return MX_SUCCESSFUL_RESULT;
+
+		return (*handler_fn)( record, field, handler_data_ptr,
+				value_ptr, 0, num_elements, element_size );
+	}
+
+	/* Varargs arrays are arrays of pointers to the rows below them.
+	 * Walk down to each row of the last dimension with an explicit
+	 * stack, merging rows that happen to be adjacent, as they are
+	 * when the array was allocated by mx_allocate_array().  Each
+	 * string of a string array is a row of its own.
+	 */
+
+	last_level = descriptor->num_dimensions - 1;
+
+	if ( descriptor->datatype == MXFT_STRING ) {
+		row_length = 1;
+	} else {
+		row_length = field->dimension[ last_level ];
+	}
+
+	span.ptr = NULL;
+	span.first_element = 0;
+	span.num_elements = 0;
+
+	level = 0;
+	level_ptr[0] = value_ptr;
+	level_index[0] = 0;
+
+	while ( level >= 0 ) {
+		if ( level == last_level ) {
+			mx_status = mx_traverse_span_add_row( &span,
+					level_ptr[level],
+					row_length, element_size,
+					record, field,
+					handler_fn, handler_data_ptr );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+
+			level--;
+			continue;
+		}
+
+		if ( level_index[level] >= field->dimension[level] ) {
+			level--;
+			continue;
+		}
+
+		child_ptr = ((char **) level_ptr[level])[ level_index[level] ];
+
+		if ( child_ptr == (char *) NULL ) {
+			return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+			"Row %ld at dimension level %ld of field '%s' in "
+			"record '%s' is NULL.", level_index[level], level,
+				descriptor->name, record->name );
+		}
+
+		level_index[level]++;
+
+		level++;
+		level_ptr[level] = child_ptr;
+		level_index[level] = 0;
+	}
+
+	if ( span.num_elements > 0 ) {
+		mx_status = (*handler_fn)( record, field, handler_data_ptr,
+					span.ptr, span.first_element,
+					span.num_elements, element_size );
+
+		return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* The span version of mx_record_array_dependency_handler(). */
+
+MX_EXPORT mx_status_type
+mx_record_array_dependency_span_handler( MX_RECORD *record,
+					MX_RECORD_FIELD *record_field,
+					void *dependency_struct_ptr,
+					void *span_ptr,
+					long first_element,
+					long num_elements,
+					size_t element_size )
+{
+	static const char fname[] = "mx_record_array_dependency_span_handler()";
+
+	MX_RECORD_ARRAY_DEPENDENCY_STRUCT *dependency_struct;
+	MX_RECORD *array_element;
+	char *element_ptr;
+	long i;
+	mx_status_type mx_status;
+
+	/* Dependencies do not depend on where in the field a record
+	 * reference appears.
+	 */
+
+	MXW_UNUSED( first_element );
+
+	if ( dependency_struct_ptr == NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The dependency structure pointer passed was NULL." );
+	}
+
+	dependency_struct =
+		(MX_RECORD_ARRAY_DEPENDENCY_STRUCT *) dependency_struct_ptr;
+
+	if ( ( record_field->descriptor->datatype != MXFT_RECORD )
+	  && ( record_field->descriptor->datatype != MXFT_INTERFACE ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( i = 0; i < num_elements; i++ ) {
+		element_ptr = (char *) span_ptr + i * element_size;
+
+		if ( record_field->descriptor->datatype == MXFT_INTERFACE ) {
+			array_element = ((MX_INTERFACE *) element_ptr)->record;
+		} else {
+			array_element = *((MX_RECORD **) element_ptr);
+		}
+
+		if ( array_element == (MX_RECORD *) NULL )
+			continue;
+
+		if ( dependency_struct->dependency_is_to_parent ) {
+			if ( dependency_struct->add_dependency ) {
+				mx_status = mx_add_parent_dependency( record,
+					record_field, TRUE, array_element );
+			} else {
+				mx_status = mx_delete_parent_dependency( record,
+					record_field, TRUE, array_element );
+			}
+		} else {
+			if ( dependency_struct->add_dependency ) {
+				mx_status = mx_add_child_dependency( record,
+					record_field, TRUE, array_element );
+			} else {
+				mx_status = mx_delete_child_dependency( record,
+					record_field, TRUE, array_element );
+			}
+		}
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,551 @@
+/*
+ * Name:    mx_varargs_plan.c
+ *
+ * Purpose: Precomputed resolution of varargs field dimensions.
+ *
+ *          The dimensions of varargs fields, such as parent_record_array
+ *          or the value arrays of variables, are stored in the driver's
+ *          field defaults as cookies that name another field of the
+ *          same record.  mx_replace_varargs_cookies_with_values()
+ *          decodes and looks up these cookies again for every field of
+ *          every record.  Since the cookies only depend on the driver,
+ *          they are decoded once per driver into an MX_VARARGS_PLAN, so
+ *          that resolving them for a record only has to copy values.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+static void
+mx_free_varargs_plan( MX_VARARGS_PLAN *plan )
+{
+	if ( plan == (MX_VARARGS_PLAN *) NULL )
+		return;
+
+	mx_free( plan->step_array );
+	mx_free( plan->field_first_step );
+	mx_free( plan->field_num_steps );
+
+	free( plan );
+}
+
+static mx_bool_type
+mx_varargs_datatype_is_integer( long datatype )
+{
+	switch( datatype ) {
+	case MXFT_SHORT:
+	case MXFT_USHORT:
+	case MXFT_LONG:
+	case MXFT_ULONG:
+	case MXFT_HEX:
+	case MXFT_INT64:
+	case MXFT_UINT64:
+		return TRUE;
+	default:
+		return FALSE;
+	}
+}
+
+/* Decodes one cookie and checks that the field it refers to can supply
+ * an array length.
+ */
+
+static mx_status_type
+mx_varargs_plan_decode_cookie( MX_DRIVER *driver,
+				MX_RECORD_FIELD_DEFAULTS *defaults_array,
+				long num_fields,
+				long field_index,
+				long dimension_index,
+				MX_VARARGS_STEP *step )
+{
+	static const char fname[] = "mx_varargs_plan_decode_cookie()";
+
+	MX_RECORD_FIELD_DEFAULTS *referenced_defaults;
+	long cookie;
+
+	cookie = defaults_array[field_index].dimension[dimension_index];
+
+	step->field_index = field_index;
+	step->dimension_index = dimension_index;
+	step->referenced_field_index = ( -cookie )
+					/ MXU_VARARGS_COOKIE_MULTIPLIER;
+	step->array_in_field_index = ( -cookie )
+					% MXU_VARARGS_COOKIE_MULTIPLIER;
+
+	if ( ( step->referenced_field_index >= num_fields )
+	  || ( step->referenced_field_index == field_index ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Dimension %ld of field '%s' for driver '%s' has a varargs "
+		"cookie (%ld) that refers to an illegal field index %ld.",
+			dimension_index, defaults_array[field_index].name,
+			driver->name, cookie, step->referenced_field_index );
+	}
+
+	referenced_defaults =
+		&defaults_array[ step->referenced_field_index ];
+
+	if ( ( mx_varargs_datatype_is_integer(
+				referenced_defaults->datatype ) == FALSE )
+	  || ( referenced_defaults->num_dimensions > 1 )
+	  || ( ( referenced_defaults->num_dimensions == 0 )
+	    && ( step->array_in_field_index != 0 ) ) )
+	{
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Dimension %ld of field '%s' for driver '%s' refers to "
+		"field '%s', which is not an integer scalar or "
+		"one dimensional integer array.", dimension_index,
+			defaults_array[field_index].name, driver->name,
+			referenced_defaults->name );
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_create_varargs_plan( MX_DRIVER *driver )
+{
+	static const char fname[] = "mx_create_varargs_plan()";
+
+	MX_VARARGS_PLAN *plan;
+	MX_RECORD_FIELD_DEFAULTS *defaults_array;
+	MX_VARARGS_STEP *unordered_step_array, *step;
+	long *unordered_first_step;
+	mx_bool_type *field_is_placed;
+	long num_fields, num_steps, num_waiting, i, j, k, r, n;
+	mx_bool_type ready;
+	mx_status_type mx_status;
+
+	if ( driver == (MX_DRIVER *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_DRIVER pointer passed was NULL." );
+	}
+
+	mx_delete_varargs_plan( driver );
+
+	if ( ( driver->num_record_fields == (long *) NULL )
+	  || ( driver->record_field_defaults_ptr
+			== (MX_RECORD_FIELD_DEFAULTS **) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	num_fields = *(driver->num_record_fields);
+	defaults_array = *(driver->record_field_defaults_ptr);
+
+	if ( ( num_fields <= 0 )
+	  || ( defaults_array == (MX_RECORD_FIELD_DEFAULTS *) NULL ) )
+	{
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	/* Count the cookies.  Drivers without any do not get a plan. */
+
+	num_steps = 0;
+
+	for ( i = 0; i < num_fields; i++ ) {
+		if ( ( defaults_array[i].flags & MXFF_VARARGS ) == 0 )
+			continue;
+
+		for ( j = 0; j < defaults_array[i].num_dimensions; j++ ) {
+			if ( defaults_array[i].dimension[j] < 0 )
+				num_steps++;
+		}
+	}
+
+	if ( num_steps == 0 )
+		return MX_SUCCESSFUL_RESULT;
+
+	plan = (MX_VARARGS_PLAN *) calloc( 1, sizeof(MX_VARARGS_PLAN) );
+
+	unordered_step_array = (MX_VARARGS_STEP *)
+				malloc( num_steps * sizeof(MX_VARARGS_STEP) );
+
+	unordered_first_step = (long *) calloc( num_fields, sizeof(long) );
+
+	field_is_placed = (mx_bool_type *)
+			calloc( num_fields, sizeof(mx_bool_type) );
+
+	if ( plan != (MX_VARARGS_PLAN *) NULL ) {
+		plan->num_fields = num_fields;
+		plan->num_steps = num_steps;
+
+		plan->step_array = (MX_VARARGS_STEP *)
+				malloc( num_steps * sizeof(MX_VARARGS_STEP) );
+
+		plan->field_first_step = (long *)
+				calloc( num_fields, sizeof(long) );
+
+		plan->field_num_steps = (long *)
+				calloc( num_fields, sizeof(long) );
+	}
+
+	if ( ( plan == (MX_VARARGS_PLAN *) NULL )
+	  || ( plan->step_array == (MX_VARARGS_STEP *) NULL )
+	  || ( plan->field_first_step == (long *) NULL )
+	  || ( plan->field_num_steps == (long *) NULL )
+	  || ( unordered_step_array == (MX_VARARGS_STEP *) NULL )
+	  || ( unordered_first_step == (long *) NULL )
+	  || ( field_is_placed == (mx_bool_type *) NULL ) )
+	{
+		mx_status = mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to create a varargs plan "
+		"for driver '%s' with %ld steps.", driver->name, num_steps );
+
+		goto cleanup;
+	}
+
+	/* Decode the cookies in field order. */
+
+	n = 0;
+
+	for ( i = 0; i < num_fields; i++ ) {
+		unordered_first_step[i] = n;
+
+		if ( ( defaults_array[i].flags & MXFF_VARARGS ) == 0 )
+			continue;
+
+		for ( j = 0; j < defaults_array[i].num_dimensions; j++ ) {
+			if ( defaults_array[i].dimension[j] >= 0 )
+				continue;
+
+			mx_status = mx_varargs_plan_decode_cookie( driver,
+					defaults_array, num_fields, i, j,
+					&unordered_step_array[n] );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				goto cleanup;
+
+			plan->field_num_steps[i]++;
+			n++;
+		}
+	}
+
+	/* Place the fields in dependency order.  A field is ready once
+	 * every field with cookies that it refers to has been placed.
+	 * Among the ready fields, the one that comes first in the record
+	 * is taken first, so the plan follows the record order wherever
+	 * it can.  Drivers have few varargs fields, so a simple quadratic
+	 * search is good enough.
+	 */
+
+	n = 0;
+
+	while ( n < num_steps ) {
+		ready = FALSE;
+
+		for ( i = 0; i < num_fields; i++ ) {
+			if ( field_is_placed[i]
+			  || ( plan->field_num_steps[i] == 0 ) )
+			{
+				continue;
+			}
+
+			num_waiting = 0;
+
+			step = &unordered_step_array[ unordered_first_step[i] ];
+
+			for ( k = 0; k < plan->field_num_steps[i]; k++ ) {
+				r = step[k].referenced_field_index;
+
+				if ( ( plan->field_num_steps[r] > 0 )
+				  && ( field_is_placed[r] == FALSE ) )
+				{
+					num_waiting++;
+				}
+			}
+
+			if ( num_waiting == 0 ) {
+				ready = TRUE;
+				break;
+			}
+		}
+
+		if ( ready == FALSE ) {
+			mx_status = mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+			"The varargs fields of driver '%s' refer to each "
+			"other in a loop.", driver->name );
+
+			goto cleanup;
+		}
+
+		plan->field_first_step[i] = n;
+
+		memcpy( &(plan->step_array[n]),
+			&unordered_step_array[ unordered_first_step[i] ],
+			plan->field_num_steps[i] * sizeof(MX_VARARGS_STEP) );
+
+		n += plan->field_num_steps[i];
+
+		field_is_placed[i] = TRUE;
+	}
+
+	driver->varargs_plan = plan;
+
+	plan = NULL;
+
+	mx_status = MX_SUCCESSFUL_RESULT;
+
+cleanup:
+	mx_free_varargs_plan( plan );
+
+	mx_free( unordered_step_array );
+	mx_free( unordered_first_step );
+	mx_free( field_is_placed );
+
+	return mx_status;
+}
+
+MX_EXPORT mx_status_type
+mx_create_varargs_plans( MX_DRIVER *driver_list )
+{
+	MX_DRIVER *driver;
+	mx_status_type mx_status;
+
+	for ( driver = driver_list;
+		driver != (MX_DRIVER *) NULL;
+		driver = driver->next_driver )
+	{
+		mx_status = mx_create_varargs_plan( driver );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_delete_varargs_plan( MX_DRIVER *driver )
+{
+	if ( driver == (MX_DRIVER *) NULL )
+		return;
+
+	mx_free_varargs_plan( (MX_VARARGS_PLAN *) driver->varargs_plan );
+
+	driver->varargs_plan = NULL;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Returns the plan for the record, or NULL if the record's fields do
+ * not line up with its driver's field defaults.
+ */
+
+static MX_VARARGS_PLAN *
+mx_get_varargs_plan( MX_RECORD *record )
+{
+	MX_DRIVER *driver;
+	MX_VARARGS_PLAN *plan;
+
+	driver = mx_get_driver_for_record( record );
+
+	if ( driver == (MX_DRIVER *) NULL )
+		return NULL;
+
+	plan = (MX_VARARGS_PLAN *) driver->varargs_plan;
+
+	if ( plan == (MX_VARARGS_PLAN *) NULL )
+		return NULL;
+
+	if ( plan->num_fields != record->num_record_fields )
+		return NULL;
+
+	return plan;
+}
+
+static mx_status_type
+mx_execute_varargs_step( MX_RECORD *record,
+			MX_VARARGS_STEP *step )
+{
+	static const char fname[] = "mx_execute_varargs_step()";
+
+	MX_RECORD_FIELD *field, *referenced_field;
+	char *value_ptr;
+	long value, index;
+
+	field = &(record->record_field_array[ step->field_index ]);
+
+	referenced_field =
+		&(record->record_field_array[ step->referenced_field_index ]);
+
+	value_ptr = (char *) mx_get_field_value_pointer( referenced_field );
+
+	if ( value_ptr == (char *) NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, fname,
+		"Field '%s' of record '%s' has not been given a value yet, "
+		"so it cannot supply the length of field '%s'.",
+			referenced_field->descriptor->name, record->name,
+			field->descriptor->name );
+	}
+
+	index = step->array_in_field_index;
+
+	if ( ( referenced_field->descriptor->num_dimensions > 0 )
+	  && ( index >= referenced_field->dimension[0] ) )
+	{
+		return mx_error( MXE_WOULD_EXCEED_LIMIT, fname,
+		"Element %ld of field '%s' in record '%s' is past the end "
+		"of the field, which has %ld elements.", index,
+			referenced_field->descriptor->name, record->name,
+			referenced_field->dimension[0] );
+	}
+
+	switch( referenced_field->descriptor->datatype ) {
+	case MXFT_SHORT:
+		value = ((short *) value_ptr)[index];
+		break;
+	case MXFT_USHORT:
+		value = ((unsigned short *) value_ptr)[index];
+		break;
+	case MXFT_LONG:
+		value = ((long *) value_ptr)[index];
+		break;
+	case MXFT_ULONG:
+	case MXFT_HEX:
+		value = (long) ((unsigned long *) value_ptr)[index];
+		break;
+	case MXFT_INT64:
+		value = (long) ((int64_t *) value_ptr)[index];
+		break;
+	case MXFT_UINT64:
+		value = (long) ((uint64_t *) value_ptr)[index];
+		break;
+	default:
+		return mx_error( MXE_TYPE_MISMATCH, fname,
+		"Field '%s' of record '%s' has datatype %ld, which cannot "
+		"be used as an array length.",
+			referenced_field->descriptor->name, record->name,
+			referenced_field->descriptor->datatype );
+	}
+
+	if ( value < 0 ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Field '%s' of record '%s' specifies a negative length "
+		"(%ld) for field '%s'.", referenced_field->descriptor->name,
+			record->name, value, field->descriptor->name );
+	}
+
+	field->dimension[ step->dimension_index ] = value;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_resolve_varargs_field( MX_RECORD *record,
+			long field_index,
+			mx_bool_type allow_forward_references )
+{
+	static const char fname[] = "mx_resolve_varargs_field()";
+
+	MX_VARARGS_PLAN *plan;
+	MX_VARARGS_STEP *step;
+	MX_RECORD_FIELD *field_array;
+	long i, first_step;
+	mx_status_type mx_status;
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD pointer passed was NULL." );
+	}
+
+	field_array = record->record_field_array;
+
+	plan = mx_get_varargs_plan( record );
+
+	if ( plan == (MX_VARARGS_PLAN *) NULL ) {
+		return mx_replace_varargs_cookies_with_values( record,
+					field_index, allow_forward_references );
+	}
+
+	if ( ( field_index < 0 ) || ( field_index >= plan->num_fields ) ) {
+		return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+		"Field index %ld for record '%s' is outside the allowed "
+		"range of 0 to %ld.", field_index, record->name,
+			plan->num_fields - 1 );
+	}
+
+	first_step = plan->field_first_step[ field_index ];
+
+	for ( i = 0; i < plan->field_num_steps[ field_index ]; i++ ) {
+		step = &(plan->step_array[ first_step + i ]);
+
+		if ( ( allow_forward_references == FALSE )
+		  && ( step->referenced_field_index > field_index ) )
+		{
+			return mx_error( MXE_ILLEGAL_ARGUMENT, fname,
+			"Field '%s' of record '%s' gets its length from "
+			"field '%s', which comes after it.",
+				field_array[field_index].descriptor->name,
+				record->name, field_array[
+				step->referenced_field_index ].descriptor->name );
+		}
+
+		mx_status = mx_execute_varargs_step( record, step );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_resolve_record_varargs( MX_RECORD *record )
+{
+	static const char fname[] = "mx_resolve_record_varargs()";
+
+	MX_VARARGS_PLAN *plan;
+	long i;
+	mx_status_type mx_status;
+
+	if ( record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, fname,
+		"The MX_RECORD pointer passed was NULL." );
+	}
+
+	plan = mx_get_varargs_plan( record );
+
+	if ( plan == (MX_VARARGS_PLAN *) NULL ) {
+		for ( i = 0; i < record->num_record_fields; i++ ) {
+			if ( ( record->record_field_array[i].descriptor->flags
+					& MXFF_VARARGS ) == 0 )
+			{
+				continue;
+			}
+
+			mx_status = mx_replace_varargs_cookies_with_values(
+							record, i, TRUE );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+		}
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( i = 0; i < plan->num_steps; i++ ) {
+		mx_status = mx_execute_varargs_step( record,
+						&(plan->step_array[i]) );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
@@ -0,0 +1,535 @@
+/*
+ * Name:    mx_array_parse_test.c
+ *
+ * Purpose: Checks that mx_parse_numeric_row() converts long rows of every
+ *          numeric field type to exactly the values that were written,
+ *          that it rejects malformed and out of range elements, and
+ *          measures its throughput in MB/s of record description for
+ *          each field type.  For comparison, the same rows are also
+ *          parsed one token at a time through the token parsers from
+ *          mx_get_token_view_parser(), the way mx_parse_array_description()
+ *          handles each element.
+ *
+ *          The timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_record.h"
+
+#define NUM_ELEMENTS	100000
+
+#define MAX_TOKEN_LENGTH	32
+
+typedef struct {
+	long datatype;
+	const char *name;
+	size_t element_size;
+} TEST_TYPE;
+
+static TEST_TYPE test_type_array[] = {
+	{ MXFT_DOUBLE, "double", sizeof(double) },
+	{ MXFT_FLOAT,  "float",  sizeof(float) },
+	{ MXFT_LONG,   "long",   sizeof(long) },
+	{ MXFT_ULONG,  "ulong",  sizeof(unsigned long) },
+	{ MXFT_HEX,    "hex",    sizeof(unsigned long) },
+	{ MXFT_SHORT,  "short",  sizeof(short) },
+	{ MXFT_USHORT, "ushort", sizeof(unsigned short) },
+	{ MXFT_UCHAR,  "uchar",  sizeof(unsigned char) },
+	{ MXFT_BOOL,   "bool",   sizeof(mx_bool_type) },
+	{ MXFT_INT64,  "int64",  sizeof(int64_t) },
+	{ MXFT_UINT64, "uint64", sizeof(uint64_t) },
+};
+
+#define NUM_TEST_TYPES \
+	( sizeof(test_type_array) / sizeof(test_type_array[0]) )
+
+/* mx_record_token.c refers to these functions from libMx, but they are
+ * only used for record, driver and string fields.
+ */
+
+MX_EXPORT mx_status_type
+mx_add_pending_reference( MX_RECORD *referencing_record,
+			const char *record_name,
+			MX_RECORD **reference )
+{
+	MXW_UNUSED( referencing_record );
+	MXW_UNUSED( record_name );
+
+	*reference = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT MX_DRIVER *
+mx_driver_registry_lookup_name( long driver_level, const char *driver_name )
+{
+	MXW_UNUSED( driver_level );
+	MXW_UNUSED( driver_name );
+
+	return NULL;
+}
+
+MX_EXPORT long
+mx_get_max_string_token_length( MX_RECORD_FIELD *field )
+{
+	MXW_UNUSED( field );
+
+	return MXU_STRING_LENGTH;
+}
+
+MX_EXPORT MX_RECORD_FIELD *
+mx_lookup_record_field( MX_RECORD *record, const char *field_name )
+{
+	MXW_UNUSED( record );
+	MXW_UNUSED( field_name );
+
+	return NULL;
+}
+
+MX_EXPORT MX_RECORD *
+mx_record_name_index_lookup_n( MX_RECORD *record_list,
+				const char *record_name,
+				size_t record_name_length )
+{
+	MXW_UNUSED( record_list );
+	MXW_UNUSED( record_name );
+	MXW_UNUSED( record_name_length );
+
+	return NULL;
+}
+
+/*------------------------------------------------------------------------*/
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t
+next_random( void )
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+
+	return random_state;
+}
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+static MX_RECORD record;
+static MX_RECORD_FIELD record_field;
+static MX_RECORD_FIELD_DEFAULTS field_defaults;
+
+static void
+setup_field( long datatype )
+{
+	snprintf( record.name, sizeof(record.name), "test_record" );
+	snprintf( field_defaults.name, sizeof(field_defaults.name), "array" );
+
+	field_defaults.datatype = datatype;
+	field_defaults.num_dimensions = 1;
+
+	record_field.descriptor = &field_defaults;
+	record_field.record = &record;
+}
+
+static void
+setup_parse_status( MX_RECORD_FIELD_PARSE_STATUS *parse_status,
+			char *description )
+{
+	memset( parse_status, 0, sizeof(MX_RECORD_FIELD_PARSE_STATUS) );
+
+	parse_status->description = description;
+	parse_status->separators = MX_RECORD_FIELD_SEPARATORS;
+	parse_status->num_separators =
+			(int) strlen( MX_RECORD_FIELD_SEPARATORS );
+	parse_status->max_string_token_length = MXU_STRING_LENGTH;
+}
+
+/* Writes a random value of the given type as text and stores the value
+ * itself in 'element'.  Doubles and floats are written with enough
+ * digits that they must read back exactly.
+ */
+
+static int
+write_random_element( long datatype, char *buffer, void *element )
+{
+	uint64_t bits;
+	double double_value;
+	float float_value;
+	int64_t int64_value;
+
+	bits = next_random();
+
+	switch( datatype ) {
+	case MXFT_DOUBLE:
+		if ( bits & 1 ) {
+			double_value = (double) (int64_t) ( bits % 2000001 )
+						/ 1000.0 - 1000.0;
+		} else {
+			double_value = (double) (int64_t) bits * 1.0e-9;
+		}
+		*((double *) element) = double_value;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%.17g", double_value );
+
+	case MXFT_FLOAT:
+		float_value = (float) ( (double) (int32_t) bits * 1.0e-3 );
+		*((float *) element) = float_value;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%.9g", (double) float_value );
+
+	case MXFT_LONG:
+		*((long *) element) = (long) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%ld", (long) bits );
+
+	case MXFT_ULONG:
+		*((unsigned long *) element) = (unsigned long) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%lu", (unsigned long) bits );
+
+	case MXFT_HEX:
+		*((unsigned long *) element) = (unsigned long) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%lx", (unsigned long) bits );
+
+	case MXFT_SHORT:
+		*((short *) element) = (short) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%d", (int) (short) bits );
+
+	case MXFT_USHORT:
+		*((unsigned short *) element) = (unsigned short) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%u", (unsigned) (unsigned short) bits );
+
+	case MXFT_UCHAR:
+		*((unsigned char *) element) = (unsigned char) bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%u", (unsigned) (unsigned char) bits );
+
+	case MXFT_BOOL:
+		*((mx_bool_type *) element) = (mx_bool_type) ( bits & 1 );
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%d", (int) ( bits & 1 ) );
+
+	case MXFT_INT64:
+		int64_value = (int64_t) bits;
+		*((int64_t *) element) = int64_value;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%lld", (long long) int64_value );
+
+	case MXFT_UINT64:
+		*((uint64_t *) element) = bits;
+		return snprintf( buffer, MAX_TOKEN_LENGTH,
+				"%llu", (unsigned long long) bits );
+	}
+
+	return 0;
+}
+
+/* Builds a row of NUM_ELEMENTS random values, separated by single
+ * spaces with an occasional tab or newline.
+ */
+
+static char *
+build_row( TEST_TYPE *test_type, char *expected_array, size_t *length )
+{
+	char *description, *ptr;
+	long n;
+
+	description = (char *) malloc( NUM_ELEMENTS * ( MAX_TOKEN_LENGTH + 1 )
+								+ 1 );
+
+	if ( description == (char *) NULL ) {
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	ptr = description;
+
+	for ( n = 0; n < NUM_ELEMENTS; n++ ) {
+		if ( n > 0 ) {
+			switch( n % 16 ) {
+			case 7:  *ptr++ = '\t'; break;
+			case 15: *ptr++ = '\n'; break;
+			default: *ptr++ = ' ';  break;
+			}
+		}
+
+		ptr += write_random_element( test_type->datatype, ptr,
+				expected_array + n * test_type->element_size );
+	}
+
+	*ptr = '\0';
+
+	*length = ptr - description;
+
+	return description;
+}
+
+/* Parses the row one token at a time, the way that
+ * mx_parse_array_description() does for each element.
+ */
+
+static mx_status_type
+parse_row_by_token( void *row_ptr,
+		TEST_TYPE *test_type,
+		MX_RECORD_FIELD_PARSE_STATUS *parse_status )
+{
+	MX_RECORD_TOKEN_PARSER *token_parser;
+	MX_RECORD_TOKEN token;
+	long n;
+	mx_status_type mx_status;
+
+	mx_status = mx_get_token_view_parser( test_type->datatype,
+							&token_parser );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	for ( n = 0; n < NUM_ELEMENTS; n++ ) {
+		mx_status = mx_get_next_record_token_view( parse_status,
+								&token );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+
+		mx_status = (*token_parser)(
+			(char *) row_ptr + n * test_type->element_size,
+			&token, &record, &record_field, parse_status );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static int
+check_type( TEST_TYPE *test_type )
+{
+	MX_RECORD_FIELD_PARSE_STATUS parse_status;
+	struct timespec start;
+	char *description, *expected_array, *row_array, *token_array;
+	size_t length, array_size;
+	double row_seconds, token_seconds;
+	int num_failures;
+	mx_status_type mx_status;
+
+	num_failures = 0;
+
+	setup_field( test_type->datatype );
+
+	array_size = NUM_ELEMENTS * test_type->element_size;
+
+	expected_array = (char *) calloc( 1, array_size );
+	row_array = (char *) calloc( 1, array_size );
+	token_array = (char *) calloc( 1, array_size );
+
+	if ( ( expected_array == NULL ) || ( row_array == NULL )
+	  || ( token_array == NULL ) )
+	{
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	description = build_row( test_type, expected_array, &length );
+
+	setup_parse_status( &parse_status, description );
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	mx_status = mx_parse_numeric_row( row_array, test_type->datatype,
+			NUM_ELEMENTS, &record, &record_field, &parse_status );
+
+	row_seconds = elapsed_seconds( &start );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		fprintf( stderr, "mx_parse_numeric_row() failed for type %s "
+			"with error code %ld.\n", test_type->name,
+			mx_status.code );
+		num_failures++;
+	} else if ( parse_status.description != description + length ) {
+		fprintf( stderr, "mx_parse_numeric_row() stopped %ld "
+			"characters early for type %s.\n",
+			(long) ( description + length
+				- parse_status.description ),
+			test_type->name );
+		num_failures++;
+	} else if ( memcmp( row_array, expected_array, array_size ) != 0 ) {
+		fprintf( stderr, "mx_parse_numeric_row() returned the wrong "
+			"values for type %s.\n", test_type->name );
+		num_failures++;
+	}
+
+	setup_parse_status( &parse_status, description );
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	mx_status = parse_row_by_token( token_array, test_type, &parse_status );
+
+	token_seconds = elapsed_seconds( &start );
+
+	if ( ( mx_status.code != MXE_SUCCESS )
+	  || ( memcmp( token_array, expected_array, array_size ) != 0 ) )
+	{
+		fprintf( stderr, "The token parsers returned the wrong "
+			"values for type %s.\n", test_type->name );
+		num_failures++;
+	}
+
+	printf( "%-7s %8.1f MB/s by row, %8.1f MB/s by token\n",
+		test_type->name,
+		1.0e-6 * length / row_seconds,
+		1.0e-6 * length / token_seconds );
+
+	free( description );
+	free( expected_array );
+	free( row_array );
+	free( token_array );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Parses a short description and returns the error code. */
+
+static long
+parse_short_row( long datatype, const char *text, long num_elements,
+			void *row_ptr, char **description_end )
+{
+	static char description[200];
+
+	MX_RECORD_FIELD_PARSE_STATUS parse_status;
+	mx_status_type mx_status;
+
+	strlcpy( description, text, sizeof(description) );
+
+	setup_field( datatype );
+	setup_parse_status( &parse_status, description );
+
+	mx_status = mx_parse_numeric_row( row_ptr, datatype, num_elements,
+				&record, &record_field, &parse_status );
+
+	if ( description_end != (char **) NULL ) {
+		*description_end = parse_status.description;
+	}
+
+	return mx_status.code;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+static int
+check_special_cases( void )
+{
+	double double_array[4];
+	long long_array[4];
+	short short_array[2];
+	unsigned char uchar_array[2];
+	char *end;
+	int num_failures;
+
+	num_failures = 0;
+
+	/* One row out of a longer description, followed by another field. */
+
+	CHECK( parse_short_row( MXFT_DOUBLE, "  1.5\t-2e3 0.25  99 rest",
+				3, double_array, &end ) == MXE_SUCCESS );
+	CHECK( double_array[0] == 1.5 );
+	CHECK( double_array[1] == -2000.0 );
+	CHECK( double_array[2] == 0.25 );
+	CHECK( strcmp( end, "  99 rest" ) == 0 );
+
+	/* Quoted numbers are passed to the token parser. */
+
+	CHECK( parse_short_row( MXFT_LONG, "1 \"2\" 3", 3,
+					long_array, NULL ) == MXE_SUCCESS );
+	CHECK( long_array[0] == 1 );
+	CHECK( long_array[1] == 2 );
+	CHECK( long_array[2] == 3 );
+
+	/* Malformed rows. */
+
+	CHECK( parse_short_row( MXFT_DOUBLE, "1.5 2.5x 3", 3,
+			double_array, NULL ) == MXE_UNPARSEABLE_STRING );
+
+	CHECK( parse_short_row( MXFT_LONG, "1 abc", 2,
+				long_array, NULL ) == MXE_UNPARSEABLE_STRING );
+
+	CHECK( parse_short_row( MXFT_LONG, "1 2", 3,
+			long_array, NULL ) == MXE_UNEXPECTED_END_OF_DATA );
+
+	CHECK( parse_short_row( MXFT_SHORT, "-32768 32768", 2,
+			short_array, NULL ) == MXE_WOULD_EXCEED_LIMIT );
+
+	CHECK( parse_short_row( MXFT_UCHAR, "255 256", 2,
+			uchar_array, NULL ) == MXE_WOULD_EXCEED_LIMIT );
+
+	CHECK( parse_short_row( MXFT_LONG, "99999999999999999999", 1,
+			long_array, NULL ) == MXE_WOULD_EXCEED_LIMIT );
+
+	CHECK( parse_short_row( MXFT_STRING, "abc", 1,
+			long_array, NULL ) == MXE_UNSUPPORTED );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	unsigned long i;
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = check_special_cases();
+
+	for ( i = 0; i < NUM_TEST_TYPES; i++ ) {
+		num_failures += check_type( &test_type_array[i] );
+	}
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All numeric row parser checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
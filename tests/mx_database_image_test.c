@@ -0,0 +1,540 @@
+/*
+ * Name:    mx_database_image_test.c
+ *
+ * Purpose: Writes a small database out as a database image, reads it
+ *          back into an empty record list, and checks that the records
+ *          are recreated the same way that a text database would
+ *          create them.
+ *
+ *          In particular, varargs fields get their dimensions resolved
+ *          through the driver's varargs plan and get arrays of the
+ *          right length whether or not they are in the record
+ *          description, the drivers' finish_record_initialization()
+ *          functions are left for mx_finish_database_initialization(),
+ *          and a load that fails part way through deletes the records
+ *          that it had already created.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+#include "mx_database_image.h"
+
+#define TEST_TYPE		7777
+
+#define TEST_N_COOKIE		(-( 4 * MXU_VARARGS_COOKIE_MULTIPLIER ))
+
+typedef struct {
+	double position;
+	MX_RECORD *other_record;
+	long n;
+	long *value_array;
+	double *work_array;
+} TEST_STRUCT;
+
+static MX_RECORD_FIELD_DEFAULTS test_field_defaults[] = {
+  {-1, -1, "name", MXFT_STRING, NULL, 1, {MXU_RECORD_NAME_LENGTH},
+	MXF_REC_RECORD_STRUCT, offsetof(MX_RECORD, name),
+	{sizeof(char)}, NULL, MXFF_IN_DESCRIPTION, 0, 0.0, NULL},
+
+  {-1, -1, "mx_type", MXFT_RECORDTYPE, NULL, 0, {0},
+	MXF_REC_RECORD_STRUCT, offsetof(MX_RECORD, mx_type),
+	{0}, NULL, MXFF_IN_DESCRIPTION, 0, 0.0, NULL},
+
+  {-1, -1, "position", MXFT_DOUBLE, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, position),
+	{0}, NULL, MXFF_IN_DESCRIPTION, 0, 0.0, NULL},
+
+  {-1, -1, "other_record", MXFT_RECORD, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, other_record),
+	{0}, NULL, MXFF_IN_DESCRIPTION, 0, 0.0, NULL},
+
+  {-1, -1, "n", MXFT_LONG, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, n),
+	{0}, NULL, MXFF_IN_DESCRIPTION, 0, 0.0, NULL},
+
+  {-1, -1, "value_array", MXFT_LONG, NULL, 1, {TEST_N_COOKIE},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, value_array),
+	{sizeof(long)}, NULL, (MXFF_IN_DESCRIPTION | MXFF_VARARGS),
+	0, 0.0, NULL},
+
+  {-1, -1, "work_array", MXFT_DOUBLE, NULL, 1, {TEST_N_COOKIE},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, work_array),
+	{sizeof(double)}, NULL, MXFF_VARARGS, 0, 0.0, NULL},
+};
+
+static long test_num_record_fields = sizeof( test_field_defaults )
+					/ sizeof( test_field_defaults[0] );
+
+static MX_RECORD_FIELD_DEFAULTS *test_rfield_def_ptr = test_field_defaults;
+
+static mx_status_type
+test_create_record_structures( MX_RECORD *record )
+{
+	record->record_type_struct =
+			mx_record_allocate( record, sizeof(TEST_STRUCT) );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static MX_RECORD_FUNCTION_LIST test_record_function_list = {
+	NULL,
+	test_create_record_structures,
+	NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+static MX_DRIVER test_driver = {
+	"test_driver", TEST_TYPE, 2, 3, &test_record_function_list,
+	NULL, NULL, &test_num_record_fields, &test_rfield_def_ptr,
+	NULL, NULL, NULL, NULL
+};
+
+static int num_records_deleted = 0;
+static int num_records_finished = 0;
+static int num_cookie_fallbacks = 0;
+
+/*------------------------------------------------------------------------*/
+
+/* The record and driver functions from libMx that the image loader
+ * calls, reduced to what is needed for a single driver.
+ */
+
+MX_EXPORT MX_DRIVER *
+mx_get_driver_by_type( long mx_type )
+{
+	if ( mx_type == TEST_TYPE )
+		return &test_driver;
+
+	return NULL;
+}
+
+MX_EXPORT MX_DRIVER *
+mx_get_driver_for_record( MX_RECORD *record )
+{
+	return mx_get_driver_by_type( record->mx_type );
+}
+
+MX_EXPORT MX_RECORD *
+mx_create_record( void )
+{
+	return (MX_RECORD *) calloc( 1, sizeof(MX_RECORD) );
+}
+
+MX_EXPORT MX_RECORD *
+mx_get_record( MX_RECORD *record_list, const char *record_name )
+{
+	return mx_record_name_index_lookup( record_list, record_name );
+}
+
+MX_EXPORT MX_LIST_HEAD *
+mx_get_record_list_head_struct( MX_RECORD *record )
+{
+	return (MX_LIST_HEAD *) record->list_head->record_superclass_struct;
+}
+
+MX_EXPORT mx_status_type
+mx_insert_before_record( MX_RECORD *old_record, MX_RECORD *new_record )
+{
+	new_record->next_record = old_record;
+	new_record->previous_record = old_record->previous_record;
+
+	old_record->previous_record->next_record = new_record;
+	old_record->previous_record = new_record;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_construct_ptr_to_field_data( MX_RECORD *record,
+				MX_RECORD_FIELD_DEFAULTS *field_defaults,
+				void **field_data_ptr )
+{
+	char *base;
+
+	if ( field_defaults->structure_id == MXF_REC_RECORD_STRUCT ) {
+		base = (char *) record;
+	} else {
+		base = (char *) record->record_type_struct;
+	}
+
+	*field_data_ptr = base + field_defaults->structure_offset;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void *
+mx_get_field_value_pointer( MX_RECORD_FIELD *field )
+{
+	if ( ( field->descriptor->flags & MXFF_VARARGS )
+	  && ( field->descriptor->num_dimensions > 0 ) )
+	{
+		return *((void **) field->data_pointer);
+	}
+
+	return field->data_pointer;
+}
+
+MX_EXPORT mx_status_type
+mx_replace_varargs_cookies_with_values( MX_RECORD *record,
+					long field_index,
+					mx_bool_type allow_forward_references )
+{
+	static const char fname[] = "mx_replace_varargs_cookies_with_values()";
+
+	MXW_UNUSED( allow_forward_references );
+
+	num_cookie_fallbacks++;
+
+	return mx_error( MXE_UNSUPPORTED, fname,
+	"Field %ld of record '%s' was not resolved with the varargs plan.",
+		field_index, record->name );
+}
+
+MX_EXPORT mx_status_type
+mx_finish_record_initialization( MX_RECORD *record )
+{
+	MXW_UNUSED( record );
+
+	num_records_finished++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_record( MX_RECORD *record )
+{
+	TEST_STRUCT *test_struct;
+	long i;
+
+	if ( record->next_record != (MX_RECORD *) NULL ) {
+		record->previous_record->next_record = record->next_record;
+		record->next_record->previous_record = record->previous_record;
+	}
+
+	test_struct = (TEST_STRUCT *) record->record_type_struct;
+
+	if ( test_struct != (TEST_STRUCT *) NULL ) {
+		mx_free( test_struct->value_array );
+		mx_free( test_struct->work_array );
+
+		mx_record_free( record, test_struct );
+	}
+
+	if ( record->record_field_array != (MX_RECORD_FIELD *) NULL ) {
+		for ( i = 0; i < record->num_record_fields; i++ ) {
+			mx_free_record_field_private_arrays(
+				&(record->record_field_array[i]) );
+		}
+
+		mx_record_free( record, record->record_field_array );
+	}
+
+	free( record );
+
+	num_records_deleted++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static MX_RECORD *
+create_record_list( void )
+{
+	MX_RECORD *record_list;
+	mx_status_type mx_status;
+
+	record_list = (MX_RECORD *) calloc( 1, sizeof(MX_RECORD) );
+
+	record_list->mx_superclass = MXR_LIST_HEAD;
+	record_list->list_head = record_list;
+	record_list->next_record = record_list;
+	record_list->previous_record = record_list;
+
+	record_list->record_superclass_struct =
+				calloc( 1, sizeof(MX_LIST_HEAD) );
+
+	mx_status = mx_create_record_name_index( record_list );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		fprintf( stderr, "Cannot create a record name index.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	return record_list;
+}
+
+static void
+delete_record_list( MX_RECORD *record_list )
+{
+	while ( record_list->next_record != record_list ) {
+		(void) mx_record_name_index_delete( record_list->next_record );
+		(void) mx_delete_record( record_list->next_record );
+	}
+
+	(void) mx_delete_record_name_index( record_list );
+
+	free( record_list->record_superclass_struct );
+	free( record_list );
+}
+
+/* Creates a record the way that a record description would, with its
+ * varargs arrays allocated from the value of 'n'.
+ */
+
+static MX_RECORD *
+add_record( MX_RECORD *record_list, const char *name, long n )
+{
+	MX_RECORD *record;
+	TEST_STRUCT *test_struct;
+	long i;
+
+	record = mx_create_record();
+
+	record->mx_superclass = 3;
+	record->mx_class = 2;
+	record->mx_type = TEST_TYPE;
+	record->list_head = record_list;
+
+	snprintf( record->name, sizeof(record->name), "%s", name );
+
+	(void) test_create_record_structures( record );
+
+	test_struct = (TEST_STRUCT *) record->record_type_struct;
+
+	record->num_record_fields = test_num_record_fields;
+
+	record->record_field_array = (MX_RECORD_FIELD *) mx_record_allocate(
+		record, test_num_record_fields * sizeof(MX_RECORD_FIELD) );
+
+	for ( i = 0; i < test_num_record_fields; i++ ) {
+		(void) mx_share_defaults_with_record_field(
+				&(record->record_field_array[i]),
+				&test_field_defaults[i] );
+
+		record->record_field_array[i].record = record;
+
+		(void) mx_construct_ptr_to_field_data( record,
+				&test_field_defaults[i],
+				&(record->record_field_array[i].data_pointer) );
+	}
+
+	test_struct->n = n;
+	test_struct->value_array = (long *) calloc( n + 1, sizeof(long) );
+	test_struct->work_array = (double *) calloc( n + 1, sizeof(double) );
+
+	record->record_field_array[5].dimension[0] = n;
+	record->record_field_array[6].dimension[0] = n;
+
+	(void) mx_insert_before_record( record_list, record );
+	(void) mx_record_name_index_add( record );
+
+	return record;
+}
+
+static int
+count_records( MX_RECORD *record_list )
+{
+	MX_RECORD *record;
+	int num_records;
+
+	num_records = 0;
+
+	for ( record = record_list->next_record; record != record_list;
+					record = record->next_record )
+	{
+		num_records++;
+	}
+
+	return num_records;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !( condition ) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+int
+main( int argc, char *argv[] )
+{
+	MX_RECORD *source_list, *image_list, *partial_list;
+	MX_RECORD *source_a, *source_b, *image_a, *image_b;
+	TEST_STRUCT *a_struct, *b_struct;
+	char image_filename[80];
+	long i;
+	int num_failures;
+	mx_status_type mx_status;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = 0;
+
+	snprintf( image_filename, sizeof(image_filename),
+			"/tmp/mx_database_image_test.%ld", (long) getpid() );
+
+	mx_status = mx_create_varargs_plan( &test_driver );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	/* Write out a database with two records that refer to each other.
+	 * The second one has empty varargs arrays.
+	 */
+
+	source_list = create_record_list();
+
+	source_a = add_record( source_list, "alpha", 3 );
+	source_b = add_record( source_list, "beta", 0 );
+
+	a_struct = (TEST_STRUCT *) source_a->record_type_struct;
+	b_struct = (TEST_STRUCT *) source_b->record_type_struct;
+
+	a_struct->position = 1.5;
+	a_struct->other_record = source_b;
+	a_struct->value_array[0] = 10;
+	a_struct->value_array[1] = 20;
+	a_struct->value_array[2] = 30;
+	a_struct->work_array[1] = 99.0;
+
+	b_struct->position = -2.25;
+	b_struct->other_record = source_a;
+
+	mx_status = mx_write_database_image( source_list,
+						image_filename, NULL );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	/* Read it back in. */
+
+	image_list = create_record_list();
+
+	mx_status = mx_read_database_image( image_list, image_filename, NULL );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( count_records( image_list ) == 2 );
+
+	image_a = mx_get_record( image_list, "alpha" );
+	image_b = mx_get_record( image_list, "beta" );
+
+	CHECK( image_a != (MX_RECORD *) NULL );
+	CHECK( image_b != (MX_RECORD *) NULL );
+
+	if ( ( image_a != (MX_RECORD *) NULL )
+	  && ( image_b != (MX_RECORD *) NULL ) )
+	{
+		a_struct = (TEST_STRUCT *) image_a->record_type_struct;
+		b_struct = (TEST_STRUCT *) image_b->record_type_struct;
+
+		CHECK( image_a->mx_type == TEST_TYPE );
+		CHECK( a_struct->position == 1.5 );
+		CHECK( b_struct->position == -2.25 );
+		CHECK( a_struct->other_record == image_b );
+		CHECK( b_struct->other_record == image_a );
+
+		/* The description varargs field has its values. */
+
+		CHECK( a_struct->n == 3 );
+		CHECK( image_a->record_field_array[5].dimension[0] == 3 );
+		CHECK( a_struct->value_array != (long *) NULL );
+
+		if ( a_struct->value_array != (long *) NULL ) {
+			CHECK( a_struct->value_array[0] == 10 );
+			CHECK( a_struct->value_array[1] == 20 );
+			CHECK( a_struct->value_array[2] == 30 );
+		}
+
+		/* The other varargs field is not in the image, but it
+		 * still has the resolved length and a zeroed array.
+		 */
+
+		CHECK( image_a->record_field_array[6].dimension[0] == 3 );
+		CHECK( a_struct->work_array != (double *) NULL );
+
+		if ( a_struct->work_array != (double *) NULL ) {
+			for ( i = 0; i < 3; i++ ) {
+				CHECK( a_struct->work_array[i] == 0.0 );
+			}
+		}
+
+		CHECK( image_b->record_field_array[5].dimension[0] == 0 );
+		CHECK( image_b->record_field_array[6].dimension[0] == 0 );
+		CHECK( b_struct->value_array != (long *) NULL );
+		CHECK( b_struct->work_array != (double *) NULL );
+
+		/* The cookies were never decoded as they would have been
+		 * by the old per field code.
+		 */
+
+		CHECK( image_a->record_field_array[5].dimension[0]
+						!= TEST_N_COOKIE );
+		CHECK( test_field_defaults[5].dimension[0] == TEST_N_COOKIE );
+	}
+
+	CHECK( num_cookie_fallbacks == 0 );
+
+	/* Finishing the records is left to the caller. */
+
+	CHECK( num_records_finished == 0 );
+
+	/* Loading the same image again fails on the first record and
+	 * leaves the list as it was.
+	 */
+
+	mx_status = mx_read_database_image( image_list, image_filename, NULL );
+
+	CHECK( mx_status.code == MXE_ALREADY_EXISTS );
+	CHECK( count_records( image_list ) == 2 );
+
+	/* A load that fails on the second record deletes the first. */
+
+	partial_list = create_record_list();
+
+	(void) add_record( partial_list, "beta", 1 );
+
+	num_records_deleted = 0;
+
+	mx_status = mx_read_database_image( partial_list,
+						image_filename, NULL );
+
+	CHECK( mx_status.code == MXE_ALREADY_EXISTS );
+	CHECK( num_records_deleted == 1 );
+	CHECK( count_records( partial_list ) == 1 );
+	CHECK( mx_get_record( partial_list, "alpha" ) == (MX_RECORD *) NULL );
+
+	(void) remove( image_filename );
+
+	delete_record_list( partial_list );
+	delete_record_list( image_list );
+	delete_record_list( source_list );
+
+	mx_delete_varargs_plan( &test_driver );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All database image checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+/*
+ * Name:    mx_field_access_test.cpp
+ *
+ * Purpose: Checks that the constexpr field tables in mx_field_access.hpp
+ *          agree with the *_STANDARD_FIELDS macros that they come from,
+ *          that mx::field<> reads and writes the same memory that the
+ *          run time lookup from 'structure_id' and 'structure_offset'
+ *          finds, and compares the cost of the two ways of reading a
+ *          motor position.
+ *
+ *          The timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx_field_access.hpp"
+
+/* MX_MOTOR_STANDARD_FIELDS refers to this function from libMx. */
+
+MX_EXPORT mx_status_type
+mx_motor_vctest_extended_status( MX_RECORD_FIELD *field,
+				int direction,
+				mx_bool_type *value_changed )
+{
+	MXW_UNUSED( field );
+	MXW_UNUSED( direction );
+
+	*value_changed = FALSE;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/* Checks that can be made at compile time. */
+
+static_assert( mx::motor_field_table.size()
+	== sizeof(mx::motor_standard_fields)
+		/ sizeof(mx::motor_standard_fields[0]) );
+
+static_assert( mx::find_field( mx::motor_field_table, "position" ) >= 0 );
+static_assert( mx::find_field( mx::motor_field_table, "no_such_field" ) < 0 );
+
+static_assert( mx::motor_field_table[ mx::find_field(
+		mx::motor_field_table, "position" ) ].datatype == MXFT_DOUBLE );
+
+static_assert( mx::find_field_by_label_value( mx::motor_field_table,
+		MXLV_MTR_POSITION ) == mx::find_field(
+					mx::motor_field_table, "position" ) );
+
+static_assert( mx::field<&MX_MOTOR::position>::structure_id
+						== MXF_REC_CLASS_STRUCT );
+
+static_assert( std::is_same_v<
+		mx::field<&MX_ADSC_TWO_THETA::height_motor_record>::value_type,
+		MX_RECORD *> );
+
+/*------------------------------------------------------------------------*/
+
+/* The run time lookup that mx_construct_ptr_to_field_value() does. */
+
+static void *
+runtime_field_pointer( MX_RECORD *record, const mx::field_descriptor &field )
+{
+	char *structure_ptr;
+
+	switch( field.structure_id ) {
+	case MXF_REC_RECORD_STRUCT:
+		structure_ptr = (char *) record;
+		break;
+	case MXF_REC_SUPERCLASS_STRUCT:
+		structure_ptr = (char *) record->record_superclass_struct;
+		break;
+	case MXF_REC_CLASS_STRUCT:
+		structure_ptr = (char *) record->record_class_struct;
+		break;
+	case MXF_REC_TYPE_STRUCT:
+		structure_ptr = (char *) record->record_type_struct;
+		break;
+	default:
+		return NULL;
+	}
+
+	return structure_ptr + field.structure_offset;
+}
+
+template <size_t N>
+static void *
+runtime_field_pointer( MX_RECORD *record,
+		const std::array<mx::field_descriptor, N> &table,
+		const char *name )
+{
+	long i = mx::find_field( table, name );
+
+	if ( i < 0 )
+		return NULL;
+
+	return runtime_field_pointer( record, table[i] );
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* Every entry of a table must be a copy of the macro's entry. */
+
+template <size_t N>
+static int
+check_table( const std::array<mx::field_descriptor, N> &table,
+		const MX_RECORD_FIELD_DEFAULTS (&defaults)[N] )
+{
+	int num_failures = 0;
+
+	for ( size_t i = 0; i < N; i++ ) {
+		CHECK( strcmp( table[i].name, defaults[i].name ) == 0 );
+		CHECK( table[i].label_value == defaults[i].label_value );
+		CHECK( table[i].datatype == defaults[i].datatype );
+		CHECK( table[i].num_dimensions == defaults[i].num_dimensions );
+		CHECK( table[i].structure_id == defaults[i].structure_id );
+		CHECK( table[i].structure_offset
+				== defaults[i].structure_offset );
+		CHECK( table[i].flags == defaults[i].flags );
+	}
+
+	return num_failures;
+}
+
+static MX_RECORD motor_record;
+static MX_MOTOR motor;
+static MX_ADSC_TWO_THETA adsc_two_theta;
+
+static int
+check_accessors( void )
+{
+	int num_failures = 0;
+
+	motor_record.record_class_struct = &motor;
+	motor_record.record_type_struct = &adsc_two_theta;
+
+	snprintf( motor_record.name, sizeof(motor_record.name), "two_theta" );
+
+	/* field<> and the run time lookup find the same memory. */
+
+	CHECK( (void *) &mx::field<&MX_MOTOR::position>::ref( &motor_record )
+		== runtime_field_pointer( &motor_record,
+					mx::motor_field_table, "position" ) );
+
+	CHECK( (void *) &mx::field<&MX_MOTOR::scale>::ref( &motor_record )
+		== runtime_field_pointer( &motor_record,
+					mx::motor_field_table, "scale" ) );
+
+	CHECK( (void *) mx::field<&MX_RECORD::name>::ref( &motor_record )
+		== runtime_field_pointer( &motor_record,
+					mx::record_field_table, "name" ) );
+
+	CHECK( (void *) &mx::field<&MX_ADSC_TWO_THETA::height_motor_record>
+						::ref( &motor_record )
+		== runtime_field_pointer( &motor_record,
+					mx::adsc_two_theta_field_table,
+					"height_motor_record" ) );
+
+	/* Values written one way are read back the other way. */
+
+	mx::field<&MX_MOTOR::position>::set( &motor_record, 12.5 );
+
+	CHECK( motor.position == 12.5 );
+	CHECK( *(double *) runtime_field_pointer( &motor_record,
+			mx::motor_field_table, "position" ) == 12.5 );
+
+	motor.destination = -3.0;
+
+	CHECK( mx::field<&MX_MOTOR::destination>::get( &motor_record )
+								== -3.0 );
+
+	mx::field<&MX_ADSC_TWO_THETA::height_motor_record>::set(
+					&motor_record, &motor_record );
+
+	CHECK( adsc_two_theta.height_motor_record == &motor_record );
+
+	CHECK( strcmp( mx::field<&MX_RECORD::name>::get( &motor_record ),
+							"two_theta" ) == 0 );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+#define NUM_READS	20000000L
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+/* The record and descriptor are read through volatile pointers, so that
+ * the compiler cannot hoist the lookups out of the loops.
+ */
+
+static MX_RECORD * volatile volatile_record = &motor_record;
+
+static const mx::field_descriptor * volatile volatile_descriptor =
+	&mx::motor_field_table[ mx::find_field( mx::motor_field_table,
+						"position" ) ];
+
+static void
+compare_reads( void )
+{
+	struct timespec start;
+	double direct_sum, runtime_sum, direct_seconds, runtime_seconds;
+	long i;
+
+	motor.position = 1.0;
+
+	direct_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_READS; i++ ) {
+		direct_sum += mx::field<&MX_MOTOR::position>::get(
+							volatile_record );
+	}
+
+	direct_seconds = elapsed_seconds( &start );
+
+	runtime_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_READS; i++ ) {
+		runtime_sum += *(double *) runtime_field_pointer(
+				volatile_record, *volatile_descriptor );
+	}
+
+	runtime_seconds = elapsed_seconds( &start );
+
+	printf( "mx::field<>:          %.2f ns per read (sum %g)\n",
+		1.0e9 * direct_seconds / NUM_READS, direct_sum );
+	printf( "structure_id lookup:  %.2f ns per read (sum %g)\n",
+		1.0e9 * runtime_seconds / NUM_READS, runtime_sum );
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = check_table( mx::record_field_table,
+					mx::record_standard_fields )
+		+ check_table( mx::motor_field_table,
+					mx::motor_standard_fields )
+		+ check_table( mx::analog_motor_field_table,
+					mx::analog_motor_standard_fields )
+		+ check_table( mx::stepper_motor_field_table,
+					mx::stepper_motor_standard_fields )
+		+ check_table( mx::adsc_two_theta_field_table,
+					mx::adsc_two_theta_standard_fields );
+
+	num_failures += check_accessors();
+
+	compare_reads();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All field access checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,627 @@
+/*
+ * Name:    mx_field_array_pool_test.c
+ *
+ * Purpose: Checks that mx_resize_1d_field_array() keeps the contents of
+ *          an array field when it grows, reuses the field's block below
+ *          its high water mark, shrinks on request, and hands released
+ *          blocks on to other fields through the field array pool.
+ *
+ *          It also runs a list scan in which the estimated move arrays
+ *          of two motors change length at every step, and prints the
+ *          number of reallocations that the old behaviour of
+ *          reallocating on every length change would have made next to
+ *          the number of reallocations and mallocs that were actually
+ *          needed.  It times the scan against a model of the old
+ *          behaviour that calls realloc() for every length change.  The
+ *          timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_field_array_pool.h"
+
+#define NUM_SCAN_STEPS		200
+#define MAX_SCAN_POSITIONS	200
+
+#define NUM_TIMED_SCANS		2000
+
+static long num_record_frees = 0;
+
+/* The field array pool only needs these functions from libMx. */
+
+MX_EXPORT MX_LIST_HEAD *
+mx_get_record_list_head_struct( MX_RECORD *record )
+{
+	return (MX_LIST_HEAD *) record->list_head->record_superclass_struct;
+}
+
+MX_EXPORT mx_status_type
+mx_make_record_field_private( MX_RECORD_FIELD *field )
+{
+	MXW_UNUSED( field );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT void
+mx_record_free( MX_RECORD *record, void *ptr )
+{
+	MXW_UNUSED( record );
+
+	if ( ptr != NULL ) {
+		num_record_frees++;
+	}
+
+	free( ptr );
+}
+
+/*------------------------------------------------------------------------*/
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t
+next_random( void )
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+
+	return random_state;
+}
+
+/* A record list with one motor record whose fields are set up like the
+ * 'estimated_move_positions' and 'estimated_move_durations' fields.
+ */
+
+static MX_LIST_HEAD list_head;
+static MX_RECORD list_head_record;
+static MX_RECORD motor_record;
+
+typedef struct {
+	MX_RECORD_FIELD field;
+	MX_RECORD_FIELD_DEFAULTS descriptor;
+	long length;
+	double *array;
+} TEST_FIELD;
+
+static void
+init_field( TEST_FIELD *test_field, const char *name,
+		long num_dimensions, long flags )
+{
+	memset( test_field, 0, sizeof(TEST_FIELD) );
+
+	snprintf( test_field->descriptor.name,
+		sizeof(test_field->descriptor.name), "%s", name );
+
+	test_field->descriptor.datatype = MXFT_DOUBLE;
+	test_field->descriptor.num_dimensions = num_dimensions;
+	test_field->descriptor.data_element_size[0] = sizeof(double);
+	test_field->descriptor.flags = flags;
+
+	test_field->field.descriptor = &(test_field->descriptor);
+	test_field->field.record = &motor_record;
+	test_field->field.dimension = &(test_field->length);
+	test_field->field.data_pointer = &(test_field->array);
+}
+
+static void
+free_field( TEST_FIELD *test_field )
+{
+	free( test_field->array );
+
+	test_field->array = NULL;
+	test_field->length = 0;
+	test_field->field.array_allocated_size = 0;
+}
+
+static void
+init_record_list( void )
+{
+	memset( &list_head, 0, sizeof(list_head) );
+	memset( &list_head_record, 0, sizeof(list_head_record) );
+	memset( &motor_record, 0, sizeof(motor_record) );
+
+	list_head_record.list_head = &list_head_record;
+	list_head_record.record_superclass_struct = &list_head;
+
+	motor_record.list_head = &list_head_record;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/*------------------------------------------------------------------------*/
+
+static int
+check_resize( void )
+{
+	MX_FIELD_ARRAY_POOL *pool;
+	TEST_FIELD field, other_field;
+	double *array;
+	mx_status_type mx_status;
+	long i;
+	int num_failures = 0;
+
+	pool = mx_get_field_array_pool( &list_head_record );
+
+	init_field( &field, "estimated_move_positions", 1, MXFF_VARARGS );
+
+	/* Growing keeps the old values and zeroes the new elements. */
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 5, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.length == 5 );
+	CHECK( field.field.array_allocated_size == 64 );
+
+	for ( i = 0; i < 5; i++ ) {
+		field.array[i] = i + 1.0;
+	}
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 20, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.length == 20 );
+	CHECK( field.field.array_allocated_size == 256 );
+
+	for ( i = 0; i < 5; i++ ) {
+		CHECK( field.array[i] == i + 1.0 );
+	}
+
+	for ( i = 5; i < 20; i++ ) {
+		CHECK( field.array[i] == 0.0 );
+	}
+
+	/* Below the high water mark only the length changes, and elements
+	 * that come back into view are zero again.
+	 */
+
+	array = field.array;
+
+	field.array[10] = 99.0;
+
+	mx_reset_field_array_pool_statistics( pool );
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 3, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.length == 3 );
+	CHECK( field.array == array );
+	CHECK( field.field.array_allocated_size == 256 );
+	CHECK( field.array[2] == 3.0 );
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 32, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.array == array );
+	CHECK( field.array[10] == 0.0 );
+
+	CHECK( pool->num_resizes == 2 );
+	CHECK( pool->num_reallocations == 0 );
+	CHECK( pool->num_mallocs == 0 );
+
+	/* MXF_FIELD_ARRAY_SHRINK only moves the array once it fits in a
+	 * quarter of the block.
+	 */
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 10,
+						MXF_FIELD_ARRAY_SHRINK );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.array == array );
+	CHECK( pool->num_shrinks == 0 );
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 8,
+						MXF_FIELD_ARRAY_SHRINK );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.length == 8 );
+	CHECK( field.field.array_allocated_size == 64 );
+	CHECK( pool->num_shrinks == 1 );
+	CHECK( pool->num_reallocations == 1 );
+	CHECK( field.array[2] == 3.0 );
+
+	/* The shrink reused the 64 byte block that the field gave up when
+	 * it grew.  The 256 byte block that it gave up in turn went to the
+	 * pool, and the next field that needs a block of that size gets it.
+	 */
+
+	CHECK( pool->num_pool_hits == 1 );
+	CHECK( pool->num_mallocs == 0 );
+
+	CHECK( pool->num_free_blocks[2] == 1 );
+	CHECK( pool->bytes_pooled == 256 );
+
+	init_field( &other_field, "estimated_move_durations",
+						1, MXFF_VARARGS );
+
+	mx_status = mx_resize_1d_field_array( &(other_field.field), 30, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( other_field.array == array );
+	CHECK( pool->num_pool_hits == 2 );
+	CHECK( pool->num_free_blocks[2] == 0 );
+	CHECK( pool->bytes_pooled == 0 );
+
+	for ( i = 0; i < 30; i++ ) {
+		CHECK( other_field.array[i] == 0.0 );
+	}
+
+	/* Releasing a field gives its block back to the pool. */
+
+	array = field.array;
+
+	mx_release_1d_field_array( &(field.field) );
+
+	CHECK( field.array == NULL );
+	CHECK( field.length == 0 );
+	CHECK( field.field.array_allocated_size == 0 );
+	CHECK( pool->num_free_blocks[0] == 1 );
+
+	mx_status = mx_resize_1d_field_array( &(other_field.field), 4,
+						MXF_FIELD_ARRAY_SHRINK );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( other_field.array == array );
+	CHECK( pool->num_free_blocks[0] == 0 );
+	CHECK( pool->num_free_blocks[2] == 1 );
+
+	mx_release_1d_field_array( &(other_field.field) );
+
+	/* An array that was not allocated by the pool goes back through
+	 * mx_record_free() and is never put on a free list.
+	 */
+
+	init_field( &field, "estimated_move_positions", 1, MXFF_VARARGS );
+
+	field.array = (double *) malloc( 3 * sizeof(double) );
+	field.length = 3;
+
+	field.array[0] = 7.0;
+	field.array[1] = 8.0;
+	field.array[2] = 9.0;
+
+	num_record_frees = 0;
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 4, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_record_frees == 1 );
+	CHECK( field.array[2] == 9.0 );
+	CHECK( field.array[3] == 0.0 );
+	CHECK( field.field.array_allocated_size == 64 );
+
+	/* Arrays larger than the largest size class are allocated exactly
+	 * and are not pooled.
+	 */
+
+	mx_status = mx_resize_1d_field_array( &(field.field), 200000, 0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( field.field.array_allocated_size == 200000 * sizeof(double) );
+	CHECK( field.array[2] == 9.0 );
+	CHECK( field.array[199999] == 0.0 );
+
+	mx_release_1d_field_array( &(field.field) );
+
+	CHECK( pool->bytes_pooled == 64 + 256 );
+
+	/* Errors. */
+
+	mx_status = mx_resize_1d_field_array( NULL, 1, 0 );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_resize_1d_field_array( &(field.field), -1, 0 );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+
+	mx_status = mx_resize_1d_field_array( &(field.field), LONG_MAX, 0 );
+
+	CHECK( mx_status.code == MXE_WOULD_EXCEED_LIMIT );
+
+	init_field( &other_field, "position", 0, 0 );
+
+	mx_status = mx_resize_1d_field_array( &(other_field.field), 1, 0 );
+
+	CHECK( mx_status.code == MXE_TYPE_MISMATCH );
+
+	init_field( &other_field, "fixed_array", 1, 0 );
+
+	mx_status = mx_resize_1d_field_array( &(other_field.field), 1, 0 );
+
+	CHECK( mx_status.code == MXE_TYPE_MISMATCH );
+
+	return num_failures;
+}
+
+/* Each free list keeps at most MX_FIELD_ARRAY_POOL_MAX_FREE_BLOCKS. */
+
+static int
+check_free_list_limit( void )
+{
+	MX_FIELD_ARRAY_POOL *pool;
+	TEST_FIELD field_array[ MX_FIELD_ARRAY_POOL_MAX_FREE_BLOCKS + 4 ];
+	mx_status_type mx_status;
+	long i, num_fields;
+	int num_failures = 0;
+
+	pool = mx_get_field_array_pool( &list_head_record );
+
+	num_fields = sizeof(field_array) / sizeof(field_array[0]);
+
+	for ( i = 0; i < num_fields; i++ ) {
+		init_field( &field_array[i], "estimated_move_positions",
+							1, MXFF_VARARGS );
+
+		mx_status = mx_resize_1d_field_array(
+					&(field_array[i].field), 100, 0 );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+	}
+
+	for ( i = 0; i < num_fields; i++ ) {
+		mx_release_1d_field_array( &(field_array[i].field) );
+	}
+
+	CHECK( pool->num_free_blocks[4]
+			== MX_FIELD_ARRAY_POOL_MAX_FREE_BLOCKS );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* The scan lengths are chosen once, so that both ways of resizing see
+ * the same sequence.
+ */
+
+static long scan_length[ NUM_SCAN_STEPS ][2];
+
+static void
+choose_scan_lengths( void )
+{
+	long i;
+
+	for ( i = 0; i < NUM_SCAN_STEPS; i++ ) {
+		scan_length[i][0] = 1 + next_random() % MAX_SCAN_POSITIONS;
+		scan_length[i][1] = 1 + next_random() % MAX_SCAN_POSITIONS;
+	}
+}
+
+static int
+run_pooled_scan( TEST_FIELD *positions, TEST_FIELD *durations,
+		double *sum )
+{
+	mx_status_type mx_status;
+	long i, j;
+	int num_failures = 0;
+
+	for ( i = 0; i < NUM_SCAN_STEPS; i++ ) {
+		mx_status = mx_resize_1d_field_array( &(positions->field),
+						scan_length[i][0], 0 );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+
+		mx_status = mx_resize_1d_field_array( &(durations->field),
+						scan_length[i][1], 0 );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+
+		for ( j = 0; j < positions->length; j++ ) {
+			positions->array[j] = j;
+		}
+
+		for ( j = 0; j < durations->length; j++ ) {
+			durations->array[j] = 0.5;
+		}
+
+		*sum += positions->array[ positions->length - 1 ]
+			+ durations->array[ durations->length - 1 ];
+	}
+
+	return num_failures;
+}
+
+/* The old behaviour: every length change reallocates the array. */
+
+static void
+realloc_field( TEST_FIELD *test_field, long num_elements )
+{
+	if ( num_elements == test_field->length )
+		return;
+
+	test_field->array = (double *) realloc( test_field->array,
+					num_elements * sizeof(double) );
+
+	if ( num_elements > test_field->length ) {
+		memset( test_field->array + test_field->length, 0,
+		    ( num_elements - test_field->length ) * sizeof(double) );
+	}
+
+	test_field->length = num_elements;
+}
+
+static void
+run_realloc_scan( TEST_FIELD *positions, TEST_FIELD *durations,
+		double *sum )
+{
+	long i, j;
+
+	for ( i = 0; i < NUM_SCAN_STEPS; i++ ) {
+		realloc_field( positions, scan_length[i][0] );
+		realloc_field( durations, scan_length[i][1] );
+
+		for ( j = 0; j < positions->length; j++ ) {
+			positions->array[j] = j;
+		}
+
+		for ( j = 0; j < durations->length; j++ ) {
+			durations->array[j] = 0.5;
+		}
+
+		*sum += positions->array[ positions->length - 1 ]
+			+ durations->array[ durations->length - 1 ];
+	}
+}
+
+static int
+compare_scans( void )
+{
+	MX_FIELD_ARRAY_POOL *pool;
+	TEST_FIELD positions, durations;
+	struct timespec start;
+	double pooled_sum, realloc_sum, pooled_seconds, realloc_seconds;
+	long i;
+	int num_failures = 0;
+
+	pool = mx_get_field_array_pool( &list_head_record );
+
+	choose_scan_lengths();
+
+	init_field( &positions, "estimated_move_positions", 1, MXFF_VARARGS );
+	init_field( &durations, "estimated_move_durations", 1, MXFF_VARARGS );
+
+	/* One scan with the counters reset shows what the pool saves. */
+
+	mx_reset_field_array_pool_statistics( pool );
+
+	pooled_sum = 0.0;
+
+	num_failures += run_pooled_scan( &positions, &durations,
+							&pooled_sum );
+
+	printf( "List scan of %d steps with 2 array fields:\n",
+						NUM_SCAN_STEPS );
+	printf( "  length changes (old reallocations): %lu\n",
+						pool->num_resizes );
+	printf( "  reallocations:                      %lu\n",
+						pool->num_reallocations );
+	printf( "  pool hits:                          %lu\n",
+						pool->num_pool_hits );
+	printf( "  mallocs:                            %lu\n",
+						pool->num_mallocs );
+
+	CHECK( pool->num_resizes > 300 );
+	CHECK( pool->num_reallocations <= 10 );
+	CHECK( pool->num_mallocs <= pool->num_reallocations );
+
+	/* Time repeated scans.  The pooled fields are released after each
+	 * scan, so that every scan starts with empty fields.
+	 */
+
+	mx_release_1d_field_array( &(positions.field) );
+	mx_release_1d_field_array( &(durations.field) );
+
+	pooled_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_TIMED_SCANS; i++ ) {
+		num_failures += run_pooled_scan( &positions, &durations,
+							&pooled_sum );
+
+		mx_release_1d_field_array( &(positions.field) );
+		mx_release_1d_field_array( &(durations.field) );
+	}
+
+	pooled_seconds = elapsed_seconds( &start );
+
+	realloc_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_TIMED_SCANS; i++ ) {
+		run_realloc_scan( &positions, &durations, &realloc_sum );
+
+		free_field( &positions );
+		free_field( &durations );
+	}
+
+	realloc_seconds = elapsed_seconds( &start );
+
+	printf( "mx_resize_1d_field_array(): %.1f ns per length change "
+		"(sum %g)\n",
+		1.0e9 * pooled_seconds / ( 2.0 * NUM_SCAN_STEPS
+						* NUM_TIMED_SCANS ),
+		pooled_sum );
+	printf( "realloc() on every change:  %.1f ns per length change "
+		"(sum %g)\n",
+		1.0e9 * realloc_seconds / ( 2.0 * NUM_SCAN_STEPS
+						* NUM_TIMED_SCANS ),
+		realloc_sum );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	init_record_list();
+
+	mx_status = mx_create_field_array_pool( &list_head_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( mx_get_field_array_pool( &list_head_record ) != NULL );
+
+	mx_status = mx_create_field_array_pool( &list_head_record );
+
+	CHECK( mx_status.code == MXE_ALREADY_EXISTS );
+
+	num_failures += check_resize();
+	num_failures += check_free_list_limit();
+	num_failures += compare_scans();
+
+	mx_status = mx_delete_field_array_pool( &list_head_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( mx_get_field_array_pool( &list_head_record ) == NULL );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All field array pool checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,605 @@
+/*
+ * Name:    mx_motor_array_test.c
+ *
+ * Purpose: Checks that mx_motor_array_get_position() and
+ *          mx_motor_array_get_status() group the motors by driver,
+ *          make one array call per driver that has one, read the
+ *          motors of other drivers one at a time, and return every
+ *          value in the order of the motor record array.
+ *
+ *          It also polls a simulated 40 axis controller, where every
+ *          query costs a fixed round trip, both through the array
+ *          functions and one motor at a time, and reports the number
+ *          of round trips and the time that each way took.  The
+ *          timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+#define NUM_MOTORS		48
+
+#define NUM_TIMED_MOTORS	40
+#define NUM_TIMED_POLLS		100
+
+#define ROUND_TRIP_NS		20000L
+
+/* Each motor keeps the values that its simulated controller reports. */
+
+typedef struct {
+	MX_RECORD record;
+	MX_MOTOR motor;
+	long controller_steps;
+	double controller_analog;
+	unsigned long controller_status;
+} TEST_MOTOR;
+
+static TEST_MOTOR test_motor_array[NUM_MOTORS];
+static MX_RECORD *motor_record_array[NUM_MOTORS];
+
+static long num_round_trips = 0;
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+/* A query to a controller waits for ROUND_TRIP_NS. */
+
+static mx_bool_type simulate_latency = FALSE;
+
+static void
+round_trip( void )
+{
+	struct timespec start;
+
+	num_round_trips++;
+
+	if ( simulate_latency == FALSE )
+		return;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	while ( elapsed_seconds( &start ) < 1.0e-9 * ROUND_TRIP_NS )
+		;
+}
+
+static void
+read_controller( MX_MOTOR *motor )
+{
+	TEST_MOTOR *test_motor = (TEST_MOTOR *) motor->record;
+
+	if ( motor->subclass == MXC_MTR_STEPPER ) {
+		motor->raw_position.stepper = test_motor->controller_steps;
+	} else {
+		motor->raw_position.analog = test_motor->controller_analog;
+	}
+
+	motor->status = test_motor->controller_status;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Two multiaxis controller drivers that have array functions. */
+
+#define MAX_GROUP_LOG	(2 * NUM_MOTORS)
+
+typedef struct {
+	long num_array_calls;
+	long num_logged;
+	MX_MOTOR *motor_log[MAX_GROUP_LOG];
+	mx_bool_type fail;
+} TEST_DRIVER;
+
+static TEST_DRIVER pmac_driver, xps_driver;
+
+static mx_status_type
+test_driver_read( TEST_DRIVER *driver, long num_motors,
+		MX_MOTOR **motor_array )
+{
+	static const char fname[] = "test_driver_read()";
+
+	long i;
+
+	driver->num_array_calls++;
+
+	round_trip();
+
+	if ( driver->fail ) {
+		return mx_error( MXE_INTERFACE_IO_ERROR, fname,
+		"The simulated controller did not answer." );
+	}
+
+	for ( i = 0; i < num_motors; i++ ) {
+		read_controller( motor_array[i] );
+
+		if ( driver->num_logged < MAX_GROUP_LOG ) {
+			driver->motor_log[ driver->num_logged++ ]
+						= motor_array[i];
+		}
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+pmac_read_axes( long num_motors, MX_MOTOR **motor_array )
+{
+	return test_driver_read( &pmac_driver, num_motors, motor_array );
+}
+
+static mx_status_type
+xps_read_axes( long num_motors, MX_MOTOR **motor_array )
+{
+	return test_driver_read( &xps_driver, num_motors, motor_array );
+}
+
+static MX_MOTOR_FUNCTION_LIST pmac_function_list;
+static MX_MOTOR_FUNCTION_LIST xps_function_list;
+static MX_MOTOR_FUNCTION_LIST plain_function_list;
+
+/* mx_motor_array.c only needs these motor functions from libMx.  The
+ * single motor reads cost one round trip each, like a driver's
+ * get_position() or get_status().
+ */
+
+static long num_single_reads = 0;
+
+MX_EXPORT mx_status_type
+mx_motor_get_pointers( MX_RECORD *motor_record,
+			MX_MOTOR **motor,
+			MX_MOTOR_FUNCTION_LIST **function_list_ptr,
+			const char *calling_fname )
+{
+	if ( motor_record->record_class_struct == NULL ) {
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, calling_fname,
+		"The MX_MOTOR pointer for record '%s' is NULL.",
+			motor_record->name );
+	}
+
+	*motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	*function_list_ptr = (MX_MOTOR_FUNCTION_LIST *)
+				motor_record->class_specific_function_list;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_position( MX_RECORD *motor_record, double *motor_position )
+{
+	MX_MOTOR *motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	num_single_reads++;
+
+	round_trip();
+
+	read_controller( motor );
+
+	if ( motor->subclass == MXC_MTR_STEPPER ) {
+		motor->position = motor->offset
+			+ motor->scale * (double) motor->raw_position.stepper;
+	} else {
+		motor->position = motor->offset
+			+ motor->scale * motor->raw_position.analog;
+	}
+
+	*motor_position = motor->position;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_status( MX_RECORD *motor_record, unsigned long *motor_status )
+{
+	MX_MOTOR *motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	num_single_reads++;
+
+	round_trip();
+
+	read_controller( motor );
+
+	*motor_status = motor->status;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Every fourth motor is on the XPS, every eighth motor starting from
+ * the third has no array function, and the rest are on the PMAC.
+ */
+
+static MX_MOTOR_FUNCTION_LIST *
+motor_function_list( long i )
+{
+	if ( ( i % 4 ) == 0 ) {
+		return &xps_function_list;
+	} else
+	if ( ( i % 8 ) == 3 ) {
+		return &plain_function_list;
+	} else {
+		return &pmac_function_list;
+	}
+}
+
+static void
+setup_motors( void )
+{
+	TEST_MOTOR *test_motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	long i;
+
+	pmac_function_list.get_position_array = pmac_read_axes;
+	pmac_function_list.get_status_array = pmac_read_axes;
+
+	xps_function_list.get_position_array = xps_read_axes;
+	xps_function_list.get_status_array = xps_read_axes;
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		test_motor = &test_motor_array[i];
+		function_list = motor_function_list( i );
+
+		memset( test_motor, 0, sizeof(TEST_MOTOR) );
+
+		snprintf( test_motor->record.name,
+			sizeof(test_motor->record.name), "motor%ld", i );
+
+		test_motor->record.record_class_struct = &(test_motor->motor);
+		test_motor->record.class_specific_function_list =
+							function_list;
+
+		test_motor->motor.record = &(test_motor->record);
+		test_motor->motor.scale = 0.5 + 0.25 * ( i % 3 );
+		test_motor->motor.offset = -10.0 + i;
+
+		if ( function_list == &pmac_function_list ) {
+			test_motor->motor.subclass = MXC_MTR_STEPPER;
+		} else {
+			test_motor->motor.subclass = MXC_MTR_ANALOG;
+		}
+
+		test_motor->controller_steps = 1000 * i - 7;
+		test_motor->controller_analog = 2.5 * i + 0.125;
+		test_motor->controller_status = 0x100 + i;
+
+		motor_record_array[i] = &(test_motor->record);
+	}
+}
+
+static double
+expected_position( long i )
+{
+	TEST_MOTOR *test_motor = &test_motor_array[i];
+	double raw_position;
+
+	if ( test_motor->motor.subclass == MXC_MTR_STEPPER ) {
+		raw_position = (double) test_motor->controller_steps;
+	} else {
+		raw_position = test_motor->controller_analog;
+	}
+
+	return test_motor->motor.offset
+		+ test_motor->motor.scale * raw_position;
+}
+
+static void
+reset_counters( void )
+{
+	memset( &pmac_driver, 0, sizeof(pmac_driver) );
+	memset( &xps_driver, 0, sizeof(xps_driver) );
+
+	num_single_reads = 0;
+	num_round_trips = 0;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* The motors logged by a driver must be its own, in record order. */
+
+static int
+check_driver_log( TEST_DRIVER *driver,
+		MX_MOTOR_FUNCTION_LIST *function_list )
+{
+	long i, j, num_expected;
+	int num_failures = 0;
+
+	num_expected = 0;
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		if ( motor_function_list( i ) != function_list )
+			continue;
+
+		j = num_expected++;
+
+		CHECK( j < driver->num_logged );
+
+		if ( j < driver->num_logged ) {
+			CHECK( driver->motor_log[j]
+				== &(test_motor_array[i].motor) );
+		}
+	}
+
+	CHECK( driver->num_logged == num_expected );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+static int
+check_reads( void )
+{
+	double position_array[NUM_MOTORS];
+	unsigned long status_array[NUM_MOTORS];
+	MX_RECORD *subset_array[3];
+	double subset_position[3];
+	long i, num_plain_motors;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	num_plain_motors = 0;
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		if ( motor_function_list( i ) == &plain_function_list )
+			num_plain_motors++;
+	}
+
+	/* Positions */
+
+	reset_counters();
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		position_array[i] = -1.0e30;
+	}
+
+	mx_status = mx_motor_array_get_position( NUM_MOTORS,
+					motor_record_array, position_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		CHECK( position_array[i] == expected_position( i ) );
+		CHECK( test_motor_array[i].motor.position
+						== expected_position( i ) );
+	}
+
+	CHECK( pmac_driver.num_array_calls == 1 );
+	CHECK( xps_driver.num_array_calls == 1 );
+	CHECK( num_single_reads == num_plain_motors );
+	CHECK( num_round_trips == 2 + num_plain_motors );
+
+	num_failures += check_driver_log( &pmac_driver, &pmac_function_list );
+	num_failures += check_driver_log( &xps_driver, &xps_function_list );
+
+	/* Statuses */
+
+	reset_counters();
+
+	memset( status_array, 0, sizeof(status_array) );
+
+	mx_status = mx_motor_array_get_status( NUM_MOTORS,
+					motor_record_array, status_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		CHECK( status_array[i]
+			== test_motor_array[i].controller_status );
+	}
+
+	CHECK( pmac_driver.num_array_calls == 1 );
+	CHECK( xps_driver.num_array_calls == 1 );
+	CHECK( num_single_reads == num_plain_motors );
+
+	num_failures += check_driver_log( &pmac_driver, &pmac_function_list );
+	num_failures += check_driver_log( &xps_driver, &xps_function_list );
+
+	/* A subset in a different order is still returned in order. */
+
+	reset_counters();
+
+	subset_array[0] = motor_record_array[9];
+	subset_array[1] = motor_record_array[4];
+	subset_array[2] = motor_record_array[1];
+
+	mx_status = mx_motor_array_get_position( 3, subset_array,
+						subset_position );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( subset_position[0] == expected_position( 9 ) );
+	CHECK( subset_position[1] == expected_position( 4 ) );
+	CHECK( subset_position[2] == expected_position( 1 ) );
+
+	CHECK( pmac_driver.num_array_calls == 1 );
+	CHECK( pmac_driver.num_logged == 2 );
+	CHECK( pmac_driver.motor_log[0]
+			== &(test_motor_array[9].motor) );
+	CHECK( pmac_driver.motor_log[1]
+			== &(test_motor_array[1].motor) );
+	CHECK( xps_driver.num_array_calls == 1 );
+
+	/* A driver error is returned to the caller. */
+
+	reset_counters();
+
+	xps_driver.fail = TRUE;
+
+	mx_status = mx_motor_array_get_position( NUM_MOTORS,
+					motor_record_array, position_array );
+
+	CHECK( mx_status.code == MXE_INTERFACE_IO_ERROR );
+
+	xps_driver.fail = FALSE;
+
+	/* Argument errors, and a record without an MX_MOTOR. */
+
+	mx_status = mx_motor_array_get_position( NUM_MOTORS, NULL,
+							position_array );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_motor_array_get_position( NUM_MOTORS,
+						motor_record_array, NULL );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_motor_array_get_status( NUM_MOTORS,
+						motor_record_array, NULL );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	reset_counters();
+
+	mx_status = mx_motor_array_get_position( 0,
+					motor_record_array, position_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_round_trips == 0 );
+
+	test_motor_array[5].record.record_class_struct = NULL;
+
+	mx_status = mx_motor_array_get_position( NUM_MOTORS,
+					motor_record_array, position_array );
+
+	CHECK( mx_status.code == MXE_CORRUPT_DATA_STRUCTURE );
+	CHECK( num_round_trips == 0 );
+
+	test_motor_array[5].record.record_class_struct =
+					&(test_motor_array[5].motor);
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Polls the first NUM_TIMED_MOTORS motors, which are all put on the
+ * PMAC for this, once with the array function and once one at a time.
+ */
+
+static int
+compare_polls( void )
+{
+	double position_array[NUM_TIMED_MOTORS];
+	double batch_seconds, single_seconds, sum;
+	long i, n, batch_round_trips, single_round_trips;
+	struct timespec start;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	for ( i = 0; i < NUM_TIMED_MOTORS; i++ ) {
+		test_motor_array[i].record.class_specific_function_list =
+						&pmac_function_list;
+		test_motor_array[i].motor.subclass = MXC_MTR_STEPPER;
+	}
+
+	simulate_latency = TRUE;
+
+	reset_counters();
+
+	sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( n = 0; n < NUM_TIMED_POLLS; n++ ) {
+		mx_status = mx_motor_array_get_position( NUM_TIMED_MOTORS,
+					motor_record_array, position_array );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+
+		sum += position_array[ NUM_TIMED_MOTORS - 1 ];
+	}
+
+	batch_seconds = elapsed_seconds( &start );
+	batch_round_trips = num_round_trips;
+
+	reset_counters();
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( n = 0; n < NUM_TIMED_POLLS; n++ ) {
+		for ( i = 0; i < NUM_TIMED_MOTORS; i++ ) {
+			mx_status = mx_motor_get_position(
+				motor_record_array[i], &position_array[i] );
+
+			CHECK( mx_status.code == MXE_SUCCESS );
+		}
+
+		sum += position_array[ NUM_TIMED_MOTORS - 1 ];
+	}
+
+	single_seconds = elapsed_seconds( &start );
+	single_round_trips = num_round_trips;
+
+	simulate_latency = FALSE;
+
+	CHECK( batch_round_trips == NUM_TIMED_POLLS );
+	CHECK( single_round_trips == NUM_TIMED_POLLS * NUM_TIMED_MOTORS );
+
+	printf( "Polling %d axes with a %ld us round trip (sum %g):\n",
+		NUM_TIMED_MOTORS, ROUND_TRIP_NS / 1000L, sum );
+	printf( "  mx_motor_array_get_position(): %ld round trips, "
+		"%.3f ms per poll\n",
+		batch_round_trips / NUM_TIMED_POLLS,
+		1.0e3 * batch_seconds / NUM_TIMED_POLLS );
+	printf( "  mx_motor_get_position():       %ld round trips, "
+		"%.3f ms per poll\n",
+		single_round_trips / NUM_TIMED_POLLS,
+		1.0e3 * single_seconds / NUM_TIMED_POLLS );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	setup_motors();
+
+	num_failures = check_reads();
+
+	num_failures += compare_polls();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All motor array checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
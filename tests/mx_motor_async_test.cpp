@@ -0,0 +1,795 @@
+/*
+ * Name:    mx_motor_async_test.cpp
+ *
+ * Purpose: Checks the asynchronous motor move handles in mx_motor_async.c
+ *          and the C++20 coroutine support in mx_motor_async.hpp against
+ *          simulated motors whose moves take a fixed time: completion,
+ *          continuations, wait, wait_all and wait_any, timeouts,
+ *          cancellation, motors that stop on a limit, and coroutines
+ *          that co_await one move after another.
+ *
+ *          It also runs the same sequences of moves once as coroutines
+ *          driven by a single thread and once as blocking waits, one
+ *          move at a time, and reports how long each took.  The timings
+ *          are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_clock.h"
+#include "mx_mutex.h"
+#include "mx_condition_variable.h"
+#include "mx_motor.h"
+#include "mx_motor_async.hpp"
+
+#define NUM_MOTORS		8
+#define NUM_MOVES_PER_TASK	3
+
+static double
+current_seconds( void )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return now.tv_sec + 1.0e-9 * now.tv_nsec;
+}
+
+/* Each simulated motor is busy until 'end_time'.  A motor with
+ * 'stop_on_limit' set reports a limit switch when it stops.
+ */
+
+typedef struct {
+	MX_RECORD record;
+	MX_MOTOR motor;
+	double move_time;
+	double end_time;
+	unsigned long last_flags;
+	mx_bool_type fail_to_start;
+	mx_bool_type stop_on_limit;
+	long num_moves;
+	long num_aborts;
+} TEST_MOTOR;
+
+static MX_LIST_HEAD list_head;
+static MX_RECORD list_head_record;
+static TEST_MOTOR test_motor_array[NUM_MOTORS];
+
+static MX_RECORD other_list_head_record;
+static TEST_MOTOR other_motor;
+
+/* The handles and the completion wait only need these functions from
+ * libMx.  No completion notifier is created, so every motor is polled
+ * and the mutex and condition variable functions are never called.
+ */
+
+MX_EXPORT MX_CLOCK_TICK
+mx_current_clock_tick( void )
+{
+	struct timespec now;
+	MX_CLOCK_TICK clock_tick;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	clock_tick.high_order = now.tv_sec;
+	clock_tick.low_order = now.tv_nsec;
+
+	return clock_tick;
+}
+
+MX_EXPORT MX_CLOCK_TICK
+mx_subtract_clock_ticks( MX_CLOCK_TICK clock_tick_1,
+			MX_CLOCK_TICK clock_tick_2 )
+{
+	MX_CLOCK_TICK result;
+
+	result.high_order = clock_tick_1.high_order - clock_tick_2.high_order;
+
+	if ( clock_tick_1.low_order >= clock_tick_2.low_order ) {
+		result.low_order =
+			clock_tick_1.low_order - clock_tick_2.low_order;
+	} else {
+		result.high_order--;
+		result.low_order = 1000000000UL
+			+ clock_tick_1.low_order - clock_tick_2.low_order;
+	}
+
+	return result;
+}
+
+MX_EXPORT double
+mx_convert_clock_ticks_to_seconds( MX_CLOCK_TICK clock_tick )
+{
+	return clock_tick.high_order + 1.0e-9 * clock_tick.low_order;
+}
+
+MX_EXPORT void
+mx_msleep( unsigned long milliseconds )
+{
+	struct timespec pause;
+
+	pause.tv_sec = milliseconds / 1000;
+	pause.tv_nsec = 1000000L * ( milliseconds % 1000 );
+
+	nanosleep( &pause, NULL );
+}
+
+MX_EXPORT int
+mx_user_requested_interrupt( void )
+{
+	return MXF_USER_INT_NONE;
+}
+
+MX_EXPORT int
+mx_user_requested_interrupt_or_pause( void )
+{
+	return MXF_USER_INT_NONE;
+}
+
+MX_EXPORT MX_LIST_HEAD *
+mx_get_record_list_head_struct( MX_RECORD *record )
+{
+	return (MX_LIST_HEAD *) record->list_head->record_superclass_struct;
+}
+
+MX_EXPORT mx_status_type
+mx_mutex_create( MX_MUTEX **mutex )
+{
+	static const char fname[] = "mx_mutex_create()";
+
+	MXW_UNUSED( mutex );
+
+	return mx_error( MXE_UNSUPPORTED, fname,
+		"Mutexes are not used by this test." );
+}
+
+MX_EXPORT mx_status_type
+mx_mutex_destroy( MX_MUTEX *mutex )
+{
+	MXW_UNUSED( mutex );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT long
+mx_mutex_lock( MX_MUTEX *mutex )
+{
+	MXW_UNUSED( mutex );
+
+	return MXE_UNSUPPORTED;
+}
+
+MX_EXPORT long
+mx_mutex_unlock( MX_MUTEX *mutex )
+{
+	MXW_UNUSED( mutex );
+
+	return MXE_UNSUPPORTED;
+}
+
+MX_EXPORT mx_status_type
+mx_condition_variable_create( MX_CONDITION_VARIABLE **cv )
+{
+	static const char fname[] = "mx_condition_variable_create()";
+
+	MXW_UNUSED( cv );
+
+	return mx_error( MXE_UNSUPPORTED, fname,
+		"Condition variables are not used by this test." );
+}
+
+MX_EXPORT mx_status_type
+mx_condition_variable_destroy( MX_CONDITION_VARIABLE *cv )
+{
+	MXW_UNUSED( cv );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT long
+mx_condition_variable_timed_wait( MX_CONDITION_VARIABLE *cv,
+				MX_MUTEX *mutex,
+				double max_seconds_to_wait )
+{
+	MXW_UNUSED( cv );
+	MXW_UNUSED( mutex );
+	MXW_UNUSED( max_seconds_to_wait );
+
+	return MXE_UNSUPPORTED;
+}
+
+MX_EXPORT long
+mx_condition_variable_broadcast( MX_CONDITION_VARIABLE *cv )
+{
+	MXW_UNUSED( cv );
+
+	return MXE_UNSUPPORTED;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_pointers( MX_RECORD *motor_record,
+			MX_MOTOR **motor,
+			MX_MOTOR_FUNCTION_LIST **function_list_ptr,
+			const char *calling_fname )
+{
+	MXW_UNUSED( calling_fname );
+
+	*motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	if ( function_list_ptr != (MX_MOTOR_FUNCTION_LIST **) NULL ) {
+		*function_list_ptr = NULL;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_move_absolute_with_report( MX_RECORD *motor_record,
+				double destination,
+				MX_MOTOR_MOVE_REPORT_FUNCTION report_function,
+				unsigned long flags )
+{
+	static const char fname[] = "mx_motor_move_absolute_with_report()";
+
+	TEST_MOTOR *test_motor = (TEST_MOTOR *) motor_record;
+
+	MXW_UNUSED( report_function );
+
+	test_motor->last_flags = flags;
+
+	if ( test_motor->fail_to_start ) {
+		return mx_error( MXE_INTERFACE_IO_ERROR, fname,
+		"The controller for motor '%s' did not answer.",
+			motor_record->name );
+	}
+
+	test_motor->motor.destination = destination;
+	test_motor->end_time = current_seconds() + test_motor->move_time;
+	test_motor->num_moves++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_status( MX_RECORD *motor_record, unsigned long *motor_status )
+{
+	TEST_MOTOR *test_motor = (TEST_MOTOR *) motor_record;
+
+	if ( current_seconds() < test_motor->end_time ) {
+		*motor_status = MXSF_MTR_IS_BUSY;
+	} else
+	if ( test_motor->stop_on_limit ) {
+		*motor_status = MXSF_MTR_POSITIVE_LIMIT_HIT;
+	} else {
+		test_motor->motor.position = test_motor->motor.destination;
+
+		*motor_status = 0;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_soft_abort( MX_RECORD *motor_record )
+{
+	TEST_MOTOR *test_motor = (TEST_MOTOR *) motor_record;
+
+	test_motor->end_time = current_seconds();
+	test_motor->num_aborts++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static void
+init_motor( TEST_MOTOR *test_motor, MX_RECORD *list_head_ptr, long i )
+{
+	memset( test_motor, 0, sizeof(TEST_MOTOR) );
+
+	snprintf( test_motor->record.name, sizeof(test_motor->record.name),
+							"motor%ld", i );
+
+	test_motor->record.list_head = list_head_ptr;
+	test_motor->record.record_class_struct = &(test_motor->motor);
+
+	test_motor->motor.record = &(test_motor->record);
+
+	test_motor->move_time = 0.010 + 0.002 * i;
+}
+
+static void
+setup_motors( void )
+{
+	long i;
+
+	memset( &list_head, 0, sizeof(list_head) );
+
+	list_head_record.list_head = &list_head_record;
+	list_head_record.record_superclass_struct = &list_head;
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		init_motor( &test_motor_array[i], &list_head_record, i );
+	}
+
+	other_list_head_record.list_head = &other_list_head_record;
+	other_list_head_record.record_superclass_struct = &list_head;
+
+	init_motor( &other_motor, &other_list_head_record, NUM_MOTORS );
+}
+
+static MX_RECORD *
+motor_record( long i )
+{
+	return &(test_motor_array[i].record);
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+static void
+count_continuation( MX_MOTOR_HANDLE *handle, void *args )
+{
+	MXW_UNUSED( handle );
+
+	(*(long *) args)++;
+}
+
+/*------------------------------------------------------------------------*/
+
+static int
+check_handles( MX_MOTOR_ASYNC_CONTEXT *context )
+{
+	MX_MOTOR_HANDLE *handle, *handle_array[3];
+	mx_status_type mx_status;
+	long num_calls, num_pending, index;
+	int num_failures = 0;
+
+	/* A single move, waited for. */
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(0),
+						5.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( handle->state == MXS_MOTOR_HANDLE_PENDING );
+	CHECK( test_motor_array[0].last_flags & MXF_MTR_NOWAIT );
+	CHECK( context->num_pending_handles == 1 );
+
+	mx_status = mx_motor_handle_wait( handle, -1.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( handle->state == MXS_MOTOR_HANDLE_COMPLETE );
+	CHECK( test_motor_array[0].motor.position == 5.0 );
+	CHECK( context->num_pending_handles == 0 );
+
+	/* A continuation set on a finished handle runs at once. */
+
+	num_calls = 0;
+
+	mx_status = mx_motor_handle_set_continuation( handle,
+					count_continuation, &num_calls );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_calls == 1 );
+
+	mx_motor_handle_free( handle );
+
+	/* A continuation set on a pending handle runs from
+	 * mx_motor_async_run_once().
+	 */
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(1),
+						6.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	num_calls = 0;
+
+	mx_status = mx_motor_handle_set_continuation( handle,
+					count_continuation, &num_calls );
+
+	CHECK( num_calls == 0 );
+
+	num_pending = 1;
+
+	while ( num_pending > 0 ) {
+		mx_status = mx_motor_async_run_once( context, -1.0,
+							&num_pending );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+	}
+
+	CHECK( num_calls == 1 );
+	CHECK( handle->state == MXS_MOTOR_HANDLE_COMPLETE );
+
+	mx_motor_handle_free( handle );
+
+	/* wait_any returns the shortest move, and a timeout shorter than
+	 * the moves is reported by wait_all.  The first motor is slowed
+	 * down so that it cannot finish by the first poll.
+	 */
+
+	test_motor_array[7].move_time = 0.1;
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(7),
+						1.0, 0, &handle_array[0] );
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(2),
+						2.0, 0, &handle_array[1] );
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(5),
+						3.0, 0, &handle_array[2] );
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_handle_wait_all( 3, handle_array, 0.001 );
+
+	CHECK( mx_status.code == MXE_TIMED_OUT );
+
+	mx_status = mx_motor_handle_wait_any( 3, handle_array, -1.0, &index );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( index == 1 );
+	CHECK( handle_array[1]->state == MXS_MOTOR_HANDLE_COMPLETE );
+
+	mx_status = mx_motor_handle_wait_all( 3, handle_array, -1.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( handle_array[0]->state == MXS_MOTOR_HANDLE_COMPLETE );
+	CHECK( handle_array[2]->state == MXS_MOTOR_HANDLE_COMPLETE );
+
+	mx_motor_handle_free( handle_array[0] );
+	mx_motor_handle_free( handle_array[1] );
+	mx_motor_handle_free( handle_array[2] );
+
+	test_motor_array[7].move_time = 0.010 + 0.002 * 7;
+
+	/* Cancelling aborts the motor and runs the continuation. */
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(3),
+						4.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	num_calls = 0;
+
+	(void) mx_motor_handle_set_continuation( handle,
+					count_continuation, &num_calls );
+
+	mx_status = mx_motor_handle_cancel( handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( handle->state == MXS_MOTOR_HANDLE_CANCELLED );
+	CHECK( handle->result.code == MXE_INTERRUPTED );
+	CHECK( test_motor_array[3].num_aborts == 1 );
+	CHECK( num_calls == 1 );
+	CHECK( context->num_pending_handles == 0 );
+
+	mx_status = mx_motor_handle_wait( handle, -1.0 );
+
+	CHECK( mx_status.code == MXE_INTERRUPTED );
+
+	mx_motor_handle_free( handle );
+
+	/* A motor that stops on a limit fails only its own handle. */
+
+	test_motor_array[4].stop_on_limit = TRUE;
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(4),
+						9.0, 0, &handle_array[0] );
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(6),
+						9.0, 0, &handle_array[1] );
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_handle_wait_all( 2, handle_array, -1.0 );
+
+	CHECK( mx_status.code == MXE_LIMIT_WAS_EXCEEDED );
+	CHECK( handle_array[0]->state == MXS_MOTOR_HANDLE_FAILED );
+	CHECK( handle_array[1]->state == MXS_MOTOR_HANDLE_COMPLETE );
+
+	mx_motor_handle_free( handle_array[0] );
+	mx_motor_handle_free( handle_array[1] );
+
+	test_motor_array[4].stop_on_limit = FALSE;
+
+	/* Moves that cannot start, and motors of another database. */
+
+	test_motor_array[0].fail_to_start = TRUE;
+
+	handle = NULL;
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(0),
+						1.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_INTERFACE_IO_ERROR );
+	CHECK( handle == NULL );
+	CHECK( context->num_pending_handles == 0 );
+
+	test_motor_array[0].fail_to_start = FALSE;
+
+	mx_status = mx_motor_move_absolute_async( context,
+				&(other_motor.record), 1.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(0),
+						1.0, 0, NULL );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	return num_failures;
+}
+
+/* Destroying a context cancels its pending handles. */
+
+static int
+check_context_destroy( void )
+{
+	MX_MOTOR_ASYNC_CONTEXT *context;
+	MX_MOTOR_HANDLE *handle;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	mx_status = mx_motor_async_context_create( &list_head_record,
+							&context );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(0),
+						1.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_motor_async_context_destroy( context );
+
+	CHECK( handle->state == MXS_MOTOR_HANDLE_CANCELLED );
+	CHECK( handle->result.code == MXE_INTERRUPTED );
+	CHECK( handle->context == NULL );
+
+	mx_motor_handle_free( handle );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Each task moves its motor NUM_MOVES_PER_TASK times, one move after
+ * another, and records the status of the last move.
+ */
+
+typedef struct {
+	long num_finished;
+	long num_failed;
+	long num_ready;
+} TASK_RESULTS;
+
+static mx::motor_task
+move_sequence( MX_MOTOR_ASYNC_CONTEXT *context, MX_RECORD *record,
+		TASK_RESULTS *results )
+{
+	MX_MOTOR_HANDLE *handle;
+	mx_status_type mx_status;
+	long k;
+
+	for ( k = 1; k <= NUM_MOVES_PER_TASK; k++ ) {
+		mx_status = mx_motor_move_absolute_async( context, record,
+						(double) k, 0, &handle );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			results->num_failed++;
+			co_return;
+		}
+
+		mx_status = co_await mx::await_motor( handle );
+
+		mx_motor_handle_free( handle );
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			results->num_failed++;
+			co_return;
+		}
+	}
+
+	results->num_finished++;
+}
+
+/* co_await on a handle that has already finished does not suspend. */
+
+static mx::motor_task
+await_finished( MX_MOTOR_HANDLE *handle, TASK_RESULTS *results )
+{
+	mx::motor_awaiter awaiter = mx::await_motor( handle );
+
+	if ( awaiter.await_ready() ) {
+		results->num_ready++;
+	}
+
+	mx_status_type mx_status = co_await awaiter;
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		results->num_finished++;
+	}
+}
+
+static int
+check_coroutines( MX_MOTOR_ASYNC_CONTEXT *context )
+{
+	TASK_RESULTS results;
+	MX_MOTOR_HANDLE *handle;
+	mx_status_type mx_status;
+	long i, k, num_pending;
+	double start, coroutine_seconds, blocking_seconds;
+	int num_failures = 0;
+
+	/* All of the tasks run on this thread, interleaved by the
+	 * context.
+	 */
+
+	memset( &results, 0, sizeof(results) );
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		test_motor_array[i].num_moves = 0;
+	}
+
+	start = current_seconds();
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		move_sequence( context, motor_record(i), &results );
+	}
+
+	CHECK( context->num_pending_handles == NUM_MOTORS );
+
+	num_pending = 1;
+
+	while ( num_pending > 0 ) {
+		mx_status = mx_motor_async_run_once( context, -1.0,
+							&num_pending );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+	}
+
+	coroutine_seconds = current_seconds() - start;
+
+	CHECK( results.num_finished == NUM_MOTORS );
+	CHECK( results.num_failed == 0 );
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		CHECK( test_motor_array[i].num_moves == NUM_MOVES_PER_TASK );
+		CHECK( test_motor_array[i].motor.position
+					== (double) NUM_MOVES_PER_TASK );
+	}
+
+	/* The same moves, one at a time with blocking waits. */
+
+	start = current_seconds();
+
+	for ( i = 0; i < NUM_MOTORS; i++ ) {
+		for ( k = 1; k <= NUM_MOVES_PER_TASK; k++ ) {
+			mx_status = mx_motor_move_absolute_async( context,
+				motor_record(i), (double) k, 0, &handle );
+
+			CHECK( mx_status.code == MXE_SUCCESS );
+
+			mx_status = mx_motor_handle_wait( handle, -1.0 );
+
+			CHECK( mx_status.code == MXE_SUCCESS );
+
+			mx_motor_handle_free( handle );
+		}
+	}
+
+	blocking_seconds = current_seconds() - start;
+
+	printf( "%d motors, %d moves each of 10 to %.0f ms:\n",
+		NUM_MOTORS, NUM_MOVES_PER_TASK,
+		1.0e3 * test_motor_array[NUM_MOTORS-1].move_time );
+	printf( "  coroutines on one thread: %.1f ms\n",
+		1.0e3 * coroutine_seconds );
+	printf( "  blocking, one at a time:  %.1f ms\n",
+		1.0e3 * blocking_seconds );
+
+	/* A move that fails is reported to the coroutine waiting on it. */
+
+	memset( &results, 0, sizeof(results) );
+
+	test_motor_array[2].stop_on_limit = TRUE;
+	test_motor_array[2].num_moves = 0;
+
+	move_sequence( context, motor_record(1), &results );
+	move_sequence( context, motor_record(2), &results );
+
+	num_pending = 1;
+
+	while ( num_pending > 0 ) {
+		mx_status = mx_motor_async_run_once( context, -1.0,
+							&num_pending );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+	}
+
+	CHECK( results.num_finished == 1 );
+	CHECK( results.num_failed == 1 );
+	CHECK( test_motor_array[2].num_moves == 1 );
+
+	test_motor_array[2].stop_on_limit = FALSE;
+
+	/* Awaiting a finished handle resumes at once. */
+
+	memset( &results, 0, sizeof(results) );
+
+	mx_status = mx_motor_move_absolute_async( context, motor_record(0),
+						2.0, 0, &handle );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_handle_wait( handle, -1.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	await_finished( handle, &results );
+
+	CHECK( results.num_ready == 1 );
+	CHECK( results.num_finished == 1 );
+
+	mx_motor_handle_free( handle );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	MX_MOTOR_ASYNC_CONTEXT *context;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	setup_motors();
+
+	mx_status = mx_motor_async_context_create( &list_head_record,
+							&context );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	num_failures += check_handles( context );
+	num_failures += check_coroutines( context );
+
+	mx_motor_async_context_destroy( context );
+
+	num_failures += check_context_destroy();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All motor async checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,662 @@
+/*
+ * Name:    mx_motor_cache_test.c
+ *
+ * Purpose: Checks the motor state cache in mx_motor_cache.c, first from
+ *          a single thread and then with several reader threads that
+ *          call mx_motor_get_state_snapshot() while the cache is being
+ *          refreshed and invalidated by other threads.  Every snapshot
+ *          that a reader gets must be one that the simulated controller
+ *          actually reported, and a reader must never see the state go
+ *          backwards.
+ *
+ *          It also reports how many controller queries the readers
+ *          caused with and without the cache.  The timings are only
+ *          reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_atomic.h"
+#include "mx_clock.h"
+#include "mx_mutex.h"
+#include "mx_motor.h"
+
+#define NUM_READER_THREADS	8
+
+#define QUERY_NS		20000L
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+/* The motor state cache only needs these functions from libMx.  Clock
+ * ticks are CLOCK_MONOTONIC seconds and nanoseconds, and the atomic
+ * operations and mutexes use the GCC builtins and POSIX threads.
+ */
+
+MX_EXPORT int32_t
+mx_atomic_increment32( int32_t *value_ptr )
+{
+	return __atomic_add_fetch( value_ptr, 1, __ATOMIC_SEQ_CST );
+}
+
+MX_EXPORT int32_t
+mx_atomic_read32( int32_t *value_ptr )
+{
+	return __atomic_load_n( value_ptr, __ATOMIC_SEQ_CST );
+}
+
+MX_EXPORT void
+mx_atomic_memory_barrier( void )
+{
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+}
+
+MX_EXPORT MX_CLOCK_TICK
+mx_current_clock_tick( void )
+{
+	struct timespec now;
+	MX_CLOCK_TICK clock_tick;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	clock_tick.high_order = now.tv_sec;
+	clock_tick.low_order = now.tv_nsec;
+
+	return clock_tick;
+}
+
+MX_EXPORT MX_CLOCK_TICK
+mx_convert_seconds_to_clock_ticks( double seconds )
+{
+	MX_CLOCK_TICK clock_tick;
+
+	clock_tick.high_order = (unsigned long) seconds;
+	clock_tick.low_order = (unsigned long)
+		( 1.0e9 * ( seconds - (double) clock_tick.high_order ) );
+
+	return clock_tick;
+}
+
+MX_EXPORT MX_CLOCK_TICK
+mx_add_clock_ticks( MX_CLOCK_TICK clock_tick_1, MX_CLOCK_TICK clock_tick_2 )
+{
+	MX_CLOCK_TICK result;
+
+	result.high_order = clock_tick_1.high_order + clock_tick_2.high_order;
+	result.low_order = clock_tick_1.low_order + clock_tick_2.low_order;
+
+	if ( result.low_order >= 1000000000UL ) {
+		result.high_order++;
+		result.low_order -= 1000000000UL;
+	}
+
+	return result;
+}
+
+MX_EXPORT int
+mx_compare_clock_ticks( MX_CLOCK_TICK clock_tick_1,
+			MX_CLOCK_TICK clock_tick_2 )
+{
+	if ( clock_tick_1.high_order != clock_tick_2.high_order ) {
+		return ( clock_tick_1.high_order < clock_tick_2.high_order )
+			? -1 : 1;
+	}
+
+	if ( clock_tick_1.low_order != clock_tick_2.low_order ) {
+		return ( clock_tick_1.low_order < clock_tick_2.low_order )
+			? -1 : 1;
+	}
+
+	return 0;
+}
+
+MX_EXPORT mx_status_type
+mx_mutex_create( MX_MUTEX **mutex )
+{
+	static const char fname[] = "mx_mutex_create()";
+
+	pthread_mutex_t *pthread_mutex;
+
+	*mutex = (MX_MUTEX *) calloc( 1, sizeof(MX_MUTEX) );
+
+	pthread_mutex = (pthread_mutex_t *) malloc( sizeof(pthread_mutex_t) );
+
+	if ( ( *mutex == (MX_MUTEX *) NULL )
+	  || ( pthread_mutex == (pthread_mutex_t *) NULL ) )
+	{
+		mx_free( *mutex );
+		mx_free( pthread_mutex );
+
+		return mx_error( MXE_OUT_OF_MEMORY, fname,
+		"Ran out of memory trying to allocate a mutex." );
+	}
+
+	pthread_mutex_init( pthread_mutex, NULL );
+
+	(*mutex)->mutex_ptr = pthread_mutex;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_mutex_destroy( MX_MUTEX *mutex )
+{
+	pthread_mutex_destroy( (pthread_mutex_t *) mutex->mutex_ptr );
+
+	free( mutex->mutex_ptr );
+	free( mutex );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT long
+mx_mutex_lock( MX_MUTEX *mutex )
+{
+	if ( pthread_mutex_lock( (pthread_mutex_t *) mutex->mutex_ptr ) != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_mutex_unlock( MX_MUTEX *mutex )
+{
+	if ( pthread_mutex_unlock( (pthread_mutex_t *) mutex->mutex_ptr ) != 0 )
+		return MXE_OPERATING_SYSTEM_ERROR;
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT long
+mx_mutex_trylock( MX_MUTEX *mutex )
+{
+	if ( pthread_mutex_trylock( (pthread_mutex_t *) mutex->mutex_ptr )
+		!= 0 )
+	{
+		return MXE_NOT_AVAILABLE;
+	}
+
+	return MXE_SUCCESS;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_pointers( MX_RECORD *motor_record,
+			MX_MOTOR **motor,
+			MX_MOTOR_FUNCTION_LIST **function_list_ptr,
+			const char *calling_fname )
+{
+	if ( motor_record == (MX_RECORD *) NULL ) {
+		return mx_error( MXE_NULL_ARGUMENT, calling_fname,
+		"The motor record pointer passed was NULL." );
+	}
+
+	*motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	*function_list_ptr = NULL;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* Query number n of the simulated controller reports position n, busy
+ * for odd n, and an extended status string built from both, so that a
+ * snapshot mixing two queries can be recognized.  Each query takes
+ * QUERY_NS.
+ */
+
+static int32_t num_queries = 0;
+
+static mx_bool_type simulate_latency = FALSE;
+
+static void
+format_extended_status( char *buffer, size_t buffer_length,
+			long n, unsigned long status )
+{
+	snprintf( buffer, buffer_length, "%ld %lx", n, status );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_get_extended_status( MX_RECORD *motor_record,
+				double *motor_position,
+				unsigned long *motor_status )
+{
+	MX_MOTOR *motor = (MX_MOTOR *) motor_record->record_class_struct;
+	struct timespec start;
+	long n;
+
+	n = mx_atomic_increment32( &num_queries );
+
+	if ( simulate_latency ) {
+		clock_gettime( CLOCK_MONOTONIC, &start );
+
+		while ( elapsed_seconds( &start ) < 1.0e-9 * QUERY_NS )
+			;
+	}
+
+	motor->position = (double) n;
+	motor->status = ( (unsigned long) n << 4 ) | ( n & MXSF_MTR_IS_BUSY );
+
+	format_extended_status( motor->extended_status,
+			sizeof(motor->extended_status), n, motor->status );
+
+	*motor_position = motor->position;
+	*motor_status = motor->status;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static MX_RECORD motor_record;
+static MX_MOTOR motor;
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* Returns the query number of a snapshot, or -1 if the parts of the
+ * snapshot came from different queries.
+ */
+
+static long
+snapshot_query( MX_MOTOR_STATE_SNAPSHOT *snapshot )
+{
+	char expected_status[ MXU_EXTENDED_STATUS_STRING_LENGTH + 1 ];
+	long n;
+
+	n = (long) snapshot->position;
+
+	if ( ( (double) n != snapshot->position ) || ( n <= 0 ) )
+		return -1;
+
+	if ( snapshot->status
+	    != ( ( (unsigned long) n << 4 ) | ( n & MXSF_MTR_IS_BUSY ) ) )
+	{
+		return -1;
+	}
+
+	if ( snapshot->busy != ( ( n & MXSF_MTR_IS_BUSY ) ? TRUE : FALSE ) )
+		return -1;
+
+	format_extended_status( expected_status, sizeof(expected_status),
+					n, snapshot->status );
+
+	if ( strcmp( snapshot->extended_status, expected_status ) != 0 )
+		return -1;
+
+	return n;
+}
+
+/*------------------------------------------------------------------------*/
+
+static int
+check_single_thread( void )
+{
+	MX_MOTOR_STATE_SNAPSHOT snapshot;
+	unsigned long num_hits, num_misses;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	/* Without a cache, every snapshot queries the motor. */
+
+	num_queries = 0;
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( snapshot_query( &snapshot ) == 1 );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( snapshot_query( &snapshot ) == 2 );
+	CHECK( snapshot.busy == FALSE );
+
+	mx_status = mx_motor_get_state_cache_statistics( &motor_record,
+						&num_hits, &num_misses );
+
+	CHECK( mx_status.code == MXE_NOT_AVAILABLE );
+
+	/* With a cache, the motor is read once per time to live. */
+
+	mx_status = mx_motor_enable_state_cache( &motor_record, -1.0 );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+	CHECK( motor.state_cache == NULL );
+
+	mx_status = mx_motor_enable_state_cache( &motor_record, 60.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( motor.state_cache != NULL );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( snapshot_query( &snapshot ) == 3 );
+	CHECK( snapshot.busy == TRUE );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( snapshot_query( &snapshot ) == 3 );
+	CHECK( num_queries == 3 );
+
+	mx_status = mx_motor_get_state_cache_statistics( &motor_record,
+						&num_hits, &num_misses );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_hits == 1 );
+	CHECK( num_misses == 1 );
+
+	/* Invalidating the cache makes the next reader query the motor. */
+
+	mx_motor_invalidate_state_cache( &motor_record );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( snapshot_query( &snapshot ) == 4 );
+
+	/* Enabling the cache again changes the time to live and discards
+	 * the snapshot.  With a time to live of zero, every read queries.
+	 */
+
+	mx_status = mx_motor_enable_state_cache( &motor_record, 0.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( snapshot_query( &snapshot ) == 5 );
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, &snapshot );
+
+	CHECK( snapshot_query( &snapshot ) == 6 );
+
+	/* Errors. */
+
+	mx_status = mx_motor_get_state_snapshot( &motor_record, NULL );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_motor_get_state_snapshot( NULL, &snapshot );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_motor_disable_state_cache( &motor_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( motor.state_cache == NULL );
+
+	mx_status = mx_motor_disable_state_cache( &motor_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+static int stop_threads = 0;
+
+typedef struct {
+	long num_reads;
+	long num_torn;
+	long num_backwards;
+	long num_errors;
+} READER_RESULT;
+
+static void *
+reader_thread( void *argument )
+{
+	READER_RESULT *result = (READER_RESULT *) argument;
+	MX_MOTOR_STATE_SNAPSHOT snapshot;
+	mx_status_type mx_status;
+	long n, last_n;
+
+	last_n = 0;
+
+	while ( __atomic_load_n( &stop_threads, __ATOMIC_SEQ_CST ) == 0 ) {
+		mx_status = mx_motor_get_state_snapshot( &motor_record,
+								&snapshot );
+
+		result->num_reads++;
+
+		if ( mx_status.code != MXE_SUCCESS ) {
+			result->num_errors++;
+			continue;
+		}
+
+		n = snapshot_query( &snapshot );
+
+		if ( n < 0 ) {
+			result->num_torn++;
+		} else
+		if ( n < last_n ) {
+			result->num_backwards++;
+		} else {
+			last_n = n;
+		}
+	}
+
+	return NULL;
+}
+
+/* The writer discards the snapshot over and over, so that readers are
+ * constantly copying snapshots while the sequence number changes.
+ */
+
+static void *
+invalidate_thread( void *argument )
+{
+	long *num_invalidations = (long *) argument;
+
+	while ( __atomic_load_n( &stop_threads, __ATOMIC_SEQ_CST ) == 0 ) {
+		mx_motor_invalidate_state_cache( &motor_record );
+
+		(*num_invalidations)++;
+	}
+
+	return NULL;
+}
+
+/* Runs the reader threads, and the invalidating writer if asked, for
+ * 'run_seconds'.  Without a cache the readers query the motor at the
+ * same time, so their snapshots are only checked if 'check_snapshots'
+ * is set.  Returns the number of failed checks.
+ */
+
+static int
+run_threads( double run_seconds, mx_bool_type invalidate,
+		mx_bool_type check_snapshots,
+		long *num_reads, long *num_invalidations )
+{
+	pthread_t reader_id[ NUM_READER_THREADS ];
+	pthread_t writer_id;
+	READER_RESULT result[ NUM_READER_THREADS ];
+	struct timespec start, pause;
+	long i;
+	int num_failures = 0;
+
+	memset( result, 0, sizeof(result) );
+
+	*num_reads = 0;
+	*num_invalidations = 0;
+
+	__atomic_store_n( &stop_threads, 0, __ATOMIC_SEQ_CST );
+
+	for ( i = 0; i < NUM_READER_THREADS; i++ ) {
+		CHECK( pthread_create( &reader_id[i], NULL,
+					reader_thread, &result[i] ) == 0 );
+	}
+
+	if ( invalidate ) {
+		CHECK( pthread_create( &writer_id, NULL,
+				invalidate_thread, num_invalidations ) == 0 );
+	}
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	pause.tv_sec = 0;
+	pause.tv_nsec = 10000000L;
+
+	while ( elapsed_seconds( &start ) < run_seconds ) {
+		nanosleep( &pause, NULL );
+	}
+
+	__atomic_store_n( &stop_threads, 1, __ATOMIC_SEQ_CST );
+
+	for ( i = 0; i < NUM_READER_THREADS; i++ ) {
+		pthread_join( reader_id[i], NULL );
+
+		CHECK( result[i].num_reads > 0 );
+		CHECK( result[i].num_errors == 0 );
+
+		if ( check_snapshots ) {
+			CHECK( result[i].num_torn == 0 );
+			CHECK( result[i].num_backwards == 0 );
+		}
+
+		*num_reads += result[i].num_reads;
+	}
+
+	if ( invalidate ) {
+		pthread_join( writer_id, NULL );
+	}
+
+	return num_failures;
+}
+
+static int
+check_threads( void )
+{
+	unsigned long num_hits, num_misses;
+	long num_reads, num_invalidations;
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	/* A time to live of zero with a writer that keeps invalidating
+	 * the cache puts the most pressure on the sequence lock.
+	 */
+
+	num_queries = 0;
+
+	mx_status = mx_motor_enable_state_cache( &motor_record, 0.0 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	num_failures += run_threads( 0.5, TRUE, TRUE,
+				&num_reads, &num_invalidations );
+
+	printf( "Seqlock stress, %d readers and 1 writer for 0.5 s:\n",
+		NUM_READER_THREADS );
+	printf( "  %ld snapshots, %ld invalidations, %ld queries, "
+		"no torn snapshots\n",
+		num_reads, num_invalidations, (long) num_queries );
+
+	CHECK( num_invalidations > 0 );
+
+	mx_status = mx_motor_disable_state_cache( &motor_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	/* With a 50 ms time to live and a slow controller, the readers
+	 * share a few queries.
+	 */
+
+	simulate_latency = TRUE;
+
+	num_queries = 0;
+
+	mx_status = mx_motor_enable_state_cache( &motor_record, 0.05 );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	num_failures += run_threads( 0.5, FALSE, TRUE,
+				&num_reads, &num_invalidations );
+
+	mx_status = mx_motor_get_state_cache_statistics( &motor_record,
+						&num_hits, &num_misses );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_queries <= 15 );
+
+	printf( "%d readers for 0.5 s, 50 ms time to live, %ld us query:\n",
+		NUM_READER_THREADS, QUERY_NS / 1000L );
+	printf( "  with cache:    %ld snapshots, %ld queries "
+		"(%lu hits, %lu misses)\n",
+		num_reads, (long) num_queries, num_hits, num_misses );
+
+	mx_status = mx_motor_disable_state_cache( &motor_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	/* Without the cache every snapshot is a query. */
+
+	num_queries = 0;
+
+	num_failures += run_threads( 0.5, FALSE, FALSE,
+				&num_reads, &num_invalidations );
+
+	printf( "  without cache: %ld snapshots, %ld queries\n",
+		num_reads, (long) num_queries );
+
+	simulate_latency = FALSE;
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	snprintf( motor_record.name, sizeof(motor_record.name), "theta" );
+
+	motor_record.record_class_struct = &motor;
+	motor.record = &motor_record;
+
+	num_failures = check_single_thread();
+
+	num_failures += check_threads();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All motor state cache checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
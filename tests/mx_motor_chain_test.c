@@ -0,0 +1,766 @@
+/*
+ * Name:    mx_motor_chain_test.c
+ *
+ * Purpose: Checks that mx_motor_compile_position_chain() flattens a stack
+ *          of energy -> theta -> two theta -> detector height
+ *          pseudomotors into a position chain, that the chain converts
+ *          positions in both directions the same way as the stack
+ *          itself, that it picks up scale and offset changes without a
+ *          recompile, and that stacks it cannot flatten fall back to the
+ *          recursive functions or are reported as errors.
+ *
+ *          It also times the chain against the recursive conversion,
+ *          which goes through the motor API at every level.  The
+ *          timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+#define NUM_POSITIONS		100000
+
+#define MAX_RELATIVE_ERROR	1.0e-12
+#define MAX_ROUND_TRIP_ERROR	1.0e-9
+
+#define HC_KEV_ANGSTROMS	12.398419843320026
+#define SI_111_D_SPACING	3.1356
+
+#define DETECTOR_DISTANCE	250.0
+
+/* A test motor either has a position transform, is a pseudomotor at the
+ * bottom of the stack that only its driver can convert ('opaque'), or
+ * is a real motor.
+ */
+
+typedef struct {
+	MX_RECORD record;
+	MX_MOTOR motor;
+	MX_MOTOR_FUNCTION_LIST function_list;
+
+	MX_RECORD *dependent_record;
+	MX_MOTOR_TRANSFORM_FUNCTION dependent_from_raw;
+	MX_MOTOR_TRANSFORM_FUNCTION raw_from_dependent;
+	void *transform_args;
+
+	mx_bool_type opaque;
+	mx_bool_type fail_transform;
+} TEST_MOTOR;
+
+#define ENERGY		0
+#define THETA		1
+#define TWO_THETA	2
+#define HEIGHT		3
+
+#define NUM_TEST_MOTORS	4
+
+static TEST_MOTOR test_motor_array[NUM_TEST_MOTORS];
+
+static double two_theta_factor = 2.0;
+static double detector_distance = DETECTOR_DISTANCE;
+
+static double height_shift = 0.0;
+
+static long num_recursive_calls = 0;
+
+/*------------------------------------------------------------------------*/
+
+/* The transforms of the stack. */
+
+static double
+theta_from_energy( double energy, void *args )
+{
+	MXW_UNUSED( args );
+
+	return asin( HC_KEV_ANGSTROMS / ( 2.0 * SI_111_D_SPACING * energy ) )
+		* 180.0 / M_PI;
+}
+
+static double
+energy_from_theta( double theta, void *args )
+{
+	MXW_UNUSED( args );
+
+	return HC_KEV_ANGSTROMS
+		/ ( 2.0 * SI_111_D_SPACING * sin( theta * M_PI / 180.0 ) );
+}
+
+static double
+two_theta_from_theta( double theta, void *args )
+{
+	return *(double *) args * theta;
+}
+
+static double
+theta_from_two_theta( double two_theta, void *args )
+{
+	return two_theta / *(double *) args;
+}
+
+static double
+height_from_two_theta( double two_theta, void *args )
+{
+	return *(double *) args * tan( two_theta * M_PI / 180.0 );
+}
+
+static double
+two_theta_from_height( double height, void *args )
+{
+	return atan( height / *(double *) args ) * 180.0 / M_PI;
+}
+
+static double
+shift_up( double position, void *args )
+{
+	MXW_UNUSED( args );
+
+	return position + 100.0;
+}
+
+static double
+shift_down( double position, void *args )
+{
+	MXW_UNUSED( args );
+
+	return position - 100.0;
+}
+
+static mx_status_type
+test_get_position_transform( MX_MOTOR *motor,
+			MX_MOTOR_POSITION_TRANSFORM *transform )
+{
+	static const char fname[] = "test_get_position_transform()";
+
+	TEST_MOTOR *test_motor = (TEST_MOTOR *) motor->record;
+
+	if ( test_motor->fail_transform ) {
+		return mx_error( MXE_NOT_READY, fname,
+		"Motor '%s' is not ready.", motor->record->name );
+	}
+
+	transform->dependent_motor_record = test_motor->dependent_record;
+	transform->dependent_from_raw_pseudomotor =
+					test_motor->dependent_from_raw;
+	transform->raw_pseudomotor_from_dependent =
+					test_motor->raw_from_dependent;
+	transform->transform_args = test_motor->transform_args;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* The position chain only needs these motor functions from libMx.  The
+ * recursive conversions work like the ones in mx_motor.c: one call into
+ * the motor API, and one driver call, for every level of the stack.
+ */
+
+MX_EXPORT mx_status_type
+mx_motor_get_pointers( MX_RECORD *motor_record,
+			MX_MOTOR **motor,
+			MX_MOTOR_FUNCTION_LIST **function_list_ptr,
+			const char *calling_fname )
+{
+	if ( ( motor_record == (MX_RECORD *) NULL )
+	  || ( motor_record->record_class_struct == NULL ) )
+	{
+		return mx_error( MXE_CORRUPT_DATA_STRUCTURE, calling_fname,
+		"The MX_MOTOR pointer for a motor record is NULL." );
+	}
+
+	*motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	*function_list_ptr = (MX_MOTOR_FUNCTION_LIST *)
+				motor_record->class_specific_function_list;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_motor_compute_real_position_from_pseudomotor_position(
+				MX_RECORD *motor_record,
+				double pseudomotor_position,
+				double *real_position,
+				int recursion_flag )
+{
+	static const char fname[] =
+	    "mx_motor_compute_real_position_from_pseudomotor_position()";
+
+	TEST_MOTOR *test_motor;
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	double dependent_position;
+	mx_status_type mx_status;
+
+	num_recursive_calls++;
+
+	mx_status = mx_motor_get_pointers( motor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( ( motor->motor_flags & MXF_MTR_IS_PSEUDOMOTOR ) == 0 ) {
+		*real_position = pseudomotor_position;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	test_motor = (TEST_MOTOR *) motor_record;
+
+	dependent_position = ( *(test_motor->dependent_from_raw) )(
+		( pseudomotor_position - motor->offset ) / motor->scale,
+		test_motor->transform_args );
+
+	if ( ( recursion_flag == FALSE ) || test_motor->opaque ) {
+		*real_position = dependent_position;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	return mx_motor_compute_real_position_from_pseudomotor_position(
+			test_motor->dependent_record, dependent_position,
+			real_position, recursion_flag );
+}
+
+MX_EXPORT mx_status_type
+mx_motor_compute_pseudomotor_position_from_real_position(
+				MX_RECORD *motor_record,
+				double real_position,
+				double *pseudomotor_position,
+				int recursion_flag )
+{
+	static const char fname[] =
+	    "mx_motor_compute_pseudomotor_position_from_real_position()";
+
+	TEST_MOTOR *test_motor;
+	MX_MOTOR *motor;
+	MX_MOTOR_FUNCTION_LIST *function_list;
+	double dependent_position;
+	mx_status_type mx_status;
+
+	num_recursive_calls++;
+
+	mx_status = mx_motor_get_pointers( motor_record, &motor,
+						&function_list, fname );
+
+	if ( mx_status.code != MXE_SUCCESS )
+		return mx_status;
+
+	if ( ( motor->motor_flags & MXF_MTR_IS_PSEUDOMOTOR ) == 0 ) {
+		*pseudomotor_position = real_position;
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	test_motor = (TEST_MOTOR *) motor_record;
+
+	if ( recursion_flag && ( test_motor->opaque == FALSE ) ) {
+		mx_status =
+		    mx_motor_compute_pseudomotor_position_from_real_position(
+				test_motor->dependent_record, real_position,
+				&dependent_position, recursion_flag );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	} else {
+		dependent_position = real_position;
+	}
+
+	*pseudomotor_position = motor->offset + motor->scale
+		* ( *(test_motor->raw_from_dependent) )( dependent_position,
+					test_motor->transform_args );
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+static void
+init_motor( long i, const char *name, long dependent,
+		MX_MOTOR_TRANSFORM_FUNCTION dependent_from_raw,
+		MX_MOTOR_TRANSFORM_FUNCTION raw_from_dependent,
+		void *transform_args,
+		double scale, double offset )
+{
+	TEST_MOTOR *test_motor = &test_motor_array[i];
+
+	memset( test_motor, 0, sizeof(TEST_MOTOR) );
+
+	snprintf( test_motor->record.name, sizeof(test_motor->record.name),
+							"%s", name );
+
+	test_motor->record.record_class_struct = &(test_motor->motor);
+	test_motor->record.class_specific_function_list =
+					&(test_motor->function_list);
+
+	test_motor->motor.record = &(test_motor->record);
+	test_motor->motor.scale = scale;
+	test_motor->motor.offset = offset;
+
+	if ( dependent >= 0 ) {
+		test_motor->dependent_record =
+				&(test_motor_array[dependent].record);
+
+		test_motor->dependent_from_raw = dependent_from_raw;
+		test_motor->raw_from_dependent = raw_from_dependent;
+		test_motor->transform_args = transform_args;
+
+		test_motor->motor.motor_flags = MXF_MTR_IS_PSEUDOMOTOR;
+
+		test_motor->function_list.get_position_transform =
+					test_get_position_transform;
+	}
+}
+
+static void
+setup_stack( void )
+{
+	init_motor( ENERGY, "energy", THETA,
+			theta_from_energy, energy_from_theta, NULL,
+			1.0, 0.0 );
+
+	init_motor( THETA, "theta", TWO_THETA,
+			two_theta_from_theta, theta_from_two_theta,
+			&two_theta_factor, 1.0, 0.01 );
+
+	init_motor( TWO_THETA, "two_theta", HEIGHT,
+			height_from_two_theta, two_theta_from_height,
+			&detector_distance, -1.0, 0.5 );
+
+	init_motor( HEIGHT, "height", -1, NULL, NULL, NULL, 1.0, 0.0 );
+}
+
+static MX_RECORD *
+record_of( long i )
+{
+	return &(test_motor_array[i].record);
+}
+
+/* The real position for an energy, written out level by level. */
+
+static double
+expected_height( double energy )
+{
+	MX_MOTOR *energy_motor = &(test_motor_array[ENERGY].motor);
+	MX_MOTOR *theta_motor = &(test_motor_array[THETA].motor);
+	MX_MOTOR *two_theta_motor = &(test_motor_array[TWO_THETA].motor);
+	double theta, two_theta;
+
+	theta = theta_from_energy(
+		( energy - energy_motor->offset ) / energy_motor->scale, NULL );
+
+	two_theta = two_theta_factor
+		* ( theta - theta_motor->offset ) / theta_motor->scale;
+
+	return height_shift + detector_distance * tan( M_PI / 180.0
+		* ( two_theta - two_theta_motor->offset )
+			/ two_theta_motor->scale );
+}
+
+/* Heights pass through zero, so errors near zero are taken relative
+ * to 1 mm instead of to the height itself.
+ */
+
+static double
+relative_error( double value, double reference )
+{
+	if ( fabs( reference ) < 1.0 )
+		return fabs( value - reference );
+
+	return fabs( ( value - reference ) / reference );
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/*------------------------------------------------------------------------*/
+
+static double energy_array[NUM_POSITIONS];
+static double height_array[NUM_POSITIONS];
+static double round_trip_array[NUM_POSITIONS];
+
+static void
+fill_energies( void )
+{
+	long n;
+
+	/* 5 to 25 keV. */
+
+	for ( n = 0; n < NUM_POSITIONS; n++ ) {
+		energy_array[n] = 5.0 + 20.0 * n / ( NUM_POSITIONS - 1 );
+	}
+}
+
+/* Returns the number of positions that do not match the stack. */
+
+static long
+count_bad_positions( void )
+{
+	long n, num_bad;
+
+	num_bad = 0;
+
+	for ( n = 0; n < NUM_POSITIONS; n++ ) {
+		if ( relative_error( height_array[n],
+			expected_height( energy_array[n] ) )
+				> MAX_RELATIVE_ERROR )
+		{
+			num_bad++;
+		}
+		else
+		if ( relative_error( round_trip_array[n], energy_array[n] )
+				> MAX_ROUND_TRIP_ERROR )
+		{
+			num_bad++;
+		}
+	}
+
+	return num_bad;
+}
+
+static int
+check_chain( void )
+{
+	MX_MOTOR_POSITION_CHAIN *chain;
+	double position;
+	mx_status_type mx_status;
+	long n;
+	int num_failures = 0;
+
+	setup_stack();
+	fill_energies();
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	chain = (MX_MOTOR_POSITION_CHAIN *)
+			test_motor_array[ENERGY].motor.position_chain;
+
+	CHECK( chain != NULL );
+
+	if ( chain == NULL )
+		return num_failures;
+
+	CHECK( chain->num_stages == 3 );
+	CHECK( chain->pseudomotor_record == record_of(ENERGY) );
+	CHECK( chain->real_motor_record == record_of(HEIGHT) );
+	CHECK( chain->stage_array[0].motor
+				== &(test_motor_array[ENERGY].motor) );
+	CHECK( chain->stage_array[2].motor
+				== &(test_motor_array[TWO_THETA].motor) );
+
+	/* Both directions through the chain. */
+
+	num_recursive_calls = 0;
+
+	mx_status = mx_motor_chain_compute_real_positions( record_of(ENERGY),
+				NUM_POSITIONS, energy_array, height_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_chain_compute_pseudomotor_positions(
+				record_of(ENERGY), NUM_POSITIONS,
+				height_array, round_trip_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_recursive_calls == 0 );
+	CHECK( count_bad_positions() == 0 );
+
+	/* The chain agrees with the recursive conversion. */
+
+	for ( n = 0; n < NUM_POSITIONS; n += 997 ) {
+		mx_status =
+		    mx_motor_compute_real_position_from_pseudomotor_position(
+				record_of(ENERGY), energy_array[n],
+				&position, TRUE );
+
+		CHECK( mx_status.code == MXE_SUCCESS );
+		CHECK( relative_error( height_array[n], position )
+						<= MAX_RELATIVE_ERROR );
+	}
+
+	/* Scale and offset changes are used without a recompile. */
+
+	test_motor_array[THETA].motor.offset = -0.02;
+	test_motor_array[TWO_THETA].motor.scale = 1.25;
+
+	mx_status = mx_motor_chain_compute_real_positions( record_of(ENERGY),
+				NUM_POSITIONS, energy_array, height_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	mx_status = mx_motor_chain_compute_pseudomotor_positions(
+				record_of(ENERGY), NUM_POSITIONS,
+				height_array, round_trip_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( count_bad_positions() == 0 );
+
+	/* The conversions may be done in place. */
+
+	memcpy( height_array, energy_array, sizeof(height_array) );
+
+	mx_motor_position_chain_real_from_pseudo( chain, NUM_POSITIONS,
+					height_array, height_array );
+
+	memcpy( round_trip_array, height_array, sizeof(round_trip_array) );
+
+	mx_motor_position_chain_pseudo_from_real( chain, NUM_POSITIONS,
+					round_trip_array, round_trip_array );
+
+	CHECK( count_bad_positions() == 0 );
+
+	/* Compiling again replaces the chain. */
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( test_motor_array[ENERGY].motor.position_chain != NULL );
+
+	/* A stack that starts further down has fewer stages. */
+
+	mx_status = mx_motor_compile_position_chain( record_of(THETA) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	chain = (MX_MOTOR_POSITION_CHAIN *)
+			test_motor_array[THETA].motor.position_chain;
+
+	CHECK( chain != NULL );
+	CHECK( ( chain != NULL ) && ( chain->num_stages == 2 ) );
+
+	mx_motor_free_position_chain( record_of(THETA) );
+
+	CHECK( test_motor_array[THETA].motor.position_chain == NULL );
+
+	/* A real motor has no chain. */
+
+	mx_status = mx_motor_compile_position_chain( record_of(HEIGHT) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( test_motor_array[HEIGHT].motor.position_chain == NULL );
+
+	mx_motor_free_position_chain( record_of(ENERGY) );
+
+	return num_failures;
+}
+
+/* Stacks that cannot be flattened. */
+
+static int
+check_unflattened_stacks( void )
+{
+	mx_status_type mx_status;
+	int num_failures = 0;
+
+	/* A pseudomotor at the bottom that only its driver can convert
+	 * leaves the stack to the recursive functions.
+	 */
+
+	setup_stack();
+	fill_energies();
+
+	test_motor_array[HEIGHT].motor.motor_flags = MXF_MTR_IS_PSEUDOMOTOR;
+	test_motor_array[HEIGHT].opaque = TRUE;
+	test_motor_array[HEIGHT].dependent_from_raw = shift_up;
+	test_motor_array[HEIGHT].raw_from_dependent = shift_down;
+
+	height_shift = 100.0;
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( test_motor_array[ENERGY].motor.position_chain == NULL );
+
+	num_recursive_calls = 0;
+
+	mx_status = mx_motor_chain_compute_real_positions( record_of(ENERGY),
+				NUM_POSITIONS, energy_array, height_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_recursive_calls == 4L * NUM_POSITIONS );
+
+	mx_status = mx_motor_chain_compute_pseudomotor_positions(
+				record_of(ENERGY), NUM_POSITIONS,
+				height_array, round_trip_array );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( count_bad_positions() == 0 );
+
+	height_shift = 0.0;
+
+	/* A loop in the stack. */
+
+	setup_stack();
+
+	test_motor_array[TWO_THETA].dependent_record = record_of(ENERGY);
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_WOULD_EXCEED_LIMIT );
+	CHECK( test_motor_array[ENERGY].motor.position_chain == NULL );
+
+	/* A transform without an inverse. */
+
+	setup_stack();
+
+	test_motor_array[THETA].raw_from_dependent = NULL;
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_CORRUPT_DATA_STRUCTURE );
+	CHECK( test_motor_array[ENERGY].motor.position_chain == NULL );
+
+	/* A driver that cannot describe its transform. */
+
+	setup_stack();
+
+	test_motor_array[TWO_THETA].fail_transform = TRUE;
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_NOT_READY );
+	CHECK( test_motor_array[ENERGY].motor.position_chain == NULL );
+
+	/* A dependent motor that is missing its MX_MOTOR. */
+
+	setup_stack();
+
+	test_motor_array[HEIGHT].record.record_class_struct = NULL;
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_CORRUPT_DATA_STRUCTURE );
+	CHECK( test_motor_array[ENERGY].motor.position_chain == NULL );
+
+	/* NULL arrays. */
+
+	setup_stack();
+
+	mx_status = mx_motor_chain_compute_real_positions( record_of(ENERGY),
+				NUM_POSITIONS, NULL, height_array );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	mx_status = mx_motor_chain_compute_pseudomotor_positions(
+			record_of(ENERGY), NUM_POSITIONS, height_array, NULL );
+
+	CHECK( mx_status.code == MXE_NULL_ARGUMENT );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+static int
+compare_conversions( void )
+{
+	struct timespec start;
+	double chain_seconds, recursive_seconds, sum;
+	mx_status_type mx_status;
+	long n;
+	int num_failures = 0;
+
+	setup_stack();
+	fill_energies();
+
+	mx_status = mx_motor_compile_position_chain( record_of(ENERGY) );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	mx_status = mx_motor_chain_compute_real_positions( record_of(ENERGY),
+				NUM_POSITIONS, energy_array, height_array );
+
+	chain_seconds = elapsed_seconds( &start );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	sum = height_array[ NUM_POSITIONS - 1 ];
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( n = 0; n < NUM_POSITIONS; n++ ) {
+		mx_status =
+		    mx_motor_compute_real_position_from_pseudomotor_position(
+				record_of(ENERGY), energy_array[n],
+				&round_trip_array[n], TRUE );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			break;
+	}
+
+	recursive_seconds = elapsed_seconds( &start );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+
+	sum += round_trip_array[ NUM_POSITIONS - 1 ];
+
+	printf( "Energy to height through 3 pseudomotors (sum %g):\n", sum );
+	printf( "  position chain: %.1f ns per position\n",
+		1.0e9 * chain_seconds / NUM_POSITIONS );
+	printf( "  recursive:      %.1f ns per position\n",
+		1.0e9 * recursive_seconds / NUM_POSITIONS );
+
+	mx_motor_free_position_chain( record_of(ENERGY) );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = check_chain();
+	num_failures += check_unflattened_stacks();
+	num_failures += compare_conversions();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All position chain checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+/*
+ * Name:    mx_motor_estimate_test.c
+ *
+ * Purpose: Checks the batch S-curve move duration estimates made by
+ *          mx_motor_estimate_move_durations() against the scalar
+ *          reference mx_motor_estimate_move_duration().
+ *
+ *          Both orderings of the two S-curve regime boundaries are
+ *          covered: profiles where the acceleration saturates before
+ *          full speed is reached, and profiles where full speed is
+ *          reached first.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_motor.h"
+
+#define NUM_MOVES		1000
+#define MAX_RELATIVE_ERROR	1.0e-9
+
+/* The test links against mx_motor_estimate.c and mx_test_stubs.c,
+ * so it provides the one motor function that mx_motor_estimate.c calls.
+ */
+
+MX_EXPORT mx_status_type
+mx_motor_get_pointers( MX_RECORD *motor_record,
+			MX_MOTOR **motor,
+			MX_MOTOR_FUNCTION_LIST **function_list_ptr,
+			const char *calling_fname )
+{
+	MXW_UNUSED( calling_fname );
+
+	*motor = (MX_MOTOR *) motor_record->record_class_struct;
+
+	if ( function_list_ptr != (MX_MOTOR_FUNCTION_LIST **) NULL ) {
+		*function_list_ptr = NULL;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static double position_array[NUM_MOVES];
+static double duration_array[NUM_MOVES];
+
+/* Builds an S-curve profile with the given speed, base speed,
+ * acceleration and jerk, and then compares the two estimates over
+ * moves from far below to well above both regime boundaries.
+ * Returns the number of moves that disagree.
+ */
+
+static int
+check_s_curve_profile( double speed, double base_speed,
+			double acceleration, double jerk )
+{
+	MX_RECORD record;
+	MX_MOTOR motor;
+	MX_MOTOR_MOVE_PROFILE profile;
+	double a_over_j, full_distance, saturated_distance, longest_move;
+	double position, reference, error, total_duration;
+	int i, num_failures;
+	mx_status_type mx_status;
+
+	memset( &record, 0, sizeof(record) );
+	memset( &motor, 0, sizeof(motor) );
+
+	snprintf( record.name, sizeof(record.name), "test_motor" );
+
+	record.record_class_struct = &motor;
+	motor.record = &record;
+
+	motor.speed = speed;
+	motor.base_speed = base_speed;
+	motor.scale = 1.0;
+	motor.acceleration_type = MXF_MTR_ACCEL_S_CURVE;
+	motor.raw_acceleration_parameters[0] = acceleration;
+	motor.raw_acceleration_parameters[1] = jerk;
+
+	mx_status = mx_motor_get_move_profile( &record, &profile );
+
+	if ( ( mx_status.code != MXE_SUCCESS )
+	  || ( profile.profile_type != MXF_MTR_PROFILE_S_CURVE ) )
+	{
+		fprintf( stderr, "Could not build an S-curve profile for "
+			"v = %g, v0 = %g, a = %g, j = %g\n",
+			speed, base_speed, acceleration, jerk );
+		return 1;
+	}
+
+	a_over_j = acceleration / jerk;
+
+	full_distance = 2.0 * profile.ramp_distance;
+
+	saturated_distance = 2.0 * a_over_j
+			* ( 2.0 * base_speed + acceleration * a_over_j );
+
+	if ( full_distance > saturated_distance ) {
+		longest_move = 3.0 * full_distance;
+	} else {
+		longest_move = 3.0 * saturated_distance;
+	}
+
+	/* Alternate the direction of the moves, so that the batch
+	 * estimate also has to take the absolute value of each one.
+	 */
+
+	position = 0.0;
+
+	for ( i = 0; i < NUM_MOVES; i++ ) {
+		if ( i % 2 ) {
+			position -= longest_move * (i+1) / NUM_MOVES;
+		} else {
+			position += longest_move * (i+1) / NUM_MOVES;
+		}
+
+		position_array[i] = position;
+	}
+
+	mx_motor_estimate_move_durations( &profile, 0.0, NUM_MOVES,
+			position_array, duration_array, &total_duration );
+
+	num_failures = 0;
+
+	for ( i = 0; i < NUM_MOVES; i++ ) {
+		reference = mx_motor_estimate_move_duration( &profile,
+						longest_move * (i+1) / NUM_MOVES );
+
+		error = fabs( duration_array[i] - reference ) / reference;
+
+		if ( !( error <= MAX_RELATIVE_ERROR ) ) {
+			fprintf( stderr,
+			"v = %g, v0 = %g, a = %g, j = %g, d = %.9g: "
+			"batch estimate %.12g, reference %.12g\n",
+				speed, base_speed, acceleration, jerk,
+				longest_move * (i+1) / NUM_MOVES,
+				duration_array[i], reference );
+
+			num_failures++;
+		}
+	}
+
+	printf( "v = %g, v0 = %g, a = %g, j = %g: full distance %g, "
+		"saturated distance %g, %d of %d moves differ\n",
+		speed, base_speed, acceleration, jerk,
+		full_distance, saturated_distance, num_failures, NUM_MOVES );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = 0;
+
+	/* The acceleration saturates before full speed is reached,
+	 * so saturated_distance < full_distance.
+	 */
+
+	num_failures += check_s_curve_profile( 10.0, 0.0, 20.0, 50.0 );
+	num_failures += check_s_curve_profile( 10.0, 1.0, 20.0, 50.0 );
+
+	/* Full speed is reached before the acceleration saturates,
+	 * so full_distance < saturated_distance.
+	 */
+
+	num_failures += check_s_curve_profile( 0.5, 0.0, 1.0, 1.0 );
+	num_failures += check_s_curve_profile( 0.5, 0.2, 1.0, 1.0 );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d moves failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All moves passed.\n" );
+
+	return EXIT_SUCCESS;
+}
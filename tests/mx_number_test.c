@@ -0,0 +1,343 @@
+/*
+ * Name:    mx_number_test.c
+ *
+ * Purpose: Checks that mx_format_double() and mx_format_float() write
+ *          strings that read back as exactly the same value, and that
+ *          they write the same strings as the first version of these
+ *          functions, which called snprintf() with "%.15g", "%.16g" and
+ *          "%.17g" in turn.  It also counts how often the result is
+ *          longer than necessary, and compares the speed and output
+ *          size of mx_format_double() with the first version and with
+ *          the fixed precision "%.17g" that is otherwise needed to save
+ *          a double without losing digits.
+ *
+ *          The timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_stdint.h"
+#include "mx_number.h"
+
+#define NUM_VALUES	200000
+
+static double value_array[NUM_VALUES];
+
+/* A small xorshift generator, so that the test does the same thing
+ * on every platform.
+ */
+
+static uint64_t random_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t
+next_random( void )
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+
+	return random_state;
+}
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+/* One third of the values are arbitrary bit patterns, one third are
+ * decimal numbers with a few digits, like most of the values found in
+ * a database, and one third are the results of arithmetic on them.
+ */
+
+static void
+fill_value_array( void )
+{
+	uint64_t bits;
+	double value;
+	long i;
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		switch( i % 3 ) {
+		case 0:
+			do {
+				bits = next_random();
+				memcpy( &value, &bits, sizeof(value) );
+			} while ( ( value != value )
+				|| ( value > DBL_MAX ) || ( value < -DBL_MAX ) );
+			break;
+		case 1:
+			value = (double) (int64_t) ( next_random() % 2000001 )
+					/ 1000.0 - 1000.0;
+			break;
+		default:
+			value = value_array[i-1] * 0.1 + 1.0 / 3.0;
+			break;
+		}
+
+		value_array[i] = value;
+	}
+}
+
+/* The first version of mx_format_double() and mx_format_float(). */
+
+static size_t
+reference_format( char *buffer, double value,
+		int min_precision, int max_precision, mx_bool_type is_float )
+{
+	double parsed_value;
+	size_t length, num_chars_used;
+	long status;
+	int precision;
+
+	if ( ( value >= -9007199254740992.0 ) && ( value <= 9007199254740992.0 )
+	  && ( value == (double) (int64_t) value )
+	  && ( ( value != 0.0 ) || ( 1.0 / value > 0.0 ) ) )
+	{
+		return mx_format_int64( buffer, (int64_t) value );
+	}
+
+	for ( precision = min_precision; ; precision++ ) {
+		snprintf( buffer, MXU_NUMBER_FORMAT_LENGTH,
+				"%.*g", precision, value );
+
+		length = strlen( buffer );
+
+		if ( precision == max_precision )
+			break;
+
+		status = mx_parse_double_n( buffer, length,
+					&parsed_value, &num_chars_used );
+
+		if ( status != MXE_SUCCESS )
+			continue;
+
+		if ( is_float ) {
+			if ( (float) parsed_value == (float) value )
+				break;
+		} else {
+			if ( parsed_value == value )
+				break;
+		}
+	}
+
+	return length;
+}
+
+/* Returns the length of the shortest "%.<n>g" string that strtod()
+ * reads back exactly.
+ */
+
+static size_t
+shortest_g_length( double value )
+{
+	char buffer[MXU_NUMBER_FORMAT_LENGTH];
+	int precision;
+
+	for ( precision = 1; precision < 17; precision++ ) {
+		snprintf( buffer, sizeof(buffer), "%.*g", precision, value );
+
+		if ( strtod( buffer, NULL ) == value )
+			break;
+	}
+
+	snprintf( buffer, sizeof(buffer), "%.*g", precision, value );
+
+	return strlen( buffer );
+}
+
+static int
+check_doubles( void )
+{
+	char buffer[MXU_NUMBER_FORMAT_LENGTH];
+	char reference[MXU_NUMBER_FORMAT_LENGTH];
+	double parsed_value;
+	size_t length, num_chars_used;
+	long i, num_longer;
+	int num_failures;
+
+	num_failures = 0;
+	num_longer = 0;
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		length = mx_format_double( buffer, value_array[i] );
+
+		(void) reference_format( reference, value_array[i],
+							15, 17, FALSE );
+
+		if ( ( mx_parse_double_n( buffer, length, &parsed_value,
+					&num_chars_used ) != MXE_SUCCESS )
+		  || ( num_chars_used != length )
+		  || ( parsed_value != value_array[i] )
+		  || ( strtod( buffer, NULL ) != value_array[i] ) )
+		{
+			fprintf( stderr, "%.17g was written as '%s', "
+				"which does not read back exactly.\n",
+				value_array[i], buffer );
+			num_failures++;
+		}
+
+		if ( strcmp( buffer, reference ) != 0 ) {
+			fprintf( stderr, "%.17g was written as '%s' "
+				"rather than '%s'.\n",
+				value_array[i], buffer, reference );
+			num_failures++;
+		}
+
+		if ( length > shortest_g_length( value_array[i] ) ) {
+			num_longer++;
+		}
+	}
+
+	printf( "mx_format_double(): %ld of %d values were longer than the "
+		"shortest %%g form that reads back exactly.\n",
+		num_longer, NUM_VALUES );
+
+	return num_failures;
+}
+
+static int
+check_floats( void )
+{
+	char buffer[MXU_NUMBER_FORMAT_LENGTH];
+	char reference[MXU_NUMBER_FORMAT_LENGTH];
+	float value;
+	double parsed_value;
+	size_t length, num_chars_used;
+	long i;
+	int num_failures;
+
+	num_failures = 0;
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		value = (float) value_array[i];
+
+		if ( ( value > FLT_MAX ) || ( value < -FLT_MAX ) )
+			continue;
+
+		length = mx_format_float( buffer, value );
+
+		if ( ( mx_parse_double_n( buffer, length, &parsed_value,
+					&num_chars_used ) != MXE_SUCCESS )
+		  || ( (float) parsed_value != value ) )
+		{
+			fprintf( stderr, "%.9g was written as '%s', "
+				"which does not read back exactly.\n",
+				(double) value, buffer );
+			num_failures++;
+		}
+
+		(void) reference_format( reference, (double) value,
+							6, 9, TRUE );
+
+		if ( strcmp( buffer, reference ) != 0 ) {
+			fprintf( stderr, "%.9g was written as '%s' "
+				"rather than '%s'.\n",
+				(double) value, buffer, reference );
+			num_failures++;
+		}
+	}
+
+	return num_failures;
+}
+
+/* Formats every value with each writer and reports the time per value
+ * and the total number of characters written.
+ */
+
+static void
+compare_writers( void )
+{
+	char buffer[MXU_NUMBER_FORMAT_LENGTH];
+	struct timespec start;
+	double mx_seconds, reference_seconds, printf_seconds;
+	size_t mx_chars, reference_chars, printf_chars;
+	long i;
+
+	mx_chars = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		mx_chars += mx_format_double( buffer, value_array[i] );
+	}
+
+	mx_seconds = elapsed_seconds( &start );
+
+	reference_chars = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		reference_chars += reference_format( buffer, value_array[i],
+							15, 17, FALSE );
+	}
+
+	reference_seconds = elapsed_seconds( &start );
+
+	printf_chars = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_VALUES; i++ ) {
+		printf_chars += snprintf( buffer, sizeof(buffer),
+					"%.17g", value_array[i] );
+	}
+
+	printf_seconds = elapsed_seconds( &start );
+
+	printf( "mx_format_double(): %.1f ns per value, %lu characters\n",
+		1.0e9 * mx_seconds / NUM_VALUES, (unsigned long) mx_chars );
+
+	printf( "first version:      %.1f ns per value, %lu characters\n",
+		1.0e9 * reference_seconds / NUM_VALUES,
+		(unsigned long) reference_chars );
+
+	printf( "%%.17g:              %.1f ns per value, %lu characters\n",
+		1.0e9 * printf_seconds / NUM_VALUES,
+		(unsigned long) printf_chars );
+}
+
+int
+main( int argc, char *argv[] )
+{
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	fill_value_array();
+
+	num_failures = check_doubles() + check_floats();
+
+	compare_writers();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d values failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All number format checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
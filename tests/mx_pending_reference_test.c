@@ -0,0 +1,534 @@
+/*
+ * Name:    mx_pending_reference_test.c
+ *
+ * Purpose: Loads a database in which every record refers to records
+ *          that are only defined further down, and checks that the
+ *          pending reference table patches every reference to the right
+ *          record, reports references to records that never appear,
+ *          and merges the pending references of a scratch list.
+ *
+ *          It also times the load against a model of the old fixup
+ *          pass, where each forward reference got its own placeholder
+ *          in an array grown 50 at a time, and each placeholder was then
+ *          looked for in every reference of every record.  The timings
+ *          are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_driver.h"
+#include "mx_record.h"
+
+#define NUM_RECORDS		5000
+#define NUM_REFERENCES		2
+
+#define FIXUP_BLOCK_SIZE	50
+
+/* Record i refers to record i+1 and to the last record, so almost every
+ * reference in the database is a forward reference.
+ */
+
+typedef struct {
+	MX_RECORD record;
+	MX_RECORD *reference[NUM_REFERENCES];
+} TEST_RECORD;
+
+static TEST_RECORD test_record_array[NUM_RECORDS];
+
+/* The pending reference table only needs these functions from libMx. */
+
+MX_EXPORT MX_LIST_HEAD *
+mx_get_record_list_head_struct( MX_RECORD *record )
+{
+	return (MX_LIST_HEAD *) record->list_head->record_superclass_struct;
+}
+
+MX_EXPORT MX_RECORD *
+mx_get_record( MX_RECORD *record_list, const char *record_name )
+{
+	return mx_record_name_index_lookup( record_list, record_name );
+}
+
+/*------------------------------------------------------------------------*/
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+static MX_RECORD *
+create_record_list( void )
+{
+	MX_RECORD *record_list;
+
+	record_list = (MX_RECORD *) calloc( 1, sizeof(MX_RECORD) );
+
+	if ( record_list == (MX_RECORD *) NULL ) {
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	snprintf( record_list->name, sizeof(record_list->name), "mx_database" );
+
+	record_list->list_head = record_list;
+	record_list->next_record = record_list;
+	record_list->previous_record = record_list;
+
+	record_list->record_superclass_struct =
+				calloc( 1, sizeof(MX_LIST_HEAD) );
+
+	if ( record_list->record_superclass_struct == NULL ) {
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	if ( mx_create_record_name_index( record_list ).code != MXE_SUCCESS ) {
+		fprintf( stderr, "Could not create the record name index.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	return record_list;
+}
+
+static void
+destroy_record_list( MX_RECORD *record_list )
+{
+	(void) mx_delete_pending_reference_table( record_list );
+	(void) mx_delete_record_name_index( record_list );
+
+	free( record_list->record_superclass_struct );
+	free( record_list );
+}
+
+/* Adds a record to the end of the list, the way the database loader
+ * does once it has read the record's name.
+ */
+
+static void
+add_record( MX_RECORD *record_list, MX_RECORD *record, const char *name )
+{
+	memset( record, 0, sizeof(MX_RECORD) );
+
+	strlcpy( record->name, name, sizeof(record->name) );
+
+	record->list_head = record_list;
+
+	record->next_record = record_list;
+	record->previous_record = record_list->previous_record;
+
+	record_list->previous_record->next_record = record;
+	record_list->previous_record = record;
+
+	(void) mx_record_name_index_add( record );
+}
+
+static void
+get_reference_name( long i, long n, char *name, size_t max_length )
+{
+	if ( n == 0 ) {
+		snprintf( name, max_length, "r%ld", ( i + 1 ) % NUM_RECORDS );
+	} else {
+		snprintf( name, max_length, "r%d", NUM_RECORDS - 1 );
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+static int
+load_with_pending_references( MX_RECORD *record_list, double *seconds )
+{
+	TEST_RECORD *test_record;
+	struct timespec start;
+	char name[MXU_RECORD_NAME_LENGTH+1];
+	long i, n;
+	mx_status_type mx_status;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_RECORDS; i++ ) {
+		test_record = &test_record_array[i];
+
+		snprintf( name, sizeof(name), "r%ld", i );
+
+		add_record( record_list, &(test_record->record), name );
+
+		mx_status = mx_resolve_pending_references(
+						&(test_record->record) );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return 1;
+
+		for ( n = 0; n < NUM_REFERENCES; n++ ) {
+			get_reference_name( i, n, name, sizeof(name) );
+
+			mx_status = mx_add_pending_reference(
+					&(test_record->record), name,
+					&(test_record->reference[n]) );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return 1;
+		}
+	}
+
+	*seconds = elapsed_seconds( &start );
+
+	return 0;
+}
+
+/* A model of the old fixup pass, for comparison. */
+
+static int
+load_with_fixup_array( MX_RECORD *record_list, double *seconds )
+{
+	TEST_RECORD *test_record;
+	MX_RECORD **fixup_array, **new_fixup_array, *placeholder, *record;
+	struct timespec start;
+	char name[MXU_RECORD_NAME_LENGTH+1];
+	long i, j, k, n, num_fixups, num_allocated;
+
+	fixup_array = NULL;
+	num_fixups = 0;
+	num_allocated = 0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_RECORDS; i++ ) {
+		test_record = &test_record_array[i];
+
+		snprintf( name, sizeof(name), "r%ld", i );
+
+		add_record( record_list, &(test_record->record), name );
+
+		for ( n = 0; n < NUM_REFERENCES; n++ ) {
+			get_reference_name( i, n, name, sizeof(name) );
+
+			record = mx_record_name_index_lookup( record_list,
+								name );
+
+			if ( record != (MX_RECORD *) NULL ) {
+				test_record->reference[n] = record;
+				continue;
+			}
+
+			if ( num_fixups >= num_allocated ) {
+				num_allocated += FIXUP_BLOCK_SIZE;
+
+				new_fixup_array = (MX_RECORD **) realloc(
+					fixup_array,
+					num_allocated * sizeof(MX_RECORD *) );
+
+				if ( new_fixup_array == (MX_RECORD **) NULL )
+					return 1;
+
+				fixup_array = new_fixup_array;
+			}
+
+			placeholder = (MX_RECORD *)
+					calloc( 1, sizeof(MX_RECORD) );
+
+			if ( placeholder == (MX_RECORD *) NULL )
+				return 1;
+
+			strlcpy( placeholder->name, name,
+					sizeof(placeholder->name) );
+
+			placeholder->mx_superclass = MXR_PLACEHOLDER;
+
+			fixup_array[ num_fixups++ ] = placeholder;
+
+			test_record->reference[n] = placeholder;
+		}
+	}
+
+	for ( k = 0; k < num_fixups; k++ ) {
+		placeholder = fixup_array[k];
+
+		record = mx_record_name_index_lookup( record_list,
+						placeholder->name );
+
+		for ( i = 0; i < NUM_RECORDS; i++ ) {
+			for ( j = 0; j < NUM_REFERENCES; j++ ) {
+				if ( test_record_array[i].reference[j]
+							== placeholder )
+				{
+					test_record_array[i].reference[j]
+								= record;
+				}
+			}
+		}
+
+		free( placeholder );
+	}
+
+	*seconds = elapsed_seconds( &start );
+
+	free( fixup_array );
+
+	return 0;
+}
+
+/* Checks that every reference points at the record that it names. */
+
+static int
+check_references( void )
+{
+	char name[MXU_RECORD_NAME_LENGTH+1];
+	MX_RECORD *record;
+	long i, n;
+	int num_failures;
+
+	num_failures = 0;
+
+	for ( i = 0; i < NUM_RECORDS; i++ ) {
+		for ( n = 0; n < NUM_REFERENCES; n++ ) {
+			get_reference_name( i, n, name, sizeof(name) );
+
+			record = test_record_array[i].reference[n];
+
+			if ( ( record == (MX_RECORD *) NULL )
+			  || ( record < &(test_record_array[0].record) )
+			  || ( record > &(test_record_array[NUM_RECORDS-1]
+								.record) )
+			  || ( strcmp( record->name, name ) != 0 ) )
+			{
+				fprintf( stderr, "Reference %ld of record "
+				"'r%ld' does not point to record '%s'.\n",
+					n, i, name );
+				num_failures++;
+			}
+		}
+	}
+
+	return num_failures;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* References that are still pending while the database is read. */
+
+static int
+check_placeholders( void )
+{
+	MX_RECORD *record_list, *placeholder;
+	MX_RECORD record, other_record;
+	MX_RECORD *reference, *other_reference, *missing_reference;
+	int num_failures;
+	mx_status_type mx_status;
+
+	num_failures = 0;
+
+	record_list = create_record_list();
+
+	add_record( record_list, &record, "first" );
+
+	mx_status = mx_add_pending_reference( &record, "second", &reference );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( reference->mx_superclass == MXR_PLACEHOLDER );
+	CHECK( strcmp( reference->name, "second" ) == 0 );
+
+	placeholder = reference;
+
+	mx_status = mx_add_pending_reference( &record, "second",
+							&other_reference );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( other_reference == placeholder );
+
+	mx_status = mx_add_pending_reference( &record, "missing",
+							&missing_reference );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( mx_get_num_pending_references( record_list ) == 3 );
+
+	add_record( record_list, &other_record, "second" );
+
+	mx_status = mx_resolve_pending_references( &other_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( reference == &other_record );
+	CHECK( other_reference == &other_record );
+	CHECK( mx_get_num_pending_references( record_list ) == 1 );
+
+	/* A reference to a record that exists is resolved at once. */
+
+	mx_status = mx_add_pending_reference( &other_record, "first",
+							&reference );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( reference == &record );
+	CHECK( mx_get_num_pending_references( record_list ) == 1 );
+
+	/* 'missing' is never defined. */
+
+	mx_status = mx_check_pending_references( record_list );
+
+	CHECK( mx_status.code == MXE_NOT_FOUND );
+
+	/* Deleting the table must not leave the reference pointing at
+	 * the freed placeholder.
+	 */
+
+	mx_status = mx_delete_pending_reference_table( record_list );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( missing_reference == NULL );
+
+	destroy_record_list( record_list );
+
+	return num_failures;
+}
+
+/* The parallel loader reads each chunk into a scratch list and then
+ * merges its pending references into the real list.
+ */
+
+static int
+check_merge( void )
+{
+	MX_RECORD *record_list, *scratch_record_list;
+	MX_RECORD existing_record, record, scratch_record, late_record;
+	MX_RECORD *existing_reference, *shared_reference;
+	MX_RECORD *scratch_shared_reference, *new_reference;
+	int num_failures;
+	mx_status_type mx_status;
+
+	num_failures = 0;
+
+	record_list = create_record_list();
+	scratch_record_list = create_record_list();
+
+	add_record( record_list, &existing_record, "existing" );
+	add_record( record_list, &record, "record" );
+	add_record( scratch_record_list, &scratch_record, "scratch" );
+
+	(void) mx_add_pending_reference( &record, "shared",
+						&shared_reference );
+
+	(void) mx_add_pending_reference( &scratch_record, "existing",
+						&existing_reference );
+
+	(void) mx_add_pending_reference( &scratch_record, "shared",
+						&scratch_shared_reference );
+
+	(void) mx_add_pending_reference( &scratch_record, "new",
+						&new_reference );
+
+	CHECK( existing_reference->mx_superclass == MXR_PLACEHOLDER );
+
+	mx_status = mx_merge_pending_references( record_list,
+						scratch_record_list );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( existing_reference == &existing_record );
+	CHECK( scratch_shared_reference == shared_reference );
+	CHECK( new_reference->mx_superclass == MXR_PLACEHOLDER );
+	CHECK( mx_get_num_pending_references( record_list ) == 3 );
+	CHECK( mx_get_num_pending_references( scratch_record_list ) == 0 );
+
+	add_record( record_list, &late_record, "shared" );
+
+	mx_status = mx_resolve_pending_references( &late_record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( shared_reference == &late_record );
+	CHECK( scratch_shared_reference == &late_record );
+	CHECK( mx_get_num_pending_references( record_list ) == 1 );
+
+	destroy_record_list( scratch_record_list );
+	destroy_record_list( record_list );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	MX_RECORD *record_list;
+	double pending_seconds, fixup_seconds;
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = check_placeholders() + check_merge();
+
+	/* The pending reference table. */
+
+	record_list = create_record_list();
+
+	if ( load_with_pending_references( record_list, &pending_seconds ) ) {
+		fprintf( stderr, "Loading with pending references failed.\n" );
+		return EXIT_FAILURE;
+	}
+
+	num_failures += check_references();
+
+	if ( mx_get_num_pending_references( record_list ) != 0 ) {
+		fprintf( stderr, "%ld references are still pending.\n",
+			mx_get_num_pending_references( record_list ) );
+		num_failures++;
+	}
+
+	if ( mx_check_pending_references( record_list ).code != MXE_SUCCESS ) {
+		fprintf( stderr, "mx_check_pending_references() failed.\n" );
+		num_failures++;
+	}
+
+	destroy_record_list( record_list );
+
+	/* The old fixup pass. */
+
+	record_list = create_record_list();
+
+	if ( load_with_fixup_array( record_list, &fixup_seconds ) ) {
+		fprintf( stderr, "Loading with the fixup array failed.\n" );
+		return EXIT_FAILURE;
+	}
+
+	num_failures += check_references();
+
+	destroy_record_list( record_list );
+
+	printf( "%d records with %d forward references:\n",
+		NUM_RECORDS, NUM_RECORDS * NUM_REFERENCES - 2 );
+
+	printf( "pending reference table: %.2f ms\n", 1.0e3 * pending_seconds );
+	printf( "fixup array rescan:      %.2f ms\n", 1.0e3 * fixup_seconds );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All pending reference checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
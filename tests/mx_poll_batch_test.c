@@ -0,0 +1,283 @@
+/*
+ * Name:    mx_poll_batch_test.c
+ *
+ * Purpose: Checks which fields mx_poll_batch_test_for_changes() reports
+ *          as changed for each of the ways that a poll batch can test
+ *          a field: the threshold test for numeric scalars, a custom
+ *          value_changed_test_function, and the default test for
+ *          strings and arrays.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+#include "mx_poll_batch.h"
+
+typedef struct {
+	double position;
+	char status_string[40];
+	long num_values;
+	long *value_array;
+	long custom;
+} TEST_STRUCT;
+
+static mx_bool_type custom_result = FALSE;
+static int num_custom_calls = 0;
+
+static mx_status_type
+test_custom_vctest( MX_RECORD_FIELD *field,
+			int direction,
+			mx_bool_type *value_changed )
+{
+	MXW_UNUSED( field );
+	MXW_UNUSED( direction );
+
+	num_custom_calls++;
+
+	*value_changed = custom_result;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+#define POSITION	0
+#define STATUS_STRING	1
+#define VALUE_ARRAY	2
+#define CUSTOM		3
+
+#define NUM_FIELDS	4
+
+static MX_RECORD_FIELD_DEFAULTS test_field_defaults[NUM_FIELDS] = {
+  {-1, -1, "position", MXFT_DOUBLE, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, position),
+	{0}, NULL, MXFF_POLL, 0, 0.5, NULL},
+
+  {-1, -1, "status_string", MXFT_STRING, NULL, 1, {40},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, status_string),
+	{sizeof(char)}, NULL, MXFF_POLL, 0, 0.0, NULL},
+
+  {-1, -1, "value_array", MXFT_LONG, NULL, 1, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, value_array),
+	{sizeof(long)}, NULL, (MXFF_POLL | MXFF_VARARGS), 0, 0.0, NULL},
+
+  {-1, -1, "custom", MXFT_LONG, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, custom),
+	{0}, NULL, MXFF_POLL, 0, 0.0, test_custom_vctest},
+};
+
+/* The poll batch only needs mx_get_field_value_pointer() from libMx. */
+
+MX_EXPORT void *
+mx_get_field_value_pointer( MX_RECORD_FIELD *field )
+{
+	if ( ( field->descriptor->flags & MXFF_VARARGS )
+	  && ( field->descriptor->num_dimensions > 0 ) )
+	{
+		return *((void **) field->data_pointer);
+	}
+
+	return field->data_pointer;
+}
+
+/*------------------------------------------------------------------------*/
+
+static MX_RECORD record;
+static MX_RECORD_FIELD field_array[NUM_FIELDS];
+static TEST_STRUCT test_struct;
+static long value_array[8];
+static long dimension_array[NUM_FIELDS][MXU_FIELD_MAX_DIMENSIONS];
+
+static void
+setup_record( void )
+{
+	MX_RECORD_FIELD *field;
+	long i;
+
+	snprintf( record.name, sizeof(record.name), "test_record" );
+
+	record.record_type_struct = &test_struct;
+	record.num_record_fields = NUM_FIELDS;
+	record.record_field_array = field_array;
+
+	test_struct.num_values = 3;
+	test_struct.value_array = value_array;
+
+	for ( i = 0; i < NUM_FIELDS; i++ ) {
+		field = &field_array[i];
+
+		memcpy( dimension_array[i], test_field_defaults[i].dimension,
+						sizeof(dimension_array[i]) );
+
+		field->descriptor = &test_field_defaults[i];
+		field->dimension = dimension_array[i];
+		field->record = &record;
+		field->data_pointer = (char *) &test_struct
+				+ test_field_defaults[i].structure_offset;
+	}
+
+	field_array[VALUE_ARRAY].dimension[0] = test_struct.num_values;
+}
+
+/* Polls the batch and returns a bit mask of the fields that changed. */
+
+static unsigned long
+poll( MX_POLL_BATCH *poll_batch )
+{
+	unsigned long changed_mask;
+	long i, num_changed;
+	mx_status_type mx_status;
+
+	mx_status = mx_poll_batch_test_for_changes( poll_batch,
+							0, &num_changed );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		fprintf( stderr, "mx_poll_batch_test_for_changes() "
+			"failed with error code %ld.\n", mx_status.code );
+		exit( EXIT_FAILURE );
+	}
+
+	changed_mask = 0;
+
+	for ( i = 0; i < num_changed; i++ ) {
+		changed_mask |= 1UL << ( poll_batch->changed_field_array[i]
+							- field_array );
+	}
+
+	return changed_mask;
+}
+
+#define BIT(n)	( 1UL << (n) )
+
+#define CHECK_POLL( expected ) \
+	do { \
+		unsigned long changed_mask = poll( poll_batch ); \
+		if ( changed_mask != (expected) ) { \
+			fprintf( stderr, "%s:%d: changed fields 0x%lx, " \
+				"expected 0x%lx\n", __FILE__, __LINE__, \
+				changed_mask, (unsigned long) (expected) ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+int
+main( int argc, char *argv[] )
+{
+	MX_POLL_BATCH *poll_batch;
+	int num_failures;
+	mx_status_type mx_status;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = 0;
+
+	setup_record();
+
+	mx_status = mx_poll_batch_create( &poll_batch );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_status = mx_poll_batch_add_record( poll_batch, &record );
+	}
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		fprintf( stderr, "Could not build the poll batch.\n" );
+		return EXIT_FAILURE;
+	}
+
+	/* Everything starts out as zero, so nothing has changed. */
+
+	CHECK_POLL( 0 );
+
+	/* The threshold test. */
+
+	test_struct.position = 0.25;
+
+	CHECK_POLL( 0 );
+
+	test_struct.position = 1.0;
+
+	CHECK_POLL( BIT(POSITION) );
+	CHECK_POLL( 0 );
+
+	/* A string without a test function. */
+
+	snprintf( test_struct.status_string,
+			sizeof(test_struct.status_string), "Moving" );
+
+	CHECK_POLL( BIT(STATUS_STRING) );
+	CHECK_POLL( 0 );
+
+	snprintf( test_struct.status_string,
+			sizeof(test_struct.status_string), "Stopped" );
+
+	CHECK_POLL( BIT(STATUS_STRING) );
+
+	/* An array without a test function. */
+
+	value_array[1] = 42;
+
+	CHECK_POLL( BIT(VALUE_ARRAY) );
+	CHECK_POLL( 0 );
+
+	/* Elements past the end of the array are not compared. */
+
+	value_array[5] = 7;
+
+	CHECK_POLL( 0 );
+
+	/* A varargs array that gets longer has changed. */
+
+	test_struct.num_values = 6;
+	field_array[VALUE_ARRAY].dimension[0] = 6;
+
+	CHECK_POLL( BIT(VALUE_ARRAY) );
+	CHECK_POLL( 0 );
+
+	/* The manual override works for all of the tests. */
+
+	field_array[POSITION].value_has_changed_manual_override = TRUE;
+	field_array[STATUS_STRING].value_has_changed_manual_override = TRUE;
+
+	CHECK_POLL( BIT(POSITION) | BIT(STATUS_STRING) );
+	CHECK_POLL( 0 );
+
+	/* A custom test function decides for itself. */
+
+	custom_result = TRUE;
+
+	CHECK_POLL( BIT(CUSTOM) );
+
+	custom_result = FALSE;
+
+	CHECK_POLL( 0 );
+
+	if ( num_custom_calls != 16 ) {
+		fprintf( stderr, "The custom test function was called "
+			"%d times rather than 16.\n", num_custom_calls );
+		num_failures++;
+	}
+
+	mx_poll_batch_destroy( poll_batch );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All poll batch checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*
+ * Name:    mx_test_stubs.c
+ *
+ * Purpose: Minimal versions of the libMx support functions that are
+ *          needed by the test programs in this directory.
+ *
+ *          Each test links only the MX source files that it checks,
+ *          together with this file and whatever record, driver or
+ *          motor functions the test provides itself.  mx_error()
+ *          prints the message to stderr only if the environment
+ *          variable MX_TEST_VERBOSE is set, since many of the tests
+ *          provoke errors on purpose.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "mx_util.h"
+
+MX_EXPORT mx_status_type
+mx_error( long error_code, const char *location, const char *format, ... )
+{
+	mx_status_type mx_status;
+	va_list args;
+
+	if ( getenv( "MX_TEST_VERBOSE" ) != NULL ) {
+		va_start( args, format );
+
+		fprintf( stderr, "%s: ", location );
+		vfprintf( stderr, format, args );
+		fprintf( stderr, "\n" );
+
+		va_end( args );
+	}
+
+	mx_status.code = error_code;
+	mx_status.location = location;
+	mx_status.message = NULL;
+
+	return mx_status;
+}
+
+MX_EXPORT mx_status_type
+mx_successful_result( void )
+{
+	mx_status_type mx_status;
+
+	mx_status.code = MXE_SUCCESS;
+	mx_status.location = NULL;
+	mx_status.message = NULL;
+
+	return mx_status;
+}
+
+MX_EXPORT size_t
+strlcpy( char *dest, const char *src, size_t maxlen )
+{
+	size_t src_length, copy_length;
+
+	src_length = strlen( src );
+
+	if ( maxlen > 0 ) {
+		if ( src_length < maxlen ) {
+			copy_length = src_length;
+		} else {
+			copy_length = maxlen - 1;
+		}
+
+		memcpy( dest, src, copy_length );
+
+		dest[copy_length] = '\0';
+	}
+
+	return src_length;
+}
@@ -0,0 +1,786 @@
+/*
+ * Name:    mx_traverse_span_test.c
+ *
+ * Purpose: Checks that mx_traverse_field_spans() hands its handler every
+ *          leaf element of scalar, fixed size, varargs and string fields
+ *          exactly once and in order, merges rows that are adjacent in
+ *          memory, and reports NULL rows and handler errors.  It also
+ *          checks mx_record_array_dependency_span_handler().
+ *
+ *          The span traversal of 2-D and 3-D fields is timed against a
+ *          recursive traversal that calls an MX_TRAVERSE_FIELD_HANDLER
+ *          for every element, the way mx_traverse_field() does.  The
+ *          timings are only reported.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+
+#define STRING_LENGTH	8
+
+/* The span traversal only needs these functions from libMx. */
+
+static long num_parent_dependencies = 0;
+static long num_child_dependencies = 0;
+
+MX_EXPORT void *
+mx_get_field_value_pointer( MX_RECORD_FIELD *field )
+{
+	if ( ( field->descriptor->flags & MXFF_VARARGS )
+	  && ( field->descriptor->num_dimensions > 0 ) )
+	{
+		return *((void **) field->data_pointer);
+	}
+
+	return field->data_pointer;
+}
+
+MX_EXPORT mx_status_type
+mx_add_parent_dependency( MX_RECORD *current_record,
+			MX_RECORD_FIELD *current_field,
+			mx_bool_type add_child_pointer_in_parent,
+			MX_RECORD *parent_record )
+{
+	MXW_UNUSED( current_record );
+	MXW_UNUSED( current_field );
+	MXW_UNUSED( add_child_pointer_in_parent );
+	MXW_UNUSED( parent_record );
+
+	num_parent_dependencies++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_parent_dependency( MX_RECORD *current_record,
+			MX_RECORD_FIELD *current_field,
+			mx_bool_type delete_child_pointer_in_parent,
+			MX_RECORD *parent_record )
+{
+	MXW_UNUSED( current_record );
+	MXW_UNUSED( current_field );
+	MXW_UNUSED( delete_child_pointer_in_parent );
+	MXW_UNUSED( parent_record );
+
+	num_parent_dependencies--;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_add_child_dependency( MX_RECORD *current_record,
+			MX_RECORD_FIELD *current_field,
+			mx_bool_type add_parent_pointer_in_child,
+			MX_RECORD *child_record )
+{
+	MXW_UNUSED( current_record );
+	MXW_UNUSED( current_field );
+	MXW_UNUSED( add_parent_pointer_in_child );
+	MXW_UNUSED( child_record );
+
+	num_child_dependencies++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+MX_EXPORT mx_status_type
+mx_delete_child_dependency( MX_RECORD *current_record,
+			MX_RECORD_FIELD *current_field,
+			mx_bool_type delete_parent_pointer_in_child,
+			MX_RECORD *child_record )
+{
+	MXW_UNUSED( current_record );
+	MXW_UNUSED( current_field );
+	MXW_UNUSED( delete_parent_pointer_in_child );
+	MXW_UNUSED( child_record );
+
+	num_child_dependencies--;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* A test field together with everything that it points to. */
+
+typedef struct {
+	MX_RECORD record;
+	MX_RECORD_FIELD field;
+	MX_RECORD_FIELD_DEFAULTS descriptor;
+	long dimension[MXU_FIELD_MAX_DIMENSIONS];
+	void *array_pointer;
+	char *data_block;
+} TEST_FIELD;
+
+/* Builds the pointer rows of a varargs array the way mx_allocate_array()
+ * does, with the rows of the last dimension taken one after the other
+ * from 'data_cursor'.  'gap' extra elements are left after each row, so
+ * that the rows are not adjacent if 'gap' is not zero.
+ */
+
+static void *
+build_rows( long level, long num_dimensions, long *dimension,
+		size_t element_size, long gap, char **data_cursor )
+{
+	void **pointer_array;
+	char *row_ptr;
+	long i;
+
+	if ( level == num_dimensions - 1 ) {
+		row_ptr = *data_cursor;
+
+		*data_cursor += ( dimension[level] + gap ) * element_size;
+
+		return row_ptr;
+	}
+
+	pointer_array = (void **) malloc( dimension[level] * sizeof(void *) );
+
+	if ( pointer_array == (void **) NULL ) {
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	for ( i = 0; i < dimension[level]; i++ ) {
+		pointer_array[i] = build_rows( level + 1, num_dimensions,
+				dimension, element_size, gap, data_cursor );
+	}
+
+	return pointer_array;
+}
+
+static void
+free_rows( long level, long num_dimensions, long *dimension, void *ptr )
+{
+	long i;
+
+	if ( level == num_dimensions - 1 )
+		return;
+
+	for ( i = 0; i < dimension[level]; i++ ) {
+		free_rows( level + 1, num_dimensions, dimension,
+					((void **) ptr)[i] );
+	}
+
+	free( ptr );
+}
+
+static void
+setup_field( TEST_FIELD *test_field, long datatype, mx_bool_type varargs,
+		long num_dimensions, const long *dimension, long gap )
+{
+	size_t element_size, pointer_size, block_size;
+	long i, num_rows;
+	char *data_cursor;
+
+	memset( test_field, 0, sizeof(TEST_FIELD) );
+
+	snprintf( test_field->record.name, sizeof(test_field->record.name),
+							"test_record" );
+	snprintf( test_field->descriptor.name,
+			sizeof(test_field->descriptor.name), "test_field" );
+
+	switch( datatype ) {
+	case MXFT_DOUBLE: element_size = sizeof(double);	break;
+	case MXFT_RECORD: element_size = sizeof(MX_RECORD *);	break;
+	default:          element_size = sizeof(char);		break;
+	}
+
+	pointer_size = sizeof(void *);
+
+	test_field->descriptor.datatype = datatype;
+	test_field->descriptor.num_dimensions = num_dimensions;
+	test_field->descriptor.data_element_size[0] = element_size;
+
+	for ( i = 0; i < num_dimensions; i++ ) {
+		test_field->dimension[i] = dimension[i];
+		test_field->descriptor.dimension[i] = dimension[i];
+
+		if ( i > 0 ) {
+			test_field->descriptor.data_element_size[i]
+							= pointer_size;
+		}
+	}
+
+	num_rows = 1;
+
+	for ( i = 0; i < num_dimensions - 1; i++ ) {
+		num_rows *= dimension[i];
+	}
+
+	if ( num_dimensions == 0 ) {
+		block_size = element_size;
+	} else {
+		block_size = num_rows * ( dimension[num_dimensions-1] + gap )
+							* element_size;
+	}
+
+	test_field->data_block = (char *) calloc( 1, block_size );
+
+	if ( test_field->data_block == (char *) NULL ) {
+		fprintf( stderr, "Out of memory.\n" );
+		exit( EXIT_FAILURE );
+	}
+
+	test_field->field.descriptor = &(test_field->descriptor);
+	test_field->field.dimension = test_field->dimension;
+	test_field->field.record = &(test_field->record);
+
+	if ( varargs && ( num_dimensions > 0 ) ) {
+		test_field->descriptor.flags = MXFF_VARARGS;
+
+		data_cursor = test_field->data_block;
+
+		test_field->array_pointer = build_rows( 0, num_dimensions,
+			test_field->dimension, element_size, gap,
+			&data_cursor );
+
+		test_field->field.data_pointer =
+				&(test_field->array_pointer);
+	} else {
+		test_field->field.data_pointer = test_field->data_block;
+	}
+}
+
+static void
+free_field( TEST_FIELD *test_field )
+{
+	if ( test_field->descriptor.flags & MXFF_VARARGS ) {
+		free_rows( 0, test_field->descriptor.num_dimensions,
+			test_field->dimension, test_field->array_pointer );
+	}
+
+	free( test_field->data_block );
+}
+
+/* Gives every leaf element its index in the flattened field.  For
+ * string fields, each string is "s<index>".
+ */
+
+static void
+fill_rows( TEST_FIELD *test_field, long level, void *ptr, long *counter )
+{
+	MX_RECORD_FIELD_DEFAULTS *descriptor;
+	long i, last_level;
+
+	descriptor = &(test_field->descriptor);
+
+	last_level = descriptor->num_dimensions - 1;
+
+	if ( descriptor->datatype == MXFT_STRING ) {
+		last_level--;
+	}
+
+	if ( level < last_level ) {
+		for ( i = 0; i < test_field->dimension[level]; i++ ) {
+			if ( descriptor->flags & MXFF_VARARGS ) {
+				fill_rows( test_field, level + 1,
+					((void **) ptr)[i], counter );
+			}
+		}
+		return;
+	}
+
+	if ( descriptor->datatype == MXFT_STRING ) {
+		if ( ( descriptor->flags & MXFF_VARARGS ) == 0 )
+			return;
+
+		for ( i = 0; i < test_field->dimension[level]; i++ ) {
+			snprintf( ((char **) ptr)[i], STRING_LENGTH,
+						"s%ld", (*counter)++ );
+		}
+		return;
+	}
+
+	for ( i = 0; i < test_field->dimension[level]; i++ ) {
+		((double *) ptr)[i] = (double) (*counter)++;
+	}
+}
+
+static void
+fill_field( TEST_FIELD *test_field )
+{
+	long i, num_elements, counter;
+
+	counter = 0;
+
+	if ( test_field->descriptor.flags & MXFF_VARARGS ) {
+		fill_rows( test_field, 0, test_field->array_pointer, &counter );
+		return;
+	}
+
+	num_elements = 1;
+
+	for ( i = 0; i < test_field->descriptor.num_dimensions; i++ ) {
+		num_elements *= test_field->dimension[i];
+	}
+
+	for ( i = 0; i < num_elements; i++ ) {
+		((double *) test_field->data_block)[i] = (double) i;
+	}
+}
+
+/*------------------------------------------------------------------------*/
+
+typedef struct {
+	long num_spans;
+	long num_elements;
+	long num_wrong;
+	long fail_at_span;
+	double sum;
+} SPAN_LOG;
+
+static mx_status_type
+check_span_handler( MX_RECORD *record,
+		MX_RECORD_FIELD *field,
+		void *handler_data_ptr,
+		void *span_ptr,
+		long first_element,
+		long num_elements,
+		size_t element_size )
+{
+	SPAN_LOG *span_log;
+	char expected_string[STRING_LENGTH];
+	char *element_ptr;
+	long i;
+
+	MXW_UNUSED( record );
+
+	span_log = (SPAN_LOG *) handler_data_ptr;
+
+	if ( span_log->num_spans == span_log->fail_at_span ) {
+		return mx_error( MXE_FUNCTION_FAILED, "check_span_handler()",
+			"Failing at span %ld.", span_log->num_spans );
+	}
+
+	span_log->num_spans++;
+
+	if ( first_element != span_log->num_elements ) {
+		span_log->num_wrong++;
+	}
+
+	for ( i = 0; i < num_elements; i++ ) {
+		element_ptr = (char *) span_ptr + i * element_size;
+
+		if ( field->descriptor->datatype == MXFT_STRING ) {
+			snprintf( expected_string, sizeof(expected_string),
+					"s%ld", first_element + i );
+
+			if ( strcmp( element_ptr, expected_string ) != 0 ) {
+				span_log->num_wrong++;
+			}
+		} else {
+			if ( *((double *) element_ptr)
+				!= (double) ( first_element + i ) )
+			{
+				span_log->num_wrong++;
+			}
+		}
+	}
+
+	span_log->num_elements += num_elements;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static long
+traverse( TEST_FIELD *test_field, SPAN_LOG *span_log, long fail_at_span )
+{
+	mx_status_type mx_status;
+
+	memset( span_log, 0, sizeof(SPAN_LOG) );
+
+	span_log->fail_at_span = fail_at_span;
+
+	mx_status = mx_traverse_field_spans( &(test_field->record),
+					&(test_field->field),
+					check_span_handler, span_log );
+
+	return mx_status.code;
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* Runs a traversal that is expected to succeed and checks the number
+ * of spans and elements that it saw.
+ */
+
+#define CHECK_TRAVERSAL( test_field, expected_spans, expected_elements ) \
+	do { \
+		SPAN_LOG span_log; \
+		CHECK( traverse( (test_field), &span_log, -1 ) \
+						== MXE_SUCCESS ); \
+		CHECK( span_log.num_spans == (expected_spans) ); \
+		CHECK( span_log.num_elements == (expected_elements) ); \
+		CHECK( span_log.num_wrong == 0 ); \
+	} while (0)
+
+static int
+check_layouts( void )
+{
+	static const long dimension_2d[] = { 30, 40 };
+	static const long dimension_3d[] = { 4, 5, 6 };
+	static const long string_dimension[] = { 7, 3, STRING_LENGTH };
+
+	TEST_FIELD test_field;
+	SPAN_LOG span_log;
+	void *saved_row;
+	int num_failures;
+
+	num_failures = 0;
+
+	/* A scalar is a single element. */
+
+	setup_field( &test_field, MXFT_DOUBLE, FALSE, 0, NULL, 0 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 1, 1 );
+	free_field( &test_field );
+
+	/* A fixed size array is a single span. */
+
+	setup_field( &test_field, MXFT_DOUBLE, FALSE, 2, dimension_2d, 0 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 1, 30 * 40 );
+	free_field( &test_field );
+
+	/* Varargs arrays with adjacent rows are merged into one span. */
+
+	setup_field( &test_field, MXFT_DOUBLE, TRUE, 2, dimension_2d, 0 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 1, 30 * 40 );
+	free_field( &test_field );
+
+	setup_field( &test_field, MXFT_DOUBLE, TRUE, 3, dimension_3d, 0 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 1, 4 * 5 * 6 );
+	free_field( &test_field );
+
+	/* Rows that are not adjacent are a span each. */
+
+	setup_field( &test_field, MXFT_DOUBLE, TRUE, 2, dimension_2d, 1 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 30, 30 * 40 );
+
+	/* A handler error stops the traversal. */
+
+	CHECK( traverse( &test_field, &span_log, 3 ) == MXE_FUNCTION_FAILED );
+	CHECK( span_log.num_spans == 3 );
+
+	/* So does a NULL row. */
+
+	saved_row = ((void **) test_field.array_pointer)[5];
+
+	((void **) test_field.array_pointer)[5] = NULL;
+
+	CHECK( traverse( &test_field, &span_log, -1 )
+					== MXE_CORRUPT_DATA_STRUCTURE );
+
+	((void **) test_field.array_pointer)[5] = saved_row;
+
+	free_field( &test_field );
+
+	setup_field( &test_field, MXFT_DOUBLE, TRUE, 3, dimension_3d, 2 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 4 * 5, 4 * 5 * 6 );
+	free_field( &test_field );
+
+	/* The leaves of a string array are whole strings. */
+
+	setup_field( &test_field, MXFT_STRING, TRUE, 3, string_dimension, 0 );
+	fill_field( &test_field );
+	CHECK_TRAVERSAL( &test_field, 1, 7 * 3 );
+	free_field( &test_field );
+
+	return num_failures;
+}
+
+static int
+check_dependencies( void )
+{
+	static const long dimension[] = { 5 };
+
+	MX_RECORD other_record;
+	MX_RECORD_ARRAY_DEPENDENCY_STRUCT dependency_struct;
+	TEST_FIELD test_field;
+	MX_RECORD **record_array;
+	int num_failures;
+	mx_status_type mx_status;
+
+	num_failures = 0;
+
+	setup_field( &test_field, MXFT_RECORD, TRUE, 1, dimension, 0 );
+
+	record_array = (MX_RECORD **) test_field.array_pointer;
+
+	record_array[0] = &other_record;
+	record_array[2] = &other_record;
+	record_array[4] = &other_record;
+
+	dependency_struct.add_dependency = TRUE;
+	dependency_struct.dependency_is_to_parent = TRUE;
+
+	mx_status = mx_traverse_field_spans( &(test_field.record),
+				&(test_field.field),
+				mx_record_array_dependency_span_handler,
+				&dependency_struct );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_parent_dependencies == 3 );
+	CHECK( num_child_dependencies == 0 );
+
+	dependency_struct.add_dependency = FALSE;
+
+	mx_status = mx_traverse_field_spans( &(test_field.record),
+				&(test_field.field),
+				mx_record_array_dependency_span_handler,
+				&dependency_struct );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_parent_dependencies == 0 );
+
+	dependency_struct.add_dependency = TRUE;
+	dependency_struct.dependency_is_to_parent = FALSE;
+
+	mx_status = mx_traverse_field_spans( &(test_field.record),
+				&(test_field.field),
+				mx_record_array_dependency_span_handler,
+				&dependency_struct );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_child_dependencies == 3 );
+
+	free_field( &test_field );
+
+	return num_failures;
+}
+
+/*------------------------------------------------------------------------*/
+
+/* The per element traversal, with the same recursion as
+ * mx_traverse_field_array().
+ */
+
+static mx_status_type
+traverse_by_element( MX_RECORD *record,
+		MX_RECORD_FIELD *field,
+		MX_TRAVERSE_FIELD_HANDLER *handler_fn,
+		void *handler_data_ptr,
+		long *array_indices,
+		void *array_ptr,
+		long dimension_level )
+{
+	char *element_ptr;
+	size_t element_size;
+	long i;
+	mx_status_type mx_status;
+
+	if ( dimension_level == field->descriptor->num_dimensions - 1 ) {
+		element_size = field->descriptor->data_element_size[0];
+
+		for ( i = 0; i < field->dimension[dimension_level]; i++ ) {
+			array_indices[dimension_level] = i;
+
+			element_ptr = (char *) array_ptr + i * element_size;
+
+			mx_status = (*handler_fn)( record, field,
+					handler_data_ptr, array_indices,
+					element_ptr, dimension_level + 1 );
+
+			if ( mx_status.code != MXE_SUCCESS )
+				return mx_status;
+		}
+
+		return MX_SUCCESSFUL_RESULT;
+	}
+
+	for ( i = 0; i < field->dimension[dimension_level]; i++ ) {
+		array_indices[dimension_level] = i;
+
+		mx_status = traverse_by_element( record, field,
+				handler_fn, handler_data_ptr, array_indices,
+				((void **) array_ptr)[i], dimension_level + 1 );
+
+		if ( mx_status.code != MXE_SUCCESS )
+			return mx_status;
+	}
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+sum_element_handler( MX_RECORD *record,
+		MX_RECORD_FIELD *field,
+		void *handler_data_ptr,
+		long *array_indices,
+		void *array_ptr,
+		long dimension_level )
+{
+	MXW_UNUSED( record );
+	MXW_UNUSED( field );
+	MXW_UNUSED( array_indices );
+	MXW_UNUSED( dimension_level );
+
+	*((double *) handler_data_ptr) += *((double *) array_ptr);
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static mx_status_type
+sum_span_handler( MX_RECORD *record,
+		MX_RECORD_FIELD *field,
+		void *handler_data_ptr,
+		void *span_ptr,
+		long first_element,
+		long num_elements,
+		size_t element_size )
+{
+	double sum;
+	long i;
+
+	MXW_UNUSED( record );
+	MXW_UNUSED( field );
+	MXW_UNUSED( first_element );
+	MXW_UNUSED( element_size );
+
+	sum = 0.0;
+
+	for ( i = 0; i < num_elements; i++ ) {
+		sum += ((double *) span_ptr)[i];
+	}
+
+	*((double *) handler_data_ptr) += sum;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+static double
+elapsed_seconds( struct timespec *start )
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return ( now.tv_sec - start->tv_sec )
+		+ 1.0e-9 * ( now.tv_nsec - start->tv_nsec );
+}
+
+#define NUM_REPEATS	20
+
+static int
+compare_traversals( const char *label, long num_dimensions,
+			const long *dimension, long gap )
+{
+	TEST_FIELD test_field;
+	long array_indices[MXU_FIELD_MAX_DIMENSIONS];
+	struct timespec start;
+	double element_sum, span_sum, element_seconds, span_seconds;
+	long i, num_elements;
+	int num_failures;
+
+	num_failures = 0;
+
+	setup_field( &test_field, MXFT_DOUBLE, TRUE,
+				num_dimensions, dimension, gap );
+	fill_field( &test_field );
+
+	element_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_REPEATS; i++ ) {
+		(void) traverse_by_element( &(test_field.record),
+				&(test_field.field), sum_element_handler,
+				&element_sum, array_indices,
+				test_field.array_pointer, 0 );
+	}
+
+	element_seconds = elapsed_seconds( &start );
+
+	span_sum = 0.0;
+
+	clock_gettime( CLOCK_MONOTONIC, &start );
+
+	for ( i = 0; i < NUM_REPEATS; i++ ) {
+		(void) mx_traverse_field_spans( &(test_field.record),
+				&(test_field.field), sum_span_handler,
+				&span_sum );
+	}
+
+	span_seconds = elapsed_seconds( &start );
+
+	num_elements = 1;
+
+	for ( i = 0; i < num_dimensions; i++ ) {
+		num_elements *= dimension[i];
+	}
+
+	/* The values are small integers, so both sums are exact. */
+
+	CHECK( element_sum == NUM_REPEATS * 0.5 * (double) num_elements
+					* (double) ( num_elements - 1 ) );
+	CHECK( span_sum == element_sum );
+
+	printf( "%-22s %7.2f ms by element, %7.2f ms by span, "
+		"%5.1fx faster\n", label,
+		1.0e3 * element_seconds / NUM_REPEATS,
+		1.0e3 * span_seconds / NUM_REPEATS,
+		element_seconds / span_seconds );
+
+	free_field( &test_field );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	static const long dimension_2d[] = { 1000, 1000 };
+	static const long dimension_3d[] = { 100, 100, 100 };
+
+	int num_failures;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = check_layouts() + check_dependencies();
+
+	num_failures += compare_traversals( "2-D 1000x1000",
+						2, dimension_2d, 0 );
+	num_failures += compare_traversals( "2-D 1000x1000, gaps",
+						2, dimension_2d, 1 );
+	num_failures += compare_traversals( "3-D 100x100x100",
+						3, dimension_3d, 0 );
+	num_failures += compare_traversals( "3-D 100x100x100, gaps",
+						3, dimension_3d, 1 );
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All span traversal checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,425 @@
+/*
+ * Name:    mx_varargs_plan_test.c
+ *
+ * Purpose: Checks that mx_create_varargs_plan() orders the varargs
+ *          cookies of a driver so that each field comes after the
+ *          varargs fields that it gets its length from, that it rejects
+ *          cookies that refer to unusable fields or to each other in a
+ *          loop, and that mx_resolve_varargs_field() and
+ *          mx_resolve_record_varargs() write the right dimensions, or
+ *          fall back to mx_replace_varargs_cookies_with_values() when
+ *          a record does not match its driver's plan.
+ *
+ * Author:  William Lavender
+ *
+ *--------------------------------------------------------------------------
+ *
+ * Copyright 2016 Illinois Institute of Technology
+ *
+ * See the file "LICENSE" for information on usage and redistribution
+ * of this file, and for a DISCLAIMER OF ALL WARRANTIES.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "mx_util.h"
+#include "mx_record.h"
+
+#define COOKIE( field_index, array_index ) \
+	( - ( (field_index) * MXU_VARARGS_COOKIE_MULTIPLIER + (array_index) ) )
+
+typedef struct {
+	char name[MXU_RECORD_NAME_LENGTH+1];
+	long num_rows;
+	double *matrix;
+	long num_columns;
+	long *row_length_array;
+} TEST_STRUCT;
+
+#define NAME		0
+#define NUM_ROWS	1
+#define MATRIX		2
+#define NUM_COLUMNS	3
+#define ROW_LENGTHS	4
+
+#define NUM_FIELDS	5
+
+/* 'matrix' gets its second dimension from the second element of
+ * 'row_length_array', which comes after it in the record, so the plan
+ * must resolve 'row_length_array' first.
+ */
+
+static MX_RECORD_FIELD_DEFAULTS test_field_defaults[NUM_FIELDS] = {
+  {-1, -1, "name", MXFT_STRING, NULL, 1, {MXU_RECORD_NAME_LENGTH},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, name),
+	{sizeof(char)}, NULL, 0, 0, 0.0, NULL},
+
+  {-1, -1, "num_rows", MXFT_LONG, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, num_rows),
+	{0}, NULL, 0, 0, 0.0, NULL},
+
+  {-1, -1, "matrix", MXFT_DOUBLE, NULL,
+	2, {COOKIE(NUM_ROWS, 0), COOKIE(ROW_LENGTHS, 1)},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, matrix),
+	{sizeof(double), sizeof(double *)}, NULL, MXFF_VARARGS,
+	0, 0.0, NULL},
+
+  {-1, -1, "num_columns", MXFT_LONG, NULL, 0, {0},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, num_columns),
+	{0}, NULL, 0, 0, 0.0, NULL},
+
+  {-1, -1, "row_length_array", MXFT_LONG, NULL,
+	1, {COOKIE(NUM_COLUMNS, 0)},
+	MXF_REC_TYPE_STRUCT, offsetof(TEST_STRUCT, row_length_array),
+	{sizeof(long)}, NULL, MXFF_VARARGS, 0, 0.0, NULL},
+};
+
+static long num_test_fields = NUM_FIELDS;
+
+static MX_RECORD_FIELD_DEFAULTS *test_field_defaults_ptr
+						= test_field_defaults;
+
+static MX_DRIVER test_driver = {
+	"test_driver", 7777, 0, 0, NULL, NULL, NULL,
+	&num_test_fields, &test_field_defaults_ptr,
+	NULL, NULL, NULL, NULL
+};
+
+/* The varargs plan only needs these functions from libMx. */
+
+static int num_cookie_fallbacks = 0;
+
+MX_EXPORT void *
+mx_get_field_value_pointer( MX_RECORD_FIELD *field )
+{
+	if ( ( field->descriptor->flags & MXFF_VARARGS )
+	  && ( field->descriptor->num_dimensions > 0 ) )
+	{
+		return *((void **) field->data_pointer);
+	}
+
+	return field->data_pointer;
+}
+
+MX_EXPORT MX_DRIVER *
+mx_get_driver_for_record( MX_RECORD *record )
+{
+	MXW_UNUSED( record );
+
+	return &test_driver;
+}
+
+MX_EXPORT mx_status_type
+mx_replace_varargs_cookies_with_values( MX_RECORD *record,
+				long i,
+				mx_bool_type allow_forward_references )
+{
+	MXW_UNUSED( record );
+	MXW_UNUSED( i );
+	MXW_UNUSED( allow_forward_references );
+
+	num_cookie_fallbacks++;
+
+	return MX_SUCCESSFUL_RESULT;
+}
+
+/*------------------------------------------------------------------------*/
+
+static MX_RECORD record;
+static MX_RECORD_FIELD field_array[NUM_FIELDS];
+static TEST_STRUCT test_struct;
+static double matrix[64];
+static long row_length_array[] = { 7, 8, 9 };
+static long dimension_array[NUM_FIELDS][MXU_FIELD_MAX_DIMENSIONS];
+
+static void
+setup_record( void )
+{
+	MX_RECORD_FIELD *field;
+	long i;
+
+	snprintf( record.name, sizeof(record.name), "test_record" );
+
+	record.record_type_struct = &test_struct;
+	record.num_record_fields = NUM_FIELDS;
+	record.record_field_array = field_array;
+
+	snprintf( test_struct.name, sizeof(test_struct.name), "test_record" );
+
+	test_struct.num_rows = 2;
+	test_struct.matrix = matrix;
+	test_struct.num_columns = 3;
+	test_struct.row_length_array = row_length_array;
+
+	for ( i = 0; i < NUM_FIELDS; i++ ) {
+		field = &field_array[i];
+
+		memcpy( dimension_array[i], test_field_defaults[i].dimension,
+						sizeof(dimension_array[i]) );
+
+		field->descriptor = &test_field_defaults[i];
+		field->dimension = dimension_array[i];
+		field->record = &record;
+		field->data_pointer = (char *) &test_struct
+				+ test_field_defaults[i].structure_offset;
+	}
+}
+
+#define CHECK( condition ) \
+	do { \
+		if ( !(condition) ) { \
+			fprintf( stderr, "%s:%d: check failed: %s\n", \
+				__FILE__, __LINE__, #condition ); \
+			num_failures++; \
+		} \
+	} while (0)
+
+/* Builds a plan for a driver with the given field defaults and returns
+ * the error code.
+ */
+
+static long
+create_plan( MX_RECORD_FIELD_DEFAULTS *defaults_array, long num_fields )
+{
+	static MX_RECORD_FIELD_DEFAULTS *defaults_ptr;
+	static long num_record_fields;
+
+	MX_DRIVER driver;
+	mx_status_type mx_status;
+
+	memset( &driver, 0, sizeof(driver) );
+
+	snprintf( driver.name, sizeof(driver.name), "bad_driver" );
+
+	defaults_ptr = defaults_array;
+	num_record_fields = num_fields;
+
+	driver.num_record_fields = &num_record_fields;
+	driver.record_field_defaults_ptr = &defaults_ptr;
+
+	mx_status = mx_create_varargs_plan( &driver );
+
+	if ( mx_status.code == MXE_SUCCESS ) {
+		mx_delete_varargs_plan( &driver );
+	} else if ( driver.varargs_plan != NULL ) {
+		return MXE_FUNCTION_FAILED;
+	}
+
+	return mx_status.code;
+}
+
+static int
+check_bad_drivers( void )
+{
+	MX_RECORD_FIELD_DEFAULTS defaults_array[NUM_FIELDS];
+	int num_failures;
+
+	num_failures = 0;
+
+	/* Two varargs fields that get their lengths from each other. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(NUM_ROWS, 0);
+	defaults_array[NUM_ROWS].num_dimensions = 1;
+	defaults_array[NUM_ROWS].dimension[0] = COOKIE(ROW_LENGTHS, 0);
+	defaults_array[NUM_ROWS].flags = MXFF_VARARGS;
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS )
+					== MXE_CORRUPT_DATA_STRUCTURE );
+
+	/* A field that gets its length from itself. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(ROW_LENGTHS, 0);
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS )
+					== MXE_CORRUPT_DATA_STRUCTURE );
+
+	/* A field index past the end of the record. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(NUM_FIELDS, 0);
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS )
+					== MXE_CORRUPT_DATA_STRUCTURE );
+
+	/* Lengths must come from integers, not doubles or strings. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(MATRIX, 0);
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS ) == MXE_TYPE_MISMATCH );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(NAME, 1);
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS ) == MXE_TYPE_MISMATCH );
+
+	/* A scalar does not have a second element. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[ROW_LENGTHS].dimension[0] = COOKIE(NUM_COLUMNS, 1);
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS ) == MXE_TYPE_MISMATCH );
+
+	/* A driver without any cookies is fine, but gets no plan. */
+
+	memcpy( defaults_array, test_field_defaults, sizeof(defaults_array) );
+
+	defaults_array[MATRIX].flags = 0;
+	defaults_array[ROW_LENGTHS].flags = 0;
+
+	CHECK( create_plan( defaults_array, NUM_FIELDS ) == MXE_SUCCESS );
+
+	return num_failures;
+}
+
+int
+main( int argc, char *argv[] )
+{
+	MX_VARARGS_PLAN *plan;
+	long *matrix_dimension, *row_length_dimension;
+	int num_failures;
+	mx_status_type mx_status;
+
+	MXW_UNUSED( argc );
+	MXW_UNUSED( argv );
+
+	num_failures = 0;
+
+	setup_record();
+
+	mx_status = mx_create_varargs_plan( &test_driver );
+
+	if ( mx_status.code != MXE_SUCCESS ) {
+		fprintf( stderr, "Could not create the varargs plan.\n" );
+		return EXIT_FAILURE;
+	}
+
+	plan = (MX_VARARGS_PLAN *) test_driver.varargs_plan;
+
+	matrix_dimension = field_array[MATRIX].dimension;
+	row_length_dimension = field_array[ROW_LENGTHS].dimension;
+
+	/* 'row_length_array' must be resolved before 'matrix'. */
+
+	CHECK( plan->num_fields == NUM_FIELDS );
+	CHECK( plan->num_steps == 3 );
+	CHECK( plan->field_num_steps[MATRIX] == 2 );
+	CHECK( plan->field_num_steps[ROW_LENGTHS] == 1 );
+	CHECK( plan->field_num_steps[NUM_ROWS] == 0 );
+	CHECK( plan->field_first_step[ROW_LENGTHS] == 0 );
+	CHECK( plan->field_first_step[MATRIX] == 1 );
+
+	CHECK( plan->step_array[0].field_index == ROW_LENGTHS );
+	CHECK( plan->step_array[0].referenced_field_index == NUM_COLUMNS );
+	CHECK( plan->step_array[1].field_index == MATRIX );
+	CHECK( plan->step_array[1].dimension_index == 0 );
+	CHECK( plan->step_array[1].referenced_field_index == NUM_ROWS );
+	CHECK( plan->step_array[2].dimension_index == 1 );
+	CHECK( plan->step_array[2].referenced_field_index == ROW_LENGTHS );
+	CHECK( plan->step_array[2].array_in_field_index == 1 );
+
+	/* Resolving the whole record. */
+
+	mx_status = mx_resolve_record_varargs( &record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( row_length_dimension[0] == 3 );
+	CHECK( matrix_dimension[0] == 2 );
+	CHECK( matrix_dimension[1] == 8 );
+
+	/* Resolving one field at a time, the way the database loader does. */
+
+	test_struct.num_rows = 4;
+	test_struct.num_columns = 2;
+	row_length_array[1] = 5;
+
+	mx_status = mx_resolve_varargs_field( &record, MATRIX, FALSE );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+
+	mx_status = mx_resolve_varargs_field( &record, ROW_LENGTHS, FALSE );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( row_length_dimension[0] == 2 );
+
+	mx_status = mx_resolve_varargs_field( &record, MATRIX, TRUE );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( matrix_dimension[0] == 4 );
+	CHECK( matrix_dimension[1] == 5 );
+
+	mx_status = mx_resolve_varargs_field( &record, NUM_FIELDS, TRUE );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+
+	/* Bad lengths in the record. */
+
+	test_struct.num_columns = 1;
+
+	mx_status = mx_resolve_record_varargs( &record );
+
+	CHECK( mx_status.code == MXE_WOULD_EXCEED_LIMIT );
+
+	test_struct.num_columns = 3;
+	test_struct.num_rows = -1;
+
+	mx_status = mx_resolve_record_varargs( &record );
+
+	CHECK( mx_status.code == MXE_ILLEGAL_ARGUMENT );
+
+	test_struct.num_rows = 2;
+	test_struct.row_length_array = NULL;
+
+	mx_status = mx_resolve_varargs_field( &record, MATRIX, TRUE );
+
+	CHECK( mx_status.code == MXE_CORRUPT_DATA_STRUCTURE );
+
+	test_struct.row_length_array = row_length_array;
+
+	/* None of this should have needed the old cookie functions. */
+
+	CHECK( num_cookie_fallbacks == 0 );
+
+	/* A record that does not line up with its driver falls back to
+	 * mx_replace_varargs_cookies_with_values() for each varargs field.
+	 */
+
+	record.num_record_fields = NUM_FIELDS - 1;
+
+	mx_status = mx_resolve_record_varargs( &record );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_cookie_fallbacks == 1 );
+
+	record.num_record_fields = NUM_FIELDS;
+
+	mx_delete_varargs_plan( &test_driver );
+
+	CHECK( test_driver.varargs_plan == NULL );
+
+	mx_status = mx_resolve_varargs_field( &record, MATRIX, FALSE );
+
+	CHECK( mx_status.code == MXE_SUCCESS );
+	CHECK( num_cookie_fallbacks == 2 );
+
+	num_failures += check_bad_drivers();
+
+	if ( num_failures > 0 ) {
+		fprintf( stderr, "%d checks failed.\n", num_failures );
+		return EXIT_FAILURE;
+	}
+
+	printf( "All varargs plan checks passed.\n" );
+
+	return EXIT_SUCCESS;
+}